@@ -0,0 +1,1040 @@
+/* Host micro-benchmarks of the pulse and metering hot paths.
+ *
+ * Each workload first checks that the code under test still does its job (counts, debounce,
+ * min width, summation) and exits non-zero if not, then reports the best of several timed
+ * runs in ns per operation. Build and run with `make -C host run`.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_timer.h"
+#include "host_shim.h"
+#include "attr_shadow.h"
+#include "battery.h"
+#include "battery_soc.h"
+#include "lp_pulse_sm.h"
+#include "metering.h"
+#include "optical_pulse_detect.h"
+#include "pulse.h"
+#include "pulse_counter.h"
+#include "pulse_optical.h"
+#include "timesync.h"
+
+#define BENCH_GPIO 10
+#define BENCH_RUNS 5
+
+#define BENCH_CHECK(cond)                                                        \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+typedef struct {
+    pulse_counter_t counter;
+    pulse_t pulse;
+    metering_t meter;
+    host_task_t consumer;
+} bench_channel_t;
+
+static bench_channel_t s_ch;
+static volatile uint64_t s_sink;
+
+static int64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void bench_setup(uint16_t debounce_ms, uint16_t min_width_ms)
+{
+    host_button_reset();
+    host_time_set_us(1000000);
+    memset(&s_ch, 0, sizeof(s_ch));
+
+    app_metering_cfg_t cfg = {
+        .pulse_per_unit_numerator = 1000,
+        .metering_device_type = 0,
+        .unit_of_measure = 0,
+        .debounce_ms = debounce_ms,
+        .gpio_num = BENCH_GPIO,
+    };
+    pulse_config_t pulse_cfg = {
+        .gpio_num = BENCH_GPIO,
+        .debounce_ms = debounce_ms,
+        .min_width_ms = min_width_ms,
+    };
+    pulse_counter_init(&s_ch.counter, 0);
+    metering_init(&s_ch.meter, &cfg, &s_ch.counter);
+    BENCH_CHECK(pulse_init(&s_ch.pulse, &pulse_cfg, NULL, NULL, &s_ch.counter) == ESP_OK);
+    pulse_set_consumer_task(&s_ch.consumer);
+}
+
+/* One reed closure: press, hold for width_us, release, then stay open for gap_us. */
+static void bench_pulse(int64_t width_us, int64_t gap_us)
+{
+    host_button_edge(BENCH_GPIO, true);
+    host_time_advance_us(width_us);
+    host_button_edge(BENCH_GPIO, false);
+    host_time_advance_us(gap_us);
+}
+
+static void bench_drain(void)
+{
+    pulse_pending_info_t info;
+    if (pulse_take_pending(&s_ch.pulse, &info)) {
+        metering_on_pulses(&s_ch.meter, info.count, info.last_ts_us, info.prev_ts_us);
+    }
+}
+
+static void check_filters(void)
+{
+    bench_setup(50, 20);
+
+    bench_pulse(30000, 200000);
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == 1);
+
+    /* Shorter than PULSE_MIN_WIDTH_MS. */
+    bench_pulse(5000, 200000);
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == 1);
+
+    /* Contact bounce: the second release lands inside the debounce window. */
+    bench_pulse(30000, 5000);
+    bench_pulse(30000, 200000);
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == 2);
+
+    /* Blocked input and stopped buttons drop pulses. */
+    pulse_block(&s_ch.pulse, true);
+    bench_pulse(30000, 200000);
+    pulse_block(&s_ch.pulse, false);
+    pulse_enable(false);
+    bench_pulse(30000, 200000);
+    pulse_enable(true);
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == 2);
+
+    /* Level wake inside the debounce window of the last pulse is the same edge. */
+    BENCH_CHECK(pulse_record_wakeup(&s_ch.pulse, esp_timer_get_time()));
+    BENCH_CHECK(!pulse_record_wakeup(&s_ch.pulse, esp_timer_get_time() + 1000));
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == 3);
+
+    pulse_pending_info_t info;
+    BENCH_CHECK(pulse_take_pending(&s_ch.pulse, &info) && info.count == 3 && info.lost == 0);
+    BENCH_CHECK(!pulse_take_pending(&s_ch.pulse, &info));
+    BENCH_CHECK(s_ch.consumer.notified >= 3);
+
+    metering_reset(&s_ch.meter);
+    BENCH_CHECK(metering_get_summation(&s_ch.meter) == 0);
+    host_time_advance_us(200000);
+    bench_pulse(30000, 200000);
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == 1);
+}
+
+/* A pulse that preempts another writer (here a reset holding the record) is deferred to it, not
+ * dropped, and applied after the reset.
+ */
+static void check_counter_deferred(void)
+{
+    pulse_counter_t c;
+    pulse_counter_init(&c, 41);
+    BENCH_CHECK(pulse_counter_add(&c, 1000000, 50000));
+    c.seq = 3;
+    BENCH_CHECK(pulse_counter_add(&c, 2000000, 50000));
+    BENCH_CHECK(c.deferred == 1 && c.counted == 1);
+    c.seq = 4;
+    pulse_counter_set_total(&c, 100);
+    pulse_counter_snapshot_t snap;
+    pulse_counter_read(&c, &snap);
+    BENCH_CHECK(snap.total == 101 && snap.counted == 2 && snap.last_us == 2000000 && snap.prev_us == 1000000);
+    BENCH_CHECK(c.deferred == 0 && (c.seq & 1u) == 0);
+
+    /* Deferred pulses keep their debounce. */
+    c.seq = 7;
+    BENCH_CHECK(pulse_counter_add(&c, 2010000, 50000));
+    c.seq = 8;
+    pulse_counter_set_total(&c, 200);
+    pulse_counter_read(&c, &snap);
+    BENCH_CHECK(snap.total == 200 && snap.counted == 2 && snap.last_us == 2000000 && c.deferred == 0);
+}
+
+/* LP core state machine, sampled every 1 ms. */
+#define BENCH_LP_SAMPLE_US 1000
+
+static lp_pulse_t s_lp;
+
+static void bench_lp_setup(uint16_t debounce_ms, uint16_t min_width_ms, uint32_t wake_pulses)
+{
+    lp_pulse_cfg_t cfg = {
+        .channels = 1,
+        .sample_us = BENCH_LP_SAMPLE_US,
+        .wake_pulses = wake_pulses,
+        .chan[0] = {
+            .gpio = BENCH_GPIO,
+            .debounce_ticks = lp_pulse_ticks(debounce_ms, BENCH_LP_SAMPLE_US),
+            .min_width_ticks = lp_pulse_ticks(min_width_ms, BENCH_LP_SAMPLE_US),
+        },
+    };
+    lp_pulse_init(&s_lp, &cfg);
+}
+
+/* Hold the input for dur_us; returns the HP wakes raised. */
+static uint32_t bench_lp_hold(bool low, int64_t dur_us)
+{
+    uint32_t wakes = 0;
+    for (int64_t t = 0; t < dur_us; t += BENCH_LP_SAMPLE_US) {
+        wakes += lp_pulse_sample(&s_lp, low ? 1u : 0u);
+    }
+    return wakes;
+}
+
+static void check_lp_pulse(void)
+{
+    /* Edges on the sample grid: the LP core counts exactly what pulse.c counts, including
+     * bounces inside the debounce and closures under the minimum width.
+     */
+    bench_setup(50, 20);
+    bench_lp_setup(50, 20, 1);
+    srand(48);
+    uint32_t wakes = 0;
+    uint32_t taken = 0;
+    lp_pulse_snapshot_t snap;
+    for (int i = 0; i < 5000; i++) {
+        int64_t width = (1 + rand() % 60) * 1000LL;
+        int64_t gap = (1 + rand() % 120) * 1000LL;
+        bench_pulse(width, gap);
+        wakes += bench_lp_hold(true, width);
+        uint32_t w = bench_lp_hold(false, gap);
+        wakes += w;
+        if (w) {
+            taken += lp_pulse_take(&s_lp, 0, &snap);
+        }
+    }
+    uint64_t counted = metering_get_total_pulses(&s_ch.meter);
+    BENCH_CHECK(counted > 1000 && counted < 5000);
+    BENCH_CHECK(s_lp.chan[0].counted == counted);
+    /* One wake per pulse, each taken at once. */
+    BENCH_CHECK(wakes == counted && taken == counted && !lp_pulse_due(&s_lp, 0));
+
+    /* Batches of 3: no wake before the third untaken pulse, one at it. */
+    bench_lp_setup(50, 0, 3);
+    for (int batch = 0; batch < 4; batch++) {
+        uint32_t w = 0;
+        for (int k = 0; k < 3; k++) {
+            BENCH_CHECK(w == 0 && !lp_pulse_due(&s_lp, 0));
+            w += bench_lp_hold(true, 30000);
+            w += bench_lp_hold(false, 200000);
+        }
+        BENCH_CHECK(w == 1 && lp_pulse_due(&s_lp, 0));
+        BENCH_CHECK(lp_pulse_take(&s_lp, 0, &snap) == 3);
+        /* Released 230 ticks apart; the snapshot is taken 200 ticks after the last one. */
+        BENCH_CHECK(snap.last_tick - snap.prev_tick == 230 && snap.tick - snap.last_tick == 199);
+    }
+    BENCH_CHECK(s_lp.wakes == 4);
+
+    /* A contact held closed counts once, at its release. */
+    bench_lp_setup(50, 20, 1);
+    BENCH_CHECK(bench_lp_hold(true, 3600LL * 1000000LL) == 0);
+    BENCH_CHECK(bench_lp_hold(false, 1000) == 1);
+
+    /* The HP side brings a batch in as one notification with the LP timestamps. */
+    bench_setup(50, 0);
+    pulse_pending_info_t info;
+    int64_t now = esp_timer_get_time();
+    pulse_import(&s_ch.pulse, 3, now - 1000, now - 5000);
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == 3);
+    BENCH_CHECK(pulse_take_pending(&s_ch.pulse, &info) && info.count == 3);
+    BENCH_CHECK(info.last_ts_us == now - 1000 && info.prev_ts_us == now - 5000);
+    pulse_import(&s_ch.pulse, 1, now, 0);
+    BENCH_CHECK(pulse_take_pending(&s_ch.pulse, &info) && info.count == 1 && info.prev_ts_us == now - 1000);
+}
+
+/* Light on the optical sensor: pulses of width_us every period_us from start_us, seen as a drop
+ * of amplitude counts (active low). Ambient light adds a slow swing of drift counts, a step at
+ * step_us and noise. With an emitter, the sensor only sees the emitter through a disc whose mark
+ * reflects a quarter as much, while ambient light jumps between samples but holds within one.
+ */
+typedef struct {
+    int64_t start_us;
+    int64_t period_us;
+    int64_t width_us;
+    uint32_t pulses;
+    int base;
+    int amplitude;
+    int noise;
+    int drift;
+    int64_t step_us;
+    int step;
+    int emitter_gpio;
+} bench_light_t;
+
+#define BENCH_EMITTER_GPIO 12
+#define BENCH_DRIFT_PERIOD_S 1800.0
+
+static adc_oneshot_unit_handle_t s_adc;
+static int s_ambient;
+static int64_t s_ambient_us;
+
+static int bench_light_read(int channel, void *arg)
+{
+    (void)channel;
+    const bench_light_t *l = arg;
+    int64_t t = esp_timer_get_time();
+    int64_t k = (t - l->start_us) / l->period_us;
+    bool on = t >= l->start_us && k < (int64_t)l->pulses && (t - l->start_us) % l->period_us < l->width_us;
+    int noise = l->noise ? rand() % (2 * l->noise + 1) - l->noise : 0;
+    int reading;
+    if (l->emitter_gpio >= 0) {
+        if (t - s_ambient_us > 1000) {
+            s_ambient = rand() % 2000;
+            s_ambient_us = t;
+        }
+        int lit = host_gpio_out_level(l->emitter_gpio) ? (on ? l->amplitude / 4 : l->amplitude) : 0;
+        reading = l->base + s_ambient + lit + noise;
+    } else {
+        double swing = l->drift * sin(2.0 * M_PI * (double)t / (BENCH_DRIFT_PERIOD_S * 1e6));
+        reading = l->base + (int)swing + (t >= l->step_us ? l->step : 0) - (on ? l->amplitude : 0) + noise;
+    }
+    return reading < 0 ? 0 : (reading > 4095 ? 4095 : reading);
+}
+
+static pulse_optical_cfg_t bench_optical_cfg(uint32_t hz, int emitter_gpio)
+{
+    if (!s_adc) {
+        adc_oneshot_unit_init_cfg_t unit_cfg = {.unit_id = ADC_UNIT_1};
+        BENCH_CHECK(adc_oneshot_new_unit(&unit_cfg, &s_adc) == ESP_OK);
+    }
+    return (pulse_optical_cfg_t){
+        .adc = s_adc,
+        .channel = 2,
+        .atten = ADC_ATTEN_DB_12,
+        .emitter_gpio = emitter_gpio,
+        .emitter_settle_us = CONFIG_OPTICAL_EMITTER_SETTLE_US,
+        .sample_hz = hz,
+        .detect = {
+            .min_span = CONFIG_OPTICAL_MIN_SPAN,
+            .hyst_pct = CONFIG_OPTICAL_HYSTERESIS_PCT,
+            .track_shift = optical_pulse_track_shift(CONFIG_OPTICAL_TRACK_S, hz),
+            .active_low = true,
+        },
+    };
+}
+
+/* Sample l at hz for dur_us through the whole input (ADC, detector, pulse.c); returns the
+ * pulses counted.
+ */
+static uint64_t bench_optical_run(bench_light_t *l, uint32_t hz, int64_t dur_us)
+{
+    pulse_optical_cfg_t cfg = bench_optical_cfg(hz, l->emitter_gpio);
+    host_adc_set_source(bench_light_read, l);
+    BENCH_CHECK(pulse_optical_start(&s_ch.pulse, &cfg) == ESP_OK);
+    host_irq_run_until(esp_timer_get_time() + dur_us);
+    pulse_optical_stop();
+    host_adc_set_source(NULL, NULL);
+    return metering_get_total_pulses(&s_ch.meter);
+}
+
+static void check_optical(void)
+{
+    /* Meter LED at 50 Hz: 40 ms flashes every 1.5 s, ambient swinging by more than the
+     * contrast plus a step, all counted exactly and taken in one batch.
+     */
+    bench_setup(CONFIG_PULSE_DEBOUNCE_MS, CONFIG_PULSE_MIN_WIDTH_MS);
+    srand(50);
+    int64_t now = esp_timer_get_time();
+    bench_light_t led = {
+        .start_us = now + 2000000,
+        .period_us = 1500000,
+        .width_us = 40000,
+        .pulses = 400,
+        .base = 2500,
+        .amplitude = 600,
+        .noise = 20,
+        .drift = 800,
+        .step_us = now + 301000000,
+        .step = -250,
+        .emitter_gpio = -1,
+    };
+    BENCH_CHECK(bench_optical_run(&led, 50, 610LL * 1000000) == 400);
+    pulse_pending_info_t info;
+    BENCH_CHECK(pulse_take_pending(&s_ch.pulse, &info) && info.count == 400 && info.lost == 0);
+    /* Edges are stamped on the sample grid. */
+    BENCH_CHECK((info.last_ts_us - info.prev_ts_us) % 20000 == 0);
+    const pulse_optical_stats_t *st = pulse_optical_stats();
+    BENCH_CHECK(st->edges == 800 && st->read_errors == 0 && st->samples == 610 * 50);
+
+    /* Noise and drift alone never count. */
+    bench_setup(CONFIG_PULSE_DEBOUNCE_MS, CONFIG_PULSE_MIN_WIDTH_MS);
+    led.pulses = 0;
+    led.step = 0;
+    BENCH_CHECK(bench_optical_run(&led, 50, 600LL * 1000000) == 0);
+    BENCH_CHECK(pulse_optical_stats()->edges == 0);
+
+    /* Reflective disc at 10 Hz with an emitter: ambient light jumping by three times the
+     * contrast cancels out. The emitter is off between samples.
+     */
+    bench_setup(CONFIG_PULSE_DEBOUNCE_MS, CONFIG_PULSE_MIN_WIDTH_MS);
+    now = esp_timer_get_time();
+    bench_light_t disc = {
+        .start_us = now + 1000000,
+        .period_us = 4000000,
+        .width_us = 600000,
+        .pulses = 100,
+        .base = 200,
+        .amplitude = 800,
+        .noise = 20,
+        .emitter_gpio = BENCH_EMITTER_GPIO,
+    };
+    BENCH_CHECK(bench_optical_run(&disc, 10, 402LL * 1000000) == 100);
+    BENCH_CHECK(host_gpio_out_level(BENCH_EMITTER_GPIO) == 0);
+    BENCH_CHECK(pulse_optical_stats()->edges == 200);
+}
+
+/* Modelled cost of one sample on top of the time measured in the callback: light-sleep exit and
+ * re-entry with the esp_timer task switch, about 0.3 ms on the ESP32-H2/C6.
+ */
+#define BENCH_OPTICAL_WAKE_US 300
+
+typedef struct {
+    uint32_t hz;
+    double awake_pct;
+    double avg_ua;
+} bench_optical_rate_t;
+
+static const uint32_t s_optical_rates[] = {10, 20, 50, 100, 200};
+#define BENCH_OPTICAL_RATES (sizeof(s_optical_rates) / sizeof(s_optical_rates[0]))
+
+/* A minute of 1 Hz pulses two sample periods wide at each rate; all must count. The awake time
+ * is the callback's (ADC conversions on the host clock, plus the emitter settle when lit) plus
+ * BENCH_OPTICAL_WAKE_US, charged at the CPU-busy current, with the ADC current on top for the
+ * callback part. The rest of the time is light sleep.
+ */
+static void check_optical_rates(bench_optical_rate_t *out, int emitter_gpio)
+{
+    for (size_t i = 0; i < BENCH_OPTICAL_RATES; i++) {
+        uint32_t hz = s_optical_rates[i];
+        bench_setup(CONFIG_PULSE_DEBOUNCE_MS, 0);
+        srand(hz);
+        int64_t now = esp_timer_get_time();
+        bench_light_t l = {
+            .start_us = now + 500000,
+            .period_us = 1000000,
+            .width_us = 2 * 1000000 / hz,
+            .pulses = 60,
+            .base = emitter_gpio >= 0 ? 200 : 2500,
+            .amplitude = 800,
+            .noise = 20,
+            .emitter_gpio = emitter_gpio,
+        };
+        const int64_t dur_us = 61LL * 1000000;
+        BENCH_CHECK(bench_optical_run(&l, hz, dur_us) == 60);
+        const pulse_optical_stats_t *st = pulse_optical_stats();
+        double cb_us = (double)st->awake_us;
+        double wake_us = (double)st->samples * BENCH_OPTICAL_WAKE_US;
+        double awake = (cb_us + wake_us) / (double)dur_us;
+        out[i] = (bench_optical_rate_t){
+            .hz = hz,
+            .awake_pct = 100.0 * awake,
+            .avg_ua = awake * CONFIG_ENERGY_CPU_BUSY_UA + cb_us / (double)dur_us * CONFIG_ENERGY_ADC_UA +
+                      (1.0 - awake) * CONFIG_ENERGY_SLEEP_UA,
+        };
+    }
+}
+
+/* Fake battery hardware: logs each call as one letter (E/D divider on/off, W wait, S sample). */
+typedef struct {
+    char log[16];
+    size_t n;
+    uint32_t waited_us;
+    bool sample_ok;
+    int adc_mv;
+} bench_battery_hw_t;
+
+static void bench_battery_divider(void *ctx, bool on)
+{
+    bench_battery_hw_t *hw = ctx;
+    hw->log[hw->n++] = on ? 'E' : 'D';
+}
+
+static void bench_battery_wait(void *ctx, uint32_t us)
+{
+    bench_battery_hw_t *hw = ctx;
+    hw->log[hw->n++] = 'W';
+    hw->waited_us += us;
+}
+
+static bool bench_battery_sample(void *ctx, int *adc_mv, uint16_t *samples, uint32_t *awake_us)
+{
+    bench_battery_hw_t *hw = ctx;
+    hw->log[hw->n++] = 'S';
+    *adc_mv = hw->adc_mv;
+    *samples = 16;
+    *awake_us = 400;
+    return hw->sample_ok;
+}
+
+static void check_battery(void)
+{
+    /* 1:1 divider, two LiFePO4 cells. */
+    battery_cfg_t cfg = {
+        .r_top_ohm = 1000000,
+        .r_bot_ohm = 1000000,
+        .empty_mv = 5000,
+        .full_mv = 7000,
+        .settle_us = 2000,
+    };
+    bench_battery_hw_t hw = {.sample_ok = true, .adc_mv = 3200};
+    battery_meas_ops_t ops = {
+        .divider_enable = bench_battery_divider,
+        .wait_us = bench_battery_wait,
+        .sample = bench_battery_sample,
+        .ctx = &hw,
+    };
+    battery_reading_t r;
+    battery_measure(&cfg, &ops, &r);
+    BENCH_CHECK(hw.n == 4 && memcmp(hw.log, "EWSD", 4) == 0 && hw.waited_us == 2000);
+    BENCH_CHECK(r.valid && r.adc_mv == 3200 && r.battery_mv == 6400 && r.samples == 16 && r.awake_us == 400);
+
+    /* A failed burst still switches the divider off and reports nothing. */
+    hw = (bench_battery_hw_t){.sample_ok = false, .adc_mv = 3200};
+    battery_measure(&cfg, &ops, &r);
+    BENCH_CHECK(hw.n == 4 && memcmp(hw.log, "EWSD", 4) == 0);
+    BENCH_CHECK(!r.valid && r.battery_mv == 0);
+    hw = (bench_battery_hw_t){.sample_ok = true, .adc_mv = -1};
+    battery_measure(&cfg, &ops, &r);
+    BENCH_CHECK(hw.log[hw.n - 1] == 'D' && !r.valid);
+
+    /* A fixed divider has no switch and no settle wait. */
+    hw = (bench_battery_hw_t){.sample_ok = true, .adc_mv = 3200};
+    ops.divider_enable = NULL;
+    cfg.settle_us = 0;
+    battery_measure(&cfg, &ops, &r);
+    BENCH_CHECK(hw.n == 1 && hw.log[0] == 'S' && r.valid);
+
+    /* Divider maths: rounded, saturated, r_bot = 0 rejected. */
+    cfg.r_top_ohm = 2000000;
+    BENCH_CHECK(battery_adc_to_mv(&cfg, 1000) == 3000);
+    cfg.r_top_ohm = 1;
+    cfg.r_bot_ohm = 3;
+    BENCH_CHECK(battery_adc_to_mv(&cfg, 1) == 1 && battery_adc_to_mv(&cfg, 2) == 3);
+    cfg.r_top_ohm = 100000000;
+    cfg.r_bot_ohm = 1;
+    BENCH_CHECK(battery_adc_to_mv(&cfg, 3300) == 65000);
+    cfg.r_bot_ohm = 0;
+    BENCH_CHECK(battery_adc_to_mv(&cfg, 3300) == 0);
+
+    /* Sanity window: the empty-full span again on each side, at least 500 mV, at most 5 V. */
+    BENCH_CHECK(battery_mv_is_sane(&cfg, 3000) && battery_mv_is_sane(&cfg, 9000));
+    BENCH_CHECK(!battery_mv_is_sane(&cfg, 2999) && !battery_mv_is_sane(&cfg, 9001));
+    cfg.empty_mv = 3000;
+    cfg.full_mv = 3100;
+    BENCH_CHECK(battery_mv_is_sane(&cfg, 2500) && !battery_mv_is_sane(&cfg, 2499));
+    BENCH_CHECK(battery_mv_is_sane(&cfg, 3600) && !battery_mv_is_sane(&cfg, 3601));
+    cfg.empty_mv = 0;
+    BENCH_CHECK(battery_mv_is_sane(&cfg, 1) && !battery_mv_is_sane(&cfg, 0));
+
+    /* ZCL attributes. */
+    cfg.empty_mv = 5000;
+    cfg.full_mv = 7000;
+    BENCH_CHECK(battery_percent_attr(&cfg, 4000) == 0 && battery_percent_attr(&cfg, 6000) == 100);
+    BENCH_CHECK(battery_percent_attr(&cfg, 7500) == 200 && battery_voltage_attr(6460) == 64);
+    BENCH_CHECK(battery_voltage_attr(30000) == 0xFE);
+}
+
+#define BENCH_S_US 1000000LL
+
+static void check_timesync(void)
+{
+    timesync_reset();
+    BENCH_CHECK(!timesync_valid() && timesync_utc(0) == 0 && timesync_local(0) == 0);
+    timesync_update(0, 1000, 3600);
+    BENCH_CHECK(timesync_valid() && timesync_utc(0) == 1000 && timesync_utc(10 * BENCH_S_US) == 1010);
+    BENCH_CHECK(timesync_local(10 * BENCH_S_US) == 1010 + 3600);
+
+    /* esp_timer runs 1000 ppm slow. A window under an hour leaves the estimate alone; two hours
+     * give it to within the 1 s quantization (139 ppm over 7200 s).
+     */
+    timesync_update(1800 * BENCH_S_US, 1000 + 1801, 3600);
+    BENCH_CHECK(timesync_drift_ppm() == 0 && timesync_last_error_ms() == 1000);
+    timesync_update(7200 * BENCH_S_US, 1000 + 7207, 3600);
+    int32_t ppm = timesync_drift_ppm();
+    BENCH_CHECK(ppm > 1000 - 139 && ppm < 1000 + 139);
+    /* The next sync two hours on is predicted to within a second, and averages in. */
+    timesync_update(14400 * BENCH_S_US, 1000 + 14414, 3600);
+    BENCH_CHECK(timesync_last_error_ms() > -1000 && timesync_last_error_ms() < 1000);
+    BENCH_CHECK(timesync_drift_ppm() > 1000 - 139 && timesync_drift_ppm() < 1000 + 139);
+    BENCH_CHECK(timesync_utc(21600 * BENCH_S_US) >= 1000 + 21620 && timesync_utc(21600 * BENCH_S_US) <= 1000 + 21622);
+
+    /* An estimate beyond TIMESYNC_MAX_DRIFT_PPM is clamped. */
+    timesync_reset();
+    timesync_update(0, 1000, 0);
+    timesync_update(3600 * BENCH_S_US, 1000 + 3600 + 400, 0);
+    BENCH_CHECK(timesync_drift_ppm() == TIMESYNC_MAX_DRIFT_PPM);
+
+    /* A step over TIMESYNC_MAX_STEP_S is taken as is and restarts the estimate: the drift stays,
+     * and syncs within the hour after the step do not move it.
+     */
+    timesync_reset();
+    timesync_update(0, 1000, 0);
+    timesync_update(3600 * BENCH_S_US, 1000 + 3601, 0);
+    ppm = timesync_drift_ppm();
+    BENCH_CHECK(ppm > 0 && ppm < 300);
+    timesync_update(4000 * BENCH_S_US, 1000 + 4000 + TIMESYNC_MAX_STEP_S + 100, 0);
+    BENCH_CHECK(timesync_drift_ppm() == ppm && timesync_last_error_ms() > TIMESYNC_MAX_STEP_S * 1000);
+    BENCH_CHECK(timesync_utc(4000 * BENCH_S_US) == 1000 + 4000 + TIMESYNC_MAX_STEP_S + 100);
+    timesync_update(7000 * BENCH_S_US, 1000 + 7000 + TIMESYNC_MAX_STEP_S + 100 + 50, 0);
+    BENCH_CHECK(timesync_drift_ppm() == ppm);
+    timesync_update(7700 * BENCH_S_US, 1000 + 7700 + TIMESYNC_MAX_STEP_S + 100 + 60, 0);
+    BENCH_CHECK(timesync_drift_ppm() != ppm);
+}
+
+#define BENCH_DAY_S 86400u
+
+static uint8_t bench_calendar(uint32_t day, uint32_t pulses)
+{
+    if (pulses) {
+        pulse_counter_add_batch(&s_ch.counter, pulses, esp_timer_get_time(), 0);
+    }
+    return metering_calendar_update(&s_ch.meter, day * BENCH_DAY_S + 12 * 3600);
+}
+
+/* Day and week consumption; day 0 (2000-01-01) was a Saturday and weeks start on Monday. */
+static void check_calendar(void)
+{
+    bench_setup(0, 0);
+    const uint32_t mon = 9;     /* 2000-01-10 */
+    BENCH_CHECK(!metering_calendar_valid(&s_ch.meter));
+    BENCH_CHECK(bench_calendar(mon, 3) == 0 && metering_calendar_valid(&s_ch.meter));
+    BENCH_CHECK(bench_calendar(mon, 5) == 0);
+    BENCH_CHECK(metering_get_current_day_consumption(&s_ch.meter) == 5);
+    BENCH_CHECK(bench_calendar(mon + 1, 0) == METERING_ROLL_DAY);
+    BENCH_CHECK(metering_get_previous_day_consumption(&s_ch.meter) == 5);
+    BENCH_CHECK(metering_get_current_day_consumption(&s_ch.meter) == 0);
+
+    /* A backward step keeps accumulating, and catching up again does not roll twice. */
+    BENCH_CHECK(bench_calendar(mon, 7) == 0);
+    BENCH_CHECK(bench_calendar(mon + 1, 1) == 0);
+    BENCH_CHECK(metering_get_current_day_consumption(&s_ch.meter) == 8);
+    BENCH_CHECK(metering_get_previous_day_consumption(&s_ch.meter) == 5);
+
+    /* A skipped day (device off over Wednesday) has no previous day. */
+    BENCH_CHECK(bench_calendar(mon + 3, 0) == METERING_ROLL_DAY);
+    BENCH_CHECK(metering_get_previous_day_consumption(&s_ch.meter) == 0);
+    BENCH_CHECK(metering_get_current_week_consumption(&s_ch.meter) == 13);
+
+    /* Sunday is still this week; Monday rolls both. */
+    BENCH_CHECK(bench_calendar(mon + 6, 4) == METERING_ROLL_DAY);
+    BENCH_CHECK(bench_calendar(mon + 7, 2) == (METERING_ROLL_DAY | METERING_ROLL_WEEK));
+    BENCH_CHECK(metering_get_previous_week_consumption(&s_ch.meter) == 19);
+    BENCH_CHECK(metering_get_previous_day_consumption(&s_ch.meter) == 2);
+    BENCH_CHECK(metering_get_current_week_consumption(&s_ch.meter) == 0);
+    /* A week with no sync at all has no previous week. */
+    BENCH_CHECK(bench_calendar(mon + 21, 0) == (METERING_ROLL_DAY | METERING_ROLL_WEEK));
+    BENCH_CHECK(metering_get_previous_week_consumption(&s_ch.meter) == 0);
+
+    /* Get Profile EndTime against the newest stored interval, ending at 100 h. */
+    const uint32_t iv = metering_profile_interval_s();
+    const uint32_t newest = 100 * iv;
+    uint32_t end = newest;
+    BENCH_CHECK(metering_profile_skip(&end, 0) == 0 && end == newest);
+    BENCH_CHECK(metering_profile_skip(&end, newest + 5) == 0 && end == newest);
+    end = newest;
+    BENCH_CHECK(metering_profile_skip(&end, newest - 1) == 1 && end == newest - iv);
+    end = newest;
+    BENCH_CHECK(metering_profile_skip(&end, newest - iv) == 1 && end == newest - iv);
+    end = newest;
+    BENCH_CHECK(metering_profile_skip(&end, newest - iv - 1) == 2 && end == newest - 2 * iv);
+    end = UINT32_MAX;
+    BENCH_CHECK(metering_profile_skip(&end, 1) == UINT16_MAX && end == UINT32_MAX - UINT16_MAX * iv);
+}
+
+/* Leak detection with the Kconfig defaults: 60 min pause, 6 h continuous, 500-pulse burst. */
+#define BENCH_MIN_US (60LL * 1000000)
+#define BENCH_HOUR_US (60 * BENCH_MIN_US)
+
+static uint8_t bench_leak_pulse(int64_t t_us)
+{
+    metering_on_pulses(&s_ch.meter, 1, t_us, 0);
+    return metering_leak_alarms(&s_ch.meter);
+}
+
+static void check_leak(void)
+{
+    BENCH_CHECK(CONFIG_LEAK_IDLE_GAP_MIN == 60 && CONFIG_LEAK_CONTINUOUS_H == 6 && CONFIG_LEAK_BURST_PULSES == 500);
+
+    /* A drip every 10 min: continuous once the run reaches 6 h, no idle once 24 h pass without
+     * a 60 min pause. 144 pulses a day stay under the burst volume.
+     */
+    bench_setup(0, 0);
+    const int64_t t0 = 10 * BENCH_HOUR_US;
+    int64_t t = t0;
+    uint8_t alarms = 0;
+    for (; t < t0 + 6 * BENCH_HOUR_US; t += 10 * BENCH_MIN_US) {
+        alarms = bench_leak_pulse(t);
+    }
+    BENCH_CHECK(alarms == 0);
+    BENCH_CHECK(bench_leak_pulse(t) == METERING_LEAK_CONTINUOUS);
+    BENCH_CHECK(metering_leak_flow_run_s(&s_ch.meter, t) == 6 * 3600);
+    for (t += 10 * BENCH_MIN_US; t < t0 + 24 * BENCH_HOUR_US; t += 10 * BENCH_MIN_US) {
+        alarms = bench_leak_pulse(t);
+    }
+    BENCH_CHECK(alarms == METERING_LEAK_CONTINUOUS);
+    BENCH_CHECK(bench_leak_pulse(t) == (METERING_LEAK_CONTINUOUS | METERING_LEAK_NO_IDLE));
+    BENCH_CHECK(metering_leak_longest_idle_s(&s_ch.meter, t) == 600);
+
+    /* A 60 min pause clears everything, seen by the tick before the next pulse. */
+    int64_t last = t;
+    metering_tick(&s_ch.meter, last + BENCH_HOUR_US - 1);
+    BENCH_CHECK(metering_leak_alarms(&s_ch.meter) == (METERING_LEAK_CONTINUOUS | METERING_LEAK_NO_IDLE));
+    metering_tick(&s_ch.meter, last + BENCH_HOUR_US);
+    BENCH_CHECK(metering_leak_alarms(&s_ch.meter) == 0);
+    BENCH_CHECK(metering_leak_flow_run_s(&s_ch.meter, last + BENCH_HOUR_US) == 0);
+    /* The next pulse starts a new run, and the pause stays in the 24 h window. */
+    t = last + 2 * BENCH_HOUR_US;
+    BENCH_CHECK(bench_leak_pulse(t) == 0);
+    BENCH_CHECK(bench_leak_pulse(t + 10 * BENCH_MIN_US) == 0);
+    BENCH_CHECK(metering_leak_longest_idle_s(&s_ch.meter, t + 10 * BENCH_MIN_US) == 2 * 3600);
+
+    /* Burst: the 500th pulse of one run, even across a 59 min lull. */
+    bench_setup(0, 0);
+    t = t0;
+    for (int i = 0; i < 250; i++, t += 1000000) {
+        alarms = bench_leak_pulse(t);
+    }
+    t += 59 * BENCH_MIN_US;
+    for (int i = 0; i < 249; i++, t += 1000000) {
+        alarms = bench_leak_pulse(t);
+    }
+    BENCH_CHECK(alarms == 0);
+    BENCH_CHECK(bench_leak_pulse(t) == METERING_LEAK_BURST);
+    /* After a full pause, a batch counts all its pulses into the new run. */
+    t += BENCH_HOUR_US + 1000000;
+    metering_on_pulses(&s_ch.meter, 499, t, t - 1000000);
+    BENCH_CHECK(metering_leak_alarms(&s_ch.meter) == 0);
+    metering_on_pulses(&s_ch.meter, 2, t + 1000000, t + 500000);
+    BENCH_CHECK(metering_leak_alarms(&s_ch.meter) == METERING_LEAK_BURST);
+    metering_tick(&s_ch.meter, t + 1000000 + BENCH_HOUR_US);
+    BENCH_CHECK(metering_leak_alarms(&s_ch.meter) == 0);
+}
+
+/* Two 1500 mAh LiFePO4 cells in series, plateau 20-90 %. */
+static void check_battery_soc(void)
+{
+    const battery_soc_cfg_t cfg = {
+        .capacity_mah = 1500,
+        .cells = 2,
+        .curve = battery_soc_lifepo4_curve,
+        .curve_len = battery_soc_lifepo4_curve_len,
+        .plateau_lo_pct = 20,
+        .plateau_hi_pct = 90,
+    };
+    battery_soc_init(&cfg, -1);
+    BENCH_CHECK(!battery_soc_valid() && battery_soc_percent_attr() == 0xFF && battery_soc_days_remaining() == 0xFFFF);
+    BENCH_CHECK(battery_soc_curve_percent(6530) == 55 && battery_soc_curve_percent(7000) == 100);
+    BENCH_CHECK(battery_soc_curve_percent(4000) == 0);
+
+    /* No saved state: the first reading anchors, even on the plateau. */
+    battery_soc_on_voltage(6600);
+    BENCH_CHECK(battery_soc_valid() && battery_soc_remaining_uah() == 1050000 && battery_soc_percent_attr() == 140);
+
+    /* On the plateau coulomb counting rules, and the voltage only bounds it to the band. */
+    battery_soc_consume(100000000ULL + 999, 0);
+    BENCH_CHECK(battery_soc_remaining_uah() == 950000);
+    battery_soc_on_voltage(6540);
+    BENCH_CHECK(battery_soc_remaining_uah() == 950000);
+    battery_soc_consume(1100000000ULL, 60);
+    BENCH_CHECK(battery_soc_remaining_uah() == 0);
+    battery_soc_on_voltage(6540);
+    BENCH_CHECK(battery_soc_remaining_uah() == 300000);
+    battery_soc_init(&cfg, 1600000);
+    BENCH_CHECK(battery_soc_remaining_uah() == 1500000);
+    battery_soc_on_voltage(6600);
+    BENCH_CHECK(battery_soc_remaining_uah() == 1350000);
+
+    /* Off the plateau the voltage wins: near empty ... */
+    battery_soc_on_voltage(6200);
+    BENCH_CHECK(battery_soc_remaining_uah() == 225000 && battery_soc_percent_attr() == 30);
+    /* ... and a freshly swapped full pack. */
+    battery_soc_on_voltage(6800);
+    BENCH_CHECK(battery_soc_remaining_uah() == 1500000 && battery_soc_percent_attr() == 200);
+
+    /* Days remaining at the day-smoothed average current: 1 mA for an hour, then 2 mA. */
+    battery_soc_init(&cfg, 1500000);
+    battery_soc_consume(0, 1000);
+    BENCH_CHECK(battery_soc_days_remaining() == 0xFFFF);
+    battery_soc_consume(1000000, 1030);
+    BENCH_CHECK(battery_soc_avg_current_ua() == 0);
+    battery_soc_consume(1000000, 4600);
+    BENCH_CHECK(battery_soc_avg_current_ua() == 1000 && battery_soc_remaining_uah() == 1499000);
+    BENCH_CHECK(battery_soc_days_remaining() == 62);
+    battery_soc_consume(3000000, 8200);
+    BENCH_CHECK(battery_soc_avg_current_ua() == 1040 && battery_soc_days_remaining() == 59);
+}
+
+/* Returns the demand read at a steady 3600 pulses per hour. */
+static int32_t check_metering(void)
+{
+    bench_setup(50, 0);
+    /* 1000 pulses per kWh at one pulse per second: 3.6 kW = 3600 pulses per hour. */
+    for (int i = 0; i < 600; i++) {
+        bench_pulse(30000, 970000);
+        bench_drain();
+    }
+    BENCH_CHECK(metering_get_summation(&s_ch.meter) == 600);
+    BENCH_CHECK(metering_get_divisor(&s_ch.meter) == 1000);
+    BENCH_CHECK((metering_get_summation_formatting(&s_ch.meter) & 0x07) == 3);
+    /* The EMA decays between pulses too, so it settles below the true rate. */
+    int32_t demand = metering_get_instantaneous_demand(&s_ch.meter);
+    BENCH_CHECK(demand > 3000 && demand < 3800);
+    return demand;
+}
+
+#if CONFIG_DEMAND_ESTIMATOR_WINDOW
+/* Ticks once a second from from_s to to_s; demand must not rise without a new pulse. */
+static int32_t bench_demand_ticks(int64_t from_s, int64_t to_s, int32_t lo, int32_t hi)
+{
+    int32_t prev = metering_get_instantaneous_demand(&s_ch.meter);
+    for (int64_t t = from_s; t <= to_s; t++) {
+        metering_tick(&s_ch.meter, t * 1000000LL);
+        int32_t demand = metering_get_instantaneous_demand(&s_ch.meter);
+        BENCH_CHECK(demand <= prev && demand >= lo && demand <= hi);
+        prev = demand;
+    }
+    return prev;
+}
+
+/* 1 m3/h at 0.01 m3 per pulse (one pulse every 36 s): steady demand, then a monotonic fall. */
+static void check_demand_window(void)
+{
+    bench_setup(50, 0);
+    metering_reset(&s_ch.meter);
+    metering_tick(&s_ch.meter, 1000LL * 1000000LL);
+    int64_t t = 1000;
+    for (int i = 0; i < 40; i++) {
+        t += 36;
+        metering_on_pulses(&s_ch.meter, 1, t * 1000000LL, (t - 36) * 1000000LL);
+        if (i >= 1) {
+            BENCH_CHECK(metering_get_instantaneous_demand(&s_ch.meter) == 100);
+            bench_demand_ticks(t + 1, t + 35, 100, 100);
+        }
+    }
+    /* Flow stops: demand keeps falling, well below the rate within ten minutes. */
+    BENCH_CHECK(bench_demand_ticks(t + 1, t + 600, 0, 100) <= 6);
+
+    /* Pulses at 0, 250 and 260 s: the first one leaving the window must not raise demand. */
+    metering_reset(&s_ch.meter);
+    t = 10000;
+    metering_tick(&s_ch.meter, t * 1000000LL);
+    metering_on_pulses(&s_ch.meter, 1, t * 1000000LL, 0);
+    metering_on_pulses(&s_ch.meter, 1, (t + 250) * 1000000LL, t * 1000000LL);
+    metering_on_pulses(&s_ch.meter, 1, (t + 260) * 1000000LL, (t + 250) * 1000000LL);
+    int32_t at_last = metering_get_instantaneous_demand(&s_ch.meter);
+    BENCH_CHECK(at_last > 0);
+    bench_demand_ticks(t + 261, t + 600, 0, at_last);
+}
+#endif
+
+typedef void (*bench_fn_t)(uint32_t n);
+
+static double bench_run(bench_fn_t setup, bench_fn_t fn, uint32_t n)
+{
+    double best = 0.0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        setup(n);
+        int64_t t0 = bench_now_ns();
+        fn(n);
+        double ns = (double)(bench_now_ns() - t0) / (double)n;
+        if (run == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+static void setup_default(uint32_t n)
+{
+    (void)n;
+    bench_setup(50, 20);
+}
+
+static void work_pulse(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        bench_pulse(30000, 970000);
+    }
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == n);
+}
+
+static void work_bounce(uint32_t n)
+{
+    /* Every other release bounces and is rejected by the debounce. */
+    for (uint32_t i = 0; i < n; i++) {
+        bench_pulse(30000, (i & 1) ? 970000 : 1000);
+    }
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == (n + 1) / 2);
+}
+
+#define BENCH_BATCH 8
+
+static void work_batch(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        for (int k = 0; k < BENCH_BATCH; k++) {
+            (void)pulse_counter_add(&s_ch.counter, esp_timer_get_time(), 0);
+            host_time_advance_us(250000);
+        }
+        bench_drain();
+    }
+    BENCH_CHECK(metering_get_total_pulses(&s_ch.meter) == (uint64_t)n * BENCH_BATCH);
+}
+
+static void work_add_only(uint32_t n)
+{
+    for (uint32_t i = 0; i < n * BENCH_BATCH; i++) {
+        (void)pulse_counter_add(&s_ch.counter, esp_timer_get_time(), 0);
+        host_time_advance_us(250000);
+    }
+}
+
+static void work_tick(uint32_t n)
+{
+    int64_t now = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++) {
+        if ((i & 15) == 0) {
+            (void)pulse_counter_add(&s_ch.counter, now, 0);
+            bench_drain();
+        }
+        now += 1000000;
+        host_time_set_us(now);
+        s_sink += metering_tick(&s_ch.meter, now);
+    }
+}
+
+static void work_counter_read(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        s_sink += pulse_counter_total(&s_ch.counter);
+    }
+}
+
+static void setup_lp(uint32_t n)
+{
+    (void)n;
+    bench_lp_setup(50, 20, 1);
+}
+
+/* One 1 ms sample per call: a 30 ms closure every second, so most samples are idle. */
+static void work_lp_sample(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        s_sink += lp_pulse_sample(&s_lp, (i % 1000) < 30 ? 1u : 0u);
+    }
+    BENCH_CHECK(s_lp.chan[0].counted == n / 1000 + ((n % 1000) > 30));
+}
+
+static optical_pulse_t s_optical;
+
+static void setup_optical(uint32_t n)
+{
+    (void)n;
+    optical_pulse_cfg_t cfg = {.min_span = 100, .hyst_pct = 15, .track_shift = 12, .active_low = true};
+    optical_pulse_init(&s_optical, &cfg);
+}
+
+/* One reading per call: a 2-sample flash every 50 samples, with a little noise. */
+static void work_optical_sample(uint32_t n)
+{
+    uint32_t on = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        int reading = 2500 + (int)(i * 7 % 23) - ((i % 50) < 2 ? 600 : 0);
+        on += optical_pulse_sample(&s_optical, reading) == OPTICAL_PULSE_ON;
+    }
+    s_sink += on;
+    BENCH_CHECK(on == (n + 49) / 50 - 1);
+}
+
+static attr_shadow_t s_shadow[2];
+static uint32_t s_shadow_writes;
+
+static void bench_shadow_write(const attr_shadow_t *attr, void *value)
+{
+    (void)attr;
+    (void)value;
+    s_shadow_writes++;
+}
+
+static void setup_shadow(uint32_t n)
+{
+    (void)n;
+    s_shadow_writes = 0;
+}
+
+static void work_shadow(uint32_t n)
+{
+    /* Summation changes every 16th loop pass, demand every 4th. */
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t summation[6] = {(uint8_t)(i >> 4), 0, 0, 0, 0, 0};
+        uint8_t demand[3] = {(uint8_t)(i >> 2), 0, 0};
+        attr_shadow_set(&s_shadow[0], summation);
+        attr_shadow_set(&s_shadow[1], demand);
+        (void)attr_shadow_flush(bench_shadow_write);
+    }
+    BENCH_CHECK(s_shadow_writes <= n / 4 + n / 16 + 2);
+}
+
+int main(void)
+{
+    check_filters();
+    check_counter_deferred();
+    check_battery();
+    check_battery_soc();
+    check_leak();
+    check_timesync();
+    check_calendar();
+    check_lp_pulse();
+    check_optical();
+    bench_optical_rate_t led_rates[BENCH_OPTICAL_RATES];
+    bench_optical_rate_t disc_rates[BENCH_OPTICAL_RATES];
+    check_optical_rates(led_rates, -1);
+    check_optical_rates(disc_rates, BENCH_EMITTER_GPIO);
+    int32_t steady_demand = check_metering();
+#if CONFIG_DEMAND_ESTIMATOR_WINDOW
+    check_demand_window();
+#endif
+    attr_shadow_register(&s_shadow[0], 1, 0x0702, 0x0000, 6);
+    attr_shadow_register(&s_shadow[1], 1, 0x0702, 0x0400, 3);
+
+    const uint32_t n = 200000;
+    double pulse_ns = bench_run(setup_default, work_pulse, n);
+    double bounce_ns = bench_run(setup_default, work_bounce, n);
+    double add_ns = bench_run(setup_default, work_add_only, n / BENCH_BATCH);
+    double batch_ns = bench_run(setup_default, work_batch, n / BENCH_BATCH);
+    double tick_ns = bench_run(setup_default, work_tick, n);
+    double read_ns = bench_run(setup_default, work_counter_read, n);
+    double shadow_ns = bench_run(setup_shadow, work_shadow, n);
+    double lp_ns = bench_run(setup_lp, work_lp_sample, n);
+    double optical_ns = bench_run(setup_optical, work_optical_sample, n);
+
+    printf("demand estimator: %s, steady 3600/h reads %d\n", CONFIG_DEMAND_ESTIMATOR_WINDOW ? "window" : "ema",
+           (int)steady_demand);
+    printf("%-34s %9.1f ns\n", "pulse (press+release, counted)", pulse_ns);
+    printf("%-34s %9.1f ns\n", "edge pair, half bounced", bounce_ns);
+    printf("%-34s %9.1f ns\n", "batch of 8 (count + drain + meter)", batch_ns);
+    printf("%-34s %9.1f ns\n", "  of which drain + meter", batch_ns - add_ns);
+    printf("%-34s %9.1f ns\n", "metering_tick", tick_ns);
+    printf("%-34s %9.1f ns\n", "pulse_counter_total", read_ns);
+    printf("%-34s %9.1f ns\n", "attr shadow set x2 + flush", shadow_ns);
+    printf("%-34s %9.1f ns\n", "lp_pulse_sample (1 input)", lp_ns);
+    printf("%-34s %9.1f ns\n", "optical_pulse_sample", optical_ns);
+    printf("optical input, 1 Hz pulses 2 samples wide (awake = ADC + %d us wake per sample):\n",
+           BENCH_OPTICAL_WAKE_US);
+    printf("  %6s %14s %10s %14s %10s\n", "rate", "LED awake", "LED uA", "emitter awake", "emitter uA");
+    for (size_t i = 0; i < BENCH_OPTICAL_RATES; i++) {
+        printf("  %3u Hz %13.2f%% %10.1f %13.2f%% %10.1f\n", (unsigned)led_rates[i].hz, led_rates[i].awake_pct,
+               led_rates[i].avg_ua, disc_rates[i].awake_pct, disc_rates[i].avg_ua);
+    }
+    return 0;
+}
@@ -0,0 +1,733 @@
+/* End-to-end harness: the whole application (app_main, the Zigbee task and every module it
+ * links) against the fake Zigbee stack in zb/ and the IDF stand-ins in shim/.
+ *
+ * Each scenario runs in its own process, scripts pulses, link outages and OTA offers on the
+ * host clock, runs the Zigbee task until a deadline and then checks what went on air and
+ * what the application did with it: reports per hour within the min/max reporting bounds,
+ * pulse totals that survive into NVS, sleep only after the post-join block and with the
+ * pulse pin idle, no pulse lost or doubled across sleep entry and wake at the fastest rated
+ * input, outages absorbed by the report queue, OTA duration and the final restart.
+ * Exits non-zero on the first failed check. Build and run with `make -C host run`.
+ *
+ * harness_deep is the same file built with DEEP_SLEEP_MODE: one scenario that boots the
+ * application once per deep-sleep wake, carrying RTC memory and NVS between the boots.
+ * harness_strobe runs the light-sleep scenarios with PULSE_PULL_STROBED, where a closed contact
+ * no longer holds the device awake. harness_multi runs them with PULSE_CHANNELS=3 and adds a
+ * scenario that drives every input.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "nvs.h"
+#include "host_shim.h"
+#include "fake_zb.h"
+#include "esp_zigbee_type.h"
+#include "app_config.h"
+#include "report_queue.h"
+#include "sleep_stats.h"
+#include "latency.h"
+#include "energy.h"
+#include "deep_sleep.h"
+#include "pulse.h"
+
+#define HARNESS_US_PER_S 1000000LL
+#define HARNESS_START_US HARNESS_US_PER_S
+#define HARNESS_PULSE_WIDTH_US 30000        /* contact closure of harness_pulses() */
+#define HARNESS_UTC_BASE_S 1760000000u
+#define HARNESS_JOIN_BLOCK_US (30 * HARNESS_US_PER_S)   /* APP_SLEEP_JOIN_BLOCK_US in main.c */
+#define HARNESS_SPARSE_S (2 * 86400)
+/* Deep-sleep costs the ledger cannot see: ROM, bootloader and app start per wake (CPU busy),
+ * and the deep-sleep floor (ESP32-H2 datasheet, RTC timer and LP IO on).
+ */
+#define HARNESS_BOOT_US 150000
+#define HARNESS_DEEP_SLEEP_UA 7
+/* Internal pull-up (about 47 kOhm) through a closed contact at 3.3 V. */
+#define HARNESS_PULLUP_UA 70
+#define HARNESS_HELD_S 3600
+
+#define HARNESS_CHECK(cond)                                                        \
+    do {                                                                           \
+        if (!(cond)) {                                                             \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                               \
+        }                                                                          \
+    } while (0)
+
+void app_main(void);
+
+static int64_t harness_s(double s)
+{
+    return HARNESS_START_US + (int64_t)(s * HARNESS_US_PER_S);
+}
+
+/* A meter that sees a few pulses a day, some in quick pairs (two within one boot, two within
+ * one awake window). Shared by the light-sleep baseline and the deep-sleep run.
+ */
+static const double s_sparse_pulses_s[] = {
+    4000, 4000.2, 21000, 21015, 30000, 44000, 52000, 52040, 68000, 80000,
+    93000, 93000.3, 110000, 125000, 125012, 140000, 150000, 160000, 160000.25, 165000,
+};
+#define HARNESS_SPARSE_PULSES (sizeof(s_sparse_pulses_s) / sizeof(s_sparse_pulses_s[0]))
+
+/* Edges of the sparse script after after_us; returns the pulses whose press is scheduled. */
+static uint32_t harness_sparse_edges(int64_t after_us)
+{
+    uint32_t n = 0;
+    for (size_t i = 0; i < HARNESS_SPARSE_PULSES; i++) {
+        int64_t t = harness_s(s_sparse_pulses_s[i]);
+        if (t > after_us) {
+            host_edge_at(t, CONFIG_PULSE_GPIO, true);
+            n++;
+        }
+        if (t + HARNESS_PULSE_WIDTH_US > after_us) {
+            host_edge_at(t + HARNESS_PULSE_WIDTH_US, CONFIG_PULSE_GPIO, false);
+        }
+    }
+    return n;
+}
+
+#if !CONFIG_DEEP_SLEEP_MODE
+/* One pulse on gpio_num every period_s in [from_s, to_s); returns how many. */
+static uint32_t harness_pulses_on(int gpio_num, double from_s, double to_s, double period_s)
+{
+    uint32_t n = 0;
+    for (double t = from_s; t < to_s; t += period_s) {
+        host_edge_at(harness_s(t), gpio_num, true);
+        host_edge_at(harness_s(t) + HARNESS_PULSE_WIDTH_US, gpio_num, false);
+        n++;
+    }
+    return n;
+}
+
+static uint32_t harness_pulses(double from_s, double to_s, double period_s)
+{
+    return harness_pulses_on(CONFIG_PULSE_GPIO, from_s, to_s, period_s);
+}
+
+/* Pulses in [from_s, to_s): closed for width_us, open for gap_us plus up to jitter_us
+ * (deterministic) so the edges walk across poll, report and sleep-entry deadlines.
+ */
+static uint32_t harness_pulse_train(double from_s, double to_s, int64_t width_us, int64_t gap_us,
+                                    uint32_t jitter_us)
+{
+    uint32_t seed = 12345;
+    uint32_t n = 0;
+    for (int64_t t = harness_s(from_s); t < harness_s(to_s); n++) {
+        host_edge_at(t, CONFIG_PULSE_GPIO, true);
+        host_edge_at(t + width_us, CONFIG_PULSE_GPIO, false);
+        seed = seed * 1103515245u + 12345u;
+        t += width_us + gap_us + (jitter_us ? (seed >> 8) % jitter_us : 0);
+    }
+    return n;
+}
+
+static void harness_boot(const fake_zb_config_t *cfg)
+{
+    host_time_set_us(HARNESS_START_US);
+    fake_zb_init(cfg);
+}
+#endif
+
+static fake_zb_config_t harness_default_config(void)
+{
+    return (fake_zb_config_t){
+        .join_delay_us = 3 * HARNESS_US_PER_S,
+        .response_delay_us = 50000,
+        .utc_base_s = HARNESS_UTC_BASE_S,
+    };
+}
+
+static uint64_t harness_saved_pulses(void)
+{
+    uint64_t total = 0;
+    app_pulse_load_total(0, &total);
+    return total;
+}
+
+typedef struct {
+    uint32_t reports;
+    uint32_t summation;     /* reports carrying CurrentSummationDelivered */
+    uint32_t demand;        /* reports carrying InstantaneousDemand */
+    uint32_t failed;
+    uint64_t air_bytes;
+} harness_window_t;
+
+/* Metering reports of endpoint ep, automatic or explicit, sent in [from_us, to_us). */
+static harness_window_t harness_metering_reports(uint8_t ep, int64_t from_us, int64_t to_us)
+{
+    harness_window_t w = {0};
+    const fake_zb_frame_t *frames;
+    size_t n = fake_zb_frames(&frames);
+    for (size_t i = 0; i < n; i++) {
+        const fake_zb_frame_t *f = &frames[i];
+        if (f->t_us < from_us || f->t_us >= to_us || f->src_endpoint != ep ||
+            f->cluster_id != ESP_ZB_ZCL_CLUSTER_ID_METERING ||
+            (f->kind != FAKE_ZB_FRAME_REPORT && f->kind != FAKE_ZB_FRAME_REPORT_CMD)) {
+            continue;
+        }
+        w.reports++;
+        for (uint8_t a = 0; a < f->attr_count; a++) {
+            w.summation += f->attr_ids[a] == ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID;
+            w.demand += f->attr_ids[a] == ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID;
+        }
+        w.failed += f->delivered ? 0 : 1;
+        w.air_bytes += f->air_bytes;
+    }
+    return w;
+}
+
+/* Time cluster reads sent so far. */
+static uint32_t harness_time_reads(void)
+{
+    const fake_zb_frame_t *frames;
+    size_t n = fake_zb_frames(&frames);
+    uint32_t reads = 0;
+    for (size_t i = 0; i < n; i++) {
+        reads += frames[i].kind == FAKE_ZB_FRAME_READ_ATTR && frames[i].cluster_id == ESP_ZB_ZCL_CLUSTER_ID_TIME;
+    }
+    return reads;
+}
+
+#if !CONFIG_DEEP_SLEEP_MODE
+static uint64_t harness_air_bytes(void)
+{
+    const fake_zb_stats_t *st = fake_zb_stats();
+    uint64_t total = 0;
+    for (int k = 0; k < FAKE_ZB_FRAME_KIND_COUNT; k++) {
+        total += st->air_bytes[k];
+    }
+    return total;
+}
+
+/* Join after one failed steering attempt, the post-join sleep block, and a pulse that wakes
+ * the device from sleep.
+ */
+static void scenario_join_sleep(void)
+{
+    fake_zb_config_t cfg = harness_default_config();
+    cfg.join_failures = 1;
+    harness_boot(&cfg);
+    harness_pulses(60, 61, 1);
+
+    app_main();
+    HARNESS_CHECK(fake_zb_run("zigbee_task", harness_s(120)));
+
+    const fake_zb_stats_t *st = fake_zb_stats();
+    const sleep_stats_t *ss = sleep_stats_get();
+    HARNESS_CHECK(st->steer_attempts == 2);
+    HARNESS_CHECK(st->joined_us > harness_s(2 * cfg.join_delay_us / (double)HARNESS_US_PER_S));
+    HARNESS_CHECK(ss->skips[SLEEP_SKIP_NOT_JOINED] > 0);
+    HARNESS_CHECK(ss->skips[SLEEP_SKIP_POST_JOIN] > 0);
+    /* Strobed, a closed contact is no reason to stay awake. */
+    HARNESS_CHECK(CONFIG_PULSE_PULL_STROBED || ss->skips[SLEEP_SKIP_PIN_ASSERTED] > 0);
+    HARNESS_CHECK(st->first_sleep_us >= st->joined_us + HARNESS_JOIN_BLOCK_US);
+    HARNESS_CHECK(ss->wakes[SLEEP_WAKE_PULSE] == 1);
+    HARNESS_CHECK(harness_saved_pulses() == 1);
+    /* Metering only: no battery reporting on the host. */
+    HARNESS_CHECK(st->frames[FAKE_ZB_FRAME_BIND_REQ] == CONFIG_PULSE_CHANNELS);
+    HARNESS_CHECK(st->frames[FAKE_ZB_FRAME_READ_ATTR] > 0);
+
+    printf("join/sleep: joined at %.1f s after %u attempts, first sleep %.1f s after join, "
+           "%u sleeps (%.1f%% of the run), skips not-joined %u post-join %u pin %u\n",
+           (st->joined_us - HARNESS_START_US) / 1e6, (unsigned)st->steer_attempts,
+           (st->first_sleep_us - st->joined_us) / 1e6, (unsigned)st->sleeps,
+           100.0 * st->slept_us / (harness_s(120) - HARNESS_START_US),
+           (unsigned)ss->skips[SLEEP_SKIP_NOT_JOINED], (unsigned)ss->skips[SLEEP_SKIP_POST_JOIN],
+           (unsigned)ss->skips[SLEEP_SKIP_PIN_ASSERTED]);
+}
+
+/* An hour of steady flow followed by an idle hour: reports per hour against the configured
+ * min/max intervals, and every pulse accounted for.
+ */
+static void scenario_reporting(void)
+{
+    fake_zb_config_t cfg = harness_default_config();
+    harness_boot(&cfg);
+    uint32_t pulses = harness_pulses(60, 3660, 12);
+
+    app_main();
+    HARNESS_CHECK(fake_zb_run("zigbee_task", harness_s(3 * 3600)));
+
+    harness_window_t busy = harness_metering_reports(APP_ZB_ENDPOINT, harness_s(60), harness_s(3660));
+    harness_window_t idle = harness_metering_reports(APP_ZB_ENDPOINT, harness_s(2 * 3600), harness_s(3 * 3600));
+    const fake_zb_stats_t *st = fake_zb_stats();
+    /* Per attribute: no faster than the min interval, no slower than the max interval. */
+    HARNESS_CHECK(busy.summation <= 3600 / CONFIG_ZB_REPORT_MIN_S + 1);
+    HARNESS_CHECK(busy.demand <= 3600 / CONFIG_ZB_REPORT_MIN_S + 1);
+    HARNESS_CHECK(busy.summation >= 3600 / CONFIG_ZB_REPORT_MAX_S);
+    HARNESS_CHECK(idle.summation <= 3600 / CONFIG_ZB_REPORT_MAX_S + 1);
+    HARNESS_CHECK(idle.demand <= 3600 / CONFIG_ZB_REPORT_MAX_S + 1);
+    HARNESS_CHECK(busy.failed == 0 && st->failed == 0);
+    HARNESS_CHECK(harness_saved_pulses() == pulses);
+    HARNESS_CHECK(sleep_stats_get()->wakes[SLEEP_WAKE_PULSE] > 0);
+    HARNESS_CHECK(latency_hist(LATENCY_STAGE_TOTAL)->count == pulses);
+
+    static const char *const stages[LATENCY_STAGE_COUNT] = {"counted", "pickup", "attr", "tx", "total"};
+    printf("latency p50/p99/max ms:");
+    for (unsigned i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        const latency_hist_t *h = latency_hist((latency_stage_t)i);
+        printf(" %s %u/%u/%u", stages[i], (unsigned)latency_percentile_ms(h, 50),
+               (unsigned)latency_percentile_ms(h, 99), (unsigned)(h->max_us / 1000));
+    }
+    printf(" (%u pulses)\n", (unsigned)latency_hist(LATENCY_STAGE_TOTAL)->count);
+    printf("reporting: %u pulses, busy hour %u reports (summation %u, demand %u, %.0f B/pulse on air), "
+           "idle hour %u reports, %u polls, %.1f kB on air in 3 h, asleep %.1f%%\n",
+           (unsigned)pulses, (unsigned)busy.reports, (unsigned)busy.summation, (unsigned)busy.demand,
+           (double)busy.air_bytes / pulses, (unsigned)idle.reports,
+           (unsigned)st->frames[FAKE_ZB_FRAME_POLL], harness_air_bytes() / 1000.0,
+           100.0 * st->slept_us / (harness_s(3 * 3600) - HARNESS_START_US));
+}
+
+/* The fastest input the counter is rated for: every closure at least PULSE_MIN_WIDTH_MS and
+ * every opening at least PULSE_DEBOUNCE_MS. The device sleeps in the openings, so most pulses
+ * are counted at the wake and their release must not count again. Shortest closures, square
+ * wave and long closures in turn; every pulse must reach NVS exactly once.
+ */
+static void scenario_pulse_timing(void)
+{
+    const int64_t min_width_us = CONFIG_PULSE_MIN_WIDTH_MS * 1000LL;
+    const int64_t debounce_us = CONFIG_PULSE_DEBOUNCE_MS * 1000LL;
+    fake_zb_config_t cfg = harness_default_config();
+    harness_boot(&cfg);
+    uint32_t pulses = harness_pulse_train(60, 120, min_width_us, debounce_us, 10000);
+    pulses += harness_pulse_train(150, 210, debounce_us, debounce_us, 10000);
+    pulses += harness_pulse_train(240, 300, 2 * HARNESS_US_PER_S, debounce_us, 500000);
+
+    app_main();
+    HARNESS_CHECK(fake_zb_run("zigbee_task", harness_s(330)));
+
+    const sleep_stats_t *ss = sleep_stats_get();
+    const fake_zb_stats_t *st = fake_zb_stats();
+    HARNESS_CHECK(harness_saved_pulses() == pulses);
+    HARNESS_CHECK(ss->wakes[SLEEP_WAKE_PULSE] > pulses / 2);
+    HARNESS_CHECK(CONFIG_PULSE_PULL_STROBED || ss->skips[SLEEP_SKIP_PIN_ASSERTED] > 0);
+
+    printf("pulse_timing: %u pulses at up to %.1f Hz, %u counted, %u woke the device, %u sleeps, "
+           "%u pin/pending skips\n",
+           (unsigned)pulses, 1e6 / (double)(min_width_us + debounce_us), (unsigned)harness_saved_pulses(),
+           (unsigned)ss->wakes[SLEEP_WAKE_PULSE], (unsigned)st->sleeps,
+           (unsigned)ss->skips[SLEEP_SKIP_PIN_ASSERTED]);
+}
+
+/* Ten minutes without a coordinator in the middle of steady flow: the report queue takes the
+ * link down, keeps snapshots and flushes them once probes get through again.
+ */
+static void scenario_outage(void)
+{
+    fake_zb_config_t cfg = harness_default_config();
+    harness_boot(&cfg);
+    uint32_t pulses = harness_pulses(60, 2400, 20);
+    fake_zb_link_outage(harness_s(600), harness_s(1200));
+
+    app_main();
+    HARNESS_CHECK(fake_zb_run("zigbee_task", harness_s(3600)));
+
+    const report_queue_stats_t *rq = report_queue_stats();
+    const fake_zb_stats_t *st = fake_zb_stats();
+    harness_window_t down = harness_metering_reports(APP_ZB_ENDPOINT, harness_s(600), harness_s(1200));
+    harness_window_t after = harness_metering_reports(APP_ZB_ENDPOINT, harness_s(1200), harness_s(2400));
+    HARNESS_CHECK(rq->outages >= 1);
+    HARNESS_CHECK(rq->queued > 0);
+    HARNESS_CHECK(rq->flushed > 0);
+    HARNESS_CHECK(st->failed > 0);
+    HARNESS_CHECK(after.reports > 0 && after.failed == 0);
+    HARNESS_CHECK(harness_saved_pulses() == pulses);
+
+    printf("outage: %u failed frames (%u metering reports while down), queue outages %u queued %u "
+           "flushed %u dropped %u probes %u\n",
+           (unsigned)st->failed, (unsigned)down.reports, (unsigned)rq->outages, (unsigned)rq->queued,
+           (unsigned)rq->flushed, (unsigned)rq->dropped, (unsigned)rq->probes);
+}
+
+/* A 32 KiB image in 64-byte blocks: everything written, boot partition switched, restart. */
+static void scenario_ota(void)
+{
+    fake_zb_config_t cfg = harness_default_config();
+    harness_boot(&cfg);
+    fake_zb_ota_t ota = {
+        .start_us = harness_s(60),
+        .file_version = CONFIG_ZB_OTA_FILE_VERSION + 1,
+        .manufacturer_code = CONFIG_ZB_MANUFACTURER_CODE,
+        .image_type = CONFIG_ZB_OTA_IMAGE_TYPE,
+        .image_size = 32 * 1024,
+        .block_size = 64,
+        .block_interval_ms = 50,
+    };
+    fake_zb_ota_offer(&ota);
+
+    app_main();
+    HARNESS_CHECK(!fake_zb_run("zigbee_task", harness_s(600)));
+
+    const fake_zb_stats_t *st = fake_zb_stats();
+    const host_ota_stats_t *os = host_ota_stats();
+    uint32_t blocks = (ota.image_size + ota.block_size - 1) / ota.block_size;
+    int64_t per_block_us = (int64_t)ota.block_interval_ms * 1000 + cfg.response_delay_us;
+    int64_t duration_us = st->ota_end_us - st->ota_start_us;
+    HARNESS_CHECK(!st->ota_aborted);
+    HARNESS_CHECK(st->ota_blocks == blocks);
+    HARNESS_CHECK(os->bytes == ota.image_size);
+    HARNESS_CHECK(os->ended && os->boot_set);
+    HARNESS_CHECK(st->restarted && st->restart_us >= st->ota_end_us);
+    HARNESS_CHECK(duration_us >= (int64_t)blocks * per_block_us);
+    HARNESS_CHECK(duration_us <= 2 * (int64_t)blocks * per_block_us);
+
+    printf("ota: %u bytes in %u blocks, %.1f s (%.0f B/s), %u block requests on air, restart at %.1f s\n",
+           (unsigned)os->bytes, (unsigned)st->ota_blocks, duration_us / 1e6, os->bytes / (duration_us / 1e6),
+           (unsigned)st->frames[FAKE_ZB_FRAME_OTA], (st->restart_us - HARNESS_START_US) / 1e6);
+}
+
+/* A meter that stops with its contact closed for an hour between two bursts of flow. With an
+ * always-on pull-up the contact conducts the whole hour and holds the device awake; strobed, it
+ * conducts only for the strobes and the device sleeps between them. Every pulse counts once.
+ * The charge is the pull-up current alone; the strobe wakes show in the sleep share.
+ */
+static void scenario_held(void)
+{
+    fake_zb_config_t cfg = harness_default_config();
+    harness_boot(&cfg);
+    uint32_t pulses = harness_pulses(60, 120, 12);
+    host_edge_at(harness_s(200), CONFIG_PULSE_GPIO, true);
+    host_edge_at(harness_s(200 + HARNESS_HELD_S), CONFIG_PULSE_GPIO, false);
+    pulses++;
+    pulses += harness_pulses(HARNESS_HELD_S + 300, HARNESS_HELD_S + 360, 12);
+
+    app_main();
+    HARNESS_CHECK(fake_zb_run("zigbee_task", harness_s(HARNESS_HELD_S + 400)));
+    double asleep = (double)fake_zb_stats()->slept_us / (harness_s(HARNESS_HELD_S + 400) - HARNESS_START_US);
+
+    int64_t conducting_us = host_gpio_pullup_closed_us(CONFIG_PULSE_GPIO);
+    HARNESS_CHECK(harness_saved_pulses() == pulses);
+    if (CONFIG_PULSE_PULL_STROBED) {
+        HARNESS_CHECK(conducting_us < HARNESS_HELD_S * HARNESS_US_PER_S / 100);
+        /* Each strobe is a wake; at 20 ms, the stack's sleep threshold, about half of every period
+         * is spent awake. The 100 ms default sleeps far longer.
+         */
+        HARNESS_CHECK(asleep > 0.5);
+    } else {
+        HARNESS_CHECK(conducting_us >= HARNESS_HELD_S * HARNESS_US_PER_S);
+        HARNESS_CHECK(asleep < 0.2);
+    }
+    printf("held: %s pull-up, contact closed %d s of %d, asleep %.1f%%, pull-up conducting %.3f s "
+           "(%.3f uAh), %u pulses counted\n",
+           CONFIG_PULSE_PULL_STROBED ? "strobed" : "always-on", HARNESS_HELD_S, HARNESS_HELD_S + 400, 100.0 * asleep,
+           conducting_us / 1e6, conducting_us * (double)HARNESS_PULLUP_UA / 3.6e9,
+           (unsigned)harness_saved_pulses());
+}
+
+/* Light-sleep baseline for harness_deep: two days of the sparse script. */
+static void scenario_sparse(void)
+{
+    fake_zb_config_t cfg = harness_default_config();
+    harness_boot(&cfg);
+    uint32_t pulses = harness_sparse_edges(0);
+
+    app_main();
+    HARNESS_CHECK(fake_zb_run("zigbee_task", harness_s(HARNESS_SPARSE_S)));
+    energy_tick(esp_timer_get_time());
+
+    const fake_zb_stats_t *st = fake_zb_stats();
+    harness_window_t w = harness_metering_reports(APP_ZB_ENDPOINT, 0, INT64_MAX);
+    uint32_t time_reads = harness_time_reads();
+    HARNESS_CHECK(harness_saved_pulses() == pulses);
+    /* One on join, then one per TIME_SYNC_INTERVAL_H once answered. */
+    HARNESS_CHECK(time_reads >= 1 && time_reads <= 1 + HARNESS_SPARSE_S / (CONFIG_TIME_SYNC_INTERVAL_H * 3600));
+    printf("sparse: light sleep, %u pulses in %d h, %u metering reports, %u time reads, %u polls, %.1f kB on air, "
+           "%.0f uAh/day\n",
+           (unsigned)pulses, HARNESS_SPARSE_S / 3600, (unsigned)w.reports, (unsigned)time_reads,
+           (unsigned)st->frames[FAKE_ZB_FRAME_POLL], harness_air_bytes() / 1000.0,
+           energy_get_charge_nah() / 1000.0 / (HARNESS_SPARSE_S / 86400.0));
+}
+
+#if CONFIG_PULSE_CHANNELS > 1
+/* Frames of kind from endpoint ep on cluster_id. */
+static uint32_t harness_frames_from(fake_zb_frame_kind_t kind, uint8_t ep, uint16_t cluster_id)
+{
+    const fake_zb_frame_t *frames;
+    size_t n = fake_zb_frames(&frames);
+    uint32_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += frames[i].kind == kind && frames[i].src_endpoint == ep && frames[i].cluster_id == cluster_id;
+    }
+    return count;
+}
+
+/* Every input at its own rate, the last one idle, for an hour: each channel reports on its own
+ * endpoint, binds its own cluster, answers Get Profile from its endpoint and saves its own
+ * total, channel 0 under the bare NVS key of a single-input device.
+ */
+static void scenario_channels(void)
+{
+    static const int gpios[] = {CONFIG_PULSE_GPIO, CONFIG_PULSE_CH1_GPIO, CONFIG_PULSE_CH2_GPIO};
+    static const double periods_s[] = {12, 30, 0};
+    _Static_assert(sizeof(gpios) / sizeof(gpios[0]) == CONFIG_PULSE_CHANNELS, "one GPIO per channel");
+    fake_zb_config_t cfg = harness_default_config();
+    harness_boot(&cfg);
+    uint32_t pulses[CONFIG_PULSE_CHANNELS] = {0};
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        if (periods_s[i] > 0) {
+            pulses[i] = harness_pulses_on(gpios[i], 60, 3660, periods_s[i]);
+        }
+        fake_zb_get_profile(harness_s(3700), (uint8_t)(APP_ZB_ENDPOINT + i), 4);
+    }
+
+    app_main();
+    HARNESS_CHECK(fake_zb_run("zigbee_task", harness_s(2 * 3600)));
+
+    const fake_zb_stats_t *st = fake_zb_stats();
+    HARNESS_CHECK(st->frames[FAKE_ZB_FRAME_BIND_REQ] == CONFIG_PULSE_CHANNELS);
+    HARNESS_CHECK(st->failed == 0);
+    printf("channels:");
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        uint8_t ep = (uint8_t)(APP_ZB_ENDPOINT + i);
+        harness_window_t w = harness_metering_reports(ep, 0, INT64_MAX);
+        uint64_t saved = 0;
+        app_pulse_load_total((uint8_t)i, &saved);
+        int64_t summation = -1;
+        HARNESS_CHECK(fake_zb_attr_value(ep, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                                         ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID, &summation));
+        HARNESS_CHECK(saved == pulses[i]);
+        HARNESS_CHECK(summation == (int64_t)pulses[i]);
+        HARNESS_CHECK(w.summation >= 3600 / CONFIG_ZB_REPORT_MAX_S);
+        HARNESS_CHECK(harness_frames_from(FAKE_ZB_FRAME_BIND_REQ, ep, ESP_ZB_ZCL_CLUSTER_ID_METERING) == 1);
+        HARNESS_CHECK(harness_frames_from(FAKE_ZB_FRAME_CUSTOM_CMD, ep, ESP_ZB_ZCL_CLUSTER_ID_METERING) == 1);
+        printf(" ep %u %u pulses %u reports,", (unsigned)ep, (unsigned)pulses[i], (unsigned)w.reports);
+    }
+    /* Channel 0 under the bare key; the others with their index appended. */
+    nvs_handle_t nvs;
+    uint64_t value = 0;
+    HARNESS_CHECK(nvs_open(APP_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK);
+    HARNESS_CHECK(nvs_get_u64(nvs, APP_NVS_KEY_PULSES, &value) == ESP_OK && value == pulses[0]);
+    HARNESS_CHECK(nvs_get_u64(nvs, APP_NVS_KEY_PULSES "0", &value) == ESP_ERR_NVS_NOT_FOUND);
+    HARNESS_CHECK(nvs_get_u64(nvs, APP_NVS_KEY_PULSES "1", &value) == ESP_OK && value == pulses[1]);
+    nvs_close(nvs);
+    printf(" %u binds\n", (unsigned)st->frames[FAKE_ZB_FRAME_BIND_REQ]);
+}
+#endif
+#else
+/* State one boot hands to the next, and the totals over all boots. Shared with the children. */
+typedef struct {
+    int64_t now_us;                 /* clock at the next boot */
+    esp_sleep_wakeup_cause_t cause;
+    bool slept;                     /* the previous boot ended in deep sleep */
+    bool commissioned;              /* the device joined in some earlier boot */
+    size_t rtc_len;
+    uint8_t rtc[4096];
+    size_t nvs_len;
+    uint8_t nvs[16384];
+
+    uint32_t boots;
+    uint32_t radio_boots;
+    uint32_t frames;
+    uint32_t summation_reports;
+    uint32_t time_reads;
+    uint32_t rejoins;
+    int64_t rejoin_us;
+    int64_t awake_us;
+    int64_t deep_us;
+    double charge_nah;
+    uint64_t total;
+    uint64_t reported;
+} harness_deep_t;
+
+static harness_deep_t *s_deep;
+static int64_t s_deep_boot_us;
+
+/* Close the boot: account for it, check it and work out the next wake. Runs from
+ * esp_deep_sleep_start() or when the run reaches its end awake.
+ */
+static void harness_deep_boot_end(bool sleeping)
+{
+    harness_deep_t *d = s_deep;
+    int64_t now = esp_timer_get_time();
+    bool radio = host_task_find("zigbee_task") != NULL;
+    const fake_zb_stats_t *st = fake_zb_stats();
+    const deep_sleep_rtc_t *rec = deep_sleep_get();
+    const fake_zb_frame_t *frames;
+    size_t n = fake_zb_frames(&frames);
+
+    energy_tick(now);
+    d->boots++;
+    d->radio_boots += radio;
+    d->frames += n;
+    d->summation_reports += harness_metering_reports(APP_ZB_ENDPOINT, 0, INT64_MAX).summation;
+    d->time_reads += harness_time_reads();
+    d->awake_us += now - s_deep_boot_us;
+    d->charge_nah += energy_get_charge_nah() + HARNESS_BOOT_US * (double)CONFIG_ENERGY_CPU_BUSY_UA / 3.6e6;
+    d->total = rec->total[0];
+    d->reported = rec->reported[0];
+    /* A count-only wake never starts the stack; a resumed one rejoins on its stored channel. */
+    HARNESS_CHECK(radio || n == 0);
+    if (radio && d->commissioned) {
+        HARNESS_CHECK(st->rejoin_channels == 1);
+        HARNESS_CHECK(st->joined_us >= 0);
+        d->rejoins++;
+        d->rejoin_us += st->joined_us - s_deep_boot_us;
+    }
+    if (radio && sleeping) {
+        /* Nothing goes to sleep unconfirmed while the link is up; NVS caught up with RTC. */
+        HARNESS_CHECK(rec->reported[0] == rec->total[0]);
+        HARNESS_CHECK(harness_saved_pulses() == rec->total[0]);
+    }
+    d->commissioned |= st->joined_us >= 0;
+    d->slept = sleeping;
+    HARNESS_CHECK(host_rtc_save(d->rtc, sizeof(d->rtc), &d->rtc_len));
+    HARNESS_CHECK(host_nvs_save(d->nvs, sizeof(d->nvs), &d->nvs_len));
+    if (!sleeping) {
+        d->now_us = now;
+        return;
+    }
+
+    /* EXT1 on the next closure of the contact, else the timer. */
+    int64_t wake = now + (int64_t)host_sleep_timer_us();
+    HARNESS_CHECK(host_sleep_timer_us() > 0);
+    d->cause = ESP_SLEEP_WAKEUP_TIMER;
+    for (size_t i = 0; i < HARNESS_SPARSE_PULSES; i++) {
+        int64_t t = harness_s(s_sparse_pulses_s[i]);
+        if (t > now && t < wake) {
+            wake = t;
+            d->cause = ESP_SLEEP_WAKEUP_EXT1;
+        }
+    }
+    d->deep_us += wake - now;
+    d->charge_nah += (wake - now) * (double)HARNESS_DEEP_SLEEP_UA / 3.6e6;
+    d->now_us = wake;
+}
+
+static void harness_deep_sleep_hook(void)
+{
+    harness_deep_boot_end(true);
+    _exit(0);
+}
+
+/* One boot: restore what survived the deep sleep and run the application until it sleeps
+ * again (the hook exits) or the run ends.
+ */
+static void harness_deep_boot(int64_t end_us)
+{
+    harness_deep_t *d = s_deep;
+    fake_zb_config_t cfg = harness_default_config();
+    cfg.commissioned = d->commissioned;
+    cfg.rejoin_scan_us = HARNESS_US_PER_S;      /* BDB scan duration 6: about 1 s per channel */
+    host_time_set_us(d->now_us);
+    fake_zb_init(&cfg);
+    s_deep_boot_us = d->now_us;
+    if (d->boots > 0) {
+        host_rtc_load(d->rtc, d->rtc_len);
+        host_nvs_load(d->nvs, d->nvs_len);
+    }
+    if (d->slept) {
+        host_set_reset_reason(ESP_RST_DEEPSLEEP);
+        uint64_t ext1 = d->cause == ESP_SLEEP_WAKEUP_EXT1 ? 1ULL << CONFIG_PULSE_GPIO : 0;
+        host_sleep_set_wakeup(d->cause, ext1);
+        /* The closure that woke us is still closed. */
+        host_gpio_set_low(CONFIG_PULSE_GPIO, ext1 != 0);
+    }
+    (void)harness_sparse_edges(d->now_us);
+    host_set_deep_sleep_hook(harness_deep_sleep_hook);
+
+    app_main();
+    HARNESS_CHECK(fake_zb_run("zigbee_task", end_us));
+    harness_deep_boot_end(false);
+}
+
+/* The sparse script with DEEP_SLEEP_MODE: every pulse counted once across count-only and
+ * radio wakes, count-only wakes silent on air, every resumed wake rejoining on one channel and
+ * the coordinator holding the final total.
+ */
+static void scenario_deep_sleep(void)
+{
+    harness_deep_t *d = mmap(NULL, sizeof(*d), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    HARNESS_CHECK(d != MAP_FAILED);
+    memset(d, 0, sizeof(*d));
+    d->now_us = HARNESS_START_US;
+    s_deep = d;
+    const int64_t end_us = harness_s(HARNESS_SPARSE_S);
+
+    while (d->now_us < end_us) {
+        fflush(stdout);
+        pid_t pid = fork();
+        HARNESS_CHECK(pid >= 0);
+        if (pid == 0) {
+            harness_deep_boot(end_us);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        HARNESS_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    uint32_t count_only = d->boots - d->radio_boots;
+    HARNESS_CHECK(d->total == HARNESS_SPARSE_PULSES);
+    HARNESS_CHECK(d->reported == d->total);
+    HARNESS_CHECK(d->rejoins > 0);
+    HARNESS_CHECK(CONFIG_DEEP_SLEEP_REPORT_PULSES == 1 || count_only > 0);
+    /* No wall clock across deep sleep, so no METERING_HISTORY and nothing to sync. */
+    HARNESS_CHECK(!CONFIG_METERING_HISTORY && d->time_reads == 0);
+    printf("deep_sleep: %u pulses in %d h, %u boots (%u radio, %u count-only), %u summation reports, "
+           "%u frames, rejoin %.2f s on 1 channel, awake %.1f s/day, %.0f uAh/day\n",
+           (unsigned)d->total, HARNESS_SPARSE_S / 3600, (unsigned)d->boots, (unsigned)d->radio_boots,
+           (unsigned)count_only, (unsigned)d->summation_reports, (unsigned)d->frames,
+           d->rejoins ? d->rejoin_us / 1e6 / d->rejoins : 0.0,
+           d->awake_us / 1e6 / (HARNESS_SPARSE_S / 86400.0),
+           d->charge_nah / 1000.0 / (HARNESS_SPARSE_S / 86400.0));
+    munmap(d, sizeof(*d));
+}
+#endif
+
+typedef struct {
+    const char *name;
+    void (*fn)(void);
+} harness_scenario_t;
+
+static const harness_scenario_t s_scenarios[] = {
+#if CONFIG_DEEP_SLEEP_MODE
+    {"deep_sleep", scenario_deep_sleep},
+#else
+    {"join_sleep", scenario_join_sleep},
+    {"reporting", scenario_reporting},
+    {"pulse_timing", scenario_pulse_timing},
+    {"outage", scenario_outage},
+    {"ota", scenario_ota},
+    {"held", scenario_held},
+    {"sparse", scenario_sparse},
+#if CONFIG_PULSE_CHANNELS > 1
+    {"channels", scenario_channels},
+#endif
+#endif
+};
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+        const harness_scenario_t *sc = &s_scenarios[i];
+        if (argc > 1 && strcmp(argv[1], sc->name) != 0) {
+            continue;
+        }
+        fflush(stdout);
+        /* The application's state is all static and the task never returns: one process each. */
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            sc->fn();
+            fflush(stdout);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "scenario %s failed\n", sc->name);
+            failed = 1;
+        }
+    }
+    return failed;
+}
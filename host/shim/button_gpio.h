@@ -0,0 +1,13 @@
+#pragma once
+
+#include "iot_button.h"
+
+typedef struct {
+    int32_t gpio_num;
+    uint8_t active_level;
+    bool enable_power_save;
+    bool disable_pull;
+} button_gpio_config_t;
+
+esp_err_t iot_button_new_gpio_device(const button_config_t *button_config, const button_gpio_config_t *gpio_cfg,
+                                     button_handle_t *ret_button);
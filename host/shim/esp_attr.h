@@ -0,0 +1,8 @@
+#pragma once
+
+/* No fast memory on the host. RTC_NOINIT variables share one section so the deep-sleep
+ * harness can carry them from one boot (process) to the next with host_rtc_save()/load().
+ */
+#define RTC_NOINIT_ATTR __attribute__((section("host_rtc_noinit")))
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
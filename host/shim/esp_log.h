@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#endif
+
+/* Errors and warnings go to stderr; info and debug are dropped to keep benchmarks quiet, but
+ * still type-check their arguments so callers do not see them as unused.
+ */
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) do { if (0) { fprintf(stderr, "I %s: " fmt "\n", tag, ##__VA_ARGS__); } } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { if (0) { fprintf(stderr, "D %s: " fmt "\n", tag, ##__VA_ARGS__); } } while (0)
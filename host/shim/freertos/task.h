@@ -0,0 +1,36 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *arg);
+
+/* A task handle is a notification counter on the host. Created tasks are not run: the
+ * Zigbee harness (zb/fake_zb.c) looks its task up by name and runs it as a coroutine on the
+ * host's own stack, so the given stack is never touched.
+ */
+typedef struct {
+    uint32_t notified;
+    TaskFunction_t fn;
+    void *arg;
+    const char *name;
+    uint32_t stack_depth;
+} host_task_t;
+typedef host_task_t *TaskHandle_t;
+typedef host_task_t StaticTask_t;
+typedef uint8_t StackType_t;    /* stack depths are in bytes, as on ESP-IDF */
+
+static inline BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    task->notified++;
+    return pdTRUE;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb);
+/* The host cannot measure stack use: reports the whole stack as unused. */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+/* Advances the host clock, firing button edges and esp_timers that fall due on the way. */
+void vTaskDelay(TickType_t ticks);
+/* Acts on the task host_task_set_current() selected; never blocks. */
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+configRUN_TIME_COUNTER_TYPE ulTaskGetIdleRunTimeCounter(void);
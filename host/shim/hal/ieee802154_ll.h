@@ -0,0 +1,4 @@
+#pragma once
+
+#define IEEE802154_TXPOWER_VALUE_MAX 20
+#define IEEE802154_TXPOWER_VALUE_MIN -24
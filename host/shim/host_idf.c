@@ -0,0 +1,557 @@
+/* IDF and FreeRTOS services the application modules call beyond the core: in-memory NVS,
+ * byte-counting OTA, sleep wake causes, non-blocking queues and task bookkeeping. Only the
+ * Zigbee harness links this; the benchmarks get by with host_shim.c.
+ */
+#include "host_shim.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_ota_ops.h"
+#include "esp_pm.h"
+#include "esp_system.h"
+#include "freertos/queue.h"
+#include "nvs_flash.h"
+
+#define HOST_NVS_ENTRIES 64
+#define HOST_NVS_NS_MAX 16
+#define HOST_TASKS_MAX 4
+
+/* ---- NVS ---- */
+
+typedef struct {
+    char ns[HOST_NVS_NS_MAX];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint8_t *data;
+    size_t len;
+} host_nvs_entry_t;
+
+static host_nvs_entry_t s_nvs[HOST_NVS_ENTRIES];
+static char s_nvs_ns[HOST_NVS_ENTRIES][HOST_NVS_NS_MAX];
+static size_t s_nvs_ns_count;
+static bool s_nvs_ready;
+static host_nvs_stats_t s_nvs_stats;
+
+esp_err_t nvs_flash_init(void)
+{
+    s_nvs_ready = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_deinit(void)
+{
+    s_nvs_ready = false;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    for (size_t i = 0; i < HOST_NVS_ENTRIES; i++) {
+        free(s_nvs[i].data);
+    }
+    memset(s_nvs, 0, sizeof(s_nvs));
+    s_nvs_stats.erases++;
+    return ESP_OK;
+}
+
+/* Handles are 1-based indices into the namespace table. */
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    (void)open_mode;
+    if (!s_nvs_ready) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (!name || strlen(name) >= HOST_NVS_NS_MAX || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < s_nvs_ns_count; i++) {
+        if (strcmp(s_nvs_ns[i], name) == 0) {
+            *out_handle = (nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    if (s_nvs_ns_count == HOST_NVS_ENTRIES) {
+        return ESP_ERR_NO_MEM;
+    }
+    strcpy(s_nvs_ns[s_nvs_ns_count], name);
+    *out_handle = (nvs_handle_t)++s_nvs_ns_count;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    s_nvs_stats.commits++;
+    return ESP_OK;
+}
+
+static host_nvs_entry_t *host_nvs_find(nvs_handle_t handle, const char *key, bool create)
+{
+    if (handle == 0 || handle > s_nvs_ns_count || !key || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return NULL;
+    }
+    const char *ns = s_nvs_ns[handle - 1];
+    host_nvs_entry_t *free_slot = NULL;
+    for (size_t i = 0; i < HOST_NVS_ENTRIES; i++) {
+        host_nvs_entry_t *e = &s_nvs[i];
+        if (!e->data) {
+            free_slot = free_slot ? free_slot : e;
+        } else if (strcmp(e->ns, ns) == 0 && strcmp(e->key, key) == 0) {
+            return e;
+        }
+    }
+    if (!create || !free_slot) {
+        return NULL;
+    }
+    strcpy(free_slot->ns, ns);
+    strcpy(free_slot->key, key);
+    return free_slot;
+}
+
+static esp_err_t host_nvs_set(nvs_handle_t handle, const char *key, const void *value, size_t len)
+{
+    host_nvs_entry_t *e = host_nvs_find(handle, key, true);
+    if (!e) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint8_t *data = malloc(len ? len : 1);
+    if (!data) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(data, value, len);
+    free(e->data);
+    e->data = data;
+    e->len = len;
+    return ESP_OK;
+}
+
+static esp_err_t host_nvs_get(nvs_handle_t handle, const char *key, void *out, size_t len)
+{
+    const host_nvs_entry_t *e = host_nvs_find(handle, key, false);
+    if (!e) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (e->len != len) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out, e->data, len);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_u64(nvs_handle_t handle, const char *key, uint64_t *out_value)
+{
+    return host_nvs_get(handle, key, out_value, sizeof(*out_value));
+}
+
+esp_err_t nvs_set_u64(nvs_handle_t handle, const char *key, uint64_t value)
+{
+    return host_nvs_set(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char *key, int64_t *out_value)
+{
+    return host_nvs_get(handle, key, out_value, sizeof(*out_value));
+}
+
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char *key, int64_t value)
+{
+    return host_nvs_set(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    const host_nvs_entry_t *e = host_nvs_find(handle, key, false);
+    if (!e) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (!out_value) {
+        *length = e->len;
+        return ESP_OK;
+    }
+    if (*length < e->len) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, e->data, e->len);
+    *length = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return host_nvs_set(handle, key, value, length);
+}
+
+const host_nvs_stats_t *host_nvs_stats(void)
+{
+    return &s_nvs_stats;
+}
+
+/* Entries as header + value, back to back. Namespace handles are not kept: nvs_open() hands
+ * them out again by name.
+ */
+typedef struct {
+    char ns[HOST_NVS_NS_MAX];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint32_t len;
+} host_nvs_record_t;
+
+bool host_nvs_save(void *buf, size_t cap, size_t *len)
+{
+    uint8_t *out = buf;
+    size_t used = 0;
+    for (size_t i = 0; i < HOST_NVS_ENTRIES; i++) {
+        const host_nvs_entry_t *e = &s_nvs[i];
+        if (!e->data) {
+            continue;
+        }
+        if (used + sizeof(host_nvs_record_t) + e->len > cap) {
+            return false;
+        }
+        host_nvs_record_t rec = {.len = (uint32_t)e->len};
+        memcpy(rec.ns, e->ns, sizeof(rec.ns));
+        memcpy(rec.key, e->key, sizeof(rec.key));
+        memcpy(&out[used], &rec, sizeof(rec));
+        memcpy(&out[used + sizeof(rec)], e->data, e->len);
+        used += sizeof(rec) + e->len;
+    }
+    *len = used;
+    return true;
+}
+
+void host_nvs_load(const void *buf, size_t len)
+{
+    const uint8_t *in = buf;
+    for (size_t i = 0; i < HOST_NVS_ENTRIES; i++) {
+        free(s_nvs[i].data);
+    }
+    memset(s_nvs, 0, sizeof(s_nvs));
+    size_t pos = 0;
+    for (size_t i = 0; i < HOST_NVS_ENTRIES && pos + sizeof(host_nvs_record_t) <= len; i++) {
+        host_nvs_record_t rec;
+        memcpy(&rec, &in[pos], sizeof(rec));
+        pos += sizeof(rec);
+        if (pos + rec.len > len) {
+            break;
+        }
+        host_nvs_entry_t *e = &s_nvs[i];
+        e->data = malloc(rec.len ? rec.len : 1);
+        if (!e->data) {
+            abort();
+        }
+        memcpy(e->ns, rec.ns, sizeof(e->ns));
+        memcpy(e->key, rec.key, sizeof(e->key));
+        memcpy(e->data, &in[pos], rec.len);
+        e->len = rec.len;
+        pos += rec.len;
+    }
+}
+
+/* ---- OTA ---- */
+
+static const esp_partition_t s_ota_partition = {
+    .label = "ota_1",
+    .address = 0x200000,
+    .size = 0x1C0000,
+};
+static host_ota_stats_t s_ota_stats;
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    (void)start_from;
+    return &s_ota_partition;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    (void)image_size;
+    if (!partition || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ota_stats = (host_ota_stats_t){.begins = s_ota_stats.begins + 1};
+    *out_handle = s_ota_stats.begins;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    if (handle != s_ota_stats.begins || s_ota_stats.ended || !data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ota_stats.bytes + size > s_ota_partition.size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    s_ota_stats.writes++;
+    s_ota_stats.bytes += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    if (handle != s_ota_stats.begins || s_ota_stats.ended) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ota_stats.ended = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    if (partition != &s_ota_partition || !s_ota_stats.ended) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ota_stats.boot_set = true;
+    return ESP_OK;
+}
+
+const host_ota_stats_t *host_ota_stats(void)
+{
+    return &s_ota_stats;
+}
+
+/* ---- sleep, power management, system ---- */
+
+static esp_sleep_wakeup_cause_t s_wake_cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+static uint64_t s_wake_ext1_status;
+static uint64_t s_ext1_mask;
+static uint64_t s_sleep_timer_us;
+static host_restart_hook_t s_restart_hook;
+static host_restart_hook_t s_deep_sleep_hook;
+static esp_reset_reason_t s_reset_reason = ESP_RST_POWERON;
+
+/* Bounds of the RTC_NOINIT_ATTR section, from the linker; absent if nothing uses it. */
+extern uint8_t __start_host_rtc_noinit[] __attribute__((weak));
+extern uint8_t __stop_host_rtc_noinit[] __attribute__((weak));
+
+void host_sleep_set_wakeup(esp_sleep_wakeup_cause_t cause, uint64_t ext1_status)
+{
+    s_wake_cause = cause;
+    s_wake_ext1_status = ext1_status;
+}
+
+uint64_t host_sleep_ext1_mask(void)
+{
+    return s_ext1_mask;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void)
+{
+    return s_wake_cause;
+}
+
+uint32_t esp_sleep_get_wakeup_causes(void)
+{
+    return s_wake_cause == ESP_SLEEP_WAKEUP_UNDEFINED ? 0 : 1u << s_wake_cause;
+}
+
+uint64_t esp_sleep_get_ext1_wakeup_status(void)
+{
+    return s_wake_cause == ESP_SLEEP_WAKEUP_EXT1 ? s_wake_ext1_status : 0;
+}
+
+esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t io_mask, esp_sleep_ext1_wakeup_mode_t level_mode)
+{
+    if (level_mode != ESP_EXT1_WAKEUP_ANY_LOW) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ext1_mask = io_mask;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source)
+{
+    if (source == ESP_SLEEP_WAKEUP_EXT1) {
+        s_ext1_mask = 0;
+    } else if (source == ESP_SLEEP_WAKEUP_TIMER) {
+        s_sleep_timer_us = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us)
+{
+    s_sleep_timer_us = time_in_us;
+    return ESP_OK;
+}
+
+uint64_t host_sleep_timer_us(void)
+{
+    return s_sleep_timer_us;
+}
+
+bool esp_sleep_is_valid_wakeup_gpio(gpio_num_t gpio_num)
+{
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+esp_err_t gpio_sleep_sel_dis(gpio_num_t gpio_num)
+{
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_pm_configure(const void *config)
+{
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void host_set_restart_hook(host_restart_hook_t hook)
+{
+    s_restart_hook = hook;
+}
+
+void esp_restart(void)
+{
+    if (s_restart_hook) {
+        s_restart_hook();
+    }
+    exit(0);
+}
+
+void host_set_deep_sleep_hook(host_restart_hook_t hook)
+{
+    s_deep_sleep_hook = hook;
+}
+
+void esp_deep_sleep_start(void)
+{
+    if (s_deep_sleep_hook) {
+        s_deep_sleep_hook();
+    }
+    exit(0);
+}
+
+void host_set_reset_reason(int reason)
+{
+    s_reset_reason = (esp_reset_reason_t)reason;
+}
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return s_reset_reason;
+}
+
+bool host_rtc_save(void *buf, size_t cap, size_t *len)
+{
+    *len = (size_t)(__stop_host_rtc_noinit - __start_host_rtc_noinit);
+    if (*len > cap) {
+        return false;
+    }
+    memcpy(buf, __start_host_rtc_noinit, *len);
+    return true;
+}
+
+void host_rtc_load(const void *buf, size_t len)
+{
+    if (len == (size_t)(__stop_host_rtc_noinit - __start_host_rtc_noinit)) {
+        memcpy(__start_host_rtc_noinit, buf, len);
+    }
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return 0;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return 0;
+}
+
+/* ---- FreeRTOS ---- */
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buf)
+{
+    *buf = (StaticQueue_t){.items = storage, .length = length, .item_size = item_size};
+    return buf;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (queue->count == queue->length) {
+        return pdFALSE;
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+    queue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (queue->count == 0) {
+        return pdFALSE;
+    }
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+static host_task_t *s_tasks[HOST_TASKS_MAX];
+static size_t s_task_count;
+static TaskHandle_t s_current_task;
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb)
+{
+    (void)priority;
+    (void)stack;
+    if (s_task_count == HOST_TASKS_MAX) {
+        return NULL;
+    }
+    *tcb = (host_task_t){.fn = fn, .arg = arg, .name = name, .stack_depth = stack_depth};
+    s_tasks[s_task_count++] = tcb;
+    return tcb;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return task ? task->stack_depth : 0;
+}
+
+TaskHandle_t host_task_find(const char *name)
+{
+    for (size_t i = 0; i < s_task_count; i++) {
+        if (strcmp(s_tasks[i]->name, name) == 0) {
+            return s_tasks[i];
+        }
+    }
+    return NULL;
+}
+
+void host_task_set_current(TaskHandle_t task)
+{
+    s_current_task = task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    host_irq_run_until(esp_timer_get_time() + (int64_t)ticks * portTICK_PERIOD_MS * 1000LL);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (!s_current_task) {
+        return 0;
+    }
+    uint32_t value = s_current_task->notified;
+    if (clear_on_exit) {
+        s_current_task->notified = 0;
+    } else if (value) {
+        s_current_task->notified--;
+    }
+    return value;
+}
+
+configRUN_TIME_COUNTER_TYPE ulTaskGetIdleRunTimeCounter(void)
+{
+    return 0;
+}
@@ -0,0 +1,542 @@
+#include "host_shim.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "button_gpio.h"
+#include "driver/gpio.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_rom_sys.h"
+
+#define HOST_BUTTONS_MAX 16
+#define HOST_TIMERS_MAX 8
+
+struct host_button {
+    int gpio_num;
+    button_cb_t cb[BUTTON_EVENT_MAX];
+    void *usr_data[BUTTON_EVENT_MAX];
+};
+
+static int64_t s_now_us;
+static struct host_button s_buttons[HOST_BUTTONS_MAX];
+static size_t s_button_count;
+static bool s_buttons_stopped;
+static uint32_t s_gpio_low;         /* contacts closed */
+
+/* Pad state behind the gpio driver calls: pulls, the level interrupt, and how long each contact
+ * has been closed with its pull-up on (the current a reed input costs).
+ */
+typedef struct {
+    gpio_pull_mode_t pull;          /* zero: GPIO_PULLUP_ONLY, the iot_button default */
+    gpio_int_type_t intr_type;
+    bool intr_enabled;
+    gpio_isr_t isr;
+    void *isr_arg;
+    bool pullup_closed;
+    int64_t pullup_closed_since_us;
+    int64_t pullup_closed_us;
+    bool out_high;
+} host_pin_t;
+
+static host_pin_t s_pins[GPIO_NUM_MAX];
+static bool s_isr_service;
+
+struct host_timer {
+    esp_timer_create_args_t args;
+    bool armed;
+    int64_t deadline_us;
+    int64_t period_us;              /* 0: one-shot */
+};
+
+struct host_adc_unit {
+    adc_unit_t unit;
+    uint16_t configured;            /* channels set up by adc_oneshot_config_channel() */
+};
+
+static struct host_adc_unit s_adc_units[2];
+static bool s_adc_claimed[2];
+static host_adc_source_t s_adc_source;
+static void *s_adc_source_arg;
+
+static struct host_timer s_timers[HOST_TIMERS_MAX];
+static size_t s_timer_count;
+
+/* Scheduled edges, sorted by time; s_edge_head is the next one due. */
+typedef struct {
+    int64_t t_us;
+    int gpio_num;
+    bool pressed;
+} host_edge_t;
+
+static host_edge_t *s_edges;
+static size_t s_edge_head;
+static size_t s_edge_count;
+static size_t s_edge_cap;
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+void host_time_set_us(int64_t now_us)
+{
+    s_now_us = now_us;
+}
+
+void host_time_advance_us(int64_t delta_us)
+{
+    s_now_us += delta_us;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "ESP_ERR";
+    }
+}
+
+esp_err_t iot_button_new_gpio_device(const button_config_t *button_config, const button_gpio_config_t *gpio_cfg,
+                                     button_handle_t *ret_button)
+{
+    (void)button_config;
+    if (s_button_count == HOST_BUTTONS_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    struct host_button *b = &s_buttons[s_button_count++];
+    *b = (struct host_button){.gpio_num = (int)gpio_cfg->gpio_num};
+    *ret_button = b;
+    return ESP_OK;
+}
+
+esp_err_t iot_button_register_cb(button_handle_t btn, button_event_t event, button_event_args_t *event_args,
+                                 button_cb_t cb, void *usr_data)
+{
+    (void)event_args;
+    if (!btn || event >= BUTTON_EVENT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    btn->cb[event] = cb;
+    btn->usr_data[event] = usr_data;
+    return ESP_OK;
+}
+
+esp_err_t iot_button_stop(void)
+{
+    s_buttons_stopped = true;
+    return ESP_OK;
+}
+
+esp_err_t iot_button_resume(void)
+{
+    s_buttons_stopped = false;
+    return ESP_OK;
+}
+
+static bool host_pin_valid(int gpio_num)
+{
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+/* Restart or stop the pull-up-through-contact clock after a contact or pull change. */
+static void host_pin_account(int gpio_num)
+{
+    host_pin_t *pin = &s_pins[gpio_num];
+    bool up = pin->pull == GPIO_PULLUP_ONLY || pin->pull == GPIO_PULLUP_PULLDOWN;
+    bool on = up && (s_gpio_low & (1u << gpio_num));
+    if (on == pin->pullup_closed) {
+        return;
+    }
+    if (on) {
+        pin->pullup_closed_since_us = s_now_us;
+    } else {
+        pin->pullup_closed_us += s_now_us - pin->pullup_closed_since_us;
+    }
+    pin->pullup_closed = on;
+}
+
+/* A level-low interrupt fires whenever it is enabled and the pad reads low. */
+static void host_pin_irq(int gpio_num)
+{
+    host_pin_t *pin = &s_pins[gpio_num];
+    if (pin->isr && pin->intr_enabled && pin->intr_type == GPIO_INTR_LOW_LEVEL && gpio_get_level(gpio_num) == 0) {
+        pin->isr(pin->isr_arg);
+    }
+}
+
+static void host_contact_set(int gpio_num, bool closed)
+{
+    if (closed) {
+        s_gpio_low |= 1u << gpio_num;
+    } else {
+        s_gpio_low &= ~(1u << gpio_num);
+    }
+    host_pin_account(gpio_num);
+}
+
+bool host_button_edge(int gpio_num, bool pressed)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return false;
+    }
+    host_contact_set(gpio_num, pressed);
+    bool seen = s_pins[gpio_num].isr != NULL;
+    host_pin_irq(gpio_num);
+    for (size_t i = 0; i < s_button_count; i++) {
+        struct host_button *b = &s_buttons[i];
+        if (b->gpio_num != gpio_num) {
+            continue;
+        }
+        button_event_t event = pressed ? BUTTON_PRESS_DOWN : BUTTON_PRESS_UP;
+        if (!s_buttons_stopped && b->cb[event]) {
+            b->cb[event](b, b->usr_data[event]);
+        }
+        return true;
+    }
+    return seen;
+}
+
+void host_button_reset(void)
+{
+    s_button_count = 0;
+    s_buttons_stopped = false;
+    s_gpio_low = 0;
+    memset(s_pins, 0, sizeof(s_pins));
+    s_isr_service = false;
+}
+
+void host_gpio_set_low(int gpio_num, bool low)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return;
+    }
+    host_contact_set(gpio_num, low);
+}
+
+int64_t host_gpio_pullup_closed_us(int gpio_num)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return 0;
+    }
+    const host_pin_t *pin = &s_pins[gpio_num];
+    return pin->pullup_closed_us + (pin->pullup_closed ? s_now_us - pin->pullup_closed_since_us : 0);
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return 0;
+    }
+    /* Pulled down only, the pad reads low whatever the contact does. */
+    bool low = (s_gpio_low & (1u << gpio_num)) || s_pins[gpio_num].pull == GPIO_PULLDOWN_ONLY;
+    return low ? 0 : 1;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].pull = pull;
+    host_pin_account(gpio_num);
+    host_pin_irq(gpio_num);
+    return ESP_OK;
+}
+
+esp_err_t gpio_pullup_en(gpio_num_t gpio_num)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_pull_mode_t pull = s_pins[gpio_num].pull;
+    bool down = pull == GPIO_PULLDOWN_ONLY || pull == GPIO_PULLUP_PULLDOWN;
+    return gpio_set_pull_mode(gpio_num, down ? GPIO_PULLUP_PULLDOWN : GPIO_PULLUP_ONLY);
+}
+
+esp_err_t gpio_pulldown_dis(gpio_num_t gpio_num)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_pull_mode_t pull = s_pins[gpio_num].pull;
+    bool up = pull == GPIO_PULLUP_ONLY || pull == GPIO_PULLUP_PULLDOWN;
+    return gpio_set_pull_mode(gpio_num, up ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    if (!cfg || cfg->pin_bit_mask == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int gpio = 0; gpio < GPIO_NUM_MAX; gpio++) {
+        if (!(cfg->pin_bit_mask & (1ULL << gpio))) {
+            continue;
+        }
+        host_pin_t *pin = &s_pins[gpio];
+        bool up = cfg->pull_up_en == GPIO_PULLUP_ENABLE;
+        bool down = cfg->pull_down_en == GPIO_PULLDOWN_ENABLE;
+        pin->pull = up ? (down ? GPIO_PULLUP_PULLDOWN : GPIO_PULLUP_ONLY) : (down ? GPIO_PULLDOWN_ONLY : GPIO_FLOATING);
+        pin->intr_type = cfg->intr_type;
+        pin->intr_enabled = cfg->intr_type != GPIO_INTR_DISABLE;
+        host_pin_account(gpio);
+        host_pin_irq(gpio);
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].out_high = level != 0;
+    return ESP_OK;
+}
+
+int host_gpio_out_level(int gpio_num)
+{
+    return host_pin_valid(gpio_num) && s_pins[gpio_num].out_high ? 1 : 0;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    (void)intr_alloc_flags;
+    if (s_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_isr_service = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    if (!s_isr_service || !host_pin_valid(gpio_num)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_pins[gpio_num].isr = isr_handler;
+    s_pins[gpio_num].isr_arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].intr_enabled = true;
+    host_pin_irq(gpio_num);
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    if (!host_pin_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].intr_enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_timer_count == HOST_TIMERS_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    struct host_timer *t = &s_timers[s_timer_count++];
+    *t = (struct host_timer){.args = *create_args};
+    *out_handle = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = true;
+    timer->deadline_us = s_now_us + (int64_t)timeout_us;
+    timer->period_us = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    if (!timer || period == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = true;
+    timer->deadline_us = s_now_us + (int64_t)period;
+    timer->period_us = (int64_t)period;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = false;
+    return ESP_OK;
+}
+
+void host_edge_at(int64_t t_us, int gpio_num, bool pressed)
+{
+    if (s_edge_head > 0 && s_edge_head == s_edge_count) {
+        s_edge_head = 0;
+        s_edge_count = 0;
+    }
+    if (s_edge_count == s_edge_cap) {
+        s_edge_cap = s_edge_cap ? 2 * s_edge_cap : 256;
+        s_edges = realloc(s_edges, s_edge_cap * sizeof(*s_edges));
+        if (!s_edges) {
+            abort();
+        }
+    }
+    /* Traces are scheduled in order, so this is almost always an append. */
+    size_t i = s_edge_count;
+    while (i > s_edge_head && s_edges[i - 1].t_us > t_us) {
+        i--;
+    }
+    memmove(&s_edges[i + 1], &s_edges[i], (s_edge_count - i) * sizeof(*s_edges));
+    s_edges[i] = (host_edge_t){.t_us = t_us, .gpio_num = gpio_num, .pressed = pressed};
+    s_edge_count++;
+}
+
+static struct host_timer *host_timer_next(void)
+{
+    struct host_timer *next = NULL;
+    for (size_t i = 0; i < s_timer_count; i++) {
+        struct host_timer *t = &s_timers[i];
+        if (t->armed && (!next || t->deadline_us < next->deadline_us)) {
+            next = t;
+        }
+    }
+    return next;
+}
+
+bool host_irq_peek(host_irq_t *out)
+{
+    struct host_timer *t = host_timer_next();
+    bool edge = s_edge_head < s_edge_count;
+    if (!t && !edge) {
+        return false;
+    }
+    if (t && (!edge || t->deadline_us <= s_edges[s_edge_head].t_us)) {
+        *out = (host_irq_t){.t_us = t->deadline_us, .timer = true, .gpio_num = -1};
+    } else {
+        const host_edge_t *e = &s_edges[s_edge_head];
+        *out = (host_irq_t){.t_us = e->t_us, .gpio_num = e->gpio_num, .pressed = e->pressed};
+    }
+    return true;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    host_time_advance_us(us);
+}
+
+void host_adc_set_source(host_adc_source_t fn, void *arg)
+{
+    s_adc_source = fn;
+    s_adc_source_arg = arg;
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config, adc_oneshot_unit_handle_t *ret_unit)
+{
+    if (!init_config || !ret_unit || init_config->unit_id > ADC_UNIT_2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_adc_claimed[init_config->unit_id]) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_adc_claimed[init_config->unit_id] = true;
+    struct host_adc_unit *u = &s_adc_units[init_config->unit_id];
+    *u = (struct host_adc_unit){.unit = init_config->unit_id};
+    *ret_unit = u;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel,
+                                     const adc_oneshot_chan_cfg_t *config)
+{
+    if (!handle || !config || channel < 0 || channel >= 16) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->configured |= 1u << channel;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw)
+{
+    if (!handle || !out_raw || chan < 0 || chan >= 16 || !(handle->configured & (1u << chan))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_raw = s_adc_source ? s_adc_source(chan, s_adc_source_arg) : 0;
+    host_time_advance_us(HOST_ADC_READ_US);
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_io_to_channel(int io_num, adc_unit_t *unit_id, adc_channel_t *channel)
+{
+    if (!unit_id || !channel || io_num < 0 || io_num > 6) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *unit_id = ADC_UNIT_1;
+    *channel = io_num;
+    return ESP_OK;
+}
+
+void host_irq_run_until(int64_t t_us)
+{
+    host_irq_t irq;
+    while (host_irq_peek(&irq) && irq.t_us <= t_us) {
+        if (irq.t_us > s_now_us) {
+            s_now_us = irq.t_us;
+        }
+        if (irq.timer) {
+            struct host_timer *t = host_timer_next();
+            if (t->period_us) {
+                t->deadline_us += t->period_us;
+            } else {
+                t->armed = false;
+            }
+            t->args.callback(t->args.arg);
+        } else {
+            s_edge_head++;
+            (void)host_button_edge(irq.gpio_num, irq.pressed);
+        }
+    }
+    if (t_us > s_now_us) {
+        s_now_us = t_us;
+    }
+}
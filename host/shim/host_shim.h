@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/task.h"
+#include "esp_sleep.h"
+
+/* Host-side controls for the shims: the clock esp_timer_get_time() returns and the
+ * contacts behind the iot_button devices.
+ */
+void host_time_set_us(int64_t now_us);
+void host_time_advance_us(int64_t delta_us);
+
+/* Drive the contact on gpio_num: pressed=true delivers BUTTON_PRESS_DOWN, false BUTTON_PRESS_UP
+ * (both only while buttons are resumed) and runs an enabled level interrupt on the pin.
+ * Contacts are active-low, so the pin also reads 0 through gpio_get_level() while pressed.
+ * Returns false if neither a button nor an interrupt handler uses that GPIO.
+ */
+bool host_button_edge(int gpio_num, bool pressed);
+/* Forget all buttons (between independent scenarios). */
+void host_button_reset(void);
+/* Set the level gpio_get_level() reads without any button event, e.g. a contact already closed
+ * when the device boots.
+ */
+void host_gpio_set_low(int gpio_num, bool low);
+/* Time the contact on gpio_num has been closed with its pull-up on, i.e. conducting. */
+int64_t host_gpio_pullup_closed_us(int gpio_num);
+/* Level last written with gpio_set_level(). */
+int host_gpio_out_level(int gpio_num);
+
+/* Source of adc_oneshot_read() readings: fn(channel, arg) at the current host time. Without one
+ * every reading is 0. Each reading advances the clock by HOST_ADC_READ_US.
+ */
+#define HOST_ADC_READ_US 20
+typedef int (*host_adc_source_t)(int channel, void *arg);
+void host_adc_set_source(host_adc_source_t fn, void *arg);
+
+/* Interrupt-level events on the host clock: button edges scheduled ahead of time and armed
+ * esp_timers. They fire in time order as the clock is moved by host_irq_run_until(), which
+ * vTaskDelay() and the fake Zigbee stack's sleep use.
+ */
+typedef struct {
+    int64_t t_us;
+    bool timer;             /* esp_timer deadline, else a button edge */
+    int gpio_num;
+    bool pressed;
+} host_irq_t;
+
+void host_edge_at(int64_t t_us, int gpio_num, bool pressed);
+/* Earliest pending event; false if there is none. */
+bool host_irq_peek(host_irq_t *out);
+/* Fire everything due up to t_us, each at its own time, and leave the clock at t_us. */
+void host_irq_run_until(int64_t t_us);
+
+/* Task whose notifications ulTaskNotifyTake() consumes. */
+void host_task_set_current(TaskHandle_t task);
+TaskHandle_t host_task_find(const char *name);
+
+/* Wake cause esp_sleep_get_wakeup_cause() reports after the next sleep. */
+void host_sleep_set_wakeup(esp_sleep_wakeup_cause_t cause, uint64_t ext1_status);
+uint64_t host_sleep_ext1_mask(void);
+
+/* Duration esp_sleep_enable_timer_wakeup() armed, 0 if none. */
+uint64_t host_sleep_timer_us(void);
+
+typedef void (*host_restart_hook_t)(void);
+void host_set_restart_hook(host_restart_hook_t hook);
+/* esp_deep_sleep_start() calls this; it must not return. */
+void host_set_deep_sleep_hook(host_restart_hook_t hook);
+/* What esp_reset_reason() reports; ESP_RST_POWERON unless set. */
+void host_set_reset_reason(int reason);
+
+/* Deep sleep across processes: copy every RTC_NOINIT_ATTR variable, or the whole in-memory NVS,
+ * into buf and back in the next boot. Save returns false if cap is too small.
+ */
+bool host_rtc_save(void *buf, size_t cap, size_t *len);
+void host_rtc_load(const void *buf, size_t len);
+bool host_nvs_save(void *buf, size_t cap, size_t *len);
+void host_nvs_load(const void *buf, size_t len);
+
+typedef struct {
+    uint32_t begins;
+    uint32_t writes;
+    uint64_t bytes;
+    bool ended;
+    bool boot_set;
+} host_ota_stats_t;
+
+const host_ota_stats_t *host_ota_stats(void);
+
+typedef struct {
+    uint32_t commits;
+    uint32_t erases;
+} host_nvs_stats_t;
+
+const host_nvs_stats_t *host_nvs_stats(void);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* Subset of espressif/button used by the core. Buttons are driven by host_button_edge(). */
+typedef struct host_button *button_handle_t;
+
+typedef enum {
+    BUTTON_PRESS_DOWN = 0,
+    BUTTON_PRESS_UP,
+    BUTTON_LONG_PRESS_START,
+    BUTTON_EVENT_MAX,
+} button_event_t;
+
+typedef struct {
+    uint16_t long_press_time;
+    uint16_t short_press_time;
+} button_config_t;
+
+typedef union {
+    struct {
+        uint16_t press_time;
+    } long_press;
+} button_event_args_t;
+
+typedef void (*button_cb_t)(void *button_handle, void *usr_data);
+
+esp_err_t iot_button_register_cb(button_handle_t btn, button_event_t event, button_event_args_t *event_args,
+                                 button_cb_t cb, void *usr_data);
+esp_err_t iot_button_stop(void);
+esp_err_t iot_button_resume(void);
@@ -0,0 +1,78 @@
+#pragma once
+
+/* Host build: Kconfig defaults of the options the core modules read. */
+#ifndef CONFIG_PULSE_CHANNELS
+#define CONFIG_PULSE_CHANNELS 1
+#endif
+#define CONFIG_PULSE_GPIO 10
+#define CONFIG_PULSE_DEBOUNCE_MS 50
+#define CONFIG_PULSE_MIN_WIDTH_MS 20
+#define CONFIG_PULSE_PER_UNIT_NUMERATOR 1000
+#define CONFIG_DEMAND_ESTIMATOR_EMA 1
+#define CONFIG_DEMAND_DECAY_TAU_S 60
+#define CONFIG_DEMAND_IDLE_TIMEOUT_S 30
+#define CONFIG_DEMAND_RISE_TAU_S 10
+#define CONFIG_DEMAND_WINDOW_S 300
+#define CONFIG_DEMAND_WINDOW_PULSES 8
+#if !CONFIG_DEEP_SLEEP_MODE
+#define CONFIG_METERING_HISTORY 1
+#endif
+#define CONFIG_METERING_PROFILE_INTERVAL_MIN 60
+#define CONFIG_METERING_PROFILE_PERIODS 168
+#define CONFIG_ZB_VARIANT_ELECTRIC 1
+#define CONFIG_ZB_MANUFACTURER_CODE 0x1234
+#define CONFIG_ZB_MFG_CLUSTER_ID 0xFD10
+#define CONFIG_ZB_ENDPOINT 1
+#define CONFIG_PULSE_SAVE_INTERVAL_S 60
+#define CONFIG_PULSE_SAVE_QUIET_S 5
+#define CONFIG_ZB_REPORT_MIN_S 10
+#define CONFIG_ZB_REPORT_MAX_S 300
+#define CONFIG_ZB_REPORTABLE_CHANGE 1
+#define CONFIG_ZB_KEEP_ALIVE_MS 60000
+#define CONFIG_METERING_PROFILE_SAVE_H 6
+#define CONFIG_TIME_SYNC_INTERVAL_H 24
+#define CONFIG_ENERGY_SLEEP_UA 240
+#define CONFIG_ENERGY_CPU_BUSY_UA 8000
+#define CONFIG_ENERGY_RX_UA 11000
+#define CONFIG_ENERGY_TX_UA 28000
+#define CONFIG_ENERGY_FLASH_UA 15000
+#define CONFIG_ENERGY_RX_POLL_US 8000
+#define CONFIG_ENERGY_TX_FRAME_US 4000
+
+/* Application options the Zigbee harness adds on top (main.c and its modules). Battery ADC,
+ * CPU statistics and tokenized logging stay off: the host has no ADC, idle counter or console.
+ */
+#define CONFIG_SLEEPY_END_DEVICE 1
+#define CONFIG_SLEEP_WAKE_LOG 0
+#define CONFIG_APP_LOG_TOKENIZED 0
+#define CONFIG_FACTORY_RESET_BUTTON_GPIO 11
+#define CONFIG_ZB_DEVICE_ID 0x7777
+#define CONFIG_ZB_REPORT_DST_SHORT_ADDR 0x0000
+#define CONFIG_ZB_REPORT_DST_ENDPOINT 1
+#define CONFIG_ZB_CHANNEL_MASK 0x07FFF800
+#define CONFIG_ZB_SECONDARY_CHANNEL_MASK 0x0
+#define CONFIG_ZB_MIN_JOIN_LQI 0
+#define CONFIG_ZB_BDB_SCAN_DURATION 6
+#define CONFIG_ZB_OTA_FILE_VERSION 0x00000002
+#define CONFIG_ZB_OTA_IMAGE_TYPE 0x0001
+#define CONFIG_REPORT_QUEUE_FAIL_LIMIT 3
+#define CONFIG_REPORT_QUEUE_PROBE_S 120
+#define CONFIG_REPORT_QUEUE_PROBE_MAX_S 1800
+#define CONFIG_ENERGY_AWAKE_IDLE_UA 3000
+#define CONFIG_ENERGY_ADC_UA 1500
+#define CONFIG_ZIGBEE_TASK_STACK_SIZE 6144
+#define CONFIG_ZB_SED_TABLE_SIZES 1
+#define CONFIG_ZB_NWK_TABLE_SIZE 16
+#define CONFIG_ZB_IO_BUFFER_SIZE 32
+#define CONFIG_ZB_SCHED_QUEUE_SIZE 32
+#define CONFIG_ZB_BINDING_TABLE_SIZE 8
+
+/* Extra pulse channels of harness_multi (PULSE_CHANNELS=3), Kconfig defaults. */
+#define CONFIG_PULSE_CH1_GPIO 12
+#define CONFIG_PULSE_CH1_DEBOUNCE_MS 50
+#define CONFIG_PULSE_CH1_PER_UNIT_NUMERATOR 1000
+#define CONFIG_PULSE_CH1_DEVICE_TYPE 2
+#define CONFIG_PULSE_CH2_GPIO 13
+#define CONFIG_PULSE_CH2_DEBOUNCE_MS 50
+#define CONFIG_PULSE_CH2_PER_UNIT_NUMERATOR 1000
+#define CONFIG_PULSE_CH2_DEVICE_TYPE 2
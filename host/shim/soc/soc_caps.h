@@ -0,0 +1,5 @@
+#pragma once
+
+/* No RTC IO matrix or RTC peripheral power domain on the host: the deep-sleep pad setup takes
+ * the plain GPIO path.
+ */
@@ -0,0 +1,610 @@
+/* Discrete-event energy and airtime simulator of a sleepy pulse meter.
+ *
+ * Replays a pulse trace through the firmware's metering (demand, profile), pulse counter,
+ * NVS save scheduler and energy ledger, and models around them what the Zigbee stack does
+ * on its own: parent polls every keep-alive, attribute reports by min/max interval and
+ * reportable change, and the wakes these cause. Runs two configurations over the same trace
+ * and prints them side by side.
+ *
+ *   sim [-a key=value]... [-b key=value]... [-d days] (-g days | trace.csv)
+ *
+ * The trace has one pulse per line, first column the time in seconds (any epoch, fractions
+ * allowed); lines that do not start with a number are skipped. -g generates a synthetic
+ * household trace instead. -d repeats the trace in whole days until the duration is covered.
+ * Demand estimator and taus are build-time options: compare them with sim vs sim_window.
+ */
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_shim.h"
+#include "energy.h"
+#include "metering.h"
+#include "pulse_counter.h"
+#include "save_sched.h"
+
+#define SIM_US_PER_S 1000000LL
+#define SIM_US_PER_DAY (86400LL * SIM_US_PER_S)
+/* Pulse timestamps of 0 mean "none" to the meter; start the clock a second in. */
+#define SIM_START_US SIM_US_PER_S
+#define SIM_DEMAND_TICK_US SIM_US_PER_S
+
+/* Bytes the device puts on air per frame, PHY header included. A secured unicast ZCL frame:
+ * PHY 6, MAC 9 + FCS 2, NWK 8 + auxiliary header 14 + MIC 4, APS 8, ZCL 3.
+ */
+#define SIM_ZCL_FRAME_BYTES 54
+#define SIM_ATTR_RECORD_BYTES 3          /* attribute ID and type ahead of the value */
+#define SIM_SUMMATION_BYTES 6
+#define SIM_DEMAND_BYTES 3
+#define SIM_READ_ATTR_BYTES 4            /* Time: read Time and TimeStatus */
+#define SIM_POLL_BYTES 18                /* MAC data request */
+
+typedef struct {
+    int64_t report_min_s;
+    int64_t report_max_s;
+    int64_t report_change;
+    int64_t save_interval_s;
+    int64_t save_quiet_s;
+    int64_t keep_alive_ms;
+    int64_t profile_save_h;
+    int64_t time_sync_h;
+    int64_t debounce_ms;
+    int64_t pulses_per_unit;
+    int64_t awake_us;
+    int64_t rx_poll_us;
+    int64_t tx_frame_us;
+    int64_t flash_write_us;
+    int64_t sleep_ua;
+    int64_t busy_ua;
+    int64_t rx_ua;
+    int64_t tx_ua;
+    int64_t flash_ua;
+} sim_cfg_t;
+
+typedef struct {
+    const char *name;
+    size_t offset;
+    const char *help;
+} sim_key_t;
+
+#define SIM_KEY(field, help) {#field, offsetof(sim_cfg_t, field), help}
+
+static const sim_key_t s_keys[] = {
+    SIM_KEY(report_min_s, "report min interval"),
+    SIM_KEY(report_max_s, "report max interval"),
+    SIM_KEY(report_change, "reportable change, summation and demand"),
+    SIM_KEY(save_interval_s, "PULSE_SAVE_INTERVAL_S"),
+    SIM_KEY(save_quiet_s, "PULSE_SAVE_QUIET_S"),
+    SIM_KEY(keep_alive_ms, "parent poll interval"),
+    SIM_KEY(profile_save_h, "load profile flash mirror period"),
+    SIM_KEY(time_sync_h, "Time cluster read period"),
+    SIM_KEY(debounce_ms, "pulse debounce"),
+    SIM_KEY(pulses_per_unit, "pulses per kWh/m3"),
+    SIM_KEY(awake_us, "CPU time per wake"),
+    SIM_KEY(rx_poll_us, "receiver time per poll"),
+    SIM_KEY(tx_frame_us, "radio time per frame"),
+    SIM_KEY(flash_write_us, "time per NVS commit"),
+    SIM_KEY(sleep_ua, "light-sleep current"),
+    SIM_KEY(busy_ua, "awake current"),
+    SIM_KEY(rx_ua, "RX current"),
+    SIM_KEY(tx_ua, "TX current"),
+    SIM_KEY(flash_ua, "flash write current"),
+};
+
+#define SIM_KEY_COUNT (sizeof(s_keys) / sizeof(s_keys[0]))
+
+/* Kconfig defaults, plus assumed (not measured) wake and NVS commit times for what Kconfig does
+ * not cover. Override them with -a/-b awake_us=... flash_write_us=... for a given board.
+ */
+static const sim_cfg_t s_default_cfg = {
+    .report_min_s = CONFIG_ZB_REPORT_MIN_S,
+    .report_max_s = CONFIG_ZB_REPORT_MAX_S,
+    .report_change = CONFIG_ZB_REPORTABLE_CHANGE,
+    .save_interval_s = CONFIG_PULSE_SAVE_INTERVAL_S,
+    .save_quiet_s = CONFIG_PULSE_SAVE_QUIET_S,
+    .keep_alive_ms = CONFIG_ZB_KEEP_ALIVE_MS,
+    .profile_save_h = CONFIG_METERING_PROFILE_SAVE_H,
+    .time_sync_h = CONFIG_TIME_SYNC_INTERVAL_H,
+    .debounce_ms = CONFIG_PULSE_DEBOUNCE_MS,
+    .pulses_per_unit = CONFIG_PULSE_PER_UNIT_NUMERATOR,
+    .awake_us = 3000,
+    .rx_poll_us = CONFIG_ENERGY_RX_POLL_US,
+    .tx_frame_us = CONFIG_ENERGY_TX_FRAME_US,
+    .flash_write_us = 6000,
+    .sleep_ua = CONFIG_ENERGY_SLEEP_UA,
+    .busy_ua = CONFIG_ENERGY_CPU_BUSY_UA,
+    .rx_ua = CONFIG_ENERGY_RX_UA,
+    .tx_ua = CONFIG_ENERGY_TX_UA,
+    .flash_ua = CONFIG_ENERGY_FLASH_UA,
+};
+
+typedef enum {
+    SIM_WAKE_PULSE = 0,
+    SIM_WAKE_POLL,
+    SIM_WAKE_REPORT,
+    SIM_WAKE_COUNT,
+} sim_wake_t;
+
+typedef struct {
+    uint64_t pulses;
+    uint64_t summation;
+    uint32_t wakes[SIM_WAKE_COUNT];
+    uint32_t tx_frames;
+    uint32_t reports;
+    uint64_t tx_bytes;
+    uint32_t flash_writes;
+    uint64_t time_us[ENERGY_STATE_COUNT];
+    uint64_t charge_nah;
+    uint32_t uah_per_day;
+    double run_s;
+} sim_result_t;
+
+/* One reported attribute as the stack sees it. */
+typedef struct {
+    int64_t value;
+    int64_t reported;
+    int64_t last_report_us;
+} sim_report_t;
+
+typedef struct {
+    const sim_cfg_t *cfg;
+    pulse_counter_t counter;
+    metering_t meter;
+    save_sched_t save;
+    uint64_t consumed;
+    sim_report_t summation;
+    sim_report_t demand;
+    int64_t awake_until_us;
+    int64_t next_poll_us;
+    int64_t last_tick_us;
+    int64_t last_profile_save_us;
+    int64_t last_time_sync_us;
+    sim_result_t *res;
+} sim_t;
+
+typedef struct {
+    int64_t *t_us;
+    size_t count;
+    size_t cap;
+    int64_t span_us;
+} sim_trace_t;
+
+static sim_t s_sim;
+
+static void trace_push(sim_trace_t *tr, int64_t t_us)
+{
+    if (tr->count == tr->cap) {
+        tr->cap = tr->cap ? tr->cap * 2 : 4096;
+        tr->t_us = realloc(tr->t_us, tr->cap * sizeof(tr->t_us[0]));
+        if (!tr->t_us) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    tr->t_us[tr->count++] = t_us;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Timestamps relative to the first pulse; the span is rounded up to whole days. */
+static void trace_finish(sim_trace_t *tr)
+{
+    if (tr->count == 0) {
+        fprintf(stderr, "trace has no pulses\n");
+        exit(1);
+    }
+    qsort(tr->t_us, tr->count, sizeof(tr->t_us[0]), cmp_i64);
+    int64_t t0 = tr->t_us[0];
+    for (size_t i = 0; i < tr->count; i++) {
+        tr->t_us[i] -= t0;
+    }
+    int64_t last = tr->t_us[tr->count - 1];
+    tr->span_us = (last / SIM_US_PER_DAY + 1) * SIM_US_PER_DAY;
+}
+
+static void trace_load(sim_trace_t *tr, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char *end;
+        double t_s = strtod(line, &end);
+        if (end == line) {
+            continue;
+        }
+        trace_push(tr, (int64_t)(t_s * (double)SIM_US_PER_S));
+    }
+    fclose(f);
+    trace_finish(tr);
+}
+
+static uint32_t sim_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* Electricity meter at 1000 pulses/kWh: a base load, a morning and an evening peak, and
+ * appliances that switch on for a few minutes at random. Power is held for a minute at a
+ * time and a pulse is emitted every 1 Wh, so pulse spacing follows the load like a real
+ * meter's LED. Deterministic.
+ */
+static void trace_generate(sim_trace_t *tr, int days)
+{
+    uint32_t seed = 0x9e3779b9u;
+    double wh = 0.0;
+    int appliance_min = 0;
+    double appliance_w = 0.0;
+    for (int64_t minute = 0; minute < (int64_t)days * 1440; minute++) {
+        int hour = (int)((minute / 60) % 24);
+        double w = 120.0 + (double)(sim_rand(&seed) % 40);
+        if (hour >= 7 && hour < 9) {
+            w += 400.0;
+        } else if (hour >= 18 && hour < 23) {
+            w += 700.0;
+        }
+        if (appliance_min == 0 && sim_rand(&seed) % 90 == 0) {
+            appliance_min = 3 + (int)(sim_rand(&seed) % 40);
+            appliance_w = 800.0 + (double)(sim_rand(&seed) % 1600);
+        }
+        if (appliance_min > 0) {
+            w += appliance_w;
+            appliance_min--;
+        }
+        /* Pulses inside this minute at the instants the energy crosses whole Wh. */
+        double wh_per_us = w / 3600.0 / (double)SIM_US_PER_S;
+        double next = 1.0 - wh;
+        double span_us = 60.0 * (double)SIM_US_PER_S;
+        double t = next / wh_per_us;
+        while (t < span_us) {
+            trace_push(tr, minute * 60 * SIM_US_PER_S + (int64_t)t);
+            t += 1.0 / wh_per_us;
+        }
+        wh += w / 60.0;
+        wh -= (double)(int64_t)wh;
+    }
+    trace_finish(tr);
+    tr->span_us = (int64_t)days * SIM_US_PER_DAY;
+}
+
+static void sim_sleep(int64_t until_us)
+{
+    int64_t span = until_us - s_sim.awake_until_us;
+    while (span > 0) {
+        uint32_t chunk = span > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)span;
+        energy_add(ENERGY_STATE_SLEEP, chunk);
+        span -= chunk;
+    }
+}
+
+/* Radio or flash work extends the current wake. */
+static void sim_busy(energy_state_t state, int64_t duration_us)
+{
+    energy_add(state, (uint32_t)duration_us);
+    s_sim.awake_until_us += duration_us;
+}
+
+static void sim_tx(uint32_t bytes)
+{
+    sim_busy(ENERGY_STATE_TX, s_sim.cfg->tx_frame_us);
+    energy_count(ENERGY_COUNT_TX_FRAMES);
+    s_sim.res->tx_frames++;
+    s_sim.res->tx_bytes += bytes;
+}
+
+static void sim_flash_write(void)
+{
+    sim_busy(ENERGY_STATE_FLASH, s_sim.cfg->flash_write_us);
+    energy_count(ENERGY_COUNT_FLASH_WRITES);
+    s_sim.res->flash_writes++;
+}
+
+static bool report_due(const sim_report_t *r, int64_t now_us, const sim_cfg_t *cfg)
+{
+    int64_t since = now_us - r->last_report_us;
+    if (since >= cfg->report_max_s * SIM_US_PER_S) {
+        return true;
+    }
+    int64_t delta = r->value - r->reported;
+    if (delta < 0) {
+        delta = -delta;
+    }
+    return delta > 0 && delta >= cfg->report_change && since >= cfg->report_min_s * SIM_US_PER_S;
+}
+
+/* Earliest time the stack would send this attribute, given its current value. */
+static int64_t report_deadline(const sim_report_t *r, const sim_cfg_t *cfg)
+{
+    int64_t delta = r->value - r->reported;
+    if (delta < 0) {
+        delta = -delta;
+    }
+    if (delta > 0 && delta >= cfg->report_change) {
+        return r->last_report_us + cfg->report_min_s * SIM_US_PER_S;
+    }
+    return r->last_report_us + cfg->report_max_s * SIM_US_PER_S;
+}
+
+static void report_sent(sim_report_t *r, int64_t now_us)
+{
+    r->reported = r->value;
+    r->last_report_us = now_us;
+}
+
+/* Summation and demand share a cluster, so attributes due together go in one frame. */
+static void sim_service_reports(int64_t now_us)
+{
+    uint32_t bytes = 0;
+    if (report_due(&s_sim.summation, now_us, s_sim.cfg)) {
+        report_sent(&s_sim.summation, now_us);
+        bytes += SIM_ATTR_RECORD_BYTES + SIM_SUMMATION_BYTES;
+    }
+    if (report_due(&s_sim.demand, now_us, s_sim.cfg)) {
+        report_sent(&s_sim.demand, now_us);
+        bytes += SIM_ATTR_RECORD_BYTES + SIM_DEMAND_BYTES;
+    }
+    if (bytes > 0) {
+        sim_tx(SIM_ZCL_FRAME_BYTES + bytes);
+        s_sim.res->reports++;
+    }
+}
+
+/* One pass of the firmware main loop, in its order. */
+static void sim_loop_pass(int64_t now_us)
+{
+    const sim_cfg_t *cfg = s_sim.cfg;
+
+    pulse_counter_snapshot_t snap;
+    pulse_counter_read(&s_sim.counter, &snap);
+    if (snap.counted != s_sim.consumed) {
+        uint32_t count = (uint32_t)(snap.counted - s_sim.consumed);
+        s_sim.consumed = snap.counted;
+        metering_on_pulses(&s_sim.meter, count, snap.last_us, snap.prev_us);
+        save_sched_mark(&s_sim.save);
+    }
+
+    if (save_sched_due(&s_sim.save, now_us, metering_get_last_pulse_us(&s_sim.meter))) {
+        sim_flash_write();
+        save_sched_done(&s_sim.save, now_us);
+    }
+    if (now_us - s_sim.last_time_sync_us >= cfg->time_sync_h * 3600LL * SIM_US_PER_S) {
+        sim_tx(SIM_ZCL_FRAME_BYTES + SIM_READ_ATTR_BYTES);
+        sim_busy(ENERGY_STATE_RX, cfg->rx_poll_us);
+        s_sim.last_time_sync_us = now_us;
+    }
+    if (now_us - s_sim.last_profile_save_us >= cfg->profile_save_h * 3600LL * SIM_US_PER_S) {
+        sim_flash_write();
+        s_sim.last_profile_save_us = now_us;
+    }
+    if (now_us - s_sim.last_tick_us >= SIM_DEMAND_TICK_US) {
+        s_sim.last_tick_us = now_us;
+        (void)metering_tick(&s_sim.meter, now_us);
+    }
+
+    s_sim.summation.value = (int64_t)metering_get_summation(&s_sim.meter);
+    s_sim.demand.value = metering_get_instantaneous_demand(&s_sim.meter);
+    sim_service_reports(now_us);
+}
+
+static void sim_run(const sim_cfg_t *cfg, const sim_trace_t *tr, int64_t duration_us, sim_result_t *res)
+{
+    struct timespec w0, w1;
+    clock_gettime(CLOCK_MONOTONIC, &w0);
+
+    memset(&s_sim, 0, sizeof(s_sim));
+    memset(res, 0, sizeof(*res));
+    s_sim.cfg = cfg;
+    s_sim.res = res;
+
+    const int64_t start = SIM_START_US;
+    const int64_t end = start + duration_us;
+    energy_model_t model = {.current_ua = {
+        [ENERGY_STATE_SLEEP] = (uint32_t)cfg->sleep_ua,
+        [ENERGY_STATE_AWAKE_IDLE] = (uint32_t)cfg->busy_ua,
+        [ENERGY_STATE_CPU_BUSY] = (uint32_t)cfg->busy_ua,
+        [ENERGY_STATE_RX] = (uint32_t)cfg->rx_ua,
+        [ENERGY_STATE_TX] = (uint32_t)cfg->tx_ua,
+        [ENERGY_STATE_FLASH] = (uint32_t)cfg->flash_ua,
+    }};
+    host_time_set_us(start);
+    energy_init(&model, start);
+
+    app_metering_cfg_t mcfg = {
+        .pulse_per_unit_numerator = (uint32_t)cfg->pulses_per_unit,
+        .debounce_ms = (uint16_t)cfg->debounce_ms,
+        .gpio_num = CONFIG_PULSE_GPIO,
+    };
+    pulse_counter_init(&s_sim.counter, 0);
+    metering_init(&s_sim.meter, &mcfg, &s_sim.counter);
+    save_sched_init(&s_sim.save, cfg->save_interval_s * SIM_US_PER_S, cfg->save_quiet_s * SIM_US_PER_S, start);
+    s_sim.summation.last_report_us = start;
+    s_sim.demand.last_report_us = start;
+    s_sim.last_tick_us = start;
+    s_sim.last_profile_save_us = start;
+    s_sim.last_time_sync_us = start;
+    s_sim.awake_until_us = start;
+    s_sim.next_poll_us = start + cfg->keep_alive_ms * 1000LL;
+
+    size_t idx = 0;
+    int64_t loop_us = start;
+    for (;;) {
+        int64_t next_pulse = idx < tr->count ? loop_us + tr->t_us[idx] : INT64_MAX;
+        int64_t next_report = report_deadline(&s_sim.summation, cfg);
+        int64_t d = report_deadline(&s_sim.demand, cfg);
+        if (d < next_report) {
+            next_report = d;
+        }
+
+        int64_t now = next_pulse;
+        sim_wake_t cause = SIM_WAKE_PULSE;
+        if (s_sim.next_poll_us < now) {
+            now = s_sim.next_poll_us;
+            cause = SIM_WAKE_POLL;
+        }
+        if (next_report < now) {
+            now = next_report;
+            cause = SIM_WAKE_REPORT;
+        }
+        if (now >= end) {
+            break;
+        }
+
+        if (now < s_sim.awake_until_us) {
+            now = s_sim.awake_until_us;
+        } else {
+            sim_sleep(now);
+            energy_count(ENERGY_COUNT_WAKES);
+            res->wakes[cause]++;
+            s_sim.awake_until_us = now + cfg->awake_us;
+        }
+        host_time_set_us(now);
+
+        if (cause == SIM_WAKE_PULSE) {
+            (void)pulse_counter_add(&s_sim.counter, next_pulse, cfg->debounce_ms * 1000LL);
+            res->pulses++;
+            if (++idx == tr->count && loop_us + tr->span_us < end) {
+                loop_us += tr->span_us;
+                idx = 0;
+            }
+        } else if (cause == SIM_WAKE_POLL) {
+            sim_busy(ENERGY_STATE_RX, cfg->rx_poll_us);
+            res->tx_bytes += SIM_POLL_BYTES;
+            s_sim.next_poll_us += cfg->keep_alive_ms * 1000LL;
+        }
+        sim_loop_pass(now);
+        energy_tick(s_sim.awake_until_us);
+    }
+    sim_sleep(end);
+    energy_tick(end);
+
+    res->summation = metering_get_summation(&s_sim.meter);
+    for (int i = 0; i < ENERGY_STATE_COUNT; i++) {
+        res->time_us[i] = energy_get_time_us((energy_state_t)i);
+    }
+    res->charge_nah = energy_get_charge_nah();
+    res->uah_per_day = energy_get_uah_per_day(end);
+
+    clock_gettime(CLOCK_MONOTONIC, &w1);
+    res->run_s = (double)(w1.tv_sec - w0.tv_sec) + (double)(w1.tv_nsec - w0.tv_nsec) / 1e9;
+}
+
+static void cfg_set(sim_cfg_t *cfg, const char *arg)
+{
+    const char *eq = strchr(arg, '=');
+    if (eq) {
+        for (size_t i = 0; i < SIM_KEY_COUNT; i++) {
+            if (strlen(s_keys[i].name) == (size_t)(eq - arg) && strncmp(s_keys[i].name, arg, eq - arg) == 0) {
+                char *end;
+                long long v = strtoll(eq + 1, &end, 0);
+                if (*end == '\0' && v >= 0) {
+                    *(int64_t *)((char *)cfg + s_keys[i].offset) = v;
+                    return;
+                }
+            }
+        }
+    }
+    fprintf(stderr, "bad setting '%s'; keys:\n", arg);
+    for (size_t i = 0; i < SIM_KEY_COUNT; i++) {
+        fprintf(stderr, "  %-16s %s\n", s_keys[i].name, s_keys[i].help);
+    }
+    exit(2);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sim [-a key=value]... [-b key=value]... [-d days] (-g days | trace.csv)\n");
+    exit(2);
+}
+
+static void print_row_u(const char *name, uint64_t a, uint64_t b)
+{
+    printf("%-22s %14llu %14llu\n", name, (unsigned long long)a, (unsigned long long)b);
+}
+
+static void print_row_f(const char *name, double a, double b)
+{
+    printf("%-22s %14.1f %14.1f\n", name, a, b);
+}
+
+int main(int argc, char **argv)
+{
+    sim_cfg_t cfg[2] = {s_default_cfg, s_default_cfg};
+    sim_trace_t trace = {0};
+    int gen_days = 0;
+    double days = 0.0;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "-b") == 0) && i + 1 < argc) {
+            cfg_set(&cfg[argv[i][1] - 'a'], argv[i + 1]);
+            i++;
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            days = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            gen_days = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            usage();
+        }
+    }
+    if (gen_days > 0) {
+        trace_generate(&trace, gen_days);
+    } else if (path) {
+        trace_load(&trace, path);
+    } else {
+        usage();
+    }
+    int64_t duration_us = days > 0.0 ? (int64_t)(days * (double)SIM_US_PER_DAY) : trace.span_us;
+
+    sim_result_t res[2];
+    for (int i = 0; i < 2; i++) {
+        sim_run(&cfg[i], &trace, duration_us, &res[i]);
+    }
+
+    printf("%zu pulses in the trace, %.1f days simulated (demand estimator: %s)\n\n", trace.count,
+           (double)duration_us / (double)SIM_US_PER_DAY, CONFIG_DEMAND_ESTIMATOR_WINDOW ? "window" : "ema");
+    printf("%-22s %14s %14s\n", "", "A", "B");
+    for (size_t i = 0; i < SIM_KEY_COUNT; i++) {
+        int64_t a = *(const int64_t *)((const char *)&cfg[0] + s_keys[i].offset);
+        int64_t b = *(const int64_t *)((const char *)&cfg[1] + s_keys[i].offset);
+        if (a != b) {
+            print_row_u(s_keys[i].name, (uint64_t)a, (uint64_t)b);
+        }
+    }
+    print_row_u("pulses", res[0].pulses, res[1].pulses);
+    print_row_u("summation", res[0].summation, res[1].summation);
+    print_row_u("wakes: pulse", res[0].wakes[SIM_WAKE_PULSE], res[1].wakes[SIM_WAKE_PULSE]);
+    print_row_u("wakes: poll", res[0].wakes[SIM_WAKE_POLL], res[1].wakes[SIM_WAKE_POLL]);
+    print_row_u("wakes: report", res[0].wakes[SIM_WAKE_REPORT], res[1].wakes[SIM_WAKE_REPORT]);
+    print_row_u("reports", res[0].reports, res[1].reports);
+    print_row_u("TX frames", res[0].tx_frames, res[1].tx_frames);
+    print_row_u("bytes on air", res[0].tx_bytes, res[1].tx_bytes);
+    print_row_u("flash writes", res[0].flash_writes, res[1].flash_writes);
+    print_row_f("awake s", (double)res[0].time_us[ENERGY_STATE_CPU_BUSY] / 1e6,
+                (double)res[1].time_us[ENERGY_STATE_CPU_BUSY] / 1e6);
+    print_row_f("RX s", (double)res[0].time_us[ENERGY_STATE_RX] / 1e6, (double)res[1].time_us[ENERGY_STATE_RX] / 1e6);
+    print_row_f("TX s", (double)res[0].time_us[ENERGY_STATE_TX] / 1e6, (double)res[1].time_us[ENERGY_STATE_TX] / 1e6);
+    print_row_f("flash s", (double)res[0].time_us[ENERGY_STATE_FLASH] / 1e6,
+                (double)res[1].time_us[ENERGY_STATE_FLASH] / 1e6);
+    print_row_f("charge mAh", (double)res[0].charge_nah / 1e6, (double)res[1].charge_nah / 1e6);
+    print_row_u("uAh/day", res[0].uah_per_day, res[1].uah_per_day);
+    print_row_f("run ms", res[0].run_s * 1e3, res[1].run_s * 1e3);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "esp_zigbee_type.h"
+#include "esp_zigbee_cluster.h"
+#include "esp_zigbee_attribute.h"
+#include "nwk/esp_zigbee_nwk.h"
+#include "zcl/esp_zigbee_zcl_command.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+
+typedef enum {
+    ESP_ZB_ZDO_SIGNAL_DEFAULT_START = 0x00,
+    ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP = 0x01,
+    ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE = 0x02,
+    ESP_ZB_ZDO_SIGNAL_LEAVE = 0x03,
+    ESP_ZB_ZDO_SIGNAL_ERROR = 0x04,
+    ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START = 0x05,
+    ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT = 0x06,
+    ESP_ZB_BDB_SIGNAL_STEERING = 0x0A,
+    ESP_ZB_BDB_SIGNAL_FORMATION = 0x0B,
+    ESP_ZB_COMMON_SIGNAL_CAN_SLEEP = 0x16,
+    ESP_ZB_ZDO_SIGNAL_PRODUCTION_CONFIG_READY = 0x17,
+} esp_zb_app_signal_type_t;
+
+typedef enum {
+    ESP_ZB_BDB_STATUS_SUCCESS = 0,
+    ESP_ZB_BDB_STATUS_IN_PROGRESS,
+    ESP_ZB_BDB_STATUS_NOT_AA_CAPABLE,
+    ESP_ZB_BDB_STATUS_NO_NETWORK,
+    ESP_ZB_BDB_STATUS_TARGET_FAILURE,
+    ESP_ZB_BDB_STATUS_FORMATION_FAILURE,
+    ESP_ZB_BDB_STATUS_NO_IDENTIFY_QUERY_RESPONSE,
+    ESP_ZB_BDB_STATUS_BINDING_TABLE_FULL,
+    ESP_ZB_BDB_STATUS_NO_SCAN_RESPONSE,
+    ESP_ZB_BDB_STATUS_NOT_PERMITTED,
+    ESP_ZB_BDB_STATUS_TCLK_EX_FAILURE,
+    ESP_ZB_BDB_STATUS_NOT_ON_A_NETWORK,
+    ESP_ZB_BDB_STATUS_ON_A_NETWORK,
+    ESP_ZB_BDB_STATUS_CANCELLED,
+    ESP_ZB_BDB_STATUS_DEV_ANNCE_SEND_FAILURE,
+} esp_zb_bdb_commissioning_status_t;
+
+typedef enum {
+    ESP_ZB_BDB_MODE_INITIALIZATION = 0,
+    ESP_ZB_BDB_MODE_TOUCHLINK_COMMISSIONING = 1,
+    ESP_ZB_BDB_MODE_NETWORK_STEERING = 2,
+    ESP_ZB_BDB_MODE_NETWORK_FORMATION = 4,
+    ESP_ZB_BDB_MODE_FINDING_N_BINDING = 8,
+} esp_zb_bdb_commissioning_mode_mask_t;
+
+typedef struct {
+    uint32_t *p_app_signal;
+    esp_err_t esp_err_status;
+} esp_zb_app_signal_t;
+
+typedef enum {
+    ESP_ZB_DEVICE_TYPE_COORDINATOR = 0,
+    ESP_ZB_DEVICE_TYPE_ROUTER = 1,
+    ESP_ZB_DEVICE_TYPE_ED = 2,
+} esp_zb_nwk_device_type_t;
+
+typedef enum {
+    ESP_ZB_ED_AGING_TIMEOUT_10SEC = 0,
+    ESP_ZB_ED_AGING_TIMEOUT_2MIN,
+    ESP_ZB_ED_AGING_TIMEOUT_4MIN,
+    ESP_ZB_ED_AGING_TIMEOUT_8MIN,
+    ESP_ZB_ED_AGING_TIMEOUT_16MIN,
+    ESP_ZB_ED_AGING_TIMEOUT_32MIN,
+    ESP_ZB_ED_AGING_TIMEOUT_64MIN,
+} esp_zb_aging_timeout_t;
+
+typedef struct {
+    uint8_t ed_timeout;
+    uint32_t keep_alive;
+} esp_zb_zed_cfg_t;
+
+typedef struct {
+    uint8_t max_children;
+} esp_zb_zczr_cfg_t;
+
+typedef struct {
+    esp_zb_nwk_device_type_t esp_zb_role;
+    bool install_code_policy;
+    union {
+        esp_zb_zczr_cfg_t zczr_cfg;
+        esp_zb_zed_cfg_t zed_cfg;
+    } nwk_cfg;
+} esp_zb_cfg_t;
+
+typedef enum {
+    ZB_RADIO_MODE_NATIVE = 0,
+    ZB_RADIO_MODE_UART_RCP = 1,
+} esp_zb_radio_mode_t;
+
+typedef enum {
+    ZB_HOST_CONNECTION_MODE_NONE = 0,
+    ZB_HOST_CONNECTION_MODE_CLI_UART = 1,
+    ZB_HOST_CONNECTION_MODE_RCP_UART = 2,
+} esp_zb_host_connection_mode_t;
+
+typedef struct {
+    struct {
+        esp_zb_radio_mode_t radio_mode;
+    } radio_config;
+    struct {
+        esp_zb_host_connection_mode_t host_connection_mode;
+    } host_config;
+} esp_zb_platform_config_t;
+
+/* Implemented by the application. */
+void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct);
+
+esp_err_t esp_zb_platform_config(esp_zb_platform_config_t *config);
+/* Table and buffer sizes; only accepted before esp_zb_init(). */
+esp_err_t esp_zb_overall_network_size_set(uint16_t size);
+esp_err_t esp_zb_io_buffer_size_set(uint16_t size);
+esp_err_t esp_zb_scheduler_queue_size_set(uint16_t size);
+esp_err_t esp_zb_aps_src_binding_table_size_set(uint16_t size);
+esp_err_t esp_zb_aps_dst_binding_table_size_set(uint16_t size);
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg);
+esp_err_t esp_zb_start(bool autostart);
+/* Runs due stack work, the reporting engine and the CAN_SLEEP decision. */
+void esp_zb_stack_main_loop_iteration(void);
+void esp_zb_factory_reset(void);
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list);
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb);
+
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask);
+esp_zb_bdb_commissioning_mode_mask_t esp_zb_get_bdb_commissioning_mode(void);
+esp_zb_bdb_commissioning_status_t esp_zb_get_bdb_commissioning_status(void);
+bool esp_zb_bdb_is_factory_new(void);
+bool esp_zb_bdb_dev_joined(void);
+void esp_zb_bdb_set_scan_duration(uint8_t duration);
+
+uint32_t esp_zb_get_channel_mask(void);
+uint32_t esp_zb_get_primary_network_channel_set(void);
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask);
+uint32_t esp_zb_get_secondary_network_channel_set(void);
+esp_err_t esp_zb_set_secondary_network_channel_set(uint32_t channel_mask);
+void esp_zb_secur_network_min_join_lqi_set(uint8_t lqi);
+void esp_zb_set_node_descriptor_power_source(bool is_main_power);
+void esp_zb_set_tx_power(int8_t power);
+void esp_zb_get_tx_power(int8_t *power);
+
+void esp_zb_sleep_enable(bool enable);
+esp_err_t esp_zb_sleep_set_threshold(uint32_t threshold_ms);
+/* Light sleep until the next stack deadline, esp_timer or EXT1 pin edge. */
+void esp_zb_sleep_now(void);
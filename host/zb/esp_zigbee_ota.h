@@ -0,0 +1,5 @@
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+esp_err_t esp_zb_ota_upgrade_client_query_interval_set(uint8_t endpoint, uint16_t interval);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+    ESP_ZB_TRACE_LEVEL_CRITICAL = 0,
+    ESP_ZB_TRACE_LEVEL_ERROR = 1,
+    ESP_ZB_TRACE_LEVEL_WARN = 2,
+    ESP_ZB_TRACE_LEVEL_INFO = 3,
+    ESP_ZB_TRACE_LEVEL_DEBUG = 4,
+} esp_zb_trace_level_cfg_t;
+
+void esp_zb_set_trace_level_mask(esp_zb_trace_level_cfg_t trace_level, uint32_t trace_mask);
@@ -0,0 +1,482 @@
+#pragma once
+
+/* Host stand-in for esp-zigbee-lib: the types, IDs and constants the application uses, with
+ * the field names of the 1.x headers. Values follow the ZCL spec where the application or the
+ * fake stack depends on them; the rest only need to be distinct.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef uint8_t esp_zb_ieee_addr_t[8];
+
+typedef struct {
+    uint32_t low;
+    uint16_t high;
+} __attribute__((packed)) esp_zb_uint48_t;
+
+typedef struct {
+    uint16_t low;
+    uint8_t high;
+} __attribute__((packed)) esp_zb_uint24_t;
+
+typedef struct {
+    uint16_t low;
+    int8_t high;
+} __attribute__((packed)) esp_zb_int24_t;
+
+#define ESP_ZB_AF_HA_PROFILE_ID 0x0104
+
+/* ---- ZCL identifiers ---- */
+
+#define ESP_ZB_ZCL_CLUSTER_ID_BASIC 0x0000
+#define ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG 0x0001
+#define ESP_ZB_ZCL_CLUSTER_ID_TIME 0x000A
+#define ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE 0x0019
+#define ESP_ZB_ZCL_CLUSTER_ID_METERING 0x0702
+
+#define ESP_ZB_ZCL_CLUSTER_SERVER_ROLE 0x01
+#define ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE 0x02
+
+#define ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC 0xFFFF
+
+typedef enum {
+    ESP_ZB_ZCL_ATTR_TYPE_NULL = 0x00,
+    ESP_ZB_ZCL_ATTR_TYPE_BOOL = 0x10,
+    ESP_ZB_ZCL_ATTR_TYPE_8BITMAP = 0x18,
+    ESP_ZB_ZCL_ATTR_TYPE_16BITMAP = 0x19,
+    ESP_ZB_ZCL_ATTR_TYPE_32BITMAP = 0x1B,
+    ESP_ZB_ZCL_ATTR_TYPE_U8 = 0x20,
+    ESP_ZB_ZCL_ATTR_TYPE_U16 = 0x21,
+    ESP_ZB_ZCL_ATTR_TYPE_U24 = 0x22,
+    ESP_ZB_ZCL_ATTR_TYPE_U32 = 0x23,
+    ESP_ZB_ZCL_ATTR_TYPE_U48 = 0x25,
+    ESP_ZB_ZCL_ATTR_TYPE_S8 = 0x28,
+    ESP_ZB_ZCL_ATTR_TYPE_S16 = 0x29,
+    ESP_ZB_ZCL_ATTR_TYPE_S24 = 0x2A,
+    ESP_ZB_ZCL_ATTR_TYPE_S32 = 0x2B,
+    ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM = 0x30,
+    ESP_ZB_ZCL_ATTR_TYPE_16BIT_ENUM = 0x31,
+    ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING = 0x41,
+    ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING = 0x42,
+    ESP_ZB_ZCL_ATTR_TYPE_ARRAY = 0x48,
+    ESP_ZB_ZCL_ATTR_TYPE_SET = 0x50,
+    ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME = 0xE2,
+    ESP_ZB_ZCL_ATTR_TYPE_IEEE_ADDR = 0xF0,
+} esp_zb_zcl_attr_type_t;
+
+typedef enum {
+    ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY = 0x01,
+    ESP_ZB_ZCL_ATTR_ACCESS_WRITE_ONLY = 0x02,
+    ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE = 0x03,
+    ESP_ZB_ZCL_ATTR_ACCESS_REPORTING = 0x04,
+} esp_zb_zcl_attr_access_t;
+
+typedef enum {
+    ESP_ZB_ZCL_STATUS_SUCCESS = 0x00,
+    ESP_ZB_ZCL_STATUS_FAIL = 0x01,
+    ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB = 0x86,
+    ESP_ZB_ZCL_STATUS_INVALID_VALUE = 0x87,
+    ESP_ZB_ZCL_STATUS_TIMEOUT = 0x94,
+} esp_zb_zcl_status_t;
+
+typedef enum {
+    ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV = 0x00,
+    ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI = 0x01,
+} esp_zb_zcl_cmd_direction_t;
+
+#define ESP_ZB_ZCL_REPORT_DIRECTION_SEND 0x00
+#define ESP_ZB_ZCL_REPORT_DIRECTION_RECV 0x01
+
+typedef enum {
+    ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT = 0x00,
+    ESP_ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT = 0x01,
+    ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT = 0x02,
+    ESP_ZB_APS_ADDR_MODE_64_ENDP_PRESENT = 0x03,
+} esp_zb_aps_address_mode_t;
+
+typedef enum {
+    ESP_ZB_ZCL_ADDR_TYPE_SHORT = 0,
+    ESP_ZB_ZCL_ADDR_TYPE_IEEE_GPD = 1,
+    ESP_ZB_ZCL_ADDR_TYPE_SRC_ID_GPD = 2,
+    ESP_ZB_ZCL_ADDR_TYPE_IEEE = 3,
+} esp_zb_zcl_addr_type_t;
+
+/* Basic */
+#define ESP_ZB_ZCL_ATTR_BASIC_ZCL_VERSION_ID 0x0000
+#define ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID 0x0004
+#define ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID 0x0005
+#define ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID 0x0007
+#define ESP_ZB_ZCL_ATTR_BASIC_SW_BUILD_ID 0x4000
+#define ESP_ZB_ZCL_BASIC_ZCL_VERSION_DEFAULT_VALUE 0x08
+#define ESP_ZB_ZCL_BASIC_POWER_SOURCE_BATTERY 0x03
+#define ESP_ZB_ZCL_BASIC_POWER_SOURCE_DC_SOURCE 0x04
+
+/* Power configuration */
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_VOLTAGE_ID 0x0000
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_FREQUENCY_ID 0x0001
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_ALARM_MASK_ID 0x0010
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_VOLTAGE_MIN_THRESHOLD 0x0011
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_VOLTAGE_MAX_THRESHOLD 0x0012
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_DWELL_TRIP_POINT 0x0013
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID 0x0020
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID 0x0021
+
+/* Time */
+#define ESP_ZB_ZCL_ATTR_TIME_TIME_ID 0x0000
+#define ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID 0x0002
+#define ESP_ZB_ZCL_ATTR_TIME_LOCAL_TIME_ID 0x0007
+
+/* Simple Metering */
+#define ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID 0x0000
+#define ESP_ZB_ZCL_ATTR_METERING_UNIT_OF_MEASURE_ID 0x0300
+#define ESP_ZB_ZCL_ATTR_METERING_MULTIPLIER_ID 0x0301
+#define ESP_ZB_ZCL_ATTR_METERING_DIVISOR_ID 0x0302
+#define ESP_ZB_ZCL_ATTR_METERING_SUMMATION_FORMATTING_ID 0x0303
+#define ESP_ZB_ZCL_ATTR_METERING_DEMAND_FORMATTING_ID 0x0304
+#define ESP_ZB_ZCL_ATTR_METERING_METERING_DEVICE_TYPE_ID 0x0306
+#define ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID 0x0400
+
+/* OTA upgrade (client) */
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ID 0x0000
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID 0x0001
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID 0x0002
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_STACK_VERSION_ID 0x0003
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID 0x0004
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_STACK_VERSION_ID 0x0005
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID 0x0006
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID 0x0007
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID 0x0008
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID 0x0009
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STAMP_ID 0x000A
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID 0xFFF1
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID 0xFFF2
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID 0xFFF3
+
+#define ESP_ZB_ZCL_OTA_UPGRADE_SERVER_DEF_VALUE {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}
+#define ESP_ZB_ZCL_OTA_UPGRADE_FILE_OFFSET_DEF_VALUE 0xFFFFFFFF
+#define ESP_ZB_ZCL_OTA_UPGRADE_IMAGE_STATUS_DEF_VALUE 0x00
+#define ESP_ZB_ZCL_OTA_UPGRADE_STACK_VERSION_DEF_VALUE 0x0002
+#define ESP_ZB_ZCL_OTA_UPGRADE_DOWNLOADED_STACK_DEF_VALUE 0x0002
+#define ESP_ZB_ZCL_OTA_UPGRADE_SERVER_ADDR_DEF_VALUE 0xFFFF
+#define ESP_ZB_ZCL_OTA_UPGRADE_SERVER_ENDPOINT_DEF_VALUE 0xFF
+#define ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF 5
+#define ESP_ZB_OTA_UPGRADE_MIN_BLOCK_PERIOD_DEF_VALUE 0
+
+typedef enum {
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START = 0x0000,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY = 0x0001,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE = 0x0002,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH = 0x0003,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT = 0x0004,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK = 0x0005,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_OK = 0x0006,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR = 0x0007,
+} esp_zb_zcl_ota_upgrade_status_t;
+
+/* ---- attribute, cluster and endpoint lists ---- */
+
+typedef struct {
+    uint8_t type;
+    uint16_t size;
+    void *value;
+} esp_zb_zcl_attribute_data_t;
+
+typedef struct {
+    uint16_t id;
+    esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_attribute_t;
+
+/* The head node only names the cluster; attributes follow it. Values are copied into
+ * storage owned by the list, as in the real stack.
+ */
+typedef struct esp_zb_attribute_list_s {
+    esp_zb_zcl_attribute_t attribute;
+    uint16_t cluster_id;
+    uint16_t manuf_code;
+    uint8_t access;
+    struct esp_zb_attribute_list_s *next;
+} esp_zb_attribute_list_t;
+
+typedef struct esp_zb_cluster_list_s {
+    uint16_t cluster_id;
+    uint8_t role;
+    esp_zb_attribute_list_t *attr_list;
+    struct esp_zb_cluster_list_s *next;
+} esp_zb_cluster_list_t;
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t app_profile_id;
+    uint16_t app_device_id;
+    uint32_t app_device_version;
+} esp_zb_endpoint_config_t;
+
+typedef struct esp_zb_ep_list_s {
+    esp_zb_endpoint_config_t config;
+    esp_zb_cluster_list_t *cluster_list;
+    struct esp_zb_ep_list_s *next;
+} esp_zb_ep_list_t;
+
+typedef struct {
+    uint8_t zcl_version;
+    uint8_t power_source;
+} esp_zb_basic_cluster_cfg_t;
+
+typedef struct {
+    uint16_t main_voltage;
+    uint8_t main_freq;
+    uint8_t main_alarm_mask;
+    uint16_t main_voltage_min;
+    uint16_t main_voltage_max;
+    uint16_t main_voltage_dwell;
+} esp_zb_power_config_cluster_cfg_t;
+
+typedef struct {
+    uint32_t ota_upgrade_file_version;
+    uint16_t ota_upgrade_manufacturer;
+    uint16_t ota_upgrade_image_type;
+    uint16_t ota_min_block_reque;
+    uint32_t ota_upgrade_file_offset;
+    uint32_t ota_upgrade_downloaded_file_ver;
+    esp_zb_ieee_addr_t ota_upgrade_server_id;
+    uint8_t ota_image_upgrade_status;
+} esp_zb_ota_cluster_cfg_t;
+
+typedef struct {
+    uint16_t timer_query;
+    uint16_t hw_version;
+    uint8_t max_data_size;
+} esp_zb_zcl_ota_upgrade_client_variable_t;
+
+/* ---- reporting ---- */
+
+typedef union {
+    uint8_t u8;
+    uint16_t u16;
+    esp_zb_uint24_t u24;
+    uint32_t u32;
+    esp_zb_uint48_t u48;
+    int8_t s8;
+    int16_t s16;
+    esp_zb_int24_t s24;
+    int32_t s32;
+} esp_zb_zcl_attr_var_t;
+
+typedef struct {
+    uint8_t direction;
+    uint8_t ep;
+    uint16_t cluster_id;
+    uint8_t cluster_role;
+    uint16_t attr_id;
+    uint16_t manuf_code;
+    union {
+        struct {
+            uint16_t min_interval;
+            uint16_t max_interval;
+            esp_zb_zcl_attr_var_t delta;
+            esp_zb_zcl_attr_var_t reported_value;
+            uint16_t def_min_interval;
+            uint16_t def_max_interval;
+        } send_info;
+        struct {
+            uint16_t timeout;
+        } recv_info;
+    } u;
+    struct {
+        uint16_t short_addr;
+        uint8_t endpoint;
+        uint16_t profile_id;
+    } dst;
+} esp_zb_zcl_reporting_info_t;
+
+typedef struct {
+    uint8_t endpoint_id;
+    uint16_t cluster_id;
+    uint8_t cluster_role;
+    uint16_t manuf_code;
+    uint16_t attr_id;
+} esp_zb_zcl_attr_location_info_t;
+
+/* ---- commands and callback messages ---- */
+
+typedef struct {
+    union {
+        uint16_t addr_short;
+        esp_zb_ieee_addr_t addr_long;
+    } dst_addr_u;
+    uint8_t dst_endpoint;
+    uint8_t src_endpoint;
+} esp_zb_zcl_basic_cmd_t;
+
+typedef struct {
+    esp_zb_zcl_addr_type_t addr_type;
+    union {
+        uint16_t short_addr;
+        uint32_t src_id;
+        esp_zb_ieee_addr_t ieee_addr;
+    } u;
+} esp_zb_zcl_addr_t;
+
+typedef struct {
+    uint8_t fc;
+    uint16_t manuf_code;
+    uint8_t tsn;
+    int8_t rssi;
+} esp_zb_zcl_frame_header_t;
+
+typedef struct {
+    uint8_t id;
+    uint8_t direction;
+    uint8_t is_common;
+} esp_zb_zcl_command_t;
+
+typedef struct {
+    esp_zb_zcl_status_t status;
+    esp_zb_zcl_frame_header_t header;
+    esp_zb_zcl_addr_t src_address;
+    uint16_t dst_address;
+    uint8_t src_endpoint;
+    uint8_t dst_endpoint;
+    uint16_t cluster;
+    uint16_t profile;
+    esp_zb_zcl_command_t command;
+} esp_zb_zcl_cmd_info_t;
+
+typedef struct {
+    esp_zb_zcl_status_t status;
+    uint8_t dst_endpoint;
+    uint16_t cluster;
+} esp_zb_device_cb_common_info_t;
+
+typedef struct {
+    esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+    esp_zb_aps_address_mode_t address_mode;
+    uint16_t clusterID;
+    uint16_t attributeID;
+    uint8_t direction;
+    uint8_t manuf_specific;
+    uint16_t manuf_code;
+} esp_zb_zcl_report_attr_cmd_t;
+
+typedef struct {
+    esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+    esp_zb_aps_address_mode_t address_mode;
+    uint16_t clusterID;
+    uint8_t manuf_specific;
+    uint8_t direction;
+    uint8_t dis_default_resp;
+    uint16_t manuf_code;
+    uint8_t attr_number;
+    uint16_t *attr_field;
+} esp_zb_zcl_read_attr_cmd_t;
+
+typedef struct {
+    esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+    esp_zb_aps_address_mode_t address_mode;
+    uint16_t profile_id;
+    uint16_t cluster_id;
+    uint16_t manuf_code;
+    uint8_t direction;
+    uint8_t dis_default_resp;
+    uint8_t manuf_specific;
+    uint8_t custom_cmd_id;
+    esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_custom_cluster_cmd_req_t;
+
+typedef struct {
+    esp_err_t status;
+    uint8_t tsn;
+    esp_zb_zcl_addr_t dst_addr;
+    uint8_t dst_endpoint;
+    uint8_t src_endpoint;
+} esp_zb_zcl_command_send_status_message_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    uint8_t attribute_status;
+    esp_zb_zcl_attribute_t attribute;
+} esp_zb_zcl_set_attr_value_message_t;
+
+typedef struct esp_zb_zcl_read_attr_resp_variable_s {
+    esp_zb_zcl_status_t status;
+    esp_zb_zcl_attribute_t attribute;
+    struct esp_zb_zcl_read_attr_resp_variable_s *next;
+} esp_zb_zcl_read_attr_resp_variable_t;
+
+typedef struct {
+    esp_zb_zcl_cmd_info_t info;
+    esp_zb_zcl_read_attr_resp_variable_t *variables;
+} esp_zb_zcl_cmd_read_attr_resp_message_t;
+
+typedef struct {
+    esp_zb_zcl_cmd_info_t info;
+    uint16_t size;
+    void *data;
+} esp_zb_zcl_privilege_command_message_t;
+
+typedef struct {
+    uint32_t file_version;
+    uint16_t image_type;
+    uint16_t manufacturer_code;
+    uint32_t image_size;
+} esp_zb_zcl_ota_upgrade_header_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    esp_zb_zcl_ota_upgrade_status_t upgrade_status;
+    esp_zb_zcl_ota_upgrade_header_t ota_header;
+    uint16_t payload_size;
+    uint8_t *payload;
+} esp_zb_zcl_ota_upgrade_value_message_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    esp_zb_zcl_addr_t server_addr;
+    uint8_t server_endpoint;
+    uint32_t file_version;
+    uint16_t manufacturer_code;
+    uint16_t image_type;
+    uint32_t image_size;
+} esp_zb_zcl_ota_upgrade_query_image_resp_message_t;
+
+typedef enum {
+    ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID = 0x0000,
+    ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID = 0x0004,
+    ESP_ZB_CORE_OTA_UPGRADE_QUERY_IMAGE_RESP_CB_ID = 0x0006,
+    ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID = 0x1000,
+    ESP_ZB_CORE_CMD_PRIVILEGE_COMMAND_REQ_CB_ID = 0x1011,
+} esp_zb_core_action_callback_id_t;
+
+typedef esp_err_t (*esp_zb_core_action_callback_t)(esp_zb_core_action_callback_id_t callback_id, const void *message);
+typedef void (*esp_zb_zcl_command_send_status_callback_t)(esp_zb_zcl_command_send_status_message_t message);
+
+/* ---- ZDO ---- */
+
+typedef enum {
+    ESP_ZB_ZDP_STATUS_SUCCESS = 0x00,
+    ESP_ZB_ZDP_STATUS_INV_REQUESTTYPE = 0x80,
+    ESP_ZB_ZDP_STATUS_TIMEOUT = 0x85,
+    ESP_ZB_ZDP_STATUS_NOT_SUPPORTED = 0x84,
+} esp_zb_zdp_status_t;
+
+typedef enum {
+    ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP = 0x01,
+    ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED = 0x03,
+} esp_zb_zdo_bind_dst_addr_mode_t;
+
+typedef struct {
+    esp_zb_ieee_addr_t src_address;
+    uint8_t src_endp;
+    uint16_t cluster_id;
+    uint8_t dst_addr_mode;
+    union {
+        uint16_t addr_short;
+        esp_zb_ieee_addr_t addr_long;
+    } dst_address_u;
+    uint8_t dst_endp;
+    uint16_t req_dst_addr;
+} esp_zb_zdo_bind_req_param_t;
+
+typedef void (*esp_zb_zdo_bind_callback_t)(esp_zb_zdp_status_t zdo_status, void *user_ctx);
@@ -0,0 +1,1561 @@
+/* Fake esp-zigbee-lib for the host harness: the subset of the API the application calls,
+ * driven by the host clock.
+ *
+ * The stack keeps the attribute tables the application registers, runs a min/max/change
+ * reporting engine over them, logs every frame the device would transmit and answers as the
+ * coordinator would after a fixed delay (send status, bind, Time read, OTA blocks). Link
+ * outages turn those answers into failures. CAN_SLEEP is raised whenever nothing is due
+ * within the sleep threshold, and esp_zb_sleep_now() moves the clock to the next stack
+ * deadline, esp_timer or EXT1 pin edge.
+ *
+ * Simplifications: responses do not wait for a parent poll, automatic reports get a send
+ * status callback like explicit commands (the real stack only does that for the latter, but
+ * report_queue outages can then be exercised without remote reads), and the device's own
+ * rejoin, leave and remote attribute writes are not modelled.
+ */
+#include "fake_zb.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_zigbee_core.h"
+#include "esp_zigbee_ota.h"
+#include "esp_zigbee_trace.h"
+#include "zcl/esp_zigbee_zcl_common.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "host_shim.h"
+
+#define FAKE_ZB_US_PER_S 1000000LL
+#define FAKE_ZB_EVENTS_MAX 64
+#define FAKE_ZB_REPORTS_MAX 32
+#define FAKE_ZB_OUTAGES_MAX 8
+
+/* Secured unicast up to and including APS, as sim.c counts it: PHY 6, MAC 9 + FCS 2,
+ * NWK 8 + auxiliary header 14 + MIC 4, APS 8. ZCL frames add their 3-byte header.
+ */
+#define FAKE_ZB_NWK_FRAME_BYTES 51
+#define FAKE_ZB_ZCL_HEADER_BYTES 3
+#define FAKE_ZB_ZCL_MANUF_BYTES 2
+#define FAKE_ZB_ATTR_RECORD_BYTES 3     /* attribute ID and type ahead of the value */
+#define FAKE_ZB_POLL_BYTES 18           /* MAC data request */
+#define FAKE_ZB_BIND_REQ_BYTES 22       /* ZDO TSN and Bind_req with 64-bit destination */
+#define FAKE_ZB_OTA_QUERY_BYTES 9
+#define FAKE_ZB_OTA_BLOCK_REQ_BYTES 14
+#define FAKE_ZB_OTA_END_REQ_BYTES 9
+
+#define FAKE_ZB_ZDO_TIMEOUT_US (5 * FAKE_ZB_US_PER_S)
+#define FAKE_ZB_JOIN_RETRY_US FAKE_ZB_US_PER_S
+#define FAKE_ZB_SHORT_ADDR 0x1A2B
+#define FAKE_ZB_COORDINATOR_SHORT 0x0000
+#define FAKE_ZB_COORDINATOR_ENDPOINT 1
+#define FAKE_ZB_PAN_ID 0x1A62
+#define FAKE_ZB_CHANNEL 15
+#define FAKE_ZB_TX_POWER_MIN -24
+#define FAKE_ZB_TX_POWER_MAX 20
+
+static const esp_zb_ieee_addr_t s_device_ieee = {0x11, 0x22, 0x33, 0xFE, 0xFF, 0x44, 0x55, 0x66};
+static const esp_zb_ieee_addr_t s_coordinator_ieee = {0x01, 0x02, 0x03, 0xFE, 0xFF, 0x04, 0x05, 0x06};
+static const esp_zb_ieee_addr_t s_ext_pan_id = {0xDD, 0xDD, 0xDD, 0xDD, 0xDD, 0xDD, 0xDD, 0xDD};
+
+typedef enum {
+    FAKE_ZB_EV_SIGNAL,
+    FAKE_ZB_EV_SEND_STATUS,
+    FAKE_ZB_EV_BIND,
+    FAKE_ZB_EV_TIME_RESP,
+    FAKE_ZB_EV_GET_PROFILE,
+} fake_zb_event_kind_t;
+
+typedef struct {
+    int64_t t_us;
+    fake_zb_event_kind_t kind;
+    uint32_t signal;
+    esp_err_t status;
+    uint8_t tsn;
+    uint8_t src_endpoint;
+    uint8_t dst_endpoint;
+    uint16_t dst_short;
+    uint8_t periods;                /* Get Profile NumberOfPeriods */
+    esp_zb_zdo_bind_callback_t bind_cb;
+    void *bind_ctx;
+} fake_zb_event_t;
+
+typedef struct {
+    uint8_t ep;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint16_t manuf_code;
+    uint16_t min_s;
+    uint16_t max_s;
+    int64_t delta;
+    bool enabled;
+    bool has_last;
+    int64_t last_us;
+    int64_t last_value;
+} fake_zb_report_t;
+
+typedef enum {
+    FAKE_ZB_OTA_IDLE,
+    FAKE_ZB_OTA_QUERY,
+    FAKE_ZB_OTA_QUERY_RESP,
+    FAKE_ZB_OTA_BLOCK_REQ,
+    FAKE_ZB_OTA_BLOCK_RESP,
+    FAKE_ZB_OTA_CHECK,
+    FAKE_ZB_OTA_END_REQ,
+    FAKE_ZB_OTA_FINISH,
+} fake_zb_ota_phase_t;
+
+static fake_zb_config_t s_cfg;
+static fake_zb_stats_t s_stats;
+
+static fake_zb_frame_t *s_frames;
+static size_t s_frame_count;
+static size_t s_frame_cap;
+
+static fake_zb_event_t s_events[FAKE_ZB_EVENTS_MAX];
+static size_t s_event_count;
+
+static fake_zb_report_t s_reports[FAKE_ZB_REPORTS_MAX];
+static size_t s_report_count;
+
+static struct {
+    int64_t from_us;
+    int64_t to_us;
+} s_outages[FAKE_ZB_OUTAGES_MAX];
+static size_t s_outage_count;
+
+static esp_zb_ep_list_t *s_ep_list;
+static esp_zb_core_action_callback_t s_core_cb;
+static esp_zb_zcl_command_send_status_callback_t s_send_status_cb;
+
+static uint32_t s_keep_alive_ms;
+static bool s_started;
+static bool s_zb_inited;            /* table sizes are fixed from esp_zb_init() on */
+static bool s_joined;
+static bool s_factory_new = true;
+static bool s_rx_on_when_idle = true;
+static bool s_sleep_enabled;
+static uint32_t s_sleep_threshold_ms = 20;
+static uint8_t s_bdb_mode;
+static uint32_t s_primary_channels;
+static uint32_t s_secondary_channels;
+static int8_t s_tx_power;
+static uint8_t s_tsn;
+static int64_t s_next_poll_us;
+
+static fake_zb_ota_t s_ota;
+static fake_zb_ota_phase_t s_ota_phase;
+static int64_t s_ota_next_us;
+static uint32_t s_ota_offset;
+static uint16_t s_ota_query_interval_min = ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF;
+static uint8_t s_ota_block[UINT16_MAX];
+
+static jmp_buf s_run_jmp;
+static bool s_running;
+static bool s_ran;
+static int64_t s_stop_us;
+
+/* ---- harness controls ---- */
+
+void fake_zb_init(const fake_zb_config_t *cfg)
+{
+    s_cfg = cfg ? *cfg : (fake_zb_config_t){0};
+    if (!cfg) {
+        s_cfg.join_delay_us = 3 * FAKE_ZB_US_PER_S;
+        s_cfg.response_delay_us = 50000;
+    }
+    s_stats = (fake_zb_stats_t){
+        .first_sleep_us = -1,
+        .joined_us = -1,
+        .ota_start_us = -1,
+        .ota_end_us = -1,
+    };
+    s_frame_count = 0;
+    s_event_count = 0;
+    s_report_count = 0;
+    s_outage_count = 0;
+    s_started = false;
+    s_zb_inited = false;
+    s_joined = false;
+    s_factory_new = !s_cfg.commissioned;
+    s_rx_on_when_idle = true;
+    s_sleep_enabled = false;
+    s_ota_phase = FAKE_ZB_OTA_IDLE;
+}
+
+void fake_zb_link_outage(int64_t from_us, int64_t to_us)
+{
+    if (s_outage_count < FAKE_ZB_OUTAGES_MAX) {
+        s_outages[s_outage_count].from_us = from_us;
+        s_outages[s_outage_count].to_us = to_us;
+        s_outage_count++;
+    }
+}
+
+void fake_zb_ota_offer(const fake_zb_ota_t *ota)
+{
+    s_ota = *ota;
+    s_ota_phase = FAKE_ZB_OTA_QUERY;
+    s_ota_next_us = ota->start_us;
+    s_ota_offset = 0;
+}
+
+static void fake_zb_post(const fake_zb_event_t *ev);
+
+void fake_zb_get_profile(int64_t t_us, uint8_t endpoint, uint8_t periods)
+{
+    fake_zb_post(&(fake_zb_event_t){
+        .t_us = t_us,
+        .kind = FAKE_ZB_EV_GET_PROFILE,
+        .src_endpoint = FAKE_ZB_COORDINATOR_ENDPOINT,
+        .dst_endpoint = endpoint,
+        .dst_short = FAKE_ZB_COORDINATOR_SHORT,
+        .periods = periods,
+    });
+}
+
+const fake_zb_stats_t *fake_zb_stats(void)
+{
+    return &s_stats;
+}
+
+size_t fake_zb_frames(const fake_zb_frame_t **out)
+{
+    *out = s_frames;
+    return s_frame_count;
+}
+
+static void fake_zb_restart(void)
+{
+    s_stats.restarted = true;
+    s_stats.restart_us = esp_timer_get_time();
+    longjmp(s_run_jmp, 2);
+}
+
+bool fake_zb_run(const char *task_name, int64_t until_us)
+{
+    TaskHandle_t task = host_task_find(task_name);
+    if (!task || s_ran) {
+        return false;
+    }
+    s_ran = true;
+    s_stop_us = until_us;
+    host_task_set_current(task);
+    host_set_restart_hook(fake_zb_restart);
+
+    int rc = setjmp(s_run_jmp);
+    if (rc == 0) {
+        s_running = true;
+        task->fn(task->arg);
+    }
+    s_running = false;
+    host_set_restart_hook(NULL);
+    return rc == 1;
+}
+
+/* ---- attribute storage ---- */
+
+static uint16_t fake_zb_manuf(uint16_t manuf_code)
+{
+    /* Zero-initialised reporting info means "not manufacturer specific" too. */
+    return manuf_code == 0 ? ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC : manuf_code;
+}
+
+static uint16_t fake_zb_value_size(uint8_t type, const void *value)
+{
+    switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_BOOL:
+    case ESP_ZB_ZCL_ATTR_TYPE_8BITMAP:
+    case ESP_ZB_ZCL_ATTR_TYPE_U8:
+    case ESP_ZB_ZCL_ATTR_TYPE_S8:
+    case ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM:
+        return 1;
+    case ESP_ZB_ZCL_ATTR_TYPE_16BITMAP:
+    case ESP_ZB_ZCL_ATTR_TYPE_U16:
+    case ESP_ZB_ZCL_ATTR_TYPE_S16:
+    case ESP_ZB_ZCL_ATTR_TYPE_16BIT_ENUM:
+        return 2;
+    case ESP_ZB_ZCL_ATTR_TYPE_U24:
+    case ESP_ZB_ZCL_ATTR_TYPE_S24:
+        return 3;
+    case ESP_ZB_ZCL_ATTR_TYPE_32BITMAP:
+    case ESP_ZB_ZCL_ATTR_TYPE_U32:
+    case ESP_ZB_ZCL_ATTR_TYPE_S32:
+    case ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME:
+        return 4;
+    case ESP_ZB_ZCL_ATTR_TYPE_U48:
+        return 6;
+    case ESP_ZB_ZCL_ATTR_TYPE_IEEE_ADDR:
+        return 8;
+    case ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING:
+    case ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING: {
+        uint8_t len = value ? *(const uint8_t *)value : 0;
+        return (uint16_t)(1 + (len == 0xFF ? 0 : len));
+    }
+    default:
+        return 0;
+    }
+}
+
+static bool fake_zb_decode(uint8_t type, const void *value, int64_t *out)
+{
+    uint16_t size = fake_zb_value_size(type, value);
+    if (!value || size == 0 || size > 6 || type == ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING ||
+        type == ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING) {
+        return false;
+    }
+    const uint8_t *b = (const uint8_t *)value;
+    uint64_t raw = 0;
+    for (uint16_t i = 0; i < size; i++) {
+        raw |= (uint64_t)b[i] << (8 * i);
+    }
+    bool is_signed = type == ESP_ZB_ZCL_ATTR_TYPE_S8 || type == ESP_ZB_ZCL_ATTR_TYPE_S16 ||
+                     type == ESP_ZB_ZCL_ATTR_TYPE_S24 || type == ESP_ZB_ZCL_ATTR_TYPE_S32;
+    if (is_signed && (raw & (1ULL << (8 * size - 1)))) {
+        raw |= ~0ULL << (8 * size);
+    }
+    *out = (int64_t)raw;
+    return true;
+}
+
+static esp_err_t fake_zb_list_append(esp_zb_attribute_list_t *list, uint16_t attr_id, uint16_t manuf_code,
+                                     uint8_t type, uint8_t access, const void *value, uint16_t size)
+{
+    if (!list || !value || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_zb_attribute_list_t *tail = list;
+    while (tail->next) {
+        tail = tail->next;
+        if (tail->attribute.id == attr_id && tail->manuf_code == manuf_code) {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    esp_zb_attribute_list_t *node = calloc(1, sizeof(*node));
+    void *copy = malloc(size);
+    if (!node || !copy) {
+        free(node);
+        free(copy);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, value, size);
+    *node = (esp_zb_attribute_list_t){
+        .attribute = {.id = attr_id, .data = {.type = type, .size = size, .value = copy}},
+        .cluster_id = list->cluster_id,
+        .manuf_code = manuf_code,
+        .access = access,
+    };
+    tail->next = node;
+    return ESP_OK;
+}
+
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id)
+{
+    esp_zb_attribute_list_t *list = calloc(1, sizeof(*list));
+    if (list) {
+        list->cluster_id = cluster_id;
+        list->attribute.id = 0xFFFF;
+    }
+    return list;
+}
+
+esp_err_t esp_zb_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t cluster_id, uint16_t attr_id,
+                                  uint8_t attr_type, uint8_t attr_access, void *value_p)
+{
+    return esp_zb_cluster_add_manufacturer_attr(attr_list, cluster_id, attr_id,
+                                                ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC, attr_type, attr_access,
+                                                value_p);
+}
+
+esp_err_t esp_zb_cluster_add_manufacturer_attr(esp_zb_attribute_list_t *attr_list, uint16_t cluster_id,
+                                               uint16_t attr_id, uint16_t manuf_code, uint8_t attr_type,
+                                               uint8_t attr_access, void *value_p)
+{
+    if (!attr_list || attr_list->cluster_id != cluster_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return fake_zb_list_append(attr_list, attr_id, manuf_code, attr_type, attr_access, value_p,
+                               fake_zb_value_size(attr_type, value_p));
+}
+
+esp_zb_attribute_list_t *esp_zb_basic_cluster_create(esp_zb_basic_cluster_cfg_t *basic_cfg)
+{
+    esp_zb_attribute_list_t *list = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_BASIC);
+    esp_zb_basic_cluster_cfg_t cfg = basic_cfg ? *basic_cfg
+                                               : (esp_zb_basic_cluster_cfg_t){
+                                                     .zcl_version = ESP_ZB_ZCL_BASIC_ZCL_VERSION_DEFAULT_VALUE,
+                                                 };
+    esp_zb_cluster_add_attr(list, ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_ATTR_BASIC_ZCL_VERSION_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &cfg.zcl_version);
+    esp_zb_cluster_add_attr(list, ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &cfg.power_source);
+    return list;
+}
+
+esp_zb_attribute_list_t *esp_zb_power_config_cluster_create(esp_zb_power_config_cluster_cfg_t *power_cfg)
+{
+    esp_zb_attribute_list_t *list = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG);
+    esp_zb_power_config_cluster_cfg_t cfg = power_cfg ? *power_cfg : (esp_zb_power_config_cluster_cfg_t){0};
+    const uint16_t cl = ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG;
+    const uint8_t ro = ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY;
+    const uint8_t rw = ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE;
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_VOLTAGE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, ro,
+                            &cfg.main_voltage);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_FREQUENCY_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, ro,
+                            &cfg.main_freq);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_ALARM_MASK_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP,
+                            rw, &cfg.main_alarm_mask);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_VOLTAGE_MIN_THRESHOLD,
+                            ESP_ZB_ZCL_ATTR_TYPE_U16, rw, &cfg.main_voltage_min);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_VOLTAGE_MAX_THRESHOLD,
+                            ESP_ZB_ZCL_ATTR_TYPE_U16, rw, &cfg.main_voltage_max);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_POWER_CONFIG_MAINS_DWELL_TRIP_POINT, ESP_ZB_ZCL_ATTR_TYPE_U16,
+                            rw, &cfg.main_voltage_dwell);
+    return list;
+}
+
+esp_zb_attribute_list_t *esp_zb_ota_cluster_create(esp_zb_ota_cluster_cfg_t *ota_cfg)
+{
+    esp_zb_attribute_list_t *list = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE);
+    esp_zb_ota_cluster_cfg_t cfg = ota_cfg ? *ota_cfg : (esp_zb_ota_cluster_cfg_t){0};
+    const uint16_t cl = ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE;
+    const uint8_t ro = ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY;
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ID, ESP_ZB_ZCL_ATTR_TYPE_IEEE_ADDR, ro,
+                            cfg.ota_upgrade_server_id);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID, ESP_ZB_ZCL_ATTR_TYPE_U32, ro,
+                            &cfg.ota_upgrade_file_offset);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID, ESP_ZB_ZCL_ATTR_TYPE_U32, ro,
+                            &cfg.ota_upgrade_file_version);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_U32, ro, &cfg.ota_upgrade_downloaded_file_ver);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM, ro,
+                            &cfg.ota_image_upgrade_status);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, ro,
+                            &cfg.ota_upgrade_manufacturer);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, ro,
+                            &cfg.ota_upgrade_image_type);
+    esp_zb_cluster_add_attr(list, cl, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, ro,
+                            &cfg.ota_min_block_reque);
+    return list;
+}
+
+esp_zb_attribute_list_t *esp_zb_time_cluster_create(void *time_cfg)
+{
+    (void)time_cfg;
+    esp_zb_attribute_list_t *list = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_TIME);
+    uint32_t invalid = 0xFFFFFFFF;
+    esp_zb_cluster_add_attr(list, ESP_ZB_ZCL_CLUSTER_ID_TIME, ESP_ZB_ZCL_ATTR_TIME_TIME_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &invalid);
+    return list;
+}
+
+esp_err_t esp_zb_ota_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    uint8_t type;
+    uint16_t size;
+    switch (attr_id) {
+    case ESP_ZB_ZCL_ATTR_OTA_UPGRADE_STACK_VERSION_ID:
+    case ESP_ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_STACK_VERSION_ID:
+    case ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID:
+        type = ESP_ZB_ZCL_ATTR_TYPE_U16;
+        size = 2;
+        break;
+    case ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STAMP_ID:
+        type = ESP_ZB_ZCL_ATTR_TYPE_U32;
+        size = 4;
+        break;
+    case ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID:
+        type = ESP_ZB_ZCL_ATTR_TYPE_U8;
+        size = 1;
+        break;
+    case ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID:
+        type = ESP_ZB_ZCL_ATTR_TYPE_ARRAY;
+        size = sizeof(esp_zb_zcl_ota_upgrade_client_variable_t);
+        break;
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return fake_zb_list_append(attr_list, attr_id, ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC, type,
+                               ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, value_p, size);
+}
+
+esp_zb_cluster_list_t *esp_zb_zcl_cluster_list_create(void)
+{
+    return calloc(1, sizeof(esp_zb_cluster_list_t));
+}
+
+static esp_err_t fake_zb_cluster_list_add(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                          uint8_t role_mask)
+{
+    if (!cluster_list || !attr_list) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_zb_cluster_list_t *node = calloc(1, sizeof(*node));
+    if (!node) {
+        return ESP_ERR_NO_MEM;
+    }
+    *node = (esp_zb_cluster_list_t){.cluster_id = attr_list->cluster_id, .role = role_mask, .attr_list = attr_list};
+    esp_zb_cluster_list_t *tail = cluster_list;
+    while (tail->next) {
+        tail = tail->next;
+    }
+    tail->next = node;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_cluster_list_add_basic_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                uint8_t role_mask)
+{
+    return fake_zb_cluster_list_add(cluster_list, attr_list, role_mask);
+}
+
+esp_err_t esp_zb_cluster_list_add_power_config_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                       esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return fake_zb_cluster_list_add(cluster_list, attr_list, role_mask);
+}
+
+esp_err_t esp_zb_cluster_list_add_metering_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                   esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return fake_zb_cluster_list_add(cluster_list, attr_list, role_mask);
+}
+
+esp_err_t esp_zb_cluster_list_add_ota_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                              uint8_t role_mask)
+{
+    return fake_zb_cluster_list_add(cluster_list, attr_list, role_mask);
+}
+
+esp_err_t esp_zb_cluster_list_add_time_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                               uint8_t role_mask)
+{
+    return fake_zb_cluster_list_add(cluster_list, attr_list, role_mask);
+}
+
+esp_err_t esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list_t *cluster_list,
+                                                 esp_zb_attribute_list_t *attr_list, uint8_t role_mask)
+{
+    return fake_zb_cluster_list_add(cluster_list, attr_list, role_mask);
+}
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void)
+{
+    return calloc(1, sizeof(esp_zb_ep_list_t));
+}
+
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list,
+                                esp_zb_endpoint_config_t endpoint_config)
+{
+    if (!ep_list || !cluster_list) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_zb_ep_list_t *node = calloc(1, sizeof(*node));
+    if (!node) {
+        return ESP_ERR_NO_MEM;
+    }
+    *node = (esp_zb_ep_list_t){.config = endpoint_config, .cluster_list = cluster_list};
+    esp_zb_ep_list_t *tail = ep_list;
+    while (tail->next) {
+        tail = tail->next;
+    }
+    tail->next = node;
+    return ESP_OK;
+}
+
+static esp_zb_cluster_list_t *fake_zb_find_cluster(uint8_t endpoint, uint16_t cluster_id, uint8_t role)
+{
+    for (esp_zb_ep_list_t *ep = s_ep_list ? s_ep_list->next : NULL; ep; ep = ep->next) {
+        if (ep->config.endpoint != endpoint) {
+            continue;
+        }
+        for (esp_zb_cluster_list_t *cl = ep->cluster_list->next; cl; cl = cl->next) {
+            if (cl->cluster_id == cluster_id && (cl->role & role)) {
+                return cl;
+            }
+        }
+    }
+    return NULL;
+}
+
+static esp_zb_attribute_list_t *fake_zb_find_attr(uint8_t endpoint, uint16_t cluster_id, uint8_t role,
+                                                  uint16_t manuf_code, uint16_t attr_id)
+{
+    esp_zb_cluster_list_t *cl = fake_zb_find_cluster(endpoint, cluster_id, role);
+    if (!cl) {
+        return NULL;
+    }
+    manuf_code = fake_zb_manuf(manuf_code);
+    for (esp_zb_attribute_list_t *a = cl->attr_list->next; a; a = a->next) {
+        if (a->attribute.id == attr_id && a->manuf_code == manuf_code) {
+            return a;
+        }
+    }
+    return NULL;
+}
+
+static esp_zb_zcl_status_t fake_zb_set_value(uint8_t endpoint, uint16_t cluster_id, uint8_t role,
+                                             uint16_t manuf_code, uint16_t attr_id, const void *value_p)
+{
+    esp_zb_attribute_list_t *a = fake_zb_find_attr(endpoint, cluster_id, role, manuf_code, attr_id);
+    if (!a) {
+        return ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB;
+    }
+    if (!value_p) {
+        return ESP_ZB_ZCL_STATUS_INVALID_VALUE;
+    }
+    uint16_t size = a->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_ARRAY
+                        ? a->attribute.data.size
+                        : fake_zb_value_size(a->attribute.data.type, value_p);
+    if (size != a->attribute.data.size) {
+        void *grown = realloc(a->attribute.data.value, size);
+        if (!grown) {
+            return ESP_ZB_ZCL_STATUS_FAIL;
+        }
+        a->attribute.data.value = grown;
+        a->attribute.data.size = size;
+    }
+    memcpy(a->attribute.data.value, value_p, size);
+    s_stats.attr_writes++;
+    return ESP_ZB_ZCL_STATUS_SUCCESS;
+}
+
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role,
+                                                 uint16_t attr_id, void *value_p, bool check)
+{
+    (void)check;
+    return fake_zb_set_value(endpoint, cluster_id, cluster_role, ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC, attr_id,
+                             value_p);
+}
+
+esp_zb_zcl_status_t esp_zb_zcl_set_manufacturer_attribute_val(uint8_t endpoint, uint16_t cluster_id,
+                                                              uint8_t cluster_role, uint16_t manuf_code,
+                                                              uint16_t attr_id, void *value_p, bool check)
+{
+    (void)check;
+    return fake_zb_set_value(endpoint, cluster_id, cluster_role, manuf_code, attr_id, value_p);
+}
+
+bool fake_zb_attr_value(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, int64_t *out)
+{
+    esp_zb_attribute_list_t *a = fake_zb_find_attr(endpoint, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                                   ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC, attr_id);
+    return a && fake_zb_decode(a->attribute.data.type, a->attribute.data.value, out);
+}
+
+/* ---- frames and events ---- */
+
+static int64_t fake_zb_poll_interval_us(void)
+{
+    uint32_t ms = s_cfg.poll_interval_ms ? s_cfg.poll_interval_ms : s_keep_alive_ms;
+    return (int64_t)(ms ? ms : 60000) * 1000;
+}
+
+static bool fake_zb_link_up(int64_t now)
+{
+    for (size_t i = 0; i < s_outage_count; i++) {
+        if (now >= s_outages[i].from_us && now < s_outages[i].to_us) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Log one transmitted frame; returns whether the coordinator gets it. */
+static bool fake_zb_tx(fake_zb_frame_kind_t kind, uint8_t src_endpoint, uint16_t cluster_id,
+                       const uint16_t *attr_ids, uint8_t attr_count, uint16_t air_bytes)
+{
+    int64_t now = esp_timer_get_time();
+    bool delivered = fake_zb_link_up(now);
+    if (s_frame_count == s_frame_cap) {
+        size_t cap = s_frame_cap ? 2 * s_frame_cap : 256;
+        fake_zb_frame_t *grown = realloc(s_frames, cap * sizeof(*grown));
+        if (!grown) {
+            fprintf(stderr, "fake_zb: out of memory for the frame log\n");
+            abort();
+        }
+        s_frames = grown;
+        s_frame_cap = cap;
+    }
+    fake_zb_frame_t *f = &s_frames[s_frame_count++];
+    *f = (fake_zb_frame_t){
+        .t_us = now,
+        .kind = (uint8_t)kind,
+        .delivered = delivered,
+        .src_endpoint = src_endpoint,
+        .cluster_id = cluster_id,
+        .attr_count = attr_count > FAKE_ZB_FRAME_ATTRS ? FAKE_ZB_FRAME_ATTRS : attr_count,
+        .air_bytes = air_bytes,
+    };
+    for (uint8_t i = 0; i < f->attr_count; i++) {
+        f->attr_ids[i] = attr_ids[i];
+    }
+    s_stats.frames[kind]++;
+    s_stats.air_bytes[kind] += air_bytes;
+    if (!delivered) {
+        s_stats.failed++;
+    }
+    return delivered;
+}
+
+static uint16_t fake_zb_zcl_bytes(bool manuf, uint32_t payload)
+{
+    return (uint16_t)(FAKE_ZB_NWK_FRAME_BYTES + FAKE_ZB_ZCL_HEADER_BYTES + (manuf ? FAKE_ZB_ZCL_MANUF_BYTES : 0) +
+                      payload);
+}
+
+static void fake_zb_post(const fake_zb_event_t *ev)
+{
+    if (s_event_count == FAKE_ZB_EVENTS_MAX) {
+        fprintf(stderr, "fake_zb: event queue full\n");
+        abort();
+    }
+    s_events[s_event_count++] = *ev;
+}
+
+static void fake_zb_post_signal(uint32_t signal, esp_err_t status, int64_t delay_us)
+{
+    fake_zb_post(&(fake_zb_event_t){
+        .t_us = esp_timer_get_time() + delay_us,
+        .kind = FAKE_ZB_EV_SIGNAL,
+        .signal = signal,
+        .status = status,
+    });
+}
+
+static uint8_t fake_zb_post_send_status(bool delivered, uint8_t src_endpoint, uint16_t dst_short, uint8_t dst_endpoint)
+{
+    uint8_t tsn = s_tsn++;
+    fake_zb_post(&(fake_zb_event_t){
+        .t_us = esp_timer_get_time() + s_cfg.response_delay_us,
+        .kind = FAKE_ZB_EV_SEND_STATUS,
+        .status = delivered ? ESP_OK : ESP_FAIL,
+        .tsn = tsn,
+        .src_endpoint = src_endpoint,
+        .dst_endpoint = dst_endpoint,
+        .dst_short = dst_short,
+    });
+    return tsn;
+}
+
+static void fake_zb_raise_signal(uint32_t signal, esp_err_t status)
+{
+    uint32_t sig = signal;
+    esp_zb_app_signal_t s = {.p_app_signal = &sig, .esp_err_status = status};
+    esp_zb_app_signal_handler(&s);
+}
+
+static void fake_zb_time_response(const fake_zb_event_t *ev)
+{
+    if (!s_core_cb) {
+        return;
+    }
+    uint32_t utc = s_cfg.utc_base_s + (uint32_t)(esp_timer_get_time() / FAKE_ZB_US_PER_S);
+    int32_t zone = 0;
+    uint32_t local = utc;
+    esp_zb_zcl_read_attr_resp_variable_t vars[3] = {
+        {.status = ESP_ZB_ZCL_STATUS_SUCCESS,
+         .attribute = {.id = ESP_ZB_ZCL_ATTR_TIME_TIME_ID,
+                       .data = {.type = ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME, .size = 4, .value = &utc}}},
+        {.status = ESP_ZB_ZCL_STATUS_SUCCESS,
+         .attribute = {.id = ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID,
+                       .data = {.type = ESP_ZB_ZCL_ATTR_TYPE_S32, .size = 4, .value = &zone}}},
+        {.status = ESP_ZB_ZCL_STATUS_SUCCESS,
+         .attribute = {.id = ESP_ZB_ZCL_ATTR_TIME_LOCAL_TIME_ID,
+                       .data = {.type = ESP_ZB_ZCL_ATTR_TYPE_U32, .size = 4, .value = &local}}},
+    };
+    vars[0].next = &vars[1];
+    vars[1].next = &vars[2];
+    esp_zb_zcl_cmd_read_attr_resp_message_t msg = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .src_address = {.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT, .u.short_addr = ev->dst_short},
+            .dst_address = FAKE_ZB_SHORT_ADDR,
+            .src_endpoint = ev->dst_endpoint,
+            .dst_endpoint = ev->src_endpoint,
+            .cluster = ESP_ZB_ZCL_CLUSTER_ID_TIME,
+            .profile = ESP_ZB_AF_HA_PROFILE_ID,
+        },
+        .variables = vars,
+    };
+    (void)s_core_cb(ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID, &msg);
+}
+
+/* Get Profile from the coordinator: channel 0, EndTime 0 (most recent), ev->periods intervals. */
+static void fake_zb_get_profile_request(const fake_zb_event_t *ev)
+{
+    if (!s_core_cb || !s_joined) {
+        return;
+    }
+    uint8_t req[6] = {0x00, 0, 0, 0, 0, ev->periods};
+    esp_zb_zcl_privilege_command_message_t msg = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .src_address = {.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT, .u.short_addr = ev->dst_short},
+            .dst_address = FAKE_ZB_SHORT_ADDR,
+            .src_endpoint = ev->src_endpoint,
+            .dst_endpoint = ev->dst_endpoint,
+            .cluster = ESP_ZB_ZCL_CLUSTER_ID_METERING,
+            .profile = ESP_ZB_AF_HA_PROFILE_ID,
+            .command = {.id = 0x00},            /* Get Profile */
+        },
+        .size = sizeof(req),
+        .data = req,
+    };
+    (void)s_core_cb(ESP_ZB_CORE_CMD_PRIVILEGE_COMMAND_REQ_CB_ID, &msg);
+}
+
+static void fake_zb_dispatch(const fake_zb_event_t *ev)
+{
+    switch (ev->kind) {
+    case FAKE_ZB_EV_SIGNAL:
+        if (ev->signal == ESP_ZB_BDB_SIGNAL_STEERING || ev->signal == ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT) {
+            s_bdb_mode = 0;
+            if (ev->status == ESP_OK) {
+                s_joined = true;
+                s_factory_new = false;
+                s_stats.joined_us = esp_timer_get_time();
+                s_next_poll_us = s_stats.joined_us + fake_zb_poll_interval_us();
+            }
+        }
+        fake_zb_raise_signal(ev->signal, ev->status);
+        break;
+    case FAKE_ZB_EV_SEND_STATUS:
+        if (s_send_status_cb) {
+            esp_zb_zcl_command_send_status_message_t msg = {
+                .status = ev->status,
+                .tsn = ev->tsn,
+                .dst_addr = {.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT, .u.short_addr = ev->dst_short},
+                .dst_endpoint = ev->dst_endpoint,
+                .src_endpoint = ev->src_endpoint,
+            };
+            s_send_status_cb(msg);
+        }
+        break;
+    case FAKE_ZB_EV_BIND:
+        if (ev->bind_cb) {
+            ev->bind_cb(ev->status == ESP_OK ? ESP_ZB_ZDP_STATUS_SUCCESS : ESP_ZB_ZDP_STATUS_TIMEOUT, ev->bind_ctx);
+        }
+        break;
+    case FAKE_ZB_EV_TIME_RESP:
+        fake_zb_time_response(ev);
+        break;
+    case FAKE_ZB_EV_GET_PROFILE:
+        fake_zb_get_profile_request(ev);
+        break;
+    }
+}
+
+/* Pop and dispatch events due by now, earliest first; handlers may post more. */
+static void fake_zb_run_events(int64_t now)
+{
+    while (s_event_count > 0) {
+        size_t best = 0;
+        for (size_t i = 1; i < s_event_count; i++) {
+            if (s_events[i].t_us < s_events[best].t_us) {
+                best = i;
+            }
+        }
+        if (s_events[best].t_us > now) {
+            return;
+        }
+        fake_zb_event_t ev = s_events[best];
+        memmove(&s_events[best], &s_events[best + 1], (s_event_count - best - 1) * sizeof(s_events[0]));
+        s_event_count--;
+        fake_zb_dispatch(&ev);
+    }
+}
+
+/* ---- reporting ---- */
+
+static fake_zb_report_t *fake_zb_report_find(uint8_t ep, uint16_t cluster_id, uint16_t manuf_code, uint16_t attr_id,
+                                             bool create)
+{
+    manuf_code = fake_zb_manuf(manuf_code);
+    for (size_t i = 0; i < s_report_count; i++) {
+        fake_zb_report_t *r = &s_reports[i];
+        if (r->ep == ep && r->cluster_id == cluster_id && r->manuf_code == manuf_code && r->attr_id == attr_id) {
+            return r;
+        }
+    }
+    if (!create || s_report_count == FAKE_ZB_REPORTS_MAX ||
+        !fake_zb_find_attr(ep, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, manuf_code, attr_id)) {
+        return NULL;
+    }
+    fake_zb_report_t *r = &s_reports[s_report_count++];
+    *r = (fake_zb_report_t){
+        .ep = ep,
+        .cluster_id = cluster_id,
+        .attr_id = attr_id,
+        .manuf_code = manuf_code,
+        .delta = 1,
+    };
+    return r;
+}
+
+esp_err_t esp_zb_zcl_update_reporting_info(esp_zb_zcl_reporting_info_t *report_info)
+{
+    if (!report_info || report_info->direction != ESP_ZB_ZCL_REPORT_DIRECTION_SEND) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fake_zb_report_t *r = fake_zb_report_find(report_info->ep, report_info->cluster_id, report_info->manuf_code,
+                                              report_info->attr_id, true);
+    if (!r) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_zb_attribute_list_t *a = fake_zb_find_attr(r->ep, r->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                                   r->manuf_code, r->attr_id);
+    r->min_s = report_info->u.send_info.min_interval;
+    r->max_s = report_info->u.send_info.max_interval;
+    int64_t delta = 0;
+    if (fake_zb_decode(a->attribute.data.type, &report_info->u.send_info.delta, &delta)) {
+        r->delta = delta;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_zcl_start_attr_reporting(esp_zb_zcl_attr_location_info_t attr_info)
+{
+    fake_zb_report_t *r = fake_zb_report_find(attr_info.endpoint_id, attr_info.cluster_id, attr_info.manuf_code,
+                                              attr_info.attr_id, true);
+    if (!r) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!r->enabled) {
+        r->enabled = true;
+        r->last_us = esp_timer_get_time();
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_zcl_stop_attr_reporting(esp_zb_zcl_attr_location_info_t attr_info)
+{
+    fake_zb_report_t *r = fake_zb_report_find(attr_info.endpoint_id, attr_info.cluster_id, attr_info.manuf_code,
+                                              attr_info.attr_id, false);
+    if (!r) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    r->enabled = false;
+    return ESP_OK;
+}
+
+/* Earliest time the entry is due, or INT64_MAX; value is the attribute's current value. */
+static int64_t fake_zb_report_due(const fake_zb_report_t *r, int64_t *value)
+{
+    esp_zb_attribute_list_t *a = fake_zb_find_attr(r->ep, r->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                                   r->manuf_code, r->attr_id);
+    bool numeric = a && fake_zb_decode(a->attribute.data.type, a->attribute.data.value, value);
+    if (!r->has_last) {
+        return r->last_us;
+    }
+    int64_t due = INT64_MAX;
+    if (r->max_s > 0 && r->max_s != 0xFFFF) {
+        due = r->last_us + (int64_t)r->max_s * FAKE_ZB_US_PER_S;
+    }
+    int64_t delta = r->delta > 0 ? r->delta : 1;
+    int64_t change = numeric ? *value - r->last_value : 0;
+    if (change < 0) {
+        change = -change;
+    }
+    if (numeric && change >= delta) {
+        int64_t at = r->last_us + (int64_t)r->min_s * FAKE_ZB_US_PER_S;
+        if (at < due) {
+            due = at;
+        }
+    }
+    return due;
+}
+
+static void fake_zb_run_reports(int64_t now)
+{
+    bool sent[FAKE_ZB_REPORTS_MAX] = {0};
+    for (size_t i = 0; i < s_report_count; i++) {
+        int64_t value = 0;
+        if (sent[i] || !s_reports[i].enabled || fake_zb_report_due(&s_reports[i], &value) > now) {
+            continue;
+        }
+        /* Everything due on the same endpoint and cluster shares one Report Attributes frame. */
+        uint16_t ids[FAKE_ZB_REPORTS_MAX];
+        uint8_t count = 0;
+        uint32_t payload = 0;
+        const fake_zb_report_t *head = &s_reports[i];
+        for (size_t j = i; j < s_report_count; j++) {
+            fake_zb_report_t *r = &s_reports[j];
+            int64_t v = 0;
+            if (sent[j] || !r->enabled || r->ep != head->ep || r->cluster_id != head->cluster_id ||
+                r->manuf_code != head->manuf_code || fake_zb_report_due(r, &v) > now) {
+                continue;
+            }
+            esp_zb_attribute_list_t *a = fake_zb_find_attr(r->ep, r->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                                           r->manuf_code, r->attr_id);
+            payload += FAKE_ZB_ATTR_RECORD_BYTES + a->attribute.data.size;
+            ids[count++] = r->attr_id;
+            sent[j] = true;
+            r->has_last = true;
+            r->last_us = now;
+            r->last_value = v;
+        }
+        bool manuf = head->manuf_code != ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC;
+        bool delivered = fake_zb_tx(FAKE_ZB_FRAME_REPORT, head->ep, head->cluster_id, ids, count,
+                                    fake_zb_zcl_bytes(manuf, payload));
+        /* Reports go to the binding, which the harness coordinator always accepts. */
+        (void)fake_zb_post_send_status(delivered, head->ep, FAKE_ZB_COORDINATOR_SHORT, FAKE_ZB_COORDINATOR_ENDPOINT);
+    }
+}
+
+/* ---- OTA client ---- */
+
+static uint8_t fake_zb_ota_endpoint(void)
+{
+    for (esp_zb_ep_list_t *ep = s_ep_list ? s_ep_list->next : NULL; ep; ep = ep->next) {
+        if (fake_zb_find_cluster(ep->config.endpoint, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+                                 ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE)) {
+            return ep->config.endpoint;
+        }
+    }
+    return 1;
+}
+
+static esp_err_t fake_zb_ota_status(esp_zb_zcl_ota_upgrade_status_t status, uint8_t *payload, uint16_t payload_size)
+{
+    if (!s_core_cb) {
+        return ESP_FAIL;
+    }
+    esp_zb_zcl_ota_upgrade_value_message_t msg = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .dst_endpoint = fake_zb_ota_endpoint(),
+            .cluster = ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+        },
+        .upgrade_status = status,
+        .ota_header = {
+            .file_version = s_ota.file_version,
+            .image_type = s_ota.image_type,
+            .manufacturer_code = s_ota.manufacturer_code,
+            .image_size = s_ota.image_size,
+        },
+        .payload_size = payload_size,
+        .payload = payload,
+    };
+    return s_core_cb(ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID, &msg);
+}
+
+static void fake_zb_ota_abort(void)
+{
+    s_stats.ota_aborted = true;
+    s_ota_phase = FAKE_ZB_OTA_IDLE;
+    (void)fake_zb_ota_status(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT, NULL, 0);
+}
+
+static void fake_zb_ota_step(int64_t now)
+{
+    uint8_t ep = fake_zb_ota_endpoint();
+    int64_t retry_us = (int64_t)s_ota.block_interval_ms * 1000;
+
+    switch (s_ota_phase) {
+    case FAKE_ZB_OTA_IDLE:
+        break;
+    case FAKE_ZB_OTA_QUERY:
+        if (!s_joined) {
+            s_ota_next_us = now + FAKE_ZB_JOIN_RETRY_US;
+        } else if (fake_zb_tx(FAKE_ZB_FRAME_OTA, ep, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, NULL, 0,
+                              fake_zb_zcl_bytes(false, FAKE_ZB_OTA_QUERY_BYTES))) {
+            s_ota_phase = FAKE_ZB_OTA_QUERY_RESP;
+            s_ota_next_us = now + s_cfg.response_delay_us;
+        } else {
+            s_ota_next_us = now + (int64_t)s_ota_query_interval_min * 60 * FAKE_ZB_US_PER_S;
+        }
+        break;
+    case FAKE_ZB_OTA_QUERY_RESP: {
+        esp_zb_zcl_ota_upgrade_query_image_resp_message_t resp = {
+            .info = {
+                .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+                .dst_endpoint = ep,
+                .cluster = ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+            },
+            .server_addr = {.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT, .u.short_addr = FAKE_ZB_COORDINATOR_SHORT},
+            .server_endpoint = FAKE_ZB_COORDINATOR_ENDPOINT,
+            .file_version = s_ota.file_version,
+            .manufacturer_code = s_ota.manufacturer_code,
+            .image_type = s_ota.image_type,
+            .image_size = s_ota.image_size,
+        };
+        if (!s_core_cb || s_core_cb(ESP_ZB_CORE_OTA_UPGRADE_QUERY_IMAGE_RESP_CB_ID, &resp) != ESP_OK) {
+            s_ota_phase = FAKE_ZB_OTA_IDLE;
+            break;
+        }
+        s_stats.ota_start_us = now;
+        if (fake_zb_ota_status(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START, NULL, 0) != ESP_OK) {
+            fake_zb_ota_abort();
+            break;
+        }
+        s_ota_offset = 0;
+        s_ota_phase = FAKE_ZB_OTA_BLOCK_REQ;
+        s_ota_next_us = now;
+        break;
+    }
+    case FAKE_ZB_OTA_BLOCK_REQ:
+        if (fake_zb_tx(FAKE_ZB_FRAME_OTA, ep, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, NULL, 0,
+                       fake_zb_zcl_bytes(false, FAKE_ZB_OTA_BLOCK_REQ_BYTES))) {
+            s_ota_phase = FAKE_ZB_OTA_BLOCK_RESP;
+            s_ota_next_us = now + s_cfg.response_delay_us;
+        } else {
+            s_ota_next_us = now + retry_us;
+        }
+        break;
+    case FAKE_ZB_OTA_BLOCK_RESP: {
+        uint32_t left = s_ota.image_size - s_ota_offset;
+        uint16_t len = left < s_ota.block_size ? (uint16_t)left : s_ota.block_size;
+        /* A plain OTA file: the upgrade file identifier, then a byte pattern. */
+        static const uint8_t file_id[] = {0x1E, 0xF1, 0xEE, 0x0B};
+        for (uint16_t i = 0; i < len; i++) {
+            uint32_t at = s_ota_offset + i;
+            s_ota_block[i] = at < sizeof(file_id) ? file_id[at] : (uint8_t)(at * 31 + 7);
+        }
+        if (fake_zb_ota_status(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE, s_ota_block, len) != ESP_OK) {
+            fake_zb_ota_abort();
+            break;
+        }
+        s_ota_offset += len;
+        s_stats.ota_blocks++;
+        s_stats.ota_rx_bytes += len;
+        s_ota_phase = s_ota_offset >= s_ota.image_size ? FAKE_ZB_OTA_CHECK : FAKE_ZB_OTA_BLOCK_REQ;
+        s_ota_next_us = s_ota_phase == FAKE_ZB_OTA_CHECK ? now : now + retry_us;
+        break;
+    }
+    case FAKE_ZB_OTA_CHECK:
+        if (fake_zb_ota_status(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK, NULL, 0) != ESP_OK) {
+            fake_zb_ota_abort();
+            break;
+        }
+        (void)fake_zb_ota_status(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY, NULL, 0);
+        s_ota_phase = FAKE_ZB_OTA_END_REQ;
+        s_ota_next_us = now;
+        break;
+    case FAKE_ZB_OTA_END_REQ:
+        if (fake_zb_tx(FAKE_ZB_FRAME_OTA, ep, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, NULL, 0,
+                       fake_zb_zcl_bytes(false, FAKE_ZB_OTA_END_REQ_BYTES))) {
+            s_ota_phase = FAKE_ZB_OTA_FINISH;
+            s_ota_next_us = now + s_cfg.response_delay_us;
+        } else {
+            s_ota_next_us = now + retry_us;
+        }
+        break;
+    case FAKE_ZB_OTA_FINISH:
+        s_stats.ota_end_us = now;
+        s_ota_phase = FAKE_ZB_OTA_IDLE;
+        /* The application restarts from here on success. */
+        if (fake_zb_ota_status(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH, NULL, 0) != ESP_OK) {
+            s_stats.ota_aborted = true;
+        }
+        break;
+    }
+}
+
+esp_err_t esp_zb_ota_upgrade_client_query_interval_set(uint8_t endpoint, uint16_t interval)
+{
+    (void)endpoint;
+    s_ota_query_interval_min = interval;
+    return ESP_OK;
+}
+
+/* ---- main loop and sleep ---- */
+
+static int64_t fake_zb_next_deadline(void)
+{
+    int64_t next = s_stop_us;
+    for (size_t i = 0; i < s_event_count; i++) {
+        if (s_events[i].t_us < next) {
+            next = s_events[i].t_us;
+        }
+    }
+    if (s_ota_phase != FAKE_ZB_OTA_IDLE && s_ota_next_us < next) {
+        next = s_ota_next_us;
+    }
+    if (s_joined) {
+        if (s_next_poll_us < next) {
+            next = s_next_poll_us;
+        }
+        for (size_t i = 0; i < s_report_count; i++) {
+            int64_t value = 0;
+            int64_t due = s_reports[i].enabled ? fake_zb_report_due(&s_reports[i], &value) : INT64_MAX;
+            if (due < next) {
+                next = due;
+            }
+        }
+    }
+    return next;
+}
+
+void esp_zb_stack_main_loop_iteration(void)
+{
+    int64_t now = esp_timer_get_time();
+    if (s_running && now >= s_stop_us) {
+        longjmp(s_run_jmp, 1);
+    }
+
+    fake_zb_run_events(now);
+    if (s_ota_phase != FAKE_ZB_OTA_IDLE && now >= s_ota_next_us) {
+        fake_zb_ota_step(now);
+    }
+    if (s_joined) {
+        if (now >= s_next_poll_us) {
+            (void)fake_zb_tx(FAKE_ZB_FRAME_POLL, 0, 0, NULL, 0, FAKE_ZB_POLL_BYTES);
+            s_next_poll_us = now + fake_zb_poll_interval_us();
+        }
+        fake_zb_run_reports(now);
+    }
+
+    if (s_started && s_sleep_enabled && !s_rx_on_when_idle &&
+        fake_zb_next_deadline() - now >= (int64_t)s_sleep_threshold_ms * 1000) {
+        s_stats.can_sleep++;
+        fake_zb_raise_signal(ESP_ZB_COMMON_SIGNAL_CAN_SLEEP, ESP_OK);
+    }
+}
+
+void esp_zb_sleep_now(void)
+{
+    int64_t t0 = esp_timer_get_time();
+    int64_t deadline = fake_zb_next_deadline();
+    uint64_t ext1_mask = host_sleep_ext1_mask();
+    esp_sleep_wakeup_cause_t cause = ESP_SLEEP_WAKEUP_TIMER;
+    uint64_t ext1_status = 0;
+
+    /* Edges on pins that are not wake sources fire but do not end the sleep. */
+    bool woke = false;
+    host_irq_t irq;
+    while (!woke && host_irq_peek(&irq) && irq.t_us <= deadline) {
+        host_irq_run_until(irq.t_us);
+        if (irq.timer) {
+            woke = true;
+        } else if (irq.pressed && irq.gpio_num >= 0 && (ext1_mask & (1ULL << irq.gpio_num))) {
+            cause = ESP_SLEEP_WAKEUP_EXT1;
+            ext1_status = 1ULL << irq.gpio_num;
+            woke = true;
+        }
+    }
+    if (!woke) {
+        host_irq_run_until(deadline);
+    }
+    host_sleep_set_wakeup(cause, ext1_status);
+
+    int64_t now = esp_timer_get_time();
+    s_stats.sleeps++;
+    s_stats.slept_us += now - t0;
+    if (s_stats.first_sleep_us < 0) {
+        s_stats.first_sleep_us = t0;
+    }
+}
+
+void esp_zb_sleep_enable(bool enable)
+{
+    s_sleep_enabled = enable;
+}
+
+esp_err_t esp_zb_sleep_set_threshold(uint32_t threshold_ms)
+{
+    s_sleep_threshold_ms = threshold_ms;
+    return ESP_OK;
+}
+
+/* ---- commissioning ---- */
+
+esp_err_t esp_zb_platform_config(esp_zb_platform_config_t *config)
+{
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t fake_zb_size_set(uint16_t size)
+{
+    if (s_zb_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return size ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_zb_overall_network_size_set(uint16_t size)
+{
+    return fake_zb_size_set(size);
+}
+
+esp_err_t esp_zb_io_buffer_size_set(uint16_t size)
+{
+    return fake_zb_size_set(size);
+}
+
+esp_err_t esp_zb_scheduler_queue_size_set(uint16_t size)
+{
+    return fake_zb_size_set(size);
+}
+
+esp_err_t esp_zb_aps_src_binding_table_size_set(uint16_t size)
+{
+    return fake_zb_size_set(size);
+}
+
+esp_err_t esp_zb_aps_dst_binding_table_size_set(uint16_t size)
+{
+    return fake_zb_size_set(size);
+}
+
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg)
+{
+    s_zb_inited = true;
+    if (nwk_cfg && nwk_cfg->esp_zb_role == ESP_ZB_DEVICE_TYPE_ED) {
+        s_keep_alive_ms = nwk_cfg->nwk_cfg.zed_cfg.keep_alive;
+    }
+}
+
+esp_err_t esp_zb_start(bool autostart)
+{
+    if (s_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_started = true;
+    if (autostart && s_cfg.commissioned) {
+        /* Rejoin the stored network: one scan per primary channel, found on FAKE_ZB_CHANNEL only. */
+        s_stats.rejoin_channels = (uint32_t)__builtin_popcount(s_primary_channels);
+        esp_err_t status = (s_primary_channels & (1u << FAKE_ZB_CHANNEL)) ? ESP_OK : ESP_FAIL;
+        fake_zb_post_signal(ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP, ESP_OK, 0);
+        fake_zb_post_signal(ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT, status,
+                            s_cfg.response_delay_us + (int64_t)s_stats.rejoin_channels * s_cfg.rejoin_scan_us);
+    } else if (autostart) {
+        fake_zb_post_signal(ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP, ESP_OK, 0);
+        fake_zb_post_signal(ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START, ESP_OK, s_cfg.response_delay_us);
+    }
+    return ESP_OK;
+}
+
+void esp_zb_factory_reset(void)
+{
+    s_joined = false;
+    s_factory_new = true;
+}
+
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list)
+{
+    s_ep_list = ep_list;
+    return ep_list ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb)
+{
+    s_core_cb = cb;
+}
+
+void esp_zb_zcl_command_send_status_handler_register(esp_zb_zcl_command_send_status_callback_t handler)
+{
+    s_send_status_cb = handler;
+}
+
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask)
+{
+    if (!(mode_mask & ESP_ZB_BDB_MODE_NETWORK_STEERING)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    s_bdb_mode = mode_mask;
+    s_stats.steer_attempts++;
+    bool ok = s_stats.steer_attempts > s_cfg.join_failures;
+    fake_zb_post_signal(ESP_ZB_BDB_SIGNAL_STEERING, ok ? ESP_OK : ESP_FAIL, s_cfg.join_delay_us);
+    return ESP_OK;
+}
+
+esp_zb_bdb_commissioning_mode_mask_t esp_zb_get_bdb_commissioning_mode(void)
+{
+    return (esp_zb_bdb_commissioning_mode_mask_t)s_bdb_mode;
+}
+
+esp_zb_bdb_commissioning_status_t esp_zb_get_bdb_commissioning_status(void)
+{
+    if (s_bdb_mode) {
+        return ESP_ZB_BDB_STATUS_IN_PROGRESS;
+    }
+    return s_joined ? ESP_ZB_BDB_STATUS_SUCCESS : ESP_ZB_BDB_STATUS_NO_NETWORK;
+}
+
+bool esp_zb_bdb_is_factory_new(void)
+{
+    return s_factory_new;
+}
+
+bool esp_zb_bdb_dev_joined(void)
+{
+    return s_joined;
+}
+
+void esp_zb_bdb_set_scan_duration(uint8_t duration)
+{
+    (void)duration;
+}
+
+uint32_t esp_zb_get_channel_mask(void)
+{
+    return s_primary_channels | s_secondary_channels;
+}
+
+uint32_t esp_zb_get_primary_network_channel_set(void)
+{
+    return s_primary_channels;
+}
+
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask)
+{
+    s_primary_channels = channel_mask;
+    return ESP_OK;
+}
+
+uint32_t esp_zb_get_secondary_network_channel_set(void)
+{
+    return s_secondary_channels;
+}
+
+esp_err_t esp_zb_set_secondary_network_channel_set(uint32_t channel_mask)
+{
+    s_secondary_channels = channel_mask;
+    return ESP_OK;
+}
+
+void esp_zb_secur_network_min_join_lqi_set(uint8_t lqi)
+{
+    (void)lqi;
+}
+
+void esp_zb_set_node_descriptor_power_source(bool is_main_power)
+{
+    (void)is_main_power;
+}
+
+void esp_zb_set_tx_power(int8_t power)
+{
+    if (power < FAKE_ZB_TX_POWER_MIN) {
+        power = FAKE_ZB_TX_POWER_MIN;
+    } else if (power > FAKE_ZB_TX_POWER_MAX) {
+        power = FAKE_ZB_TX_POWER_MAX;
+    }
+    s_tx_power = power;
+}
+
+void esp_zb_get_tx_power(int8_t *power)
+{
+    if (power) {
+        *power = s_tx_power;
+    }
+}
+
+void esp_zb_set_trace_level_mask(esp_zb_trace_level_cfg_t trace_level, uint32_t trace_mask)
+{
+    (void)trace_level;
+    (void)trace_mask;
+}
+
+/* ---- network ---- */
+
+uint16_t esp_zb_get_short_address(void)
+{
+    return s_joined ? FAKE_ZB_SHORT_ADDR : 0xFFFE;
+}
+
+uint16_t esp_zb_get_pan_id(void)
+{
+    return s_joined ? FAKE_ZB_PAN_ID : 0xFFFF;
+}
+
+uint8_t esp_zb_get_current_channel(void)
+{
+    return s_joined ? FAKE_ZB_CHANNEL : 0;
+}
+
+void esp_zb_get_long_address(esp_zb_ieee_addr_t addr)
+{
+    memcpy(addr, s_device_ieee, sizeof(esp_zb_ieee_addr_t));
+}
+
+void esp_zb_get_extended_pan_id(esp_zb_ieee_addr_t ext_pan_id)
+{
+    if (s_joined) {
+        memcpy(ext_pan_id, s_ext_pan_id, sizeof(esp_zb_ieee_addr_t));
+    } else {
+        memset(ext_pan_id, 0, sizeof(esp_zb_ieee_addr_t));
+    }
+}
+
+esp_err_t esp_zb_ieee_address_by_short(uint16_t short_addr, uint8_t *ieee_addr)
+{
+    if (short_addr != FAKE_ZB_COORDINATOR_SHORT || !ieee_addr) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    memcpy(ieee_addr, s_coordinator_ieee, sizeof(esp_zb_ieee_addr_t));
+    return ESP_OK;
+}
+
+void esp_zb_set_rx_on_when_idle(bool rx_on)
+{
+    s_rx_on_when_idle = rx_on;
+}
+
+/* ---- commands ---- */
+
+esp_err_t esp_zb_zcl_add_privilege_command(uint8_t endpoint, uint16_t cluster, uint16_t command)
+{
+    (void)endpoint;
+    (void)cluster;
+    (void)command;
+    return ESP_OK;
+}
+
+uint8_t esp_zb_zcl_report_attr_cmd_req(esp_zb_zcl_report_attr_cmd_t *cmd_req)
+{
+    uint16_t manuf = cmd_req->manuf_specific ? cmd_req->manuf_code : ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC;
+    esp_zb_attribute_list_t *a = fake_zb_find_attr(cmd_req->zcl_basic_cmd.src_endpoint, cmd_req->clusterID,
+                                                   ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, manuf, cmd_req->attributeID);
+    uint32_t payload = FAKE_ZB_ATTR_RECORD_BYTES + (a ? a->attribute.data.size : 0);
+    bool delivered = fake_zb_tx(FAKE_ZB_FRAME_REPORT_CMD, cmd_req->zcl_basic_cmd.src_endpoint, cmd_req->clusterID,
+                                &cmd_req->attributeID, 1, fake_zb_zcl_bytes(cmd_req->manuf_specific, payload));
+    return fake_zb_post_send_status(delivered, cmd_req->zcl_basic_cmd.src_endpoint,
+                                    cmd_req->zcl_basic_cmd.dst_addr_u.addr_short, cmd_req->zcl_basic_cmd.dst_endpoint);
+}
+
+uint8_t esp_zb_zcl_read_attr_cmd_req(esp_zb_zcl_read_attr_cmd_t *cmd_req)
+{
+    bool delivered = fake_zb_tx(FAKE_ZB_FRAME_READ_ATTR, cmd_req->zcl_basic_cmd.src_endpoint, cmd_req->clusterID,
+                                cmd_req->attr_field, cmd_req->attr_number,
+                                fake_zb_zcl_bytes(cmd_req->manuf_specific, 2u * cmd_req->attr_number));
+    uint8_t tsn = fake_zb_post_send_status(delivered, cmd_req->zcl_basic_cmd.src_endpoint,
+                                           cmd_req->zcl_basic_cmd.dst_addr_u.addr_short,
+                                           cmd_req->zcl_basic_cmd.dst_endpoint);
+    if (delivered && cmd_req->clusterID == ESP_ZB_ZCL_CLUSTER_ID_TIME) {
+        fake_zb_post(&(fake_zb_event_t){
+            .t_us = esp_timer_get_time() + 2 * s_cfg.response_delay_us,
+            .kind = FAKE_ZB_EV_TIME_RESP,
+            .tsn = tsn,
+            .src_endpoint = cmd_req->zcl_basic_cmd.src_endpoint,
+            .dst_endpoint = cmd_req->zcl_basic_cmd.dst_endpoint,
+            .dst_short = cmd_req->zcl_basic_cmd.dst_addr_u.addr_short,
+        });
+    }
+    return tsn;
+}
+
+uint8_t esp_zb_zcl_custom_cluster_cmd_req(esp_zb_zcl_custom_cluster_cmd_req_t *cmd_req)
+{
+    bool delivered = fake_zb_tx(FAKE_ZB_FRAME_CUSTOM_CMD, cmd_req->zcl_basic_cmd.src_endpoint, cmd_req->cluster_id,
+                                NULL, 0, fake_zb_zcl_bytes(cmd_req->manuf_specific, cmd_req->data.size));
+    return fake_zb_post_send_status(delivered, cmd_req->zcl_basic_cmd.src_endpoint,
+                                    cmd_req->zcl_basic_cmd.dst_addr_u.addr_short, cmd_req->zcl_basic_cmd.dst_endpoint);
+}
+
+void esp_zb_zdo_device_bind_req(esp_zb_zdo_bind_req_param_t *cmd_req, esp_zb_zdo_bind_callback_t user_cb,
+                                void *user_ctx)
+{
+    bool delivered = fake_zb_tx(FAKE_ZB_FRAME_BIND_REQ, cmd_req->src_endp, cmd_req->cluster_id, NULL, 0,
+                                FAKE_ZB_NWK_FRAME_BYTES + FAKE_ZB_BIND_REQ_BYTES);
+    fake_zb_post(&(fake_zb_event_t){
+        .t_us = esp_timer_get_time() + (delivered ? s_cfg.response_delay_us : FAKE_ZB_ZDO_TIMEOUT_US),
+        .kind = FAKE_ZB_EV_BIND,
+        .status = delivered ? ESP_OK : ESP_ERR_TIMEOUT,
+        .bind_cb = user_cb,
+        .bind_ctx = user_ctx,
+    });
+}
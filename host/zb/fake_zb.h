@@ -0,0 +1,99 @@
+#pragma once
+
+/* Controls of the fake Zigbee stack (fake_zb.c) the harness runs the application against.
+ *
+ * The fake stands in for the coordinator too: it joins after a delay, answers binds and Time
+ * reads, acknowledges or fails every frame depending on the link state, runs the attribute
+ * reporting engine, serves one OTA image at a fixed block rate and sends scripted Get Profile
+ * requests. Every frame the device
+ * would have put on air is logged with its size.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+    FAKE_ZB_FRAME_REPORT = 0,       /* automatic attribute report */
+    FAKE_ZB_FRAME_REPORT_CMD,       /* esp_zb_zcl_report_attr_cmd_req() */
+    FAKE_ZB_FRAME_READ_ATTR,
+    FAKE_ZB_FRAME_CUSTOM_CMD,
+    FAKE_ZB_FRAME_BIND_REQ,
+    FAKE_ZB_FRAME_POLL,             /* MAC data request to the parent */
+    FAKE_ZB_FRAME_OTA,              /* OTA query, block and upgrade end requests */
+    FAKE_ZB_FRAME_KIND_COUNT,
+} fake_zb_frame_kind_t;
+
+#define FAKE_ZB_FRAME_ATTRS 4
+
+typedef struct {
+    int64_t t_us;
+    uint8_t kind;               /* fake_zb_frame_kind_t */
+    bool delivered;             /* false while the link is down */
+    uint8_t src_endpoint;
+    uint16_t cluster_id;
+    uint8_t attr_count;
+    uint16_t attr_ids[FAKE_ZB_FRAME_ATTRS];
+    uint16_t air_bytes;         /* PHY to ZCL payload, as sim.c counts it */
+} fake_zb_frame_t;
+
+typedef struct {
+    int64_t join_delay_us;      /* steering start to the STEERING signal */
+    uint32_t join_failures;     /* steering attempts that fail before one succeeds */
+    int64_t response_delay_us;  /* request to send status, bind result or Time response */
+    uint32_t poll_interval_ms;  /* parent polls once joined; 0 uses the keep-alive */
+    uint32_t utc_base_s;        /* coordinator UTC at host time 0 */
+    bool commissioned;          /* network kept in zb_storage: esp_zb_start() rejoins (DEVICE_REBOOT) */
+    int64_t rejoin_scan_us;     /* rejoin time per channel in the primary channel set */
+} fake_zb_config_t;
+
+typedef struct {
+    int64_t start_us;           /* first query; retried every second until joined */
+    uint32_t file_version;
+    uint16_t manufacturer_code;
+    uint16_t image_type;
+    uint32_t image_size;
+    uint16_t block_size;
+    uint32_t block_interval_ms;
+} fake_zb_ota_t;
+
+typedef struct {
+    uint32_t frames[FAKE_ZB_FRAME_KIND_COUNT];
+    uint64_t air_bytes[FAKE_ZB_FRAME_KIND_COUNT];
+    uint32_t failed;            /* frames sent while the link was down */
+    uint32_t attr_writes;       /* esp_zb_zcl_set_*attribute_val() calls */
+    uint32_t can_sleep;         /* CAN_SLEEP signals raised */
+    uint32_t sleeps;
+    int64_t slept_us;
+    int64_t first_sleep_us;     /* -1 until the first sleep */
+    int64_t joined_us;          /* -1 until joined */
+    uint32_t steer_attempts;
+    uint32_t rejoin_channels;   /* channels the last rejoin scanned */
+    int64_t ota_start_us;       /* -1 until the START callback */
+    int64_t ota_end_us;         /* FINISH callback, -1 if not reached */
+    uint32_t ota_blocks;
+    uint64_t ota_rx_bytes;      /* image payload delivered */
+    bool ota_aborted;
+    bool restarted;
+    int64_t restart_us;
+} fake_zb_stats_t;
+
+/* Reset the stack; cfg NULL takes the defaults (3 s join, 50 ms responses, keep-alive polls). */
+void fake_zb_init(const fake_zb_config_t *cfg);
+/* Frames sent in [from_us, to_us) are not acknowledged. Up to 8 windows. */
+void fake_zb_link_outage(int64_t from_us, int64_t to_us);
+void fake_zb_ota_offer(const fake_zb_ota_t *ota);
+/* The coordinator sends Get Profile (consumption delivered, most recent intervals) to endpoint
+ * at t_us. Call after fake_zb_init(); the response goes on air as a custom command frame.
+ */
+void fake_zb_get_profile(int64_t t_us, uint8_t endpoint, uint8_t periods);
+
+/* Run the task xTaskCreateStatic() registered under task_name until the host clock reaches until_us.
+ * The task never returns, so this can be called once per process; fork for each scenario.
+ * Returns false if the task restarted the device (esp_restart) instead.
+ */
+bool fake_zb_run(const char *task_name, int64_t until_us);
+
+const fake_zb_stats_t *fake_zb_stats(void);
+size_t fake_zb_frames(const fake_zb_frame_t **out);
+/* The stack's copy of a numeric server attribute; false if it does not exist. */
+bool fake_zb_attr_value(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, int64_t *out);
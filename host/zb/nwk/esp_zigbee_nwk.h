@@ -0,0 +1,11 @@
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+uint16_t esp_zb_get_short_address(void);
+uint16_t esp_zb_get_pan_id(void);
+uint8_t esp_zb_get_current_channel(void);
+void esp_zb_get_long_address(esp_zb_ieee_addr_t addr);
+void esp_zb_get_extended_pan_id(esp_zb_ieee_addr_t ext_pan_id);
+esp_err_t esp_zb_ieee_address_by_short(uint16_t short_addr, uint8_t *ieee_addr);
+void esp_zb_set_rx_on_when_idle(bool rx_on);
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+/* Each returns the transaction sequence number the send status callback reports. */
+uint8_t esp_zb_zcl_report_attr_cmd_req(esp_zb_zcl_report_attr_cmd_t *cmd_req);
+uint8_t esp_zb_zcl_read_attr_cmd_req(esp_zb_zcl_read_attr_cmd_t *cmd_req);
+uint8_t esp_zb_zcl_custom_cluster_cmd_req(esp_zb_zcl_custom_cluster_cmd_req_t *cmd_req);
+void esp_zb_zcl_command_send_status_handler_register(esp_zb_zcl_command_send_status_callback_t handler);
@@ -0,0 +1,4 @@
+#pragma once
+
+/* The cluster IDs and defaults live in esp_zigbee_type.h on the host. */
+#include "esp_zigbee_type.h"
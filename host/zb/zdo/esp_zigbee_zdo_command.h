@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_zigbee_type.h"
+
+void esp_zb_zdo_device_bind_req(esp_zb_zdo_bind_req_param_t *cmd_req, esp_zb_zdo_bind_callback_t user_cb,
+                                void *user_ctx);
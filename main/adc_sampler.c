@@ -0,0 +1,354 @@
+#include "adc_sampler.h"
+
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "soc/soc_caps.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#if SOC_ADC_DMA_SUPPORTED
+#include "esp_adc/adc_continuous.h"
+#endif
+
+static const char *TAG = "adc_sampler";
+
+/* Oneshot fallback: give the sample-and-hold cap time to recharge through the divider. */
+#define ADC_SAMPLER_ONESHOT_DELAY_US   50
+/* Continuous mode: 20 kHz keeps the same ~50 us spacing but the CPU idles in between. */
+#define ADC_SAMPLER_CONT_FREQ_HZ       20000
+#define ADC_SAMPLER_CONT_FRAME_SAMPLES 8
+#define ADC_SAMPLER_CONT_TIMEOUT_MS    20
+
+#if SOC_ADC_DMA_SUPPORTED
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_SAMPLER_OUTPUT_TYPE ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_SAMPLER_GET_CHANNEL(p) ((p)->type1.channel)
+#define ADC_SAMPLER_GET_DATA(p) ((p)->type1.data)
+#else
+#define ADC_SAMPLER_OUTPUT_TYPE ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_SAMPLER_GET_CHANNEL(p) ((p)->type2.channel)
+#define ADC_SAMPLER_GET_DATA(p) ((p)->type2.data)
+#endif
+#define ADC_SAMPLER_FRAME_BYTES (ADC_SAMPLER_CONT_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES)
+#endif
+
+static adc_sampler_config_t s_cfg;
+static adc_oneshot_unit_handle_t s_oneshot;
+static adc_oneshot_unit_handle_t s_units[2];
+static adc_cali_handle_t s_cali;
+static bool s_cali_enabled;
+static bool s_ready;
+#if SOC_ADC_DMA_SUPPORTED
+static adc_continuous_handle_t s_cont;
+#endif
+
+void adc_stats_reset(adc_stats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->min = INT_MAX;
+    st->max = INT_MIN;
+}
+
+void adc_stats_add(adc_stats_t *st, int mv)
+{
+    st->n++;
+    double delta = (double)mv - st->mean;
+    st->mean += delta / (double)st->n;
+    st->m2 += delta * ((double)mv - st->mean);
+    st->sum += mv;
+    if (mv < st->min) {
+        st->min = mv;
+    }
+    if (mv > st->max) {
+        st->max = mv;
+    }
+}
+
+double adc_stats_variance(const adc_stats_t *st)
+{
+    if (st->n < 2) {
+        return 0.0;
+    }
+    return st->m2 / (double)(st->n - 1);
+}
+
+int adc_stats_trimmed_mean(const adc_stats_t *st)
+{
+    if (st->n == 0) {
+        return 0;
+    }
+    int64_t avg;
+    if (st->n >= 5) {
+        avg = (st->sum - st->min - st->max) / (int64_t)(st->n - 2);
+    } else {
+        avg = st->sum / (int64_t)st->n;
+    }
+    return avg < 0 ? 0 : (int)avg;
+}
+
+bool adc_stats_stable(const adc_stats_t *st, uint32_t min_samples, uint32_t sem_uv)
+{
+    if (sem_uv == 0 || st->n < 2 || st->n < min_samples) {
+        return false;
+    }
+    /* var / n <= sem^2, all in mV^2. */
+    double sem_mv = (double)sem_uv / 1000.0;
+    return adc_stats_variance(st) <= sem_mv * sem_mv * (double)st->n;
+}
+
+static bool adc_sampler_raw_to_mv(int raw, int *mv)
+{
+    return adc_cali_raw_to_voltage(s_cali, raw, mv) == ESP_OK && *mv >= 0;
+}
+
+static void adc_sampler_init_cali(adc_unit_t unit)
+{
+    s_cali_enabled = false;
+    adc_cali_scheme_ver_t scheme_mask = 0;
+    if (adc_cali_check_scheme(&scheme_mask) != ESP_OK) {
+        return;
+    }
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    if (scheme_mask & ADC_CALI_SCHEME_VER_CURVE_FITTING) {
+        adc_cali_curve_fitting_config_t cali_cfg = {
+            .unit_id = unit,
+            .chan = (adc_channel_t)s_cfg.channel,
+            .atten = (adc_atten_t)s_cfg.atten,
+            .bitwidth = ADC_BITWIDTH_DEFAULT,
+        };
+        if (adc_cali_create_scheme_curve_fitting(&cali_cfg, &s_cali) == ESP_OK) {
+            s_cali_enabled = true;
+        }
+    }
+#endif
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    if (!s_cali_enabled && (scheme_mask & ADC_CALI_SCHEME_VER_LINE_FITTING)) {
+        adc_cali_line_fitting_config_t cali_cfg = {
+            .unit_id = unit,
+            .atten = (adc_atten_t)s_cfg.atten,
+            .bitwidth = ADC_BITWIDTH_DEFAULT,
+        };
+        if (adc_cali_create_scheme_line_fitting(&cali_cfg, &s_cali) == ESP_OK) {
+            s_cali_enabled = true;
+        }
+    }
+#endif
+}
+
+#if SOC_ADC_DMA_SUPPORTED
+static esp_err_t adc_sampler_init_continuous(adc_unit_t unit)
+{
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = ADC_SAMPLER_FRAME_BYTES * 2,
+        .conv_frame_size = ADC_SAMPLER_FRAME_BYTES,
+    };
+    esp_err_t err = adc_continuous_new_handle(&handle_cfg, &s_cont);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    adc_digi_pattern_config_t pattern = {
+        .atten = (uint8_t)s_cfg.atten,
+        .channel = (uint8_t)s_cfg.channel,
+        .unit = (uint8_t)unit,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_continuous_config_t dig_cfg = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = ADC_SAMPLER_CONT_FREQ_HZ,
+        .conv_mode = (unit == ADC_UNIT_2) ? ADC_CONV_SINGLE_UNIT_2 : ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_SAMPLER_OUTPUT_TYPE,
+    };
+    err = adc_continuous_config(s_cont, &dig_cfg);
+    if (err != ESP_OK) {
+        adc_continuous_deinit(s_cont);
+        s_cont = NULL;
+    }
+    return err;
+}
+
+/* DMA burst: the driver holds a PM lock while running and the task blocks on the
+ * frame ring buffer, so the CPU idles between frames instead of spinning.
+ */
+static void adc_sampler_burst_continuous(adc_stats_t *st)
+{
+    uint8_t frame[ADC_SAMPLER_FRAME_BYTES];
+    uint32_t seen = 0;
+
+    if (adc_continuous_start(s_cont) != ESP_OK) {
+        return;
+    }
+
+    while (st->n < s_cfg.max_samples) {
+        uint32_t got = 0;
+        esp_err_t err = adc_continuous_read(s_cont, frame, sizeof(frame), &got, ADC_SAMPLER_CONT_TIMEOUT_MS);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "adc_continuous_read failed: %s", esp_err_to_name(err));
+            break;
+        }
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&frame[i];
+            if (ADC_SAMPLER_GET_CHANNEL(p) != (uint32_t)s_cfg.channel) {
+                continue;
+            }
+            if (seen++ < s_cfg.discard) {
+                continue;
+            }
+            int mv = 0;
+            if (adc_sampler_raw_to_mv((int)ADC_SAMPLER_GET_DATA(p), &mv) && st->n < s_cfg.max_samples) {
+                adc_stats_add(st, mv);
+            }
+        }
+        if (adc_stats_stable(st, s_cfg.min_samples, s_cfg.sem_uv)) {
+            break;
+        }
+    }
+
+    (void)adc_continuous_stop(s_cont);
+    (void)adc_continuous_flush_pool(s_cont);
+}
+#endif
+
+static void adc_sampler_burst_oneshot(adc_stats_t *st)
+{
+    uint32_t max_attempts = (uint32_t)s_cfg.discard + s_cfg.max_samples + 16;
+
+    for (uint32_t i = 0; i < max_attempts && st->n < s_cfg.max_samples; i++) {
+        int raw = 0;
+        esp_err_t err = adc_oneshot_read(s_oneshot, (adc_channel_t)s_cfg.channel, &raw);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "adc_oneshot_read failed: %s", esp_err_to_name(err));
+            continue;
+        }
+
+        int mv = 0;
+        if (!adc_sampler_raw_to_mv(raw, &mv)) {
+            continue;
+        }
+
+        if (i < s_cfg.discard) {
+            esp_rom_delay_us(ADC_SAMPLER_ONESHOT_DELAY_US);
+            continue;
+        }
+
+        adc_stats_add(st, mv);
+        if (adc_stats_stable(st, s_cfg.min_samples, s_cfg.sem_uv)) {
+            break;
+        }
+        esp_rom_delay_us(ADC_SAMPLER_ONESHOT_DELAY_US);
+    }
+}
+
+esp_err_t adc_sampler_oneshot_unit(int unit, adc_oneshot_unit_handle_t *out)
+{
+    if (!out || unit < 1 || unit > 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    adc_oneshot_unit_handle_t *handle = &s_units[unit - 1];
+    if (!*handle) {
+        adc_oneshot_unit_init_cfg_t unit_cfg = {
+            .unit_id = (unit == 2) ? ADC_UNIT_2 : ADC_UNIT_1,
+        };
+        esp_err_t err = adc_oneshot_new_unit(&unit_cfg, handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "adc_oneshot_new_unit failed: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+    *out = *handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_sampler_init(const adc_sampler_config_t *cfg)
+{
+    if (!cfg || cfg->max_samples == 0 || cfg->min_samples > cfg->max_samples) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_cfg = *cfg;
+    s_ready = false;
+    adc_unit_t unit = (cfg->unit == 2) ? ADC_UNIT_2 : ADC_UNIT_1;
+
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#if SOC_ADC_DMA_SUPPORTED
+    if (cfg->continuous) {
+        err = adc_sampler_init_continuous(unit);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Continuous ADC unavailable (%s), using oneshot", esp_err_to_name(err));
+        }
+    }
+#endif
+    if (err != ESP_OK) {
+        err = adc_sampler_oneshot_unit(cfg->unit == 2 ? 2 : 1, &s_oneshot);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        adc_oneshot_chan_cfg_t chan_cfg = {
+            .atten = (adc_atten_t)cfg->atten,
+            .bitwidth = ADC_BITWIDTH_DEFAULT,
+        };
+        err = adc_oneshot_config_channel(s_oneshot, (adc_channel_t)cfg->channel, &chan_cfg);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "adc_oneshot_config_channel failed: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    adc_sampler_init_cali(unit);
+    s_ready = true;
+
+    ESP_LOGI(TAG, "ADC init: unit=%d chan=%d atten=%d cali=%s mode=%s samples=%u..%u sem=%" PRIu32 "uV",
+             cfg->unit, cfg->channel, cfg->atten,
+             s_cali_enabled ? "yes" : "no",
+             s_oneshot ? "oneshot" : "continuous",
+             (unsigned)cfg->min_samples, (unsigned)cfg->max_samples, cfg->sem_uv);
+    return ESP_OK;
+}
+
+bool adc_sampler_calibrated(void)
+{
+    return s_ready && s_cali_enabled;
+}
+
+esp_err_t adc_sampler_measure(adc_sampler_result_t *out)
+{
+    if (!out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!s_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!s_cali_enabled) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    adc_stats_t st;
+    adc_stats_reset(&st);
+    int64_t t0 = esp_timer_get_time();
+
+#if SOC_ADC_DMA_SUPPORTED
+    if (s_cont) {
+        adc_sampler_burst_continuous(&st);
+        out->continuous = true;
+    } else
+#endif
+    {
+        adc_sampler_burst_oneshot(&st);
+    }
+
+    out->awake_us = (uint32_t)(esp_timer_get_time() - t0);
+    out->samples = (uint16_t)st.n;
+    if (st.n < s_cfg.min_samples || st.n == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    out->mv = adc_stats_trimmed_mean(&st);
+    return ESP_OK;
+}
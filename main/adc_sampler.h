@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_adc/adc_oneshot.h"
+
+/* Running statistics over one ADC burst: Welford mean/variance plus min/max for trimming. */
+typedef struct {
+    uint32_t n;
+    double mean;
+    double m2;
+    int64_t sum;
+    int min;
+    int max;
+} adc_stats_t;
+
+void adc_stats_reset(adc_stats_t *st);
+void adc_stats_add(adc_stats_t *st, int mv);
+double adc_stats_variance(const adc_stats_t *st);
+/* Mean with min and max dropped once there are enough samples to spare them. */
+int adc_stats_trimmed_mean(const adc_stats_t *st);
+/* True once at least min_samples were taken and the standard error of the mean is <= sem_uv. */
+bool adc_stats_stable(const adc_stats_t *st, uint32_t min_samples, uint32_t sem_uv);
+
+typedef struct {
+    int unit;               /* 1 or 2 */
+    int channel;
+    int atten;
+    uint16_t discard;       /* leading samples to drop (source impedance settling) */
+    uint16_t min_samples;
+    uint16_t max_samples;
+    uint32_t sem_uv;        /* early-stop threshold, 0 always takes max_samples */
+    bool continuous;        /* prefer continuous (DMA) mode where the target supports it */
+} adc_sampler_config_t;
+
+typedef struct {
+    int mv;                 /* trimmed mean at the ADC pin */
+    uint16_t samples;       /* samples that contributed to mv */
+    uint32_t awake_us;      /* wall time of the burst */
+    bool continuous;        /* burst ran in continuous (DMA) mode */
+} adc_sampler_result_t;
+
+esp_err_t adc_sampler_init(const adc_sampler_config_t *cfg);
+/* Oneshot handle of ADC unit (1 or 2), created on first use. A unit can be claimed only once and
+ * the ESP32-H2 has one, so the battery sampler and the optical pulse input share it.
+ */
+esp_err_t adc_sampler_oneshot_unit(int unit, adc_oneshot_unit_handle_t *out);
+bool adc_sampler_calibrated(void);
+/* Take one adaptive burst. Returns ESP_ERR_INVALID_SIZE if fewer than min_samples were valid. */
+esp_err_t adc_sampler_measure(adc_sampler_result_t *out);
@@ -2,15 +2,103 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
 
 #define APP_NVS_NAMESPACE "meter"
 #define APP_NVS_KEY_CONFIG "cfg"
 #define APP_NVS_KEY_PULSES "pulses"
+#define APP_NVS_KEY_SOC "soc"
+#define APP_NVS_KEY_PROFILE "profile"
 
 #define APP_MFG_CODE CONFIG_ZB_MANUFACTURER_CODE
 #define APP_MFG_CLUSTER_ID CONFIG_ZB_MFG_CLUSTER_ID
 #define APP_MANUFACTURER_NAME "Custom"
 
+/* Manufacturer cluster attributes. */
+#define APP_MFG_ATTR_RESET_COUNTER 0x0008
+#define APP_MFG_ATTR_BATTERY_DAYS 0x0010
+/* Power-state diagnostics (uint32, read-only). Long states in seconds, short ones in ms. */
+#define APP_MFG_ATTR_DIAG_SLEEP_S 0x0020
+#define APP_MFG_ATTR_DIAG_AWAKE_IDLE_S 0x0021
+#define APP_MFG_ATTR_DIAG_CPU_BUSY_MS 0x0022
+#define APP_MFG_ATTR_DIAG_RX_MS 0x0023
+#define APP_MFG_ATTR_DIAG_TX_MS 0x0024
+#define APP_MFG_ATTR_DIAG_ADC_MS 0x0025
+#define APP_MFG_ATTR_DIAG_FLASH_MS 0x0026
+#define APP_MFG_ATTR_DIAG_WAKES 0x0027
+#define APP_MFG_ATTR_DIAG_TX_FRAMES 0x0028
+#define APP_MFG_ATTR_DIAG_ADC_BURSTS 0x0029
+#define APP_MFG_ATTR_DIAG_FLASH_WRITES 0x002A
+#define APP_MFG_ATTR_DIAG_UAH_PER_DAY 0x002B
+#define APP_MFG_ATTR_DIAG_FIRST APP_MFG_ATTR_DIAG_SLEEP_S
+#define APP_MFG_ATTR_DIAG_LAST APP_MFG_ATTR_DIAG_UAH_PER_DAY
+/* Sleep statistics (uint32, read-only): wake causes by sleep_wake_t, skip reasons by
+ * sleep_skip_t, sleep-duration histogram buckets, longest sleep in ms.
+ */
+#define APP_MFG_ATTR_SLEEP_WAKE_BASE 0x0030
+#define APP_MFG_ATTR_SLEEP_SKIP_BASE 0x0035
+#define APP_MFG_ATTR_SLEEP_HIST_BASE 0x0038
+#define APP_MFG_ATTR_SLEEP_MAX_MS 0x0040
+#define APP_MFG_ATTR_SLEEP_FIRST APP_MFG_ATTR_SLEEP_WAKE_BASE
+#define APP_MFG_ATTR_SLEEP_LAST APP_MFG_ATTR_SLEEP_MAX_MS
+/* Post-mortem event trace download: write a page number, then read the page (octet string of
+ * APP_TRACE_PAGE_ENTRIES evtrace_entry_t, oldest first) and the total event count.
+ */
+#define APP_MFG_ATTR_TRACE_TOTAL 0x0050
+#define APP_MFG_ATTR_TRACE_PAGE 0x0051
+#define APP_MFG_ATTR_TRACE_DATA 0x0052
+#define APP_TRACE_PAGE_ENTRIES 8
+/* Store-and-forward report buffering: counters (uint32) and the backlog batch, an octet string of
+ * APP_BACKLOG_BATCH_ENTRIES x {channel u8, age s u32, summation u48, demand s24} sent as a
+ * manufacturer report.
+ */
+#define APP_MFG_ATTR_QUEUE_QUEUED 0x0054
+#define APP_MFG_ATTR_QUEUE_DROPPED 0x0055
+#define APP_MFG_ATTR_QUEUE_FLUSHED 0x0056
+#define APP_MFG_ATTR_QUEUE_OUTAGES 0x0057
+#define APP_MFG_ATTR_QUEUE_FIRST APP_MFG_ATTR_QUEUE_QUEUED
+#define APP_MFG_ATTR_QUEUE_LAST APP_MFG_ATTR_QUEUE_OUTAGES
+#define APP_MFG_ATTR_BACKLOG 0x0058
+#define APP_BACKLOG_ENTRY_SIZE 14
+/* Leak detection (LEAK_DETECT): alarm bitmap32 with METERING_LEAK_* of channel n in bits 4n..4n+3
+ * (reportable), and uint32 diagnostics of the worst channel.
+ */
+#define APP_MFG_ATTR_LEAK_ALARM 0x0060
+#define APP_MFG_ATTR_LEAK_LONGEST_IDLE_S 0x0061
+#define APP_MFG_ATTR_LEAK_FLOW_RUN_S 0x0062
+#define APP_MFG_ATTR_LEAK_FIRST APP_MFG_ATTR_LEAK_LONGEST_IDLE_S
+#define APP_MFG_ATTR_LEAK_LAST APP_MFG_ATTR_LEAK_FLOW_RUN_S
+/* Attribute shadow (uint32, read-only): ZCL attribute writes made and writes skipped as unchanged. */
+#define APP_MFG_ATTR_ZCL_WRITES 0x0064
+#define APP_MFG_ATTR_ZCL_WRITES_AVOIDED 0x0065
+#define APP_MFG_ATTR_ZCL_FIRST APP_MFG_ATTR_ZCL_WRITES
+#define APP_MFG_ATTR_ZCL_LAST APP_MFG_ATTR_ZCL_WRITES_AVOIDED
+#define APP_BACKLOG_BATCH_ENTRIES 6
+/* Pulse latency histograms (LATENCY_PROBES): write a latency_stage_t to select one (0xFF clears
+ * them all), then read it as an octet string of count u32, max us u32, mean us u32 and
+ * LATENCY_BUCKETS u16 bucket counts. Selecting also dumps every stage to the log.
+ */
+#define APP_MFG_ATTR_LATENCY_STAGE 0x0068
+#define APP_MFG_ATTR_LATENCY_HIST 0x0069
+#define APP_LATENCY_STAGE_CLEAR 0xFF
+/* Memory (uint32, read-only, bytes): unused stack of the Zigbee and battery monitor tasks (high-water
+ * marks, 0 if the task does not exist), free heap and its low-water mark since boot.
+ */
+#define APP_MFG_ATTR_MEM_ZB_STACK_FREE 0x006A
+#define APP_MFG_ATTR_MEM_POWER_STACK_FREE 0x006B
+#define APP_MFG_ATTR_MEM_HEAP_FREE 0x006C
+#define APP_MFG_ATTR_MEM_HEAP_MIN_FREE 0x006D
+#define APP_MFG_ATTR_MEM_FIRST APP_MFG_ATTR_MEM_ZB_STACK_FREE
+#define APP_MFG_ATTR_MEM_LAST APP_MFG_ATTR_MEM_HEAP_MIN_FREE
+/* Deep-sleep mode (DEEP_SLEEP_MODE, uint32, read-only): wakes since the RTC record was created and
+ * how many of them started the radio. Set on every radio wake.
+ */
+#define APP_MFG_ATTR_DEEP_WAKES 0x006E
+#define APP_MFG_ATTR_DEEP_RADIO_WAKES 0x006F
+#define APP_MFG_ATTR_DEEP_FIRST APP_MFG_ATTR_DEEP_WAKES
+#define APP_MFG_ATTR_DEEP_LAST APP_MFG_ATTR_DEEP_RADIO_WAKES
+
 #if CONFIG_ZB_VARIANT_ELECTRIC
 #define APP_UNIT_OF_MEASURE 0
 #define APP_METERING_DEVICE_TYPE 0
@@ -24,6 +112,29 @@
 #define APP_METERING_DEVICE_TYPE 1
 #define APP_MODEL_IDENTIFIER "ESP32-PulseMeter-Gas"
 #endif
+/* UnitOfMeasure for the extra channels' MeteringDeviceType: m3 for gas and water, kWh otherwise. */
+#define APP_UNIT_FOR_DEVICE_TYPE(type) (((type) == 1 || (type) == 2) ? 1 : 0)
+
+/* Pulse inputs: channel n is served on endpoint APP_ZB_ENDPOINT + n and saved under the
+ * NVS keys above with n appended (channel 0 keeps the bare keys).
+ */
+#define APP_PULSE_MAX_CHANNELS 8
+#ifndef CONFIG_PULSE_CHANNELS
+#define CONFIG_PULSE_CHANNELS 1
+#endif
+_Static_assert(CONFIG_PULSE_CHANNELS >= 1 && CONFIG_PULSE_CHANNELS <= APP_PULSE_MAX_CHANNELS,
+               "CONFIG_PULSE_CHANNELS out of range");
+
+/* Day/week consumption, Get Profile and the Time cluster sync they need (not in deep sleep). */
+#ifndef CONFIG_METERING_HISTORY
+#define CONFIG_METERING_HISTORY 0
+#endif
+
+/* Simple Metering historical consumption attributes (uint24, summation units). */
+#define APP_METERING_ATTR_CURRENT_DAY_DELIVERED 0x0401
+#define APP_METERING_ATTR_PREVIOUS_DAY_DELIVERED 0x0403
+#define APP_METERING_ATTR_CURRENT_WEEK_DELIVERED 0x0430
+#define APP_METERING_ATTR_PREVIOUS_WEEK_DELIVERED 0x0432
 
 #define APP_ZB_ENDPOINT CONFIG_ZB_ENDPOINT
 #define APP_ZB_DEVICE_ID CONFIG_ZB_DEVICE_ID
@@ -35,10 +146,16 @@ typedef struct {
     uint8_t metering_device_type;
     uint8_t unit_of_measure;
     uint16_t debounce_ms;
+    int gpio_num;
 } app_metering_cfg_t;
 
-void app_config_load(app_metering_cfg_t *cfg);
-void app_pulse_load_total(uint64_t *total);
-void app_pulse_save_total(uint64_t total);
+/* Configuration of pulse channel `channel` (0..CONFIG_PULSE_CHANNELS-1). */
+void app_config_load(uint8_t channel, app_metering_cfg_t *cfg);
+void app_pulse_load_total(uint8_t channel, uint64_t *total);
+void app_pulse_save_total(uint8_t channel, uint64_t total);
+bool app_soc_load(int64_t *remaining_uah);
+void app_soc_save(int64_t remaining_uah);
+bool app_profile_load(uint8_t channel, void *blob, size_t size);
+void app_profile_save(uint8_t channel, const void *blob, size_t size);
 void app_config_reset_counter_request(void);
 bool app_config_consume_reset_request(void);
@@ -0,0 +1,67 @@
+#include "attr_shadow.h"
+
+#include <string.h>
+
+static attr_shadow_t *s_list;
+static size_t s_dirty;
+static attr_shadow_stats_t s_stats;
+
+static void attr_shadow_inc(uint32_t *v)
+{
+    if (*v != UINT32_MAX) {
+        (*v)++;
+    }
+}
+
+void attr_shadow_register(attr_shadow_t *attr, uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id,
+                          uint8_t size)
+{
+    *attr = (attr_shadow_t){
+        .next = s_list,
+        .cluster_id = cluster_id,
+        .attr_id = attr_id,
+        .endpoint = endpoint,
+        .size = size > ATTR_SHADOW_MAX_SIZE ? ATTR_SHADOW_MAX_SIZE : size,
+    };
+    s_list = attr;
+}
+
+void attr_shadow_set(attr_shadow_t *attr, const void *value)
+{
+    attr_shadow_inc(&s_stats.sets);
+    memcpy(attr->value, value, attr->size);
+    /* Changing back to what the stack already has before a flush cancels the write. */
+    bool dirty = !attr->pushed_valid || memcmp(attr->value, attr->pushed, attr->size) != 0;
+    if (dirty != attr->dirty) {
+        attr->dirty = dirty;
+        s_dirty = dirty ? s_dirty + 1 : s_dirty - 1;
+    }
+}
+
+bool attr_shadow_pending(void)
+{
+    return s_dirty > 0;
+}
+
+size_t attr_shadow_flush(attr_shadow_write_t write)
+{
+    size_t writes = 0;
+    for (attr_shadow_t *attr = s_list; attr && s_dirty > 0; attr = attr->next) {
+        if (!attr->dirty) {
+            continue;
+        }
+        write(attr, attr->value);
+        memcpy(attr->pushed, attr->value, attr->size);
+        attr->pushed_valid = true;
+        attr->dirty = false;
+        s_dirty--;
+        attr_shadow_inc(&s_stats.writes);
+        writes++;
+    }
+    return writes;
+}
+
+const attr_shadow_stats_t *attr_shadow_stats(void)
+{
+    return &s_stats;
+}
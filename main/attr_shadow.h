@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Shadow of ZCL attribute values owned by the application. Setters only record the value;
+ * attr_shadow_flush() pushes the ones that differ from what the stack last got, in one place
+ * just before the stack runs. The caller passes the stack setter to the flush, which calls it
+ * directly, so set and flush from the Zigbee task.
+ */
+
+#define ATTR_SHADOW_MAX_SIZE 6      /* largest attribute kept: uint48 */
+
+/* Callers own the storage (e.g. one per attribute in a channel struct) and register it once. */
+typedef struct attr_shadow {
+    struct attr_shadow *next;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t endpoint;
+    uint8_t size;
+    bool dirty;
+    bool pushed_valid;
+    uint8_t value[ATTR_SHADOW_MAX_SIZE];
+    uint8_t pushed[ATTR_SHADOW_MAX_SIZE];
+} attr_shadow_t;
+
+typedef struct {
+    uint32_t sets;          /* attr_shadow_set() calls, each was a stack call before */
+    uint32_t writes;        /* stack calls made by flushes */
+} attr_shadow_stats_t;
+
+typedef void (*attr_shadow_write_t)(const attr_shadow_t *attr, void *value);
+
+void attr_shadow_register(attr_shadow_t *attr, uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id,
+                          uint8_t size);
+void attr_shadow_set(attr_shadow_t *attr, const void *value);
+bool attr_shadow_pending(void);
+/* Push every dirty attribute through write. Returns the number of stack calls made. */
+size_t attr_shadow_flush(attr_shadow_write_t write);
+const attr_shadow_stats_t *attr_shadow_stats(void);
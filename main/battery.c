@@ -0,0 +1,119 @@
+#include "battery.h"
+
+#include <string.h>
+
+uint16_t battery_adc_to_mv(const battery_cfg_t *cfg, uint32_t adc_mv)
+{
+    uint32_t r_top = cfg->r_top_ohm;
+    uint32_t r_bot = cfg->r_bot_ohm;
+
+    if (r_bot == 0) {
+        return 0;
+    }
+
+    uint64_t r_sum = (uint64_t)r_top + (uint64_t)r_bot;
+    uint64_t mv = ((uint64_t)adc_mv * r_sum + (uint64_t)r_bot / 2) / (uint64_t)r_bot;
+    if (mv > 65000) {
+        mv = 65000;
+    }
+    return (uint16_t)mv;
+}
+
+uint8_t battery_voltage_attr(uint16_t mv)
+{
+    /* ZCL BatteryVoltage is in 100 mV units; 0xFF means "unknown". */
+    uint32_t v_100mv = (uint32_t)mv / 100U;
+    if (v_100mv >= 0xFF) {
+        v_100mv = 0xFE;
+    }
+    return (uint8_t)v_100mv;
+}
+
+bool battery_mv_is_sane(const battery_cfg_t *cfg, uint16_t mv)
+{
+    /* Reject obvious glitches using a generous window around the configured empty/full range. */
+    int32_t empty = cfg->empty_mv;
+    int32_t full = cfg->full_mv;
+    if (empty <= 0 || full <= 0) {
+        return mv > 0;
+    }
+
+    int32_t lo = (empty < full) ? empty : full;
+    int32_t hi = (empty < full) ? full : empty;
+    if (hi <= lo) {
+        return mv > 0;
+    }
+
+    int32_t span = hi - lo;
+    int32_t margin = span;
+    if (margin < 500) {
+        margin = 500;
+    } else if (margin > 5000) {
+        margin = 5000;
+    }
+
+    int32_t sane_lo = lo - margin;
+    int32_t sane_hi = hi + margin;
+    if (sane_lo < 0) {
+        sane_lo = 0;
+    }
+    if (sane_hi > 65000) {
+        sane_hi = 65000;
+    }
+
+    return (mv >= (uint16_t)sane_lo) && (mv <= (uint16_t)sane_hi);
+}
+
+uint8_t battery_percent_attr(const battery_cfg_t *cfg, uint16_t mv)
+{
+    int32_t empty_mv = cfg->empty_mv;
+    int32_t full_mv = cfg->full_mv;
+
+    if (full_mv <= empty_mv) {
+        return 0xFF;
+    }
+
+    if (mv <= empty_mv) {
+        return 0;
+    }
+
+    if (mv >= full_mv) {
+        return 200;
+    }
+
+    int32_t percent = ((int32_t)mv - empty_mv) * 100 / (full_mv - empty_mv);
+    if (percent < 0) {
+        percent = 0;
+    } else if (percent > 100) {
+        percent = 100;
+    }
+
+    return (uint8_t)(percent * 2);
+}
+
+void battery_measure(const battery_cfg_t *cfg, const battery_meas_ops_t *ops, battery_reading_t *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    if (ops->divider_enable) {
+        ops->divider_enable(ops->ctx, true);
+    }
+    if (cfg->settle_us > 0 && ops->wait_us) {
+        ops->wait_us(ops->ctx, cfg->settle_us);
+    }
+
+    int adc_mv = 0;
+    bool ok = ops->sample(ops->ctx, &adc_mv, &out->samples, &out->awake_us);
+
+    if (ops->divider_enable) {
+        ops->divider_enable(ops->ctx, false);
+    }
+
+    if (!ok || adc_mv < 0) {
+        return;
+    }
+
+    out->adc_mv = adc_mv;
+    out->battery_mv = battery_adc_to_mv(cfg, (uint32_t)adc_mv);
+    out->valid = true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Battery divider maths and the measurement sequence around it.
+ * Kept free of ESP-IDF headers: hardware access goes through battery_meas_ops_t,
+ * so the sequence can run against a fake ADC on the host.
+ */
+
+typedef struct {
+    uint32_t r_top_ohm;
+    uint32_t r_bot_ohm;
+    int32_t empty_mv;
+    int32_t full_mv;
+    uint32_t settle_us;     /* wait after enabling the divider before the first sample */
+} battery_cfg_t;
+
+typedef struct {
+    /* NULL when the divider is permanently connected. */
+    void (*divider_enable)(void *ctx, bool on);
+    void (*wait_us)(void *ctx, uint32_t us);
+    /* One ADC burst; returns false if no usable average was produced. */
+    bool (*sample)(void *ctx, int *adc_mv, uint16_t *samples, uint32_t *awake_us);
+    void *ctx;
+} battery_meas_ops_t;
+
+typedef struct {
+    bool valid;
+    int adc_mv;
+    uint16_t battery_mv;
+    uint16_t samples;
+    uint32_t awake_us;
+} battery_reading_t;
+
+uint16_t battery_adc_to_mv(const battery_cfg_t *cfg, uint32_t adc_mv);
+bool battery_mv_is_sane(const battery_cfg_t *cfg, uint16_t mv);
+/* ZCL BatteryPercentageRemaining (half-percent units, 0xFF unknown). */
+uint8_t battery_percent_attr(const battery_cfg_t *cfg, uint16_t mv);
+/* ZCL BatteryVoltage (100 mV units). */
+uint8_t battery_voltage_attr(uint16_t mv);
+
+/* Enable divider, settle, sample, disable divider. The divider is always switched off again. */
+void battery_measure(const battery_cfg_t *cfg, const battery_meas_ops_t *ops, battery_reading_t *out);
@@ -0,0 +1,191 @@
+#include "battery_soc.h"
+
+/* Resting LiFePO4 curve (per cell, light load). Flat between ~20 % and ~90 %. */
+const battery_soc_point_t battery_soc_lifepo4_curve[] = {
+    {3400, 100},
+    {3350, 90},
+    {3320, 80},
+    {3300, 70},
+    {3270, 60},
+    {3260, 50},
+    {3250, 40},
+    {3220, 30},
+    {3200, 20},
+    {3000, 10},
+    {2500, 0},
+};
+const size_t battery_soc_lifepo4_curve_len =
+    sizeof(battery_soc_lifepo4_curve) / sizeof(battery_soc_lifepo4_curve[0]);
+
+/* Average-current smoothing horizon for the days projection. */
+#define BATTERY_SOC_RATE_TAU_S   (24U * 3600U)
+#define BATTERY_SOC_RATE_MIN_DT_S 60U
+
+static battery_soc_cfg_t s_cfg;
+static bool s_valid;
+static int64_t s_remaining_uah;
+static uint64_t s_last_charge_nah;
+static uint64_t s_rate_charge_nah;
+static uint32_t s_rate_last_s;
+static bool s_rate_started;
+static uint32_t s_avg_ua;
+
+static int64_t battery_soc_capacity_uah(void)
+{
+    return (int64_t)s_cfg.capacity_mah * 1000;
+}
+
+static int64_t battery_soc_pct_to_uah(uint32_t pct)
+{
+    return battery_soc_capacity_uah() * (int64_t)pct / 100;
+}
+
+static uint32_t battery_soc_percent(void)
+{
+    int64_t cap = battery_soc_capacity_uah();
+    if (cap <= 0 || s_remaining_uah <= 0) {
+        return 0;
+    }
+    int64_t pct = (s_remaining_uah * 100 + cap / 2) / cap;
+    return pct > 100 ? 100 : (uint32_t)pct;
+}
+
+void battery_soc_init(const battery_soc_cfg_t *cfg, int64_t restored_uah)
+{
+    s_cfg = *cfg;
+    if (s_cfg.cells == 0) {
+        s_cfg.cells = 1;
+    }
+    s_valid = restored_uah >= 0;
+    s_remaining_uah = s_valid ? restored_uah : 0;
+    if (s_remaining_uah > battery_soc_capacity_uah()) {
+        s_remaining_uah = battery_soc_capacity_uah();
+    }
+    s_last_charge_nah = 0;
+    s_rate_charge_nah = 0;
+    s_rate_last_s = 0;
+    s_rate_started = false;
+    s_avg_ua = 0;
+}
+
+void battery_soc_consume(uint64_t charge_nah, uint32_t now_s)
+{
+    if (charge_nah >= s_last_charge_nah) {
+        uint64_t delta_nah = charge_nah - s_last_charge_nah;
+        /* Keep the sub-uAh remainder in the ledger value so nothing is lost to rounding. */
+        uint64_t delta_uah = delta_nah / 1000U;
+        s_last_charge_nah += delta_uah * 1000U;
+        s_remaining_uah -= (int64_t)delta_uah;
+        if (s_remaining_uah < 0) {
+            s_remaining_uah = 0;
+        }
+    } else {
+        s_last_charge_nah = charge_nah;
+    }
+
+    if (!s_rate_started) {
+        s_rate_started = true;
+        s_rate_last_s = now_s;
+        s_rate_charge_nah = charge_nah;
+        return;
+    }
+
+    uint32_t dt_s = now_s - s_rate_last_s;
+    if (dt_s < BATTERY_SOC_RATE_MIN_DT_S || charge_nah < s_rate_charge_nah) {
+        return;
+    }
+    /* nAh over dt seconds -> uA: nAh * 3.6 / s */
+    uint64_t ua = (charge_nah - s_rate_charge_nah) * 36U / (10U * (uint64_t)dt_s);
+    if (s_avg_ua == 0) {
+        s_avg_ua = (uint32_t)ua;
+    } else {
+        /* EMA with alpha = dt / (dt + tau), integer form. */
+        uint64_t w = dt_s;
+        uint64_t tau = BATTERY_SOC_RATE_TAU_S;
+        s_avg_ua = (uint32_t)(((uint64_t)s_avg_ua * tau + ua * w) / (tau + w));
+    }
+    s_rate_last_s = now_s;
+    s_rate_charge_nah = charge_nah;
+}
+
+uint8_t battery_soc_curve_percent(uint16_t pack_mv)
+{
+    if (!s_cfg.curve || s_cfg.curve_len == 0) {
+        return 0;
+    }
+    uint32_t mv = pack_mv / s_cfg.cells;
+    const battery_soc_point_t *c = s_cfg.curve;
+    if (mv >= c[0].mv) {
+        return c[0].percent;
+    }
+    for (size_t i = 1; i < s_cfg.curve_len; i++) {
+        if (mv >= c[i].mv) {
+            uint32_t span_mv = c[i - 1].mv - c[i].mv;
+            uint32_t span_pct = c[i - 1].percent - c[i].percent;
+            if (span_mv == 0) {
+                return c[i].percent;
+            }
+            return (uint8_t)(c[i].percent + (mv - c[i].mv) * span_pct / span_mv);
+        }
+    }
+    return c[s_cfg.curve_len - 1].percent;
+}
+
+void battery_soc_on_voltage(uint16_t pack_mv)
+{
+    if (pack_mv == 0) {
+        return;
+    }
+    uint32_t v_pct = battery_soc_curve_percent(pack_mv);
+    bool on_plateau = v_pct > s_cfg.plateau_lo_pct && v_pct < s_cfg.plateau_hi_pct;
+
+    if (!s_valid || !on_plateau) {
+        /* No history, or the curve is steep here (near full or near empty): trust the voltage.
+         * This also picks up a freshly swapped pack.
+         */
+        s_remaining_uah = battery_soc_pct_to_uah(v_pct);
+        s_valid = true;
+        return;
+    }
+
+    /* On the plateau the voltage only tells us we are somewhere inside it. */
+    int64_t lo = battery_soc_pct_to_uah(s_cfg.plateau_lo_pct);
+    int64_t hi = battery_soc_pct_to_uah(s_cfg.plateau_hi_pct);
+    if (s_remaining_uah < lo) {
+        s_remaining_uah = lo;
+    } else if (s_remaining_uah > hi) {
+        s_remaining_uah = hi;
+    }
+}
+
+bool battery_soc_valid(void)
+{
+    return s_valid;
+}
+
+int64_t battery_soc_remaining_uah(void)
+{
+    return s_remaining_uah;
+}
+
+uint8_t battery_soc_percent_attr(void)
+{
+    if (!s_valid) {
+        return 0xFF;
+    }
+    return (uint8_t)(battery_soc_percent() * 2);
+}
+
+uint16_t battery_soc_days_remaining(void)
+{
+    if (!s_valid || s_avg_ua == 0) {
+        return 0xFFFF;
+    }
+    uint64_t days = (uint64_t)s_remaining_uah / ((uint64_t)s_avg_ua * 24U);
+    return days > 0xFFFE ? 0xFFFE : (uint16_t)days;
+}
+
+uint32_t battery_soc_avg_current_ua(void)
+{
+    return s_avg_ua;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* State-of-charge estimator: coulomb counting from the energy ledger, re-anchored to an
+ * open-circuit voltage curve wherever that curve is steep enough to be trusted.
+ * No ESP-IDF dependencies.
+ */
+
+typedef struct {
+    uint16_t mv;        /* per-cell voltage */
+    uint8_t percent;
+} battery_soc_point_t;
+
+typedef struct {
+    uint32_t capacity_mah;
+    uint8_t cells;                      /* cells in series; curve is per cell */
+    const battery_soc_point_t *curve;   /* sorted by descending mv */
+    size_t curve_len;
+    /* Between these percentages the curve is too flat to anchor to; the voltage only
+     * bounds the coulomb estimate to this band.
+     */
+    uint8_t plateau_lo_pct;
+    uint8_t plateau_hi_pct;
+} battery_soc_cfg_t;
+
+extern const battery_soc_point_t battery_soc_lifepo4_curve[];
+extern const size_t battery_soc_lifepo4_curve_len;
+
+/* restored_uah < 0 means no saved state: the first voltage reading anchors the estimate. */
+void battery_soc_init(const battery_soc_cfg_t *cfg, int64_t restored_uah);
+/* Feed the ledger's running charge total (nAh since boot) and the current time. */
+void battery_soc_consume(uint64_t charge_nah, uint32_t now_s);
+/* Re-anchor against a resting battery voltage (whole pack, mV). */
+void battery_soc_on_voltage(uint16_t pack_mv);
+uint8_t battery_soc_curve_percent(uint16_t pack_mv);
+
+bool battery_soc_valid(void);
+int64_t battery_soc_remaining_uah(void);
+/* ZCL BatteryPercentageRemaining (half-percent units, 0xFF unknown). */
+uint8_t battery_soc_percent_attr(void);
+/* Projected days until empty at the recent average current, 0xFFFF unknown. */
+uint16_t battery_soc_days_remaining(void);
+uint32_t battery_soc_avg_current_ua(void);
@@ -1,47 +1,126 @@
 #include "config_cluster.h"
 
+#include <stdio.h>
 #include <string.h>
 #include "sdkconfig.h"
 #include "nvs.h"
 #include "nvs_flash.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_zigbee_attribute.h"
 #include "esp_zigbee_cluster.h"
 #include "zcl/esp_zigbee_zcl_common.h"
+#include "energy.h"
+#include "tlog.h"
+#include "evtrace.h"
+#include "latency.h"
 
 static const char *TAG = "cfg_cluster";
 static uint8_t s_reset_counter_attr;
+#if CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+static uint16_t s_battery_days_attr = 0xFFFF;
+#endif
+static uint32_t s_diag_attrs[APP_MFG_ATTR_DIAG_LAST - APP_MFG_ATTR_DIAG_FIRST + 1];
+static uint32_t s_sleep_attrs[APP_MFG_ATTR_SLEEP_LAST - APP_MFG_ATTR_SLEEP_FIRST + 1];
+static uint32_t s_queue_attrs[APP_MFG_ATTR_QUEUE_LAST - APP_MFG_ATTR_QUEUE_FIRST + 1];
+#if CONFIG_LEAK_DETECT
+static uint32_t s_leak_alarm_attr;
+static uint32_t s_leak_attrs[APP_MFG_ATTR_LEAK_LAST - APP_MFG_ATTR_LEAK_FIRST + 1];
+#endif
+static uint32_t s_zcl_attrs[APP_MFG_ATTR_ZCL_LAST - APP_MFG_ATTR_ZCL_FIRST + 1];
+static uint32_t s_mem_attrs[APP_MFG_ATTR_MEM_LAST - APP_MFG_ATTR_MEM_FIRST + 1];
+#if CONFIG_DEEP_SLEEP_MODE
+static uint32_t s_deep_attrs[APP_MFG_ATTR_DEEP_LAST - APP_MFG_ATTR_DEEP_FIRST + 1];
+#endif
+static uint8_t s_backlog_attr[1 + APP_BACKLOG_BATCH_ENTRIES * APP_BACKLOG_ENTRY_SIZE];
 static bool s_reset_pending;
+static uint32_t s_trace_total_attr;
+static uint8_t s_trace_page_attr;
+/* ZCL octet string: length byte followed by the page. */
+static uint8_t s_trace_data_attr[1 + APP_TRACE_PAGE_ENTRIES * sizeof(evtrace_entry_t)];
 
-void app_config_load(app_metering_cfg_t *cfg)
-{
-    app_metering_cfg_t defaults = {
+_Static_assert(sizeof(evtrace_entry_t) == 8, "trace wire format is 8 bytes per entry");
+#if CONFIG_LATENCY_PROBES
+static uint8_t s_latency_stage_attr;
+static uint8_t s_latency_hist_attr[1 + 3 * sizeof(uint32_t) + LATENCY_BUCKETS * sizeof(uint16_t)];
+static void config_cluster_fill_latency(uint8_t stage);
+#endif
+
+static void config_cluster_fill_trace_page(uint8_t page);
+
+#define APP_CHANNEL_DEFAULTS(n) {                                                     \
+        .pulse_per_unit_numerator = CONFIG_PULSE_CH##n##_PER_UNIT_NUMERATOR,            \
+        .metering_device_type = CONFIG_PULSE_CH##n##_DEVICE_TYPE,                       \
+        .unit_of_measure = APP_UNIT_FOR_DEVICE_TYPE(CONFIG_PULSE_CH##n##_DEVICE_TYPE),  \
+        .debounce_ms = CONFIG_PULSE_CH##n##_DEBOUNCE_MS,                                \
+        .gpio_num = CONFIG_PULSE_CH##n##_GPIO,                                          \
+    }
+
+static const app_metering_cfg_t s_channel_defaults[CONFIG_PULSE_CHANNELS] = {
+    {
         .pulse_per_unit_numerator = CONFIG_PULSE_PER_UNIT_NUMERATOR,
         .metering_device_type = APP_METERING_DEVICE_TYPE,
         .unit_of_measure = APP_UNIT_OF_MEASURE,
         .debounce_ms = CONFIG_PULSE_DEBOUNCE_MS,
-    };
+        .gpio_num = CONFIG_PULSE_GPIO,
+    },
+#if CONFIG_PULSE_CHANNELS > 1
+    APP_CHANNEL_DEFAULTS(1),
+#endif
+#if CONFIG_PULSE_CHANNELS > 2
+    APP_CHANNEL_DEFAULTS(2),
+#endif
+#if CONFIG_PULSE_CHANNELS > 3
+    APP_CHANNEL_DEFAULTS(3),
+#endif
+#if CONFIG_PULSE_CHANNELS > 4
+    APP_CHANNEL_DEFAULTS(4),
+#endif
+#if CONFIG_PULSE_CHANNELS > 5
+    APP_CHANNEL_DEFAULTS(5),
+#endif
+#if CONFIG_PULSE_CHANNELS > 6
+    APP_CHANNEL_DEFAULTS(6),
+#endif
+#if CONFIG_PULSE_CHANNELS > 7
+    APP_CHANNEL_DEFAULTS(7),
+#endif
+};
+
+void app_config_load(uint8_t channel, app_metering_cfg_t *cfg)
+{
+    const app_metering_cfg_t *defaults = &s_channel_defaults[channel < CONFIG_PULSE_CHANNELS ? channel : 0];
 
-    *cfg = defaults;
+    *cfg = *defaults;
     if (cfg->pulse_per_unit_numerator == 0) {
-        cfg->pulse_per_unit_numerator = defaults.pulse_per_unit_numerator;
+        cfg->pulse_per_unit_numerator = 1;
     }
     if (cfg->debounce_ms == 0) {
-        cfg->debounce_ms = defaults.debounce_ms;
+        cfg->debounce_ms = CONFIG_PULSE_DEBOUNCE_MS;
     }
-    cfg->metering_device_type = APP_METERING_DEVICE_TYPE;
-    cfg->unit_of_measure = APP_UNIT_OF_MEASURE;
 }
 
-void app_pulse_load_total(uint64_t *total)
+/* Channel 0 keeps the bare key so single-input devices upgrade in place. */
+static const char *app_channel_key(char *buf, size_t size, const char *base, uint8_t channel)
 {
+    if (channel == 0) {
+        return base;
+    }
+    snprintf(buf, size, "%s%u", base, (unsigned)channel);
+    return buf;
+}
+
+void app_pulse_load_total(uint8_t channel, uint64_t *total)
+{
+    char key_buf[NVS_KEY_NAME_MAX_SIZE];
+    const char *key = app_channel_key(key_buf, sizeof(key_buf), APP_NVS_KEY_PULSES, channel);
     *total = 0;
     nvs_handle_t nvs;
     esp_err_t err = nvs_open(APP_NVS_NAMESPACE, NVS_READONLY, &nvs);
     if (err == ESP_OK) {
-        err = nvs_get_u64(nvs, APP_NVS_KEY_PULSES, total);
+        err = nvs_get_u64(nvs, key, total);
         if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_LOGW(TAG, "nvs_get_u64(%s) failed: %s", APP_NVS_KEY_PULSES, esp_err_to_name(err));
+            ESP_LOGW(TAG, "nvs_get_u64(%s) failed: %s", key, esp_err_to_name(err));
         }
         nvs_close(nvs);
     } else {
@@ -49,15 +128,56 @@ void app_pulse_load_total(uint64_t *total)
     }
 }
 
-void app_pulse_save_total(uint64_t total)
+static uint32_t *config_cluster_diag_slot(uint16_t attr_id)
 {
+    if (attr_id >= APP_MFG_ATTR_DIAG_FIRST && attr_id <= APP_MFG_ATTR_DIAG_LAST) {
+        return &s_diag_attrs[attr_id - APP_MFG_ATTR_DIAG_FIRST];
+    }
+    if (attr_id >= APP_MFG_ATTR_SLEEP_FIRST && attr_id <= APP_MFG_ATTR_SLEEP_LAST) {
+        return &s_sleep_attrs[attr_id - APP_MFG_ATTR_SLEEP_FIRST];
+    }
+    if (attr_id >= APP_MFG_ATTR_QUEUE_FIRST && attr_id <= APP_MFG_ATTR_QUEUE_LAST) {
+        return &s_queue_attrs[attr_id - APP_MFG_ATTR_QUEUE_FIRST];
+    }
+#if CONFIG_LEAK_DETECT
+    if (attr_id >= APP_MFG_ATTR_LEAK_FIRST && attr_id <= APP_MFG_ATTR_LEAK_LAST) {
+        return &s_leak_attrs[attr_id - APP_MFG_ATTR_LEAK_FIRST];
+    }
+#endif
+    if (attr_id >= APP_MFG_ATTR_ZCL_FIRST && attr_id <= APP_MFG_ATTR_ZCL_LAST) {
+        return &s_zcl_attrs[attr_id - APP_MFG_ATTR_ZCL_FIRST];
+    }
+    if (attr_id >= APP_MFG_ATTR_MEM_FIRST && attr_id <= APP_MFG_ATTR_MEM_LAST) {
+        return &s_mem_attrs[attr_id - APP_MFG_ATTR_MEM_FIRST];
+    }
+#if CONFIG_DEEP_SLEEP_MODE
+    if (attr_id >= APP_MFG_ATTR_DEEP_FIRST && attr_id <= APP_MFG_ATTR_DEEP_LAST) {
+        return &s_deep_attrs[attr_id - APP_MFG_ATTR_DEEP_FIRST];
+    }
+#endif
+    return NULL;
+}
+
+static void app_nvs_account_write(int64_t t0)
+{
+    energy_add(ENERGY_STATE_FLASH, (uint32_t)(esp_timer_get_time() - t0));
+    energy_count(ENERGY_COUNT_FLASH_WRITES);
+}
+
+void app_pulse_save_total(uint8_t channel, uint64_t total)
+{
+    char key_buf[NVS_KEY_NAME_MAX_SIZE];
+    const char *key = app_channel_key(key_buf, sizeof(key_buf), APP_NVS_KEY_PULSES, channel);
     nvs_handle_t nvs;
+    int64_t t0 = esp_timer_get_time();
     esp_err_t err = nvs_open(APP_NVS_NAMESPACE, NVS_READWRITE, &nvs);
     if (err == ESP_OK) {
-        err = nvs_set_u64(nvs, APP_NVS_KEY_PULSES, total);
+        err = nvs_set_u64(nvs, key, total);
         if (err == ESP_OK) {
             err = nvs_commit(nvs);
+            app_nvs_account_write(t0);
         }
+        evtrace_record(EVT_NVS_SAVE, EVTRACE_NVS_KEY(EVTRACE_NVS_PULSES, channel), (uint16_t)err);
         if (err != ESP_OK) {
             ESP_LOGW(TAG, "nvs_save_total failed: %s", esp_err_to_name(err));
         }
@@ -67,9 +187,84 @@ void app_pulse_save_total(uint64_t total)
     }
 }
 
+bool app_soc_load(int64_t *remaining_uah)
+{
+    bool found = false;
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(APP_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_get_i64(nvs, APP_NVS_KEY_SOC, remaining_uah);
+        if (err == ESP_OK) {
+            found = true;
+        } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "nvs_get_i64(%s) failed: %s", APP_NVS_KEY_SOC, esp_err_to_name(err));
+        }
+        nvs_close(nvs);
+    }
+    return found;
+}
+
+void app_soc_save(int64_t remaining_uah)
+{
+    nvs_handle_t nvs;
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = nvs_open(APP_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_i64(nvs, APP_NVS_KEY_SOC, remaining_uah);
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+            app_nvs_account_write(t0);
+        }
+        evtrace_record(EVT_NVS_SAVE, EVTRACE_NVS_SOC, (uint16_t)err);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "nvs_save_soc failed: %s", esp_err_to_name(err));
+        }
+        nvs_close(nvs);
+    } else {
+        ESP_LOGW(TAG, "nvs_open(write) failed: %s", esp_err_to_name(err));
+    }
+}
+
+bool app_profile_load(uint8_t channel, void *blob, size_t size)
+{
+    char key_buf[NVS_KEY_NAME_MAX_SIZE];
+    const char *key = app_channel_key(key_buf, sizeof(key_buf), APP_NVS_KEY_PROFILE, channel);
+    nvs_handle_t nvs;
+    bool ok = false;
+    if (nvs_open(APP_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        size_t len = size;
+        ok = nvs_get_blob(nvs, key, blob, &len) == ESP_OK && len == size;
+        nvs_close(nvs);
+    }
+    return ok;
+}
+
+void app_profile_save(uint8_t channel, const void *blob, size_t size)
+{
+    char key_buf[NVS_KEY_NAME_MAX_SIZE];
+    const char *key = app_channel_key(key_buf, sizeof(key_buf), APP_NVS_KEY_PROFILE, channel);
+    nvs_handle_t nvs;
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = nvs_open(APP_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs, key, blob, size);
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+            app_nvs_account_write(t0);
+        }
+        evtrace_record(EVT_NVS_SAVE, EVTRACE_NVS_KEY(EVTRACE_NVS_PROFILE, channel), (uint16_t)err);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "nvs_save_profile failed: %s", esp_err_to_name(err));
+        }
+        nvs_close(nvs);
+    } else {
+        ESP_LOGW(TAG, "nvs_open(write) failed: %s", esp_err_to_name(err));
+    }
+}
+
 void app_config_reset_counter_request(void)
 {
-    ESP_LOGI(TAG, "Reset counter requested");
+    APP_LOGI(CFG_RESET_REQUESTED);
     s_reset_pending = true;
 }
 
@@ -77,7 +272,7 @@ bool app_config_consume_reset_request(void)
 {
     if (s_reset_pending) {
         s_reset_pending = false;
-        ESP_LOGI(TAG, "Reset counter pending flag consumed");
+        APP_LOGI(CFG_RESET_CONSUMED);
         return true;
     }
     return false;
@@ -90,10 +285,60 @@ void config_cluster_add(esp_zb_cluster_list_t *cluster_list, app_metering_cfg_t
 
     esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(APP_MFG_CLUSTER_ID);
 
-    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, 0x0008, APP_MFG_CODE,
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_RESET_COUNTER, APP_MFG_CODE,
                                          ESP_ZB_ZCL_ATTR_TYPE_BOOL,
                                          ESP_ZB_ZCL_ATTR_ACCESS_WRITE_ONLY,
                                          &s_reset_counter_attr);
+#if CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_BATTERY_DAYS, APP_MFG_CODE,
+                                         ESP_ZB_ZCL_ATTR_TYPE_U16,
+                                         ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                                         &s_battery_days_attr);
+#endif
+
+    for (uint16_t id = APP_MFG_ATTR_DIAG_FIRST; id <= APP_MFG_ATTR_DEEP_LAST; id++) {
+        uint32_t *slot = config_cluster_diag_slot(id);
+        if (slot) {
+            esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, id, APP_MFG_CODE,
+                                                 ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                 ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, slot);
+        }
+    }
+
+    config_cluster_fill_trace_page(0);
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_TRACE_TOTAL, APP_MFG_CODE,
+                                         ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                         ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                         &s_trace_total_attr);
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_TRACE_PAGE, APP_MFG_CODE,
+                                         ESP_ZB_ZCL_ATTR_TYPE_U8,
+                                         ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE,
+                                         &s_trace_page_attr);
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_TRACE_DATA, APP_MFG_CODE,
+                                         ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+                                         ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                         s_trace_data_attr);
+#if CONFIG_LATENCY_PROBES
+    config_cluster_fill_latency(LATENCY_STAGE_TOTAL);
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_LATENCY_STAGE, APP_MFG_CODE,
+                                         ESP_ZB_ZCL_ATTR_TYPE_U8,
+                                         ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE,
+                                         &s_latency_stage_attr);
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_LATENCY_HIST, APP_MFG_CODE,
+                                         ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+                                         ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                                         s_latency_hist_attr);
+#endif
+#if CONFIG_LEAK_DETECT
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_LEAK_ALARM, APP_MFG_CODE,
+                                         ESP_ZB_ZCL_ATTR_TYPE_32BITMAP,
+                                         ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                                         &s_leak_alarm_attr);
+#endif
+    esp_zb_cluster_add_manufacturer_attr(attr_list, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_BACKLOG, APP_MFG_CODE,
+                                         ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+                                         ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                                         s_backlog_attr);
 
     esp_zb_cluster_list_add_custom_cluster(cluster_list, attr_list,
                                            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
@@ -103,7 +348,7 @@ void config_cluster_apply_pending(app_metering_cfg_t *cfg)
 {
     (void)cfg;
     if (s_reset_counter_attr) {
-        ESP_LOGI(TAG, "Reset attribute set via manufacturer cluster");
+        APP_LOGI(CFG_RESET_ATTR_SET);
         s_reset_counter_attr = 0;
         app_config_reset_counter_request();
     }
@@ -113,3 +358,110 @@ void config_cluster_register_callbacks(void)
 {
     (void)APP_MFG_CODE;
 }
+
+void config_cluster_set_battery_days(uint16_t days)
+{
+#if CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+    if (days == s_battery_days_attr) {
+        return;
+    }
+    s_battery_days_attr = days;
+    esp_zb_zcl_set_manufacturer_attribute_val(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                              APP_MFG_CODE, APP_MFG_ATTR_BATTERY_DAYS, &days, false);
+#else
+    (void)days;
+#endif
+}
+
+void config_cluster_set_leak_alarm(uint32_t alarms)
+{
+#if CONFIG_LEAK_DETECT
+    s_leak_alarm_attr = alarms;
+    esp_zb_zcl_set_manufacturer_attribute_val(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                              APP_MFG_CODE, APP_MFG_ATTR_LEAK_ALARM, &alarms, false);
+#else
+    (void)alarms;
+#endif
+}
+
+void config_cluster_set_diag(uint16_t attr_id, uint32_t value)
+{
+    uint32_t *slot = config_cluster_diag_slot(attr_id);
+    if (!slot || *slot == value) {
+        return;
+    }
+    *slot = value;
+    esp_zb_zcl_set_manufacturer_attribute_val(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                              APP_MFG_CODE, attr_id, &value, false);
+}
+
+static void config_cluster_fill_trace_page(uint8_t page)
+{
+    evtrace_entry_t entries[APP_TRACE_PAGE_ENTRIES];
+    size_t n = evtrace_read((size_t)page * APP_TRACE_PAGE_ENTRIES, entries, APP_TRACE_PAGE_ENTRIES);
+
+    s_trace_page_attr = page;
+    s_trace_data_attr[0] = (uint8_t)(n * sizeof(evtrace_entry_t));
+    memcpy(&s_trace_data_attr[1], entries, n * sizeof(evtrace_entry_t));
+    s_trace_total_attr = evtrace_total();
+}
+
+void config_cluster_select_trace_page(uint8_t page)
+{
+    config_cluster_fill_trace_page(page);
+    esp_zb_zcl_set_manufacturer_attribute_val(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                              APP_MFG_CODE, APP_MFG_ATTR_TRACE_DATA, s_trace_data_attr, false);
+    esp_zb_zcl_set_manufacturer_attribute_val(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                              APP_MFG_CODE, APP_MFG_ATTR_TRACE_TOTAL, &s_trace_total_attr, false);
+}
+
+#if CONFIG_LATENCY_PROBES
+static uint8_t *config_cluster_put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        *p++ = (uint8_t)(v >> (8 * i));
+    }
+    return p;
+}
+
+static void config_cluster_fill_latency(uint8_t stage)
+{
+    s_latency_stage_attr = stage;
+    const latency_hist_t *h = latency_hist((latency_stage_t)stage);
+    if (!h) {
+        s_latency_hist_attr[0] = 0;
+        return;
+    }
+    uint8_t *p = &s_latency_hist_attr[1];
+    p = config_cluster_put_u32(p, h->count);
+    p = config_cluster_put_u32(p, h->max_us);
+    p = config_cluster_put_u32(p, h->count ? (uint32_t)(h->sum_us / h->count) : 0);
+    for (unsigned n = 0; n < LATENCY_BUCKETS; n++) {
+        *p++ = (uint8_t)h->buckets[n];
+        *p++ = (uint8_t)(h->buckets[n] >> 8);
+    }
+    s_latency_hist_attr[0] = (uint8_t)(p - &s_latency_hist_attr[1]);
+}
+#endif
+
+void config_cluster_select_latency_stage(uint8_t stage)
+{
+#if CONFIG_LATENCY_PROBES
+    config_cluster_fill_latency(stage);
+    esp_zb_zcl_set_manufacturer_attribute_val(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                              APP_MFG_CODE, APP_MFG_ATTR_LATENCY_HIST, s_latency_hist_attr, false);
+#else
+    (void)stage;
+#endif
+}
+
+void config_cluster_set_backlog(const uint8_t *data, uint8_t len)
+{
+    if (len > sizeof(s_backlog_attr) - 1) {
+        len = sizeof(s_backlog_attr) - 1;
+    }
+    s_backlog_attr[0] = len;
+    memcpy(&s_backlog_attr[1], data, len);
+    esp_zb_zcl_set_manufacturer_attribute_val(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                              APP_MFG_CODE, APP_MFG_ATTR_BACKLOG, s_backlog_attr, false);
+}
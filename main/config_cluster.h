@@ -6,3 +6,15 @@
 void config_cluster_add(esp_zb_cluster_list_t *cluster_list, app_metering_cfg_t *cfg);
 void config_cluster_apply_pending(app_metering_cfg_t *cfg);
 void config_cluster_register_callbacks(void);
+/* Projected battery days remaining (0xFFFF unknown). */
+void config_cluster_set_battery_days(uint16_t days);
+/* Load trace page `page` into APP_MFG_ATTR_TRACE_DATA and refresh the event total. */
+void config_cluster_select_trace_page(uint8_t page);
+/* Load latency histogram `stage` into APP_MFG_ATTR_LATENCY_HIST; no-op without CONFIG_LATENCY_PROBES. */
+void config_cluster_select_latency_stage(uint8_t stage);
+/* Leak alarm bitmap (METERING_LEAK_* per channel nibble); no-op without CONFIG_LEAK_DETECT. */
+void config_cluster_set_leak_alarm(uint32_t alarms);
+/* Load one backlog batch (APP_MFG_ATTR_BACKLOG wire format) before it is reported. */
+void config_cluster_set_backlog(const uint8_t *data, uint8_t len);
+/* Update one of the read-only APP_MFG_ATTR_DIAG_* / _SLEEP_* / _QUEUE_* / _MEM_* attributes. */
+void config_cluster_set_diag(uint16_t attr_id, uint32_t value);
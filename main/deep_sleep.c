@@ -0,0 +1,177 @@
+#include "deep_sleep.h"
+
+#include <string.h>
+
+#define DEEP_SLEEP_MAGIC 0x44534C50u /* "DSLP" */
+
+typedef enum {
+    DEEP_SLEEP_REPORT_IDLE = 0,
+    DEEP_SLEEP_REPORT_IN_FLIGHT,
+    DEEP_SLEEP_REPORT_FAILED,       /* settled for this wake */
+} deep_sleep_report_t;
+
+static deep_sleep_cfg_t s_cfg;
+static deep_sleep_rtc_t s_rec;
+/* Per wake, not retained. */
+static uint8_t s_report[CONFIG_PULSE_CHANNELS];
+static uint64_t s_sent[CONFIG_PULSE_CHANNELS];
+static bool s_heartbeat[CONFIG_PULSE_CHANNELS];
+
+static uint32_t deep_sleep_checksum(const deep_sleep_rtc_t *rec)
+{
+    /* FNV-1a over everything before the checksum field. */
+    const uint8_t *p = (const uint8_t *)rec;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < offsetof(deep_sleep_rtc_t, checksum); i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+void deep_sleep_init(const deep_sleep_cfg_t *cfg)
+{
+    s_cfg = *cfg;
+    if (s_cfg.report_pulses == 0) {
+        s_cfg.report_pulses = 1;
+    }
+    memset(&s_rec, 0, sizeof(s_rec));
+    s_rec.magic = DEEP_SLEEP_MAGIC;
+    memset(s_report, 0, sizeof(s_report));
+    memset(s_heartbeat, 0, sizeof(s_heartbeat));
+}
+
+void deep_sleep_snapshot(deep_sleep_rtc_t *dst)
+{
+    if (!dst) {
+        return;
+    }
+    *dst = s_rec;
+    dst->magic = DEEP_SLEEP_MAGIC;
+    dst->checksum = deep_sleep_checksum(dst);
+}
+
+bool deep_sleep_restore(const deep_sleep_rtc_t *src)
+{
+    if (!src || src->magic != DEEP_SLEEP_MAGIC || src->checksum != deep_sleep_checksum(src)) {
+        return false;
+    }
+    s_rec = *src;
+    return true;
+}
+
+const deep_sleep_rtc_t *deep_sleep_get(void)
+{
+    return &s_rec;
+}
+
+void deep_sleep_set_total(size_t channel, uint64_t total)
+{
+    if (channel < CONFIG_PULSE_CHANNELS) {
+        s_rec.total[channel] = total;
+    }
+}
+
+void deep_sleep_set_channel(uint8_t channel)
+{
+    s_rec.channel = channel;
+}
+
+uint64_t deep_sleep_unreported(size_t channel)
+{
+    if (channel >= CONFIG_PULSE_CHANNELS) {
+        return 0;
+    }
+    uint64_t total = s_rec.total[channel];
+    uint64_t reported = s_rec.reported[channel];
+    if (total < reported) {
+        return 1;
+    }
+    return total - reported;
+}
+
+bool deep_sleep_radio_due(void)
+{
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        if (deep_sleep_unreported(i) >= s_cfg.report_pulses) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool deep_sleep_on_wake(deep_sleep_wake_t wake)
+{
+    if (wake == DEEP_SLEEP_WAKE_COLD) {
+        return true;
+    }
+    if (s_rec.wakes != UINT32_MAX) {
+        s_rec.wakes++;
+    }
+
+    if (wake == DEEP_SLEEP_WAKE_TIMER) {
+        for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+            s_heartbeat[i] = true;
+        }
+    }
+    bool radio = wake != DEEP_SLEEP_WAKE_PULSE || deep_sleep_radio_due();
+    if (radio) {
+        deep_sleep_radio_started();
+    }
+    return radio;
+}
+
+void deep_sleep_radio_started(void)
+{
+    if (s_rec.radio_wakes != UINT32_MAX) {
+        s_rec.radio_wakes++;
+    }
+}
+
+bool deep_sleep_report_due(size_t channel)
+{
+    if (channel >= CONFIG_PULSE_CHANNELS || s_report[channel] != DEEP_SLEEP_REPORT_IDLE) {
+        return false;
+    }
+    return s_heartbeat[channel] || deep_sleep_unreported(channel) > 0;
+}
+
+void deep_sleep_report_sent(size_t channel)
+{
+    if (channel < CONFIG_PULSE_CHANNELS) {
+        s_report[channel] = DEEP_SLEEP_REPORT_IN_FLIGHT;
+        s_sent[channel] = s_rec.total[channel];
+    }
+}
+
+void deep_sleep_report_confirmed(size_t channel)
+{
+    if (channel >= CONFIG_PULSE_CHANNELS || s_report[channel] != DEEP_SLEEP_REPORT_IN_FLIGHT) {
+        return;
+    }
+    s_report[channel] = DEEP_SLEEP_REPORT_IDLE;
+    s_rec.reported[channel] = s_sent[channel];
+    s_heartbeat[channel] = false;
+}
+
+void deep_sleep_report_failed(size_t channel)
+{
+    if (channel < CONFIG_PULSE_CHANNELS && s_report[channel] == DEEP_SLEEP_REPORT_IN_FLIGHT) {
+        s_report[channel] = DEEP_SLEEP_REPORT_FAILED;
+    }
+}
+
+bool deep_sleep_allowed(bool joined, bool input_active, bool busy, int64_t awake_us)
+{
+    if (!joined || input_active || busy) {
+        return false;
+    }
+    if (awake_us >= s_cfg.awake_max_us) {
+        return true;
+    }
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        if (s_report[i] == DEEP_SLEEP_REPORT_IN_FLIGHT || deep_sleep_report_due(i)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+/* Deep-sleep mode (CONFIG_DEEP_SLEEP_MODE) for meters that see a few pulses a day: the device
+ * sleeps in deep sleep between events and keeps the pulse totals, the last totals the
+ * coordinator confirmed and the Zigbee channel in an RTC record. A pulse wake counts the pulse
+ * and goes straight back to sleep without starting the radio until REPORT_PULSES are
+ * unreported; a timer wake every TIMER_S reports regardless, as a heartbeat.
+ *
+ * This module only keeps the record and makes the decisions; main.c owns the wake sources,
+ * the stack and the RTC copy. Not thread-safe; call from app_main before the Zigbee task starts
+ * and from that task after.
+ */
+
+#ifndef CONFIG_DEEP_SLEEP_MODE
+#define CONFIG_DEEP_SLEEP_MODE 0
+#endif
+#ifndef CONFIG_DEEP_SLEEP_TIMER_S
+#define CONFIG_DEEP_SLEEP_TIMER_S 21600
+#endif
+#ifndef CONFIG_DEEP_SLEEP_REPORT_PULSES
+#define CONFIG_DEEP_SLEEP_REPORT_PULSES 1
+#endif
+#ifndef CONFIG_DEEP_SLEEP_AWAKE_MAX_S
+#define CONFIG_DEEP_SLEEP_AWAKE_MAX_S 20
+#endif
+
+typedef enum {
+    DEEP_SLEEP_WAKE_COLD = 0,   /* power-on or any reset; no valid record */
+    DEEP_SLEEP_WAKE_PULSE,      /* EXT1 on a pulse input */
+    DEEP_SLEEP_WAKE_TIMER,      /* heartbeat timer */
+    DEEP_SLEEP_WAKE_OTHER,      /* e.g. the factory-reset button */
+} deep_sleep_wake_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t wakes;                             /* deep-sleep wakes since the record was created */
+    uint32_t radio_wakes;                       /* of those, wakes that started the Zigbee stack */
+    uint32_t channel;                           /* Zigbee channel at sleep entry, 0 if unknown */
+    uint64_t total[CONFIG_PULSE_CHANNELS];      /* pulse totals at sleep entry */
+    uint64_t reported[CONFIG_PULSE_CHANNELS];   /* last totals a send confirmation covered */
+    uint32_t checksum;
+} deep_sleep_rtc_t;
+
+typedef struct {
+    uint32_t report_pulses;     /* unreported pulses on one input that start the radio */
+    int64_t awake_max_us;       /* stay awake at most this long for unconfirmed reports */
+} deep_sleep_cfg_t;
+
+/* Set the thresholds and start a fresh record (cold boot). */
+void deep_sleep_init(const deep_sleep_cfg_t *cfg);
+/* Copy the record into (or restore it from) RTC memory. Restore returns false and leaves the
+ * fresh record in place if the magic or checksum do not match.
+ */
+void deep_sleep_snapshot(deep_sleep_rtc_t *dst);
+bool deep_sleep_restore(const deep_sleep_rtc_t *src);
+const deep_sleep_rtc_t *deep_sleep_get(void);
+
+void deep_sleep_set_total(size_t channel, uint64_t total);
+void deep_sleep_set_channel(uint8_t channel);
+/* Pulses on one input the coordinator has not confirmed; a counter reset counts as one. */
+uint64_t deep_sleep_unreported(size_t channel);
+/* Some input has REPORT_PULSES or more unreported. */
+bool deep_sleep_radio_due(void);
+
+/* Classify this boot once the wake pulse is counted: true if it needs the radio, false if the
+ * device can go back to sleep after the contact opens. A timer wake makes every input due for
+ * a report.
+ */
+bool deep_sleep_on_wake(deep_sleep_wake_t wake);
+/* The boot started the Zigbee stack after all (count-only wake with the contact held). */
+void deep_sleep_radio_started(void);
+
+/* Explicit summation reports: due while an input has unreported pulses or a heartbeat is owed
+ * and nothing is in flight for it. A confirmation settles the total that was sent; a failure
+ * settles the input for this wake, the RTC record keeps it unreported for the next one.
+ */
+bool deep_sleep_report_due(size_t channel);
+void deep_sleep_report_sent(size_t channel);
+void deep_sleep_report_confirmed(size_t channel);
+void deep_sleep_report_failed(size_t channel);
+
+/* Deep sleep now? Only joined, with the inputs idle and nothing else in flight (busy), and
+ * once every due report is settled or awake_us exceeds the awake budget.
+ */
+bool deep_sleep_allowed(bool joined, bool input_active, bool busy, int64_t awake_us);
@@ -0,0 +1,126 @@
+#include "energy.h"
+
+#include <string.h>
+
+/* uA * us -> nAh */
+#define ENERGY_UA_US_PER_NAH 3600000ULL
+#define ENERGY_US_PER_DAY    86400000000ULL
+
+static energy_model_t s_model;
+static int64_t s_init_us;
+static int64_t s_last_tick_us;
+static uint64_t s_time_us[ENERGY_STATE_COUNT];
+static uint32_t s_counts[ENERGY_COUNT_COUNT];
+static uint64_t s_claimed_us;
+static uint64_t s_idle_us;
+static bool s_listening;
+static uint64_t s_charge_ua_us;
+
+static void energy_account(energy_state_t state, uint64_t duration_us)
+{
+    s_time_us[state] += duration_us;
+    s_charge_ua_us += duration_us * (uint64_t)s_model.current_ua[state];
+}
+
+void energy_init(const energy_model_t *model, int64_t now_us)
+{
+    s_model = *model;
+    s_init_us = now_us;
+    s_last_tick_us = now_us;
+    memset(s_time_us, 0, sizeof(s_time_us));
+    memset(s_counts, 0, sizeof(s_counts));
+    s_claimed_us = 0;
+    s_idle_us = 0;
+    s_listening = false;
+    s_charge_ua_us = 0;
+}
+
+void energy_add(energy_state_t state, uint32_t duration_us)
+{
+    if (state >= ENERGY_STATE_COUNT || state == ENERGY_STATE_AWAKE_IDLE || state == ENERGY_STATE_CPU_BUSY) {
+        return;
+    }
+    energy_account(state, duration_us);
+    s_claimed_us += duration_us;
+}
+
+void energy_count(energy_counter_t counter)
+{
+    if (counter < ENERGY_COUNT_COUNT && s_counts[counter] != UINT32_MAX) {
+        s_counts[counter]++;
+    }
+}
+
+void energy_note_cpu_idle(uint32_t idle_us)
+{
+    s_idle_us += idle_us;
+}
+
+void energy_set_listening(bool listening)
+{
+    s_listening = listening;
+}
+
+void energy_tick(int64_t now_us)
+{
+    if (now_us <= s_last_tick_us) {
+        return;
+    }
+    uint64_t wall_us = (uint64_t)(now_us - s_last_tick_us);
+    s_last_tick_us = now_us;
+
+    /* Spans reported late (e.g. an ADC burst from another task) may overshoot this window;
+     * carry the excess so the total never exceeds wall time.
+     */
+    if (s_claimed_us >= wall_us) {
+        s_claimed_us -= wall_us;
+        s_idle_us = 0;
+        return;
+    }
+    uint64_t remainder = wall_us - s_claimed_us;
+    s_claimed_us = 0;
+
+    uint64_t idle = s_idle_us < remainder ? s_idle_us : remainder;
+    s_idle_us = 0;
+
+    if (s_listening) {
+        energy_account(ENERGY_STATE_RX, remainder);
+        return;
+    }
+    energy_account(ENERGY_STATE_AWAKE_IDLE, idle);
+    energy_account(ENERGY_STATE_CPU_BUSY, remainder - idle);
+}
+
+uint64_t energy_get_time_us(energy_state_t state)
+{
+    if (state >= ENERGY_STATE_COUNT) {
+        return 0;
+    }
+    return s_time_us[state];
+}
+
+uint32_t energy_get_count(energy_counter_t counter)
+{
+    if (counter >= ENERGY_COUNT_COUNT) {
+        return 0;
+    }
+    return s_counts[counter];
+}
+
+uint64_t energy_get_charge_nah(void)
+{
+    return s_charge_ua_us / ENERGY_UA_US_PER_NAH;
+}
+
+uint32_t energy_get_uah_per_day(int64_t now_us)
+{
+    if (now_us <= s_init_us) {
+        return 0;
+    }
+    uint64_t elapsed_s = (uint64_t)(now_us - s_init_us) / 1000000ULL;
+    if (elapsed_s == 0) {
+        return 0;
+    }
+    uint64_t per_day = (energy_get_charge_nah() / 1000U) * (ENERGY_US_PER_DAY / 1000000ULL) / elapsed_s;
+    return per_day > UINT32_MAX ? UINT32_MAX : (uint32_t)per_day;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Time-per-power-state ledger and the charge it implies under a fixed current model.
+ * It reads no clock: callers pass timestamps and durations. Not thread-safe; battery bursts
+ * and optical samples are timed where they happen and booked later from the Zigbee task.
+ */
+
+typedef enum {
+    ENERGY_STATE_SLEEP = 0,
+    ENERGY_STATE_AWAKE_IDLE,
+    ENERGY_STATE_CPU_BUSY,
+    ENERGY_STATE_RX,
+    ENERGY_STATE_TX,
+    ENERGY_STATE_ADC,
+    ENERGY_STATE_FLASH,
+    ENERGY_STATE_COUNT,
+} energy_state_t;
+
+typedef enum {
+    ENERGY_COUNT_WAKES = 0,
+    ENERGY_COUNT_TX_FRAMES,
+    ENERGY_COUNT_ADC_BURSTS,
+    ENERGY_COUNT_FLASH_WRITES,
+    ENERGY_COUNT_COUNT,
+} energy_counter_t;
+
+typedef struct {
+    uint32_t current_ua[ENERGY_STATE_COUNT];
+} energy_model_t;
+
+void energy_init(const energy_model_t *model, int64_t now_us);
+/* Attribute a span to a non-remainder state (sleep, RX, TX, ADC, flash); it is carved out of
+ * the awake remainder on the next tick.
+ */
+void energy_add(energy_state_t state, uint32_t duration_us);
+void energy_count(energy_counter_t counter);
+/* CPU idle time observed since the previous tick (e.g. idle-task run time). Without it the
+ * whole awake remainder is booked as CPU busy.
+ */
+void energy_note_cpu_idle(uint32_t idle_us);
+/* While the receiver is kept on (joining, RxOnWhenIdle) the awake remainder is booked as RX. */
+void energy_set_listening(bool listening);
+/* Close the window since the previous tick. */
+void energy_tick(int64_t now_us);
+
+uint64_t energy_get_time_us(energy_state_t state);
+uint32_t energy_get_count(energy_counter_t counter);
+/* Charge consumed since init, in nAh. */
+uint64_t energy_get_charge_nah(void);
+/* Average consumption since init scaled to a day, in uAh. */
+uint32_t energy_get_uah_per_day(int64_t now_us);
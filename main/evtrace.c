@@ -0,0 +1,83 @@
+#include "evtrace.h"
+
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+
+#ifndef CONFIG_EVTRACE_ENTRIES
+#define CONFIG_EVTRACE_ENTRIES 64
+#endif
+
+#define EVTRACE_MAGIC 0x45565452u /* "EVTR" */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t head;          /* total events written; slot is head % CONFIG_EVTRACE_ENTRIES */
+    uint16_t boot_count;
+    evtrace_entry_t entries[CONFIG_EVTRACE_ENTRIES];
+} evtrace_ring_t;
+
+static RTC_NOINIT_ATTR evtrace_ring_t s_ring;
+
+static inline uint32_t evtrace_now(void)
+{
+    return (uint32_t)((uint64_t)esp_timer_get_time() >> 10);
+}
+
+void evtrace_init(void)
+{
+    if (s_ring.magic != EVTRACE_MAGIC) {
+        memset(&s_ring, 0, sizeof(s_ring));
+        s_ring.magic = EVTRACE_MAGIC;
+    }
+    s_ring.boot_count++;
+    evtrace_record(EVT_BOOT, (uint8_t)esp_reset_reason(), s_ring.boot_count);
+}
+
+void evtrace_record(evtrace_type_t type, uint8_t arg8, uint16_t arg16)
+{
+    uint32_t idx = __atomic_fetch_add(&s_ring.head, 1, __ATOMIC_RELAXED);
+    evtrace_entry_t *e = &s_ring.entries[idx % CONFIG_EVTRACE_ENTRIES];
+    e->ts = evtrace_now();
+    e->type = (uint8_t)type;
+    e->arg8 = arg8;
+    e->arg16 = arg16;
+}
+
+void evtrace_record_coalesced(evtrace_type_t type, uint8_t arg8)
+{
+    uint32_t head = s_ring.head;
+    if (head > 0) {
+        evtrace_entry_t *last = &s_ring.entries[(head - 1) % CONFIG_EVTRACE_ENTRIES];
+        if (last->type == (uint8_t)type && last->arg8 == arg8 && last->arg16 != UINT16_MAX) {
+            last->ts = evtrace_now();
+            last->arg16++;
+            return;
+        }
+    }
+    evtrace_record(type, arg8, 1);
+}
+
+uint32_t evtrace_total(void)
+{
+    return s_ring.head;
+}
+
+size_t evtrace_capacity(void)
+{
+    return CONFIG_EVTRACE_ENTRIES;
+}
+
+size_t evtrace_read(size_t first, evtrace_entry_t *out, size_t max)
+{
+    uint32_t head = s_ring.head;
+    size_t count = head < CONFIG_EVTRACE_ENTRIES ? head : CONFIG_EVTRACE_ENTRIES;
+    uint32_t oldest = head - (uint32_t)count;
+    size_t n = 0;
+    for (size_t i = first; i < count && n < max; i++) {
+        out[n++] = s_ring.entries[(oldest + i) % CONFIG_EVTRACE_ENTRIES];
+    }
+    return n;
+}
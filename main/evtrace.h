@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Post-mortem trace of application events in RTC no-init memory. Survives software,
+ * watchdog and panic resets; a power cycle clears it. Recording is a timestamp read, one
+ * atomic increment and an 8-byte store, so it stays on in production builds.
+ */
+
+typedef enum {
+    EVT_BOOT = 1,           /* arg8 reset reason (esp_reset_reason_t), arg16 boot count */
+    EVT_PULSES,             /* arg8 channel << 5 | pulses lost (saturated at 31), arg16 pulses counted */
+    EVT_SLEEP,              /* arg8 wake cause (sleep_wake_t), arg16 consecutive cycles with that cause */
+    EVT_SLEEP_SKIP,         /* arg8 reason (sleep_skip_t), arg16 consecutive skips */
+    EVT_STEER,              /* arg8 attempt (saturated) */
+    EVT_JOINED,             /* arg16 short address */
+    EVT_TX_STATUS,          /* arg8 ZCL tsn, arg16 esp_err_t status (truncated) */
+    EVT_NVS_SAVE,           /* arg8 EVTRACE_NVS_KEY(key, channel), arg16 esp_err_t (truncated) */
+    EVT_OTA,                /* arg8 esp_zb_zcl_ota_upgrade_status_t, arg16 image KiB received */
+    EVT_REPORT_LINK,        /* arg8 1 up / 0 down, arg16 buffered snapshots */
+    EVT_LEAK,               /* arg8 leak alarm bitmap (METERING_LEAK_*), arg16 channel */
+    EVT_DEEP_SLEEP,         /* arg8 1 after a radio wake / 0 count only, arg16 unreported pulses (channel 0) */
+} evtrace_type_t;
+
+typedef enum {
+    EVTRACE_NVS_PULSES = 0,
+    EVTRACE_NVS_SOC,
+    EVTRACE_NVS_PROFILE,
+} evtrace_nvs_key_t;
+
+/* Per-channel keys carry the pulse channel in the high nibble. */
+#define EVTRACE_NVS_KEY(key, channel) ((uint8_t)((key) | ((channel) << 4)))
+
+/* Wire format of the download pages (little-endian). ts is esp_timer time >> 10 (~1.024 ms). */
+typedef struct {
+    uint32_t ts;
+    uint8_t type;
+    uint8_t arg8;
+    uint16_t arg16;
+} evtrace_entry_t;
+
+/* Validate the retained ring (or clear it) and record EVT_BOOT with the reset reason. */
+void evtrace_init(void);
+void evtrace_record(evtrace_type_t type, uint8_t arg8, uint16_t arg16);
+/* Like evtrace_record, but bumps arg16 of the newest entry if it has the same type and arg8.
+ * Single-writer only (the Zigbee task), used for the high-rate sleep cycles.
+ */
+void evtrace_record_coalesced(evtrace_type_t type, uint8_t arg8);
+
+/* Events written since the ring was last cleared (may exceed the capacity). */
+uint32_t evtrace_total(void);
+size_t evtrace_capacity(void);
+/* Copy up to max entries, oldest first, starting at chronological index first. */
+size_t evtrace_read(size_t first, evtrace_entry_t *out, size_t max);
@@ -0,0 +1,126 @@
+#include "latency.h"
+
+#include <string.h>
+
+static latency_hist_t s_hist[LATENCY_STAGE_COUNT];
+
+static void latency_hist_add(latency_stage_t stage, int64_t from_us, int64_t to_us)
+{
+    latency_hist_t *h = &s_hist[stage];
+    uint64_t us = to_us > from_us ? (uint64_t)(to_us - from_us) : 0;
+    uint64_t ms = us / 1000u;
+
+    unsigned n = 0;
+    while (ms > 0 && n < LATENCY_BUCKETS - 1) {
+        ms >>= 1;
+        n++;
+    }
+    if (h->buckets[n] != UINT16_MAX) {
+        h->buckets[n]++;
+    }
+    if (h->count != UINT32_MAX) {
+        h->count++;
+    }
+    uint32_t us32 = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    if (us32 > h->max_us) {
+        h->max_us = us32;
+    }
+    h->sum_us += us;
+}
+
+void latency_counted(latency_chan_t *lc, int64_t edge_us, int64_t counted_us)
+{
+    uint32_t head = lc->head;
+    if (head - __atomic_load_n(&lc->tail, __ATOMIC_ACQUIRE) >= LATENCY_INFLIGHT) {
+        lc->dropped++;
+        return;
+    }
+    lc->ring[head % LATENCY_INFLIGHT] = (latency_sample_t){
+        .edge_us = edge_us,
+        .counted_us = counted_us,
+    };
+    __atomic_store_n(&lc->head, head + 1u, __ATOMIC_RELEASE);
+}
+
+void latency_pickup(latency_chan_t *lc, int64_t last_us, int64_t now_us)
+{
+    uint32_t head = __atomic_load_n(&lc->head, __ATOMIC_ACQUIRE);
+    for (uint32_t i = lc->tail; i != head; i++) {
+        latency_sample_t *s = &lc->ring[i % LATENCY_INFLIGHT];
+        if (s->pickup_us == 0 && s->counted_us <= last_us) {
+            s->pickup_us = now_us;
+        }
+    }
+}
+
+void latency_attr(latency_chan_t *lc, int64_t now_us)
+{
+    uint32_t head = __atomic_load_n(&lc->head, __ATOMIC_ACQUIRE);
+    for (uint32_t i = lc->tail; i != head; i++) {
+        latency_sample_t *s = &lc->ring[i % LATENCY_INFLIGHT];
+        if (s->pickup_us != 0 && s->attr_us == 0) {
+            s->attr_us = now_us;
+        }
+    }
+}
+
+void latency_tx(latency_chan_t *lc, int64_t now_us)
+{
+    uint32_t head = __atomic_load_n(&lc->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = lc->tail;
+    /* Samples are stamped in order, so the written ones are a prefix of the ring. */
+    while (tail != head) {
+        const latency_sample_t *s = &lc->ring[tail % LATENCY_INFLIGHT];
+        if (s->attr_us == 0) {
+            break;
+        }
+        latency_hist_add(LATENCY_STAGE_COUNTED, s->edge_us, s->counted_us);
+        latency_hist_add(LATENCY_STAGE_PICKUP, s->counted_us, s->pickup_us);
+        latency_hist_add(LATENCY_STAGE_ATTR, s->pickup_us, s->attr_us);
+        latency_hist_add(LATENCY_STAGE_TX, s->attr_us, now_us);
+        latency_hist_add(LATENCY_STAGE_TOTAL, s->edge_us, now_us);
+        tail++;
+    }
+    __atomic_store_n(&lc->tail, tail, __ATOMIC_RELEASE);
+}
+
+void latency_reset(void)
+{
+    memset(s_hist, 0, sizeof(s_hist));
+}
+
+const latency_hist_t *latency_hist(latency_stage_t stage)
+{
+    if ((unsigned)stage >= LATENCY_STAGE_COUNT) {
+        return NULL;
+    }
+    return &s_hist[stage];
+}
+
+uint32_t latency_bucket_ms(unsigned n)
+{
+    if (n >= LATENCY_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return 1u << n;
+}
+
+uint32_t latency_percentile_ms(const latency_hist_t *h, unsigned pct)
+{
+    uint32_t total = 0;
+    for (unsigned n = 0; n < LATENCY_BUCKETS; n++) {
+        total += h->buckets[n];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t want = ((uint64_t)total * pct + 99u) / 100u;
+    uint32_t seen = 0;
+    for (unsigned n = 0; n < LATENCY_BUCKETS; n++) {
+        seen += h->buckets[n];
+        if (seen >= want) {
+            return latency_bucket_ms(n);
+        }
+    }
+    return UINT32_MAX;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/* Pulse-to-radio latency probes (CONFIG_LATENCY_PROBES). Every counted pulse gets a sample
+ * with five timestamps: the contact edge, the pulse being counted, the consumer task picking
+ * it up, the summation write to the stack and the first send confirmation from the channel's
+ * endpoint after that write. Completed samples go into per-stage log2 histograms.
+ *
+ * With CONFIG_PULSE_LP_CORE the HP core only sees the LP core's batches: a batch of n pulses is
+ * one sample, whose edge time is the last pulse's LP tick (quantized to PULSE_LP_SAMPLE_MS).
+ * There the histograms describe wakes, not per-pulse tail latency; the earlier pulses of a batch
+ * waited longer than the sample shows.
+ *
+ * The pulse path appends samples to a per-input ring; the Zigbee task stamps and retires them
+ * and owns the histograms. With the option off the LATENCY_PROBE_* macros expand to nothing
+ * (their arguments are not evaluated) and callers guard the rest with #if CONFIG_LATENCY_PROBES.
+ */
+
+#ifndef CONFIG_LATENCY_PROBES
+#define CONFIG_LATENCY_PROBES 0
+#endif
+
+typedef enum {
+    LATENCY_STAGE_COUNTED = 0,  /* edge -> pulse counted (press-up callback or wake record) */
+    LATENCY_STAGE_PICKUP,       /* counted -> consumer task took the batch */
+    LATENCY_STAGE_ATTR,         /* pickup -> summation written to the stack */
+    LATENCY_STAGE_TX,           /* attribute write -> send confirmation */
+    LATENCY_STAGE_TOTAL,        /* edge -> send confirmation */
+    LATENCY_STAGE_COUNT,
+} latency_stage_t;
+
+/* Bucket 0 is < 1 ms, bucket n covers [2^(n-1), 2^n) ms, the last one is open-ended (>= 16 s). */
+#define LATENCY_BUCKETS 16
+/* Samples in flight per input; pulses beyond that are counted in `dropped` only. */
+#define LATENCY_INFLIGHT 8
+
+typedef struct {
+    uint16_t buckets[LATENCY_BUCKETS];  /* saturating */
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_hist_t;
+
+typedef struct {
+    int64_t edge_us;
+    int64_t counted_us;
+    int64_t pickup_us;          /* 0 until picked up */
+    int64_t attr_us;            /* 0 until written */
+} latency_sample_t;
+
+/* In-flight samples of one pulse input. head is advanced by the pulse path only, tail by the
+ * Zigbee task only.
+ */
+typedef struct {
+    latency_sample_t ring[LATENCY_INFLIGHT];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;
+} latency_chan_t;
+
+/* Pulse path: one pulse counted at counted_us for a contact edge at edge_us. */
+void latency_counted(latency_chan_t *lc, int64_t edge_us, int64_t counted_us);
+/* Zigbee task: a batch ending with the pulse counted at last_us was taken at now_us. Matching
+ * on the counter timestamp keeps a pulse that lands after the take out of this batch.
+ */
+void latency_pickup(latency_chan_t *lc, int64_t last_us, int64_t now_us);
+/* Zigbee task: the input's summation reached the stack; stamps every picked-up sample. */
+void latency_attr(latency_chan_t *lc, int64_t now_us);
+/* Zigbee task: a frame from the input's endpoint was confirmed; retire the written samples. */
+void latency_tx(latency_chan_t *lc, int64_t now_us);
+
+/* Clear the histograms (not the samples in flight). */
+void latency_reset(void);
+const latency_hist_t *latency_hist(latency_stage_t stage);
+/* Upper bound in ms of bucket n; UINT32_MAX for the open-ended last bucket. */
+uint32_t latency_bucket_ms(unsigned n);
+/* Smallest bucket bound covering at least pct percent of the samples; 0 if empty. */
+uint32_t latency_percentile_ms(const latency_hist_t *h, unsigned pct);
+
+#if CONFIG_LATENCY_PROBES
+#define LATENCY_PROBE_COUNTED(lc, edge_us, now_us) latency_counted((lc), (edge_us), (now_us))
+#define LATENCY_PROBE_PICKUP(lc, last_us, now_us) latency_pickup((lc), (last_us), (now_us))
+#else
+#define LATENCY_PROBE_COUNTED(lc, edge_us, now_us) ((void)0)
+#define LATENCY_PROBE_PICKUP(lc, last_us, now_us) ((void)0)
+#endif
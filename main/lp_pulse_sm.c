@@ -0,0 +1,118 @@
+#include "lp_pulse_sm.h"
+
+#include <string.h>
+
+#define LP_PULSE_MAGIC 0x4C50504Cu /* "LPPL" */
+
+/* Single writer (the LP program): no claim, just odd while the records change. */
+static void lp_pulse_write_begin(lp_pulse_t *lp)
+{
+    __atomic_store_n(&lp->seq, lp->seq + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void lp_pulse_write_end(lp_pulse_t *lp)
+{
+    __atomic_store_n(&lp->seq, lp->seq + 1u, __ATOMIC_RELEASE);
+}
+
+uint32_t lp_pulse_ticks(uint32_t ms, uint32_t sample_us)
+{
+    if (sample_us == 0) {
+        return 0;
+    }
+    uint64_t us = (uint64_t)ms * 1000u;
+    return (uint32_t)((us + sample_us - 1u) / sample_us);
+}
+
+void lp_pulse_init(lp_pulse_t *lp, const lp_pulse_cfg_t *cfg)
+{
+    memset(lp, 0, sizeof(*lp));
+    lp->cfg = *cfg;
+    if (lp->cfg.channels > LP_PULSE_MAX_CHANNELS) {
+        lp->cfg.channels = LP_PULSE_MAX_CHANNELS;
+    }
+    if (lp->cfg.wake_pulses == 0) {
+        lp->cfg.wake_pulses = 1;
+    }
+    lp->magic = LP_PULSE_MAGIC;
+}
+
+bool lp_pulse_valid(const lp_pulse_t *lp, const lp_pulse_cfg_t *cfg)
+{
+    lp_pulse_t want;
+    lp_pulse_init(&want, cfg);
+    return lp->magic == LP_PULSE_MAGIC && memcmp(&lp->cfg, &want.cfg, sizeof(want.cfg)) == 0;
+}
+
+bool lp_pulse_sample(lp_pulse_t *lp, uint32_t low_mask)
+{
+    lp_pulse_write_begin(lp);
+    uint64_t now = ++lp->tick;
+    bool wake = false;
+
+    for (uint32_t i = 0; i < lp->cfg.channels; i++) {
+        lp_pulse_chan_t *c = &lp->chan[i];
+        const lp_pulse_chan_cfg_t *cc = &lp->cfg.chan[i];
+
+        if (low_mask & (1u << i)) {
+            if (c->down_tick == 0) {
+                c->down_tick = now;
+            }
+        } else if (c->down_tick != 0) {
+            /* Released: the closure lasted one tick per low sample. */
+            uint64_t width = now - c->down_tick;
+            c->down_tick = 0;
+            bool counts = cc->min_width_ticks == 0 || width >= cc->min_width_ticks;
+            if (counts && (c->last_tick == 0 || now - c->last_tick >= cc->debounce_ticks)) {
+                c->prev_tick = c->last_tick;
+                c->last_tick = now;
+                c->counted++;
+            }
+        }
+
+        /* Once per batch: the HP core takes everything when it wakes. */
+        if (c->counted - lp->taken[i] >= lp->cfg.wake_pulses && c->counted != c->notified) {
+            c->notified = c->counted;
+            wake = true;
+        }
+    }
+
+    if (wake) {
+        lp->wakes++;
+    }
+    lp_pulse_write_end(lp);
+    return wake;
+}
+
+uint32_t lp_pulse_take(lp_pulse_t *lp, size_t channel, lp_pulse_snapshot_t *snap)
+{
+    if (channel >= LP_PULSE_MAX_CHANNELS) {
+        return 0;
+    }
+    const lp_pulse_chan_t *c = &lp->chan[channel];
+    uint32_t seq;
+    uint32_t counted;
+    do {
+        seq = __atomic_load_n(&lp->seq, __ATOMIC_ACQUIRE);
+        counted = c->counted;
+        snap->tick = lp->tick;
+        snap->last_tick = c->last_tick;
+        snap->prev_tick = c->prev_tick;
+        snap->wakes = lp->wakes;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1u) || seq != __atomic_load_n(&lp->seq, __ATOMIC_RELAXED));
+
+    uint32_t n = counted - lp->taken[channel];
+    lp->taken[channel] = counted;
+    return n;
+}
+
+bool lp_pulse_due(const lp_pulse_t *lp, size_t channel)
+{
+    if (channel >= LP_PULSE_MAX_CHANNELS) {
+        return false;
+    }
+    uint32_t counted = __atomic_load_n(&lp->chan[channel].counted, __ATOMIC_RELAXED);
+    return counted - lp->taken[channel] >= lp->cfg.wake_pulses;
+}
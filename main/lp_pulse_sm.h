@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Pulse counting state machine of the ESP32-C6 LP core program (CONFIG_PULSE_LP_CORE). The LP
+ * core wakes on its timer every sample period, reads the pulse pins and calls lp_pulse_sample();
+ * the HP core sleeps until an input has wake_pulses it has not taken, or its own timer fires.
+ * Same rules as pulse.c, in whole samples: a closure counts at its release if it was low for at
+ * least min_width and the release is at least debounce after the last counted one. Closures
+ * shorter than a sample can be missed.
+ *
+ * One lp_pulse_t in LP memory is shared by both cores. The LP program is the only writer of the
+ * channel records and publishes them with a sequence lock (see pulse_counter.h); the HP core
+ * writes cfg before it starts the program and `taken` after, and reads the rest with
+ * lp_pulse_take(). Pure C so it builds for the LP core and runs in the host benchmarks.
+ */
+
+#define LP_PULSE_MAX_CHANNELS 8
+
+typedef struct {
+    uint32_t gpio;              /* LP IO number, read by the LP program */
+    uint32_t debounce_ticks;
+    uint32_t min_width_ticks;   /* 0 disables the check */
+} lp_pulse_chan_cfg_t;
+
+typedef struct {
+    uint32_t channels;
+    uint32_t sample_us;         /* one tick */
+    uint32_t wake_pulses;       /* untaken pulses on one input that wake the HP core */
+    uint32_t strobe_settle_us;  /* pins pulled down between samples, up this long before each read; 0: always up */
+    lp_pulse_chan_cfg_t chan[LP_PULSE_MAX_CHANNELS];
+} lp_pulse_cfg_t;
+
+typedef struct {
+    uint32_t counted;           /* pulses since the program started; wraps */
+    uint32_t notified;          /* counted when the HP core was last woken for this input */
+    uint64_t down_tick;         /* first low sample of the closure in progress, 0 while open */
+    uint64_t last_tick;         /* tick of the last counted pulse, 0 if none */
+    uint64_t prev_tick;         /* tick of the one before, 0 if none */
+} lp_pulse_chan_t;
+
+typedef struct {
+    uint32_t magic;
+    lp_pulse_cfg_t cfg;
+    volatile uint32_t seq;
+    uint64_t tick;              /* samples taken; the first one is tick 1 */
+    uint32_t wakes;             /* HP wakes raised */
+    lp_pulse_chan_t chan[LP_PULSE_MAX_CHANNELS];
+    volatile uint32_t taken[LP_PULSE_MAX_CHANNELS];     /* HP core: counted already handed to pulse.c */
+} lp_pulse_t;
+
+typedef struct {
+    uint64_t tick;
+    uint64_t last_tick;
+    uint64_t prev_tick;
+    uint32_t wakes;
+} lp_pulse_snapshot_t;
+
+/* Ticks covering ms at sample_us per tick, rounded up so the rule matches pulse.c's on the
+ * sampled times.
+ */
+uint32_t lp_pulse_ticks(uint32_t ms, uint32_t sample_us);
+
+/* HP core: fresh state for cfg. */
+void lp_pulse_init(lp_pulse_t *lp, const lp_pulse_cfg_t *cfg);
+/* HP core: lp holds a running program's state for cfg (e.g. after a deep-sleep boot). */
+bool lp_pulse_valid(const lp_pulse_t *lp, const lp_pulse_cfg_t *cfg);
+
+/* LP core: one sample; bit n of low_mask set while input n is closed. Returns true if the HP
+ * core should be woken.
+ */
+bool lp_pulse_sample(lp_pulse_t *lp, uint32_t low_mask);
+
+/* HP core: pulses on channel counted since the last take, with the timestamps of the latest two
+ * in snap. Marks them taken.
+ */
+uint32_t lp_pulse_take(lp_pulse_t *lp, size_t channel, lp_pulse_snapshot_t *snap);
+/* HP core: channel has enough untaken pulses to wake it. */
+bool lp_pulse_due(const lp_pulse_t *lp, size_t channel);
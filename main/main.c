@@ -20,6 +20,7 @@
 #include "driver/rtc_io.h"
 #include "esp_sleep.h"
 #include "esp_pm.h"
+#include "soc/soc_caps.h"
 
 #include "esp_zigbee_core.h"
 #include "esp_zigbee_cluster.h"
@@ -31,6 +32,7 @@
 #include "zcl/esp_zigbee_zcl_power_config.h"
 #include "zcl/esp_zigbee_zcl_metering.h"
 #include "zcl/esp_zigbee_zcl_ota.h"
+#include "zcl/esp_zigbee_zcl_time.h"
 #include "zcl/esp_zigbee_zcl_command.h"
 #include "zdo/esp_zigbee_zdo_command.h"
 #include "esp_zigbee_ota.h"
@@ -38,12 +40,26 @@
 
 #include "app_config.h"
 #include "pulse.h"
+#include "pulse_lp.h"
+#include "pulse_optical.h"
+#include "adc_sampler.h"
 #include "iot_button.h"
 #include "button_gpio.h"
 #include "metering.h"
 #include "power.h"
 #include "ota.h"
 #include "config_cluster.h"
+#include "energy.h"
+#include "battery_soc.h"
+#include "sleep_stats.h"
+#include "tlog.h"
+#include "evtrace.h"
+#include "report_queue.h"
+#include "timesync.h"
+#include "attr_shadow.h"
+#include "save_sched.h"
+#include "latency.h"
+#include "deep_sleep.h"
 #include "app_config.h"
 
 #ifndef CONFIG_BATTERY_ADC_ENABLE
@@ -55,6 +71,32 @@
 #ifndef CONFIG_ZB_STEER_COOLDOWN_S
 #define CONFIG_ZB_STEER_COOLDOWN_S 0
 #endif
+#ifndef CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+#define CONFIG_BATTERY_SOC_LIFEPO4_COULOMB 0
+#endif
+#ifndef CONFIG_ENERGY_CPU_STATS
+#define CONFIG_ENERGY_CPU_STATS 0
+#endif
+#ifndef CONFIG_SLEEP_WAKE_LOG
+#define CONFIG_SLEEP_WAKE_LOG 0
+#endif
+#ifndef CONFIG_PULSE_SAVE_INTERVAL_S
+#define CONFIG_PULSE_SAVE_INTERVAL_S 60
+#endif
+#ifndef CONFIG_PULSE_SAVE_QUIET_S
+#define CONFIG_PULSE_SAVE_QUIET_S 5
+#endif
+#ifndef CONFIG_ZIGBEE_TASK_STACK_SIZE
+#define CONFIG_ZIGBEE_TASK_STACK_SIZE 6144
+#endif
+#ifndef CONFIG_ZB_SED_TABLE_SIZES
+#define CONFIG_ZB_SED_TABLE_SIZES 0
+#endif
+#if CONFIG_PM_ENABLE && !defined(CONFIG_PM_MIN_FREQ_MHZ)
+#define CONFIG_PM_MIN_FREQ_MHZ CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#endif
+
+#define APP_ENERGY_DIAG_INTERVAL_US (60LL * 1000000LL)
 
 #if CONFIG_FACTORY_RESET_BUTTON_GPIO >= 0 && CONFIG_FACTORY_RESET_BUTTON_GPIO == CONFIG_PULSE_GPIO
 #error "CONFIG_FACTORY_RESET_BUTTON_GPIO must differ from CONFIG_PULSE_GPIO"
@@ -82,9 +124,20 @@
 #define APP_ZB_TX_POWER_DBM CONFIG_ZB_TX_POWER_DBM
 #define APP_ZB_TX_POWER_JOIN_DBM IEEE802154_TXPOWER_VALUE_MAX
 
-#define APP_EVENT_QUEUE_LEN 32
-#define APP_SAVE_INTERVAL_US (60ULL * 1000000ULL)
-#define APP_SAVE_DEBOUNCE_US (5ULL * 1000000ULL)
+/* Battery events arrive hourly and are drained every loop pass. */
+#define APP_EVENT_QUEUE_LEN 4
+#define APP_SAVE_INTERVAL_US ((int64_t)CONFIG_PULSE_SAVE_INTERVAL_S * 1000000LL)
+#define APP_SAVE_QUIET_US ((int64_t)CONFIG_PULSE_SAVE_QUIET_S * 1000000LL)
+#define APP_TIME_SYNC_INTERVAL_US ((int64_t)CONFIG_TIME_SYNC_INTERVAL_H * 3600LL * 1000000LL)
+#define APP_TIME_SYNC_RETRY_US (300LL * 1000000LL)
+/* Drop a probe/backlog send that never got a send status so the queue cannot stall. */
+#define APP_REPORT_QUEUE_SEND_TIMEOUT_US (10LL * 1000000LL)
+#define APP_PROFILE_SAVE_INTERVAL_US ((int64_t)CONFIG_METERING_PROFILE_SAVE_H * 3600LL * 1000000LL)
+/* Simple Metering Get Profile (client -> server 0x00) and its response (server -> client 0x00). */
+#define APP_METERING_CMD_GET_PROFILE 0x00
+#define APP_METERING_CMD_GET_PROFILE_RSP 0x00
+/* 7-byte header + 3 bytes per interval keeps the response in one unfragmented frame. */
+#define APP_PROFILE_MAX_PERIODS_PER_FRAME 24
 /* On battery it is fine to sample less often to reduce wakeups. */
 #define APP_BATTERY_TASK_PERIOD_BATT_MS (60 * 60 * 1000)
 #define APP_ZB_SLEEP_THRESHOLD_MS 20
@@ -93,13 +146,16 @@
 #define APP_STEER_MAX_RETRIES CONFIG_ZB_STEER_MAX_RETRIES
 #define APP_STEER_COOLDOWN_S CONFIG_ZB_STEER_COOLDOWN_S
 #define APP_DEMAND_IDLE_TIMEOUT_US (60ULL * 1000000ULL)
-#define APP_DEMAND_IDLE_CHECK_US (1ULL * 1000000ULL)
+#define APP_DEMAND_IDLE_CHECK_US (1LL * 1000000LL)
 #define APP_FACTORY_RESET_HOLD_MS 8000
 #define APP_FACTORY_RESET_POLL_MS 50
 #define APP_FACTORY_RESET_HOLD_US (APP_FACTORY_RESET_HOLD_MS * 1000ULL)
 #define APP_FACTORY_RESET_POLL_US (APP_FACTORY_RESET_POLL_MS * 1000ULL)
 #define APP_OTA_ELEMENT_HEADER_LEN 6
 #define APP_SLEEP_JOIN_BLOCK_US (30LL * 1000000LL)
+#define APP_SOC_SAVE_INTERVAL_US (6LL * 3600LL * 1000000LL)
+#define APP_DEEP_SLEEP_RELEASE_WAIT_US (2LL * 1000000LL)
+#define APP_DEEP_SLEEP_OTA_IDLE_US (30LL * 1000000LL)
 
 static const char *TAG = "zigbee_meter";
 
@@ -112,30 +168,125 @@ typedef struct {
     power_status_t power;
 } app_event_t;
 
+/* The application allocates nothing at run time: queue, task and bind contexts are static. */
 static QueueHandle_t s_app_event_queue;
+static StaticQueue_t s_app_event_queue_buf;
+static uint8_t s_app_event_queue_storage[APP_EVENT_QUEUE_LEN * sizeof(app_event_t)];
 static TaskHandle_t s_zigbee_task_handle;
-static app_metering_cfg_t s_cfg;
+static StaticTask_t s_zigbee_task_tcb;
+static StackType_t s_zigbee_task_stack[CONFIG_ZIGBEE_TASK_STACK_SIZE];
+
+/* One pulse input: its counter, meter, Simple Metering endpoint and the ZCL attribute storage
+ * behind that endpoint (must stay valid for the lifetime of the stack).
+ */
+typedef struct {
+    uint8_t index;
+    uint8_t endpoint;
+    app_metering_cfg_t cfg;
+    pulse_counter_t counter;    /* total and pulse timestamps, shared by pulse and meter */
+    pulse_t pulse;
+    metering_t meter;
+    save_sched_t save;
+#if CONFIG_LEAK_DETECT
+    uint8_t leak_alarms;
+#endif
+    esp_zb_uint48_t attr_summation;
+    uint8_t attr_unit;
+    uint8_t attr_summation_formatting;
+    uint8_t attr_demand_formatting;
+    uint8_t attr_device_type;
+    esp_zb_uint24_t attr_multiplier;
+    esp_zb_uint24_t attr_divisor;
+    esp_zb_int24_t attr_demand;
+#if CONFIG_METERING_HISTORY
+    esp_zb_uint24_t attr_day_current;
+    esp_zb_uint24_t attr_day_previous;
+    esp_zb_uint24_t attr_week_current;
+    esp_zb_uint24_t attr_week_previous;
+#endif
+    /* What the stack holds for the attributes above; pushed by app_attr_flush(). */
+    attr_shadow_t sh_summation;
+    attr_shadow_t sh_demand;
+    attr_shadow_t sh_unit;
+    attr_shadow_t sh_summation_formatting;
+    attr_shadow_t sh_demand_formatting;
+    attr_shadow_t sh_device_type;
+    attr_shadow_t sh_multiplier;
+    attr_shadow_t sh_divisor;
+#if CONFIG_METERING_HISTORY
+    attr_shadow_t sh_day_current;
+    attr_shadow_t sh_day_previous;
+    attr_shadow_t sh_week_current;
+    attr_shadow_t sh_week_previous;
+#endif
+} app_channel_t;
+
+static app_channel_t s_channels[CONFIG_PULSE_CHANNELS];
+
 static uint8_t s_last_battery_percent;
-static uint8_t s_last_battery_voltage;
-static int64_t s_last_save_us;
+static attr_shadow_t s_sh_power_source;
+#if CONFIG_BATTERY_ADC_ENABLE
+static attr_shadow_t s_sh_battery_voltage;
+static attr_shadow_t s_sh_battery_percent;
+#endif
+#if CONFIG_METERING_HISTORY
+static int64_t s_last_profile_save_us;
+static metering_profile_blob_t s_profile_blob;
+static int64_t s_next_time_sync_us;
+#endif
+typedef enum {
+    APP_RQ_IDLE = 0,
+    APP_RQ_PROBE,
+    APP_RQ_FLUSH,
+} app_rq_send_t;
+static app_rq_send_t s_rq_send;
+static uint8_t s_rq_tsn;
+static size_t s_rq_flush_n;
+/* TSNs of sends that are not metering reports, cleared by their send status. */
+static uint32_t s_other_tsn[256 / 32];
+static int64_t s_rq_send_us;
+static bool s_rq_link_changed;
 static esp_timer_handle_t s_steer_retry_timer;
 static volatile bool s_request_steer;
 static uint8_t s_steer_retry_count;
 static bool s_steer_started;
 static bool s_joined;
 static int64_t s_last_demand_check_us;
-static bool s_total_dirty;
 static volatile bool s_factory_reset_requested;
 static uint32_t s_steer_total_attempts;
 static int64_t s_no_sleep_until_us;
 static button_handle_t s_reset_button;
+#if CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+static int64_t s_last_soc_save_us;
+#endif
+static int64_t s_last_energy_diag_us;
+#if CONFIG_ENERGY_CPU_STATS
+static configRUN_TIME_COUNTER_TYPE s_last_idle_counter;
+#endif
+/* Survives software resets; validated by magic and checksum on boot. */
+static RTC_NOINIT_ATTR sleep_stats_t s_sleep_stats_rtc;
+#if CONFIG_DEEP_SLEEP_MODE
+/* Pulse totals and report state across deep sleep; trusted only after a deep-sleep reset. */
+static RTC_NOINIT_ATTR deep_sleep_rtc_t s_deep_sleep_rtc;
+static bool s_deep_resumed;
+static int64_t s_deep_joined_us;
+#endif
+#if CONFIG_PULSE_SOURCE_OPTICAL
+static uint64_t s_optical_booked_us;    /* optical sampling time already in the energy ledger */
+#endif
 #if CONFIG_SLEEPY_END_DEVICE
+#if CONFIG_SLEEP_WAKE_LOG
 static int64_t s_last_can_sleep_skip_log_us;
 static void app_log_wakeup_info(int64_t slept_ms);
 #endif
+#if CONFIG_PULSE_PULL_STROBED
+static uint64_t s_ext1_mask;            /* every EXT1 wake pin */
+static uint64_t s_ext1_armed;           /* the pins armed for the next sleep */
+#endif
+#endif
 
-static void app_zigbee_update_metering_attrs_static(void);
-static void app_zigbee_update_metering_attrs_dynamic(void);
+static void app_zigbee_update_metering_attrs_static(app_channel_t *ch);
+static void app_zigbee_update_metering_attrs_dynamic(app_channel_t *ch);
 static void app_log_power_status(const power_status_t *status, const char *context);
 static void app_factory_reset_press_cb(void *btn, void *data);
 static void app_factory_reset_hold_cb(void *btn, void *data);
@@ -149,14 +300,6 @@ static uint8_t s_zb_sw_build_id[17];
 /* ZCL attribute storage must stay valid for the lifetime of the stack. */
 static uint8_t s_attr_battery_voltage;
 static uint8_t s_attr_battery_percent;
-static esp_zb_uint48_t s_attr_summation;
-static uint8_t s_attr_unit;
-static uint8_t s_attr_summation_formatting;
-static uint8_t s_attr_demand_formatting;
-static uint8_t s_attr_device_type;
-static esp_zb_uint24_t s_attr_multiplier;
-static esp_zb_uint24_t s_attr_divisor;
-static esp_zb_int24_t s_attr_demand;
 static uint16_t s_attr_ota_stack_version;
 static uint16_t s_attr_ota_downloaded_stack_version;
 static uint32_t s_attr_ota_image_stamp;
@@ -173,11 +316,14 @@ static bool s_ota_tag_received;
 static bool s_ota_has_element_header;
 static bool s_ota_header_checked;
 static int64_t s_ota_start_time_us;
+#if CONFIG_DEEP_SLEEP_MODE
+static int64_t s_ota_last_block_us;
+#endif
 
 static void app_update_sw_build_id(void)
 {
     int len = snprintf((char *)&s_zb_sw_build_id[1], 16, "PU=%" PRIu32 " DB=%u",
-                       s_cfg.pulse_per_unit_numerator, s_cfg.debounce_ms);
+                       s_channels[0].cfg.pulse_per_unit_numerator, s_channels[0].cfg.debounce_ms);
     if (len < 0) {
         len = 0;
     } else if (len > 15) {
@@ -220,6 +366,70 @@ static esp_zb_int24_t app_to_int24(int32_t value)
     return out;
 }
 
+static void app_attr_shadow_write(const attr_shadow_t *attr, void *value)
+{
+    esp_zb_zcl_set_attribute_val(attr->endpoint, attr->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 attr->attr_id, value, false);
+#if CONFIG_LATENCY_PROBES
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        if (attr == &s_channels[i].sh_summation) {
+            latency_attr(&s_channels[i].pulse.latency, esp_timer_get_time());
+        }
+    }
+#endif
+}
+
+/* The only place application attribute values reach the stack. */
+static void app_attr_flush(void)
+{
+    if (attr_shadow_pending()) {
+        (void)attr_shadow_flush(app_attr_shadow_write);
+    }
+}
+
+static void app_attr_shadow_register_channel(app_channel_t *ch)
+{
+    const uint16_t cl = ESP_ZB_ZCL_CLUSTER_ID_METERING;
+    attr_shadow_register(&ch->sh_summation, ch->endpoint, cl, ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID,
+                         sizeof(esp_zb_uint48_t));
+    attr_shadow_register(&ch->sh_demand, ch->endpoint, cl, ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID,
+                         sizeof(esp_zb_int24_t));
+    attr_shadow_register(&ch->sh_unit, ch->endpoint, cl, ESP_ZB_ZCL_ATTR_METERING_UNIT_OF_MEASURE_ID,
+                         sizeof(uint8_t));
+    attr_shadow_register(&ch->sh_summation_formatting, ch->endpoint, cl,
+                         ESP_ZB_ZCL_ATTR_METERING_SUMMATION_FORMATTING_ID, sizeof(uint8_t));
+    attr_shadow_register(&ch->sh_demand_formatting, ch->endpoint, cl, ESP_ZB_ZCL_ATTR_METERING_DEMAND_FORMATTING_ID,
+                         sizeof(uint8_t));
+    attr_shadow_register(&ch->sh_device_type, ch->endpoint, cl, ESP_ZB_ZCL_ATTR_METERING_METERING_DEVICE_TYPE_ID,
+                         sizeof(uint8_t));
+    attr_shadow_register(&ch->sh_multiplier, ch->endpoint, cl, ESP_ZB_ZCL_ATTR_METERING_MULTIPLIER_ID,
+                         sizeof(esp_zb_uint24_t));
+    attr_shadow_register(&ch->sh_divisor, ch->endpoint, cl, ESP_ZB_ZCL_ATTR_METERING_DIVISOR_ID,
+                         sizeof(esp_zb_uint24_t));
+#if CONFIG_METERING_HISTORY
+    attr_shadow_register(&ch->sh_day_current, ch->endpoint, cl, APP_METERING_ATTR_CURRENT_DAY_DELIVERED,
+                         sizeof(esp_zb_uint24_t));
+    attr_shadow_register(&ch->sh_day_previous, ch->endpoint, cl, APP_METERING_ATTR_PREVIOUS_DAY_DELIVERED,
+                         sizeof(esp_zb_uint24_t));
+    attr_shadow_register(&ch->sh_week_current, ch->endpoint, cl, APP_METERING_ATTR_CURRENT_WEEK_DELIVERED,
+                         sizeof(esp_zb_uint24_t));
+    attr_shadow_register(&ch->sh_week_previous, ch->endpoint, cl, APP_METERING_ATTR_PREVIOUS_WEEK_DELIVERED,
+                         sizeof(esp_zb_uint24_t));
+#endif
+}
+
+static void app_attr_shadow_register_device(void)
+{
+    attr_shadow_register(&s_sh_power_source, APP_ZB_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BASIC,
+                         ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID, sizeof(uint8_t));
+#if CONFIG_BATTERY_ADC_ENABLE
+    attr_shadow_register(&s_sh_battery_voltage, APP_ZB_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
+                         ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID, sizeof(uint8_t));
+    attr_shadow_register(&s_sh_battery_percent, APP_ZB_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
+                         ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID, sizeof(uint8_t));
+#endif
+}
+
 #if CONFIG_BATTERY_ADC_ENABLE
 static void app_event_send(const app_event_t *evt)
 {
@@ -293,10 +503,14 @@ static esp_err_t app_ota_upgrade_status_handler(esp_zb_zcl_ota_upgrade_value_mes
 
     esp_err_t ret = ESP_OK;
 
+    if (message.upgrade_status != ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE) {
+        evtrace_record(EVT_OTA, (uint8_t)message.upgrade_status, (uint16_t)(s_ota_offset >> 10));
+    }
+
     switch (message.upgrade_status) {
     case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
-        ESP_LOGI(TAG, "-- OTA upgrade start (ver 0x%08lx, type 0x%x, mfg 0x%x)",
-                 message.ota_header.file_version, message.ota_header.image_type, message.ota_header.manufacturer_code);
+        APP_LOGI(OTA_START, (unsigned long)message.ota_header.file_version, message.ota_header.image_type,
+                 message.ota_header.manufacturer_code);
         s_ota_partition = esp_ota_get_next_update_partition(NULL);
         if (!s_ota_partition) {
             ESP_LOGE(TAG, "No OTA partition");
@@ -330,18 +544,21 @@ static esp_err_t app_ota_upgrade_status_handler(esp_zb_zcl_ota_upgrade_value_mes
                 return ret;
             }
             s_ota_offset += len;
+#if CONFIG_DEEP_SLEEP_MODE
+            s_ota_last_block_us = esp_timer_get_time();
+#endif
             uint32_t target = s_ota_expected_size ? s_ota_expected_size : s_ota_total_size;
             if (target > 0) {
-                ESP_LOGI(TAG, "-- OTA recv progress [%u/%u]", s_ota_offset, target);
+                APP_LOGI(OTA_PROGRESS, s_ota_offset, target);
             } else {
-                ESP_LOGI(TAG, "-- OTA recv progress [%u/unknown]", s_ota_offset);
+                APP_LOGI(OTA_PROGRESS_UNKNOWN, s_ota_offset);
             }
         }
         break;
 
     case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
         ret = (s_ota_offset == (s_ota_expected_size ? s_ota_expected_size : s_ota_total_size)) ? ESP_OK : ESP_FAIL;
-        ESP_LOGI(TAG, "-- OTA check status: %s", esp_err_to_name(ret));
+        APP_LOGI(OTA_CHECK, esp_err_to_name(ret));
         s_ota_offset = 0;
         s_ota_total_size = 0;
         s_ota_expected_size = 0;
@@ -351,12 +568,12 @@ static esp_err_t app_ota_upgrade_status_handler(esp_zb_zcl_ota_upgrade_value_mes
         break;
 
     case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
-        ESP_LOGI(TAG, "-- OTA apply");
+        APP_LOGI(OTA_APPLY);
         break;
 
     case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
-        ESP_LOGI(TAG, "-- OTA finish: image 0x%08lx size %ld bytes, time %lld ms",
-                 message.ota_header.file_version, (long)message.ota_header.image_size,
+        APP_LOGI(OTA_FINISH,
+                 (unsigned long)message.ota_header.file_version, (long)message.ota_header.image_size,
                  (long long)((esp_timer_get_time() - s_ota_start_time_us) / 1000));
         ret = esp_ota_end(s_ota_handle);
         if (ret != ESP_OK) {
@@ -373,7 +590,7 @@ static esp_err_t app_ota_upgrade_status_handler(esp_zb_zcl_ota_upgrade_value_mes
         break;
 
     default:
-        ESP_LOGI(TAG, "OTA status: %d", message.upgrade_status);
+        APP_LOGI(OTA_STATUS, message.upgrade_status);
         break;
     }
     return ret;
@@ -385,8 +602,8 @@ static esp_err_t app_ota_query_image_resp_handler(esp_zb_zcl_ota_upgrade_query_i
         ESP_LOGW(TAG, "OTA query resp status %u", message.info.status);
         return ESP_FAIL;
     }
-    ESP_LOGI(TAG, "OTA query resp: server 0x%04hx ep %u ver 0x%08lx mfg 0x%x type 0x%x size %ld",
-             message.server_addr.u.short_addr, message.server_endpoint, message.file_version,
+    APP_LOGI(OTA_QUERY_RESP,
+             message.server_addr.u.short_addr, message.server_endpoint, (unsigned long)message.file_version,
              message.manufacturer_code, message.image_type, (long)message.image_size);
     return ESP_OK;
 }
@@ -466,8 +683,7 @@ static void app_log_commissioning_state(const char *context)
     bool joined = esp_zb_bdb_dev_joined();
 
     esp_zb_get_tx_power(&tx_power);
-    ESP_LOGI(TAG,
-             "%s: factory_new=%d joined=%d mode 0x%02x status %s(%d) channel_mask 0x%08x primary 0x%08x secondary 0x%08x tx_power %d dBm",
+    APP_LOGI(COMMISSIONING_STATE,
              context, factory_new, joined, mode, app_bdb_status_to_str(status), status, channel_mask, primary_mask,
              secondary_mask,
              tx_power);
@@ -478,13 +694,14 @@ static void app_factory_reset_clear_app_state_full_nvs(const char *reason)
     ESP_LOGW(TAG, "Clearing application state via full NVS erase (%s)", reason ? reason : "n/a");
 
     /* Reset runtime counters so nothing persists before reboot. */
-    metering_reset();
-    metering_set_instantaneous_demand(0);
-    pulse_set_total(0);
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_channel_t *ch = &s_channels[i];
+        metering_reset(&ch->meter);
+        metering_set_instantaneous_demand(&ch->meter, 0);
 
-    /* Disable periodic save until reboot. */
-    s_total_dirty = false;
-    s_last_save_us = esp_timer_get_time();
+        /* Disable periodic save until reboot. */
+        save_sched_done(&ch->save, esp_timer_get_time());
+    }
 
     /* Wipe the entire NVS partition. */
     (void)nvs_flash_deinit(); /* best effort; ignore errors */
@@ -568,39 +785,142 @@ static void app_factory_reset_button_init(void)
     if (reg_err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register reset button callbacks: %s", esp_err_to_name(reg_err));
     } else {
-        ESP_LOGI(TAG, "Factory reset button enabled on GPIO%d, hold for %u ms to reset Zigbee stack",
+        APP_LOGI(RESET_BUTTON_ENABLED,
                  CONFIG_FACTORY_RESET_BUTTON_GPIO, (unsigned)APP_FACTORY_RESET_HOLD_MS);
     }
 #else
-    ESP_LOGI(TAG, "Factory reset button disabled (CONFIG_FACTORY_RESET_BUTTON_GPIO < 0)");
+    APP_LOGI(RESET_BUTTON_DISABLED);
+#endif
+}
+
+/* EXT1 bits of every pulse input; none when the LP core watches them or the input is optical. */
+static uint64_t app_pulse_gpio_mask(void)
+{
+    uint64_t mask = 0;
+#if CONFIG_PULSE_LP_CORE || CONFIG_PULSE_SOURCE_OPTICAL
+    return mask;
+#endif
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        mask |= 1ULL << s_channels[i].cfg.gpio_num;
+    }
+    return mask;
+}
+
+#if CONFIG_SLEEPY_END_DEVICE && (CONFIG_PULSE_PULL_STROBED || CONFIG_DEEP_SLEEP_MODE)
+/* Pulse inputs pulled down between strobes (PULSE_PULL_STROBED): closed contacts that read low
+ * until a strobe sees them open.
+ */
+static uint64_t app_pulse_strobing_mask(void)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        if (pulse_strobing(&s_channels[i].pulse)) {
+            mask |= 1ULL << s_channels[i].cfg.gpio_num;
+        }
+    }
+    return mask;
+}
 #endif
+
+/* The extra channels' pins come from Kconfig ints, not compile-time checks: reject clashes
+ * before any driver claims a pin.
+ */
+static void app_check_pulse_gpios(void)
+{
+    uint64_t seen = 0;
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        int gpio = s_channels[i].cfg.gpio_num;
+        bool clash = gpio < 0 || gpio >= GPIO_NUM_MAX || (seen & (1ULL << gpio));
+#if CONFIG_FACTORY_RESET_BUTTON_GPIO >= 0
+        clash = clash || gpio == CONFIG_FACTORY_RESET_BUTTON_GPIO;
+#endif
+        if (clash) {
+            ESP_LOGE(TAG, "Pulse channel %u: GPIO%d is invalid or already in use", (unsigned)i, gpio);
+            ESP_ERROR_CHECK(ESP_ERR_INVALID_ARG);
+        }
+#if !CONFIG_PULSE_SOURCE_OPTICAL
+        if (!esp_sleep_is_valid_wakeup_gpio((gpio_num_t)gpio)) {
+            ESP_LOGW(TAG, "Pulse channel %u: GPIO%d cannot wake from sleep", (unsigned)i, gpio);
+        }
+#endif
+        seen |= 1ULL << gpio;
+    }
+}
+
+#if CONFIG_PULSE_SOURCE_OPTICAL
+/* Channel 0 reads an optical sensor on its GPIO, which has to be an ADC pin. */
+static void app_optical_start(void)
+{
+    app_channel_t *ch = &s_channels[0];
+    adc_unit_t unit;
+    adc_channel_t chan;
+    esp_err_t err = adc_oneshot_io_to_channel(ch->cfg.gpio_num, &unit, &chan);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Optical input: GPIO%d is not an ADC pin", ch->cfg.gpio_num);
+        ESP_ERROR_CHECK(err);
+    }
+    int unit_num = (unit == ADC_UNIT_2) ? 2 : 1;
+    pulse_optical_cfg_t cfg = {
+        .channel = chan,
+        .atten = (adc_atten_t)CONFIG_OPTICAL_ADC_ATTEN,
+        .emitter_gpio = CONFIG_OPTICAL_EMITTER_GPIO,
+        .emitter_settle_us = CONFIG_OPTICAL_EMITTER_SETTLE_US,
+        .sample_hz = CONFIG_OPTICAL_SAMPLE_HZ,
+        .detect = {
+            .min_span = CONFIG_OPTICAL_MIN_SPAN,
+            .hyst_pct = CONFIG_OPTICAL_HYSTERESIS_PCT,
+            .track_shift = optical_pulse_track_shift(CONFIG_OPTICAL_TRACK_S, CONFIG_OPTICAL_SAMPLE_HZ),
+            .active_low = CONFIG_OPTICAL_ACTIVE_LOW,
+        },
+    };
+    ESP_ERROR_CHECK(adc_sampler_oneshot_unit(unit_num, &cfg.adc));
+    ESP_ERROR_CHECK(pulse_optical_start(&ch->pulse, &cfg));
+    APP_LOGI(OPTICAL_STARTED, ch->cfg.gpio_num, unit_num, (int)chan, (unsigned)CONFIG_OPTICAL_SAMPLE_HZ,
+             CONFIG_OPTICAL_EMITTER_GPIO);
 }
+#endif
 
 static void app_configure_light_sleep_wakeup_sources(void)
 {
     esp_err_t err;
 
-    uint64_t ext1_mask = 0;
-
-    /* EXT1 only (RTC GPIOs). Non-RTC pins are rejected at compile-time. */
-    ext1_mask |= (1ULL << CONFIG_PULSE_GPIO);
+    /* EXT1 only (RTC GPIOs), one mask for all inputs so any of them wakes the whole device. */
+    uint64_t ext1_mask = app_pulse_gpio_mask();
 
 #if CONFIG_FACTORY_RESET_BUTTON_GPIO >= 0
-    /* If the reset button is on its own pin, wake on low there too. */
-    if (CONFIG_FACTORY_RESET_BUTTON_GPIO != CONFIG_PULSE_GPIO) {
-        ext1_mask |= (1ULL << CONFIG_FACTORY_RESET_BUTTON_GPIO);
-    }
+    /* The reset button has its own pin (checked at boot); wake on low there too. */
+    ext1_mask |= (1ULL << CONFIG_FACTORY_RESET_BUTTON_GPIO);
 #endif
 
+    /* Keep the wake pins' pull-ups and input enabled while the other pads are switched to
+     * their sleep configuration (PM_SLP_DISABLE_GPIO in the low-power profile).
+     */
+    for (int gpio = 0; gpio < GPIO_NUM_MAX; gpio++) {
+        if (ext1_mask & (1ULL << gpio)) {
+            (void)gpio_sleep_sel_dis((gpio_num_t)gpio);
+        }
+    }
+
     if (ext1_mask) {
         err = esp_sleep_enable_ext1_wakeup(ext1_mask, ESP_EXT1_WAKEUP_ANY_LOW);
         if (err != ESP_OK) {
             ESP_LOGW(TAG, "esp_sleep_enable_ext1_wakeup(mask=0x%" PRIx64 ") failed: %s",
                      (uint64_t)ext1_mask, esp_err_to_name(err));
         } else {
-            ESP_LOGI(TAG, "EXT1 wake enabled mask=0x%" PRIx64, (uint64_t)ext1_mask);
+            APP_LOGI(EXT1_WAKE_ENABLED, (uint64_t)ext1_mask);
         }
     }
+#if CONFIG_PULSE_PULL_STROBED && CONFIG_SLEEPY_END_DEVICE
+    s_ext1_mask = ext1_mask;
+    s_ext1_armed = ext1_mask;
+#endif
+#if CONFIG_PULSE_LP_CORE
+    /* The LP core wakes us for its pulses, in light and deep sleep alike. */
+    err = esp_sleep_enable_ulp_wakeup();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "esp_sleep_enable_ulp_wakeup failed: %s", esp_err_to_name(err));
+    }
+#endif
 }
 
 static inline bool app_gpio_active_low(gpio_num_t gpio)
@@ -608,6 +928,26 @@ static inline bool app_gpio_active_low(gpio_num_t gpio)
     return gpio_get_level(gpio) == 0;
 }
 
+#if CONFIG_PULSE_PULL_STROBED && CONFIG_SLEEPY_END_DEVICE
+/* A strobed input would hold EXT1 (any low) asserted; leave it out until it opens. Its strobe
+ * timer wakes us meanwhile.
+ */
+static void app_update_ext1_wakeup(void)
+{
+    uint64_t mask = s_ext1_mask & ~app_pulse_strobing_mask();
+    if (mask == s_ext1_armed) {
+        return;
+    }
+    esp_err_t err = mask ? esp_sleep_enable_ext1_wakeup(mask, ESP_EXT1_WAKEUP_ANY_LOW)
+                         : esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_EXT1);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "EXT1 re-arm (mask=0x%" PRIx64 ") failed: %s", (uint64_t)mask, esp_err_to_name(err));
+        return;
+    }
+    s_ext1_armed = mask;
+}
+#endif
+
 /* GPIO wakeup is level-triggered; skip light sleep if any wake pin is already held low
  * to avoid immediate wake loops.
  */
@@ -615,14 +955,31 @@ static inline bool app_gpio_active_low(gpio_num_t gpio)
 static bool app_any_wakeup_pin_asserted(const char **out_reason)
 {
     const char *reason = NULL;
-    if (app_gpio_active_low((gpio_num_t)CONFIG_PULSE_GPIO)) {
-        reason = "pulse_gpio";
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS && !reason; i++) {
+#if CONFIG_PULSE_LP_CORE
+        /* A closed contact is the LP core's business; only a missed wake keeps us up. */
+        if (pulse_lp_due(i)) {
+            reason = "pulse_pending";
+        }
+#elif CONFIG_PULSE_SOURCE_OPTICAL
+        /* An analog input: its level means nothing to EXT1, the sample timer wakes us. */
+#else
+        /* A strobed contact is closed but waits on its strobe timer, not on EXT1. */
+        if (!pulse_strobing(&s_channels[i].pulse) &&
+            app_gpio_active_low((gpio_num_t)s_channels[i].cfg.gpio_num)) {
+            reason = "pulse_gpio";
+        }
+#endif
+        if (!reason && pulse_pending(&s_channels[i].pulse)) {
+            /* Counted after this pass picked up the pulses; report it before sleeping. */
+            reason = "pulse_pending";
+        }
+    }
 #if CONFIG_FACTORY_RESET_BUTTON_GPIO >= 0
-    } else if (CONFIG_FACTORY_RESET_BUTTON_GPIO != CONFIG_PULSE_GPIO &&
-               app_gpio_active_low((gpio_num_t)CONFIG_FACTORY_RESET_BUTTON_GPIO)) {
+    if (!reason && app_gpio_active_low((gpio_num_t)CONFIG_FACTORY_RESET_BUTTON_GPIO)) {
         reason = "factory_reset_gpio";
-#endif
     }
+#endif
 
     if (out_reason) {
         *out_reason = reason;
@@ -633,6 +990,7 @@ static bool app_any_wakeup_pin_asserted(const char **out_reason)
 
 static void app_steer_retry_timer_cb(void *arg)
 {
+    (void)arg;
     s_request_steer = true;
 }
 
@@ -701,7 +1059,7 @@ static void app_zigbee_set_tx_power(int8_t target_dbm, const char *context)
     esp_zb_get_tx_power(&before);
     esp_zb_set_tx_power(clamped);
     esp_zb_get_tx_power(&after);
-    ESP_LOGI(TAG, "TX power set to %d dBm (before %d dBm after %d dBm, %s)",
+    APP_LOGI(TX_POWER_SET,
              clamped, before, after, context);
 }
 
@@ -721,21 +1079,32 @@ static void app_start_network_steering(const char *context)
     s_steer_started = true;
     s_joined = false;
     app_log_commissioning_state(context);
-    ESP_LOGI(TAG, "Starting network steering (channel mask 0x%08x, tx_power %d dBm)",
+    APP_LOGI(STEERING_START,
              CONFIG_ZB_CHANNEL_MASK, APP_ZB_TX_POWER_DBM);
     app_zigbee_set_tx_power(APP_ZB_TX_POWER_JOIN_DBM, "steering");
     s_steer_total_attempts++;
+    evtrace_record(EVT_STEER, s_steer_total_attempts > UINT8_MAX ? UINT8_MAX : (uint8_t)s_steer_total_attempts, 0);
     if (APP_STEER_MAX_RETRIES > 0) {
-        ESP_LOGI(TAG, "Steering attempt %u/%u (%s)",
+        APP_LOGI(STEERING_ATTEMPT,
                  (unsigned)s_steer_total_attempts, (unsigned)APP_STEER_MAX_RETRIES,
                  context ? context : "n/a");
     } else {
-        ESP_LOGI(TAG, "Steering attempt %u (unlimited) (%s)",
+        APP_LOGI(STEERING_ATTEMPT_UNLIMITED,
                  (unsigned)s_steer_total_attempts, context ? context : "n/a");
     }
     esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
 }
 
+/* Stored little-endian; printed most significant byte first like the coordinator shows it. */
+static unsigned long long app_ieee_to_u64(const esp_zb_ieee_addr_t addr)
+{
+    unsigned long long v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | addr[i];
+    }
+    return v;
+}
+
 static void app_log_network_info(const char *context)
 {
     uint16_t short_addr = esp_zb_get_short_address();
@@ -746,35 +1115,45 @@ static void app_log_network_info(const char *context)
     esp_zb_get_long_address(ieee);
     esp_zb_get_extended_pan_id(extpan);
 
-    ESP_LOGI(TAG,
-             "%s: short=0x%04x pan=0x%04x ch=%u "
-             "ieee=%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x "
-             "extpan=%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x",
-             context, short_addr, pan_id, channel,
-             ieee[7], ieee[6], ieee[5], ieee[4], ieee[3], ieee[2], ieee[1], ieee[0],
-             extpan[7], extpan[6], extpan[5], extpan[4], extpan[3], extpan[2], extpan[1], extpan[0]);
+    APP_LOGI(NETWORK_INFO, context, short_addr, pan_id, channel,
+             app_ieee_to_u64(ieee), app_ieee_to_u64(extpan));
 }
 
-static void app_handle_pending_pulses(void)
+static void app_handle_channel_pulses(app_channel_t *ch)
 {
     pulse_pending_info_t pending = {0};
-    if (!pulse_take_pending(&pending)) {
+    if (!pulse_take_pending(&ch->pulse, &pending)) {
         return;
     }
+    LATENCY_PROBE_PICKUP(&ch->pulse.latency, pending.last_ts_us, esp_timer_get_time());
+    evtrace_record(EVT_PULSES, (uint8_t)((ch->index << 5) | (pending.lost > 31 ? 31 : pending.lost)),
+                   pending.count > UINT16_MAX ? UINT16_MAX : (uint16_t)pending.count);
 
     if (pending.lost > 0) {
-        ESP_LOGW(TAG, "Dropped %u pulses while pending queue was full", (unsigned)pending.lost);
+        ESP_LOGW(TAG, "Channel %u dropped %u pulses while pending queue was full",
+                 (unsigned)ch->index, (unsigned)pending.lost);
     }
 
     if (pending.count == 0) {
         return;
     }
 
-    metering_on_pulses(pending.count, pending.last_ts_us, pending.prev_ts_us);
-    uint64_t total = pulse_get_total();
-    ESP_LOGI(TAG, "Pulse counted: +%u total=%llu", (unsigned)pending.count, (unsigned long long)total);
-    app_zigbee_update_metering_attrs_dynamic();
-    s_total_dirty = true;
+    metering_on_pulses(&ch->meter, pending.count, pending.last_ts_us, pending.prev_ts_us);
+    uint64_t total = metering_get_total_pulses(&ch->meter);
+    APP_LOGI(PULSE_COUNTED, (unsigned)ch->index, (unsigned)pending.count, (unsigned long long)total);
+    app_zigbee_update_metering_attrs_dynamic(ch);
+    save_sched_mark(&ch->save);
+}
+
+/* One notification covers every input: drain them all in the same loop pass. */
+static void app_handle_pending_pulses(void)
+{
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+#if CONFIG_PULSE_LP_CORE
+        pulse_lp_poll(i, &s_channels[i].pulse);
+#endif
+        app_handle_channel_pulses(&s_channels[i]);
+    }
 }
 
 #if CONFIG_BATTERY_ADC_ENABLE
@@ -792,81 +1171,138 @@ static void app_power_status_cb(const power_status_t *status, void *ctx)
 }
 #endif
 
-static void app_zigbee_update_metering_attrs_static(void)
+static void app_zigbee_update_metering_attrs_static(app_channel_t *ch)
 {
     /* These rarely/never change; set once on join/start to reduce ZCL work per pulse. */
-    uint8_t unit = metering_get_unit_of_measure();
-    uint8_t device_type = metering_get_device_type();
-    uint8_t formatting = metering_get_summation_formatting();
-    uint8_t demand_formatting = metering_get_demand_formatting();
-    uint32_t multiplier = metering_get_multiplier();
-    uint32_t divisor = metering_get_divisor();
-    s_attr_unit = unit;
-    s_attr_summation_formatting = formatting;
-    s_attr_demand_formatting = demand_formatting;
-    s_attr_device_type = device_type;
-    s_attr_multiplier = app_to_uint24(multiplier);
-    s_attr_divisor = app_to_uint24(divisor);
-    ESP_LOGI(TAG, "Metering scale: unit=%u device_type=%u mult=%u div=%u fmt=0x%02x demand_fmt=0x%02x",
+    uint8_t unit = metering_get_unit_of_measure(&ch->meter);
+    uint8_t device_type = metering_get_device_type(&ch->meter);
+    uint8_t formatting = metering_get_summation_formatting(&ch->meter);
+    uint8_t demand_formatting = metering_get_demand_formatting(&ch->meter);
+    uint32_t multiplier = metering_get_multiplier(&ch->meter);
+    uint32_t divisor = metering_get_divisor(&ch->meter);
+    ch->attr_unit = unit;
+    ch->attr_summation_formatting = formatting;
+    ch->attr_demand_formatting = demand_formatting;
+    ch->attr_device_type = device_type;
+    ch->attr_multiplier = app_to_uint24(multiplier);
+    ch->attr_divisor = app_to_uint24(divisor);
+    APP_LOGI(METERING_SCALE, (unsigned)ch->endpoint,
              (unsigned)unit, (unsigned)device_type, (unsigned)multiplier, (unsigned)divisor,
              (unsigned)formatting, (unsigned)demand_formatting);
 
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_METERING_UNIT_OF_MEASURE_ID,
-                                 &s_attr_unit, false);
-
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_METERING_SUMMATION_FORMATTING_ID,
-                                 &s_attr_summation_formatting, false);
-
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_METERING_DEMAND_FORMATTING_ID,
-                                 &s_attr_demand_formatting, false);
-
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_METERING_METERING_DEVICE_TYPE_ID,
-                                 &s_attr_device_type, false);
-
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_METERING_MULTIPLIER_ID,
-                                 &s_attr_multiplier, false);
-
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_METERING_DIVISOR_ID,
-                                 &s_attr_divisor, false);
-}
-
-static void app_zigbee_update_metering_attrs_dynamic(void)
-{
-    /* These change on pulses / demand decay. */
-    uint64_t summation = metering_get_summation();
-    int32_t demand = metering_get_instantaneous_demand();
-    esp_zb_uint48_t summation_val = app_to_uint48(summation);
-    esp_zb_int24_t demand_val = app_to_int24(demand);
-
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID,
-                                 &summation_val, false);
-
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID,
-                                 &demand_val, false);
+    attr_shadow_set(&ch->sh_unit, &ch->attr_unit);
+    attr_shadow_set(&ch->sh_summation_formatting, &ch->attr_summation_formatting);
+    attr_shadow_set(&ch->sh_demand_formatting, &ch->attr_demand_formatting);
+    attr_shadow_set(&ch->sh_device_type, &ch->attr_device_type);
+    attr_shadow_set(&ch->sh_multiplier, &ch->attr_multiplier);
+    attr_shadow_set(&ch->sh_divisor, &ch->attr_divisor);
+}
+
+#if CONFIG_METERING_HISTORY
+static void app_zigbee_set_calendar_attr(attr_shadow_t *shadow, esp_zb_uint24_t *attr, uint32_t value)
+{
+    *attr = app_to_uint24(value > 0xFFFFFF ? 0xFFFFFF : value);
+    attr_shadow_set(shadow, attr);
+}
+
+static void app_zigbee_update_calendar_attrs(app_channel_t *ch)
+{
+    if (!metering_calendar_valid(&ch->meter)) {
+        return;
+    }
+    app_zigbee_set_calendar_attr(&ch->sh_day_current, &ch->attr_day_current,
+                                 metering_get_current_day_consumption(&ch->meter));
+    app_zigbee_set_calendar_attr(&ch->sh_day_previous, &ch->attr_day_previous,
+                                 metering_get_previous_day_consumption(&ch->meter));
+    app_zigbee_set_calendar_attr(&ch->sh_week_current, &ch->attr_week_current,
+                                 metering_get_current_week_consumption(&ch->meter));
+    app_zigbee_set_calendar_attr(&ch->sh_week_previous, &ch->attr_week_previous,
+                                 metering_get_previous_week_consumption(&ch->meter));
+}
+#endif
+
+static void app_zigbee_update_metering_attrs_dynamic(app_channel_t *ch)
+{
+    /* These change on pulses / demand decay; unchanged values never reach the stack. */
+    esp_zb_uint48_t summation_val = app_to_uint48(metering_get_summation(&ch->meter));
+    esp_zb_int24_t demand_val = app_to_int24(metering_get_instantaneous_demand(&ch->meter));
+
+    attr_shadow_set(&ch->sh_summation, &summation_val);
+    attr_shadow_set(&ch->sh_demand, &demand_val);
+#if CONFIG_METERING_HISTORY
+    app_zigbee_update_calendar_attrs(ch);
+#endif
+}
+
+/* Close the energy ledger window, splitting awake time by the idle-task run-time counter. */
+static void app_energy_tick(int64_t now)
+{
+#if CONFIG_ENERGY_CPU_STATS
+    configRUN_TIME_COUNTER_TYPE idle = ulTaskGetIdleRunTimeCounter();
+    energy_note_cpu_idle((uint32_t)(idle - s_last_idle_counter));
+    s_last_idle_counter = idle;
+#endif
+#if CONFIG_PULSE_SOURCE_OPTICAL
+    /* Each optical sample keeps the ADC and the CPU awake. */
+    uint64_t optical_us = pulse_optical_stats()->awake_us;
+    energy_add(ENERGY_STATE_ADC, (uint32_t)(optical_us - s_optical_booked_us));
+    s_optical_booked_us = optical_us;
+#endif
+    /* A router-less ZED keeps its receiver on until joined; a non-sleepy one always does. */
+    energy_set_listening(!CONFIG_SLEEPY_END_DEVICE || !s_joined);
+    energy_tick(now);
+}
+
+static uint32_t app_us_to_ms(uint64_t us)
+{
+    uint64_t ms = us / 1000ULL;
+    return ms > UINT32_MAX ? UINT32_MAX : (uint32_t)ms;
+}
+
+static void app_update_energy_diag(int64_t now)
+{
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_SLEEP_S,
+                            (uint32_t)(energy_get_time_us(ENERGY_STATE_SLEEP) / 1000000ULL));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_AWAKE_IDLE_S,
+                            (uint32_t)(energy_get_time_us(ENERGY_STATE_AWAKE_IDLE) / 1000000ULL));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_CPU_BUSY_MS, app_us_to_ms(energy_get_time_us(ENERGY_STATE_CPU_BUSY)));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_RX_MS, app_us_to_ms(energy_get_time_us(ENERGY_STATE_RX)));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_TX_MS, app_us_to_ms(energy_get_time_us(ENERGY_STATE_TX)));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_ADC_MS, app_us_to_ms(energy_get_time_us(ENERGY_STATE_ADC)));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_FLASH_MS, app_us_to_ms(energy_get_time_us(ENERGY_STATE_FLASH)));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_WAKES, energy_get_count(ENERGY_COUNT_WAKES));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_TX_FRAMES, energy_get_count(ENERGY_COUNT_TX_FRAMES));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_ADC_BURSTS, energy_get_count(ENERGY_COUNT_ADC_BURSTS));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_FLASH_WRITES, energy_get_count(ENERGY_COUNT_FLASH_WRITES));
+    config_cluster_set_diag(APP_MFG_ATTR_DIAG_UAH_PER_DAY, energy_get_uah_per_day(now));
+}
+
+/* Book the ADC burst in the energy ledger and, with the coulomb-counting model, replace the
+ * linear voltage percentage by the state-of-charge estimate.
+ */
+static void app_apply_battery_model(power_status_t *status)
+{
+    if (!status) {
+        return;
+    }
+    if (status->adc_samples > 0) {
+        energy_add(ENERGY_STATE_ADC, status->adc_awake_us);
+        energy_count(ENERGY_COUNT_ADC_BURSTS);
+    }
+
+#if CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+    int64_t now = esp_timer_get_time();
+    app_energy_tick(now);
+    battery_soc_consume(energy_get_charge_nah(), (uint32_t)(now / 1000000LL));
+    battery_soc_on_voltage(status->battery_mv);
+    status->battery_percent_attr = battery_soc_percent_attr();
+    config_cluster_set_battery_days(battery_soc_days_remaining());
+
+    if (battery_soc_valid() && (now - s_last_soc_save_us) >= APP_SOC_SAVE_INTERVAL_US) {
+        app_soc_save(battery_soc_remaining_uah());
+        s_last_soc_save_us = now;
+    }
+#endif
 }
 
 static void app_zigbee_update_power_attrs(const power_status_t *status)
@@ -875,11 +1311,7 @@ static void app_zigbee_update_power_attrs(const power_status_t *status)
                                                      : ESP_ZB_ZCL_BASIC_POWER_SOURCE_DC_SOURCE;
 
     esp_zb_set_node_descriptor_power_source(!CONFIG_BATTERY_ADC_ENABLE);
-    esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                 ESP_ZB_ZCL_CLUSTER_ID_BASIC,
-                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                 ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID,
-                                 &power_source, false);
+    attr_shadow_set(&s_sh_power_source, &power_source);
 
 #if CONFIG_BATTERY_ADC_ENABLE
     if (!status) {
@@ -890,25 +1322,14 @@ static void app_zigbee_update_power_attrs(const power_status_t *status)
     uint8_t percent = status->battery_percent_attr;
 
     if (voltage != 0xFF) {
-        if (s_last_battery_voltage == 0xFF || voltage != s_last_battery_voltage) {
-            esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                         ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
-                                         ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                         ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID,
-                                         &voltage, false);
-            s_last_battery_voltage = voltage;
-        }
+        attr_shadow_set(&s_sh_battery_voltage, &voltage);
     }
 
     if (percent != 0xFF) {
         if (s_last_battery_percent == 0xFF ||
             (percent > s_last_battery_percent + (CONFIG_BATTERY_REPORT_HYST_PCT * 2)) ||
             (percent + (CONFIG_BATTERY_REPORT_HYST_PCT * 2) < s_last_battery_percent)) {
-            esp_zb_zcl_set_attribute_val(APP_ZB_ENDPOINT,
-                                         ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
-                                         ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                                         ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID,
-                                         &percent, false);
+            attr_shadow_set(&s_sh_battery_percent, &percent);
             s_last_battery_percent = percent;
         }
     }
@@ -923,20 +1344,107 @@ static void app_log_power_status(const power_status_t *status, const char *conte
         return;
     }
 
-    ESP_LOGI(TAG, "%s power: battery_mv=%u voltage_attr=0x%02x percent_attr=0x%02x",
+    APP_LOGI(POWER_STATUS,
              context ? context : "Power",
              (unsigned)status->battery_mv,
              (unsigned)status->battery_voltage_attr,
-             (unsigned)status->battery_percent_attr);
+             (unsigned)status->battery_percent_attr,
+             (unsigned)status->adc_samples,
+             status->adc_awake_us);
 }
 
 #if CONFIG_SLEEPY_END_DEVICE
+static sleep_wake_t app_classify_wakeup(void)
+{
+    switch (esp_sleep_get_wakeup_cause()) {
+    case ESP_SLEEP_WAKEUP_EXT1: {
+        uint64_t ext1_status = esp_sleep_get_ext1_wakeup_status();
+        if (ext1_status & app_pulse_gpio_mask()) {
+            return SLEEP_WAKE_PULSE;
+        }
+#if CONFIG_FACTORY_RESET_BUTTON_GPIO >= 0
+        if (ext1_status & (1ULL << CONFIG_FACTORY_RESET_BUTTON_GPIO)) {
+            return SLEEP_WAKE_BUTTON;
+        }
+#endif
+        return SLEEP_WAKE_OTHER;
+    }
+    case ESP_SLEEP_WAKEUP_ULP:
+        /* Only the LP pulse counter wakes us this way. */
+        return SLEEP_WAKE_PULSE;
+    case ESP_SLEEP_WAKEUP_TIMER:
+        return SLEEP_WAKE_TIMER;
+    case ESP_SLEEP_WAKEUP_WIFI:
+    case ESP_SLEEP_WAKEUP_BT:
+        return SLEEP_WAKE_RADIO;
+    default:
+        return SLEEP_WAKE_OTHER;
+    }
+}
+
+static void app_sleep_skip(sleep_skip_t reason, const char *detail, int64_t now_us)
+{
+    sleep_stats_skip(reason);
+    evtrace_record_coalesced(EVT_SLEEP_SKIP, (uint8_t)reason);
+#if CONFIG_SLEEP_WAKE_LOG
+    if (now_us - s_last_can_sleep_skip_log_us > 5000000LL) {
+        APP_LOGI(SLEEP_SKIPPED, (int)reason, detail ? detail : "none");
+        s_last_can_sleep_skip_log_us = now_us;
+    }
+#else
+    (void)detail;
+    (void)now_us;
+#endif
+}
+#endif
+
+/* Stack high-water marks (bytes never used) and heap levels. Logged when a low-water mark moves. */
+static void app_update_mem_diag(void)
+{
+    static uint32_t s_last_zb_free = UINT32_MAX;
+    static uint32_t s_last_power_free = UINT32_MAX;
+    static uint32_t s_last_heap_min = UINT32_MAX;
+    uint32_t zb_free = (uint32_t)uxTaskGetStackHighWaterMark(s_zigbee_task_handle);
+    uint32_t power_free = power_monitor_stack_free();
+    uint32_t heap_free = esp_get_free_heap_size();
+    uint32_t heap_min = esp_get_minimum_free_heap_size();
+
+    config_cluster_set_diag(APP_MFG_ATTR_MEM_ZB_STACK_FREE, zb_free);
+    config_cluster_set_diag(APP_MFG_ATTR_MEM_POWER_STACK_FREE, power_free);
+    config_cluster_set_diag(APP_MFG_ATTR_MEM_HEAP_FREE, heap_free);
+    config_cluster_set_diag(APP_MFG_ATTR_MEM_HEAP_MIN_FREE, heap_min);
+    if (zb_free != s_last_zb_free || power_free != s_last_power_free || heap_min != s_last_heap_min) {
+        APP_LOGI(MEM_LOW_WATER, (unsigned)zb_free, (unsigned)CONFIG_ZIGBEE_TASK_STACK_SIZE, (unsigned)power_free,
+                 (unsigned)heap_free, (unsigned)heap_min);
+        s_last_zb_free = zb_free;
+        s_last_power_free = power_free;
+        s_last_heap_min = heap_min;
+    }
+}
+
+static void app_update_sleep_diag(void)
+{
+    const sleep_stats_t *st = sleep_stats_get();
+    for (int i = 0; i < SLEEP_WAKE_COUNT; i++) {
+        config_cluster_set_diag(APP_MFG_ATTR_SLEEP_WAKE_BASE + i, st->wakes[i]);
+    }
+    for (int i = 0; i < SLEEP_SKIP_COUNT; i++) {
+        config_cluster_set_diag(APP_MFG_ATTR_SLEEP_SKIP_BASE + i, st->skips[i]);
+    }
+    for (int i = 0; i < SLEEP_STATS_BUCKETS; i++) {
+        config_cluster_set_diag(APP_MFG_ATTR_SLEEP_HIST_BASE + i, st->hist[i]);
+    }
+    config_cluster_set_diag(APP_MFG_ATTR_SLEEP_MAX_MS, st->max_sleep_ms);
+    sleep_stats_snapshot(&s_sleep_stats_rtc);
+}
+
+#if CONFIG_SLEEPY_END_DEVICE && CONFIG_SLEEP_WAKE_LOG
 static void app_log_wakeup_info(int64_t slept_ms)
 {
     esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
     esp_sleep_source_t bitmap = esp_sleep_get_wakeup_causes();
 
-    ESP_LOGI(TAG, "Wakeup: slept~%lld ms cause=%d bitmap=0x%" PRIx64,
+    APP_LOGI(WAKEUP,
              (long long)slept_ms, (int)cause, (uint64_t)bitmap);
 }
 #endif
@@ -958,6 +1466,34 @@ static void app_update_sleep_policy(void)
 }
 
 static void app_zigbee_configure_reporting(void);
+#if CONFIG_METERING_HISTORY
+static void app_handle_time_read_resp(const esp_zb_zcl_cmd_read_attr_resp_message_t *msg);
+#endif
+
+static app_channel_t *app_channel_by_endpoint(uint8_t endpoint)
+{
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        if (s_channels[i].endpoint == endpoint) {
+            return &s_channels[i];
+        }
+    }
+    return NULL;
+}
+
+#if CONFIG_METERING_HISTORY || CONFIG_LEAK_DETECT
+static void app_tsn_mark_other(uint8_t tsn)
+{
+    s_other_tsn[tsn / 32] |= 1u << (tsn % 32);
+}
+#endif
+
+static bool app_tsn_take_other(uint8_t tsn)
+{
+    uint32_t bit = 1u << (tsn % 32);
+    bool other = (s_other_tsn[tsn / 32] & bit) != 0;
+    s_other_tsn[tsn / 32] &= ~bit;
+    return other;
+}
 
 static void app_zcl_send_status_cb(esp_zb_zcl_command_send_status_message_t message)
 {
@@ -966,9 +1502,177 @@ static void app_zcl_send_status_cb(esp_zb_zcl_command_send_status_message_t mess
         short_addr = message.dst_addr.u.short_addr;
     }
 
-    ESP_LOGI(TAG, "ZCL send status: tsn %u dst 0x%04x status %s (0x%x)",
+    APP_LOGI(ZCL_SEND_STATUS,
              message.tsn, short_addr, esp_err_to_name(message.status), message.status);
+    energy_add(ENERGY_STATE_TX, CONFIG_ENERGY_TX_FRAME_US);
+    energy_count(ENERGY_COUNT_TX_FRAMES);
+    evtrace_record(EVT_TX_STATUS, message.tsn, (uint16_t)message.status);
+#if CONFIG_LATENCY_PROBES
+    /* A failed send leaves the samples for the confirmation that finally carries them. */
+    app_channel_t *lat_ch = app_channel_by_endpoint(message.src_endpoint);
+    if (lat_ch && message.status == ESP_OK) {
+        latency_tx(&lat_ch->pulse.latency, esp_timer_get_time());
+    }
+#endif
+
+#if CONFIG_DEEP_SLEEP_MODE
+    app_channel_t *deep_ch = app_channel_by_endpoint(message.src_endpoint);
+    if (deep_ch && message.status == ESP_OK) {
+        deep_sleep_report_confirmed(deep_ch->index);
+    } else if (deep_ch) {
+        deep_sleep_report_failed(deep_ch->index);
+    }
+#endif
+
+    /* The probe or backlog batch is settled only by the status carrying its TSN. Every status
+     * counts towards the link state, but only a lost metering report is snapshotted.
+     */
+    bool queue_send = (s_rq_send != APP_RQ_IDLE && message.tsn == s_rq_tsn);
+    bool metering_report = !app_tsn_take_other(message.tsn) && !(queue_send && s_rq_send == APP_RQ_FLUSH);
+    if (queue_send) {
+        if (s_rq_send == APP_RQ_FLUSH && message.status == ESP_OK) {
+            report_queue_pop(s_rq_flush_n);
+        }
+        s_rq_send = APP_RQ_IDLE;
+    }
+    if (message.status == ESP_OK) {
+        s_rq_link_changed |= report_queue_on_success();
+    } else {
+        uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000LL);
+        if (metering_report) {
+            for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+                const metering_t *m = &s_channels[i].meter;
+                report_queue_push(now_s, (uint8_t)i, metering_get_summation(m),
+                                  metering_get_instantaneous_demand(m));
+            }
+        }
+        s_rq_link_changed |= report_queue_on_failure(now_s);
+    }
+}
+
+#if CONFIG_METERING_HISTORY
+static void app_profile_save_now(int64_t now)
+{
+    /* One scratch blob: the channels are exported and written one after another. */
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        metering_profile_export(&s_channels[i].meter, &s_profile_blob);
+        app_profile_save((uint8_t)i, &s_profile_blob, sizeof(s_profile_blob));
+    }
+    s_last_profile_save_us = now;
+}
+
+static uint8_t app_profile_interval_enum(void)
+{
+    /* ProfileIntervalPeriod: 1 = 60 min, 2 = 30 min, 3 = 15 min. */
+    switch (CONFIG_METERING_PROFILE_INTERVAL_MIN) {
+    case 15:
+        return 3;
+    case 30:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+static void app_handle_get_profile(const esp_zb_zcl_privilege_command_message_t *msg)
+{
+    enum {
+        PROFILE_OK = 0x00,
+        PROFILE_UNDEFINED_CHANNEL = 0x01,
+        PROFILE_CHANNEL_NOT_SUPPORTED = 0x02,
+        PROFILE_INVALID_END_TIME = 0x03,
+        PROFILE_MORE_PERIODS_REQUESTED = 0x04,
+        PROFILE_NO_INTERVALS = 0x05,
+    };
+    const uint8_t *req = (const uint8_t *)msg->data;
+    app_channel_t *ch = app_channel_by_endpoint(msg->info.dst_endpoint);
+    uint8_t status = PROFILE_OK;
+    uint8_t n = 0;
+    uint32_t periods[APP_PROFILE_MAX_PERIODS_PER_FRAME];
+    int64_t now = esp_timer_get_time();
+
+    if (!req || msg->size < 6 || !ch) {
+        return;
+    }
+    /* UTC end of the newest stored interval; 0 until the Time cluster was synced. */
+    uint32_t rsp_end_time = timesync_valid() ? timesync_utc(now) - metering_profile_age_s(&ch->meter, now) : 0;
+    uint8_t channel = req[0];
+    uint32_t end_time = (uint32_t)req[1] | ((uint32_t)req[2] << 8) | ((uint32_t)req[3] << 16) | ((uint32_t)req[4] << 24);
+    uint8_t requested = req[5];
+
+    if (channel > 1) {
+        status = PROFILE_UNDEFINED_CHANNEL;
+    } else if (channel != 0) {
+        status = PROFILE_CHANNEL_NOT_SUPPORTED;     /* only consumption delivered */
+    } else if (end_time != 0 && rsp_end_time == 0) {
+        status = PROFILE_INVALID_END_TIME;          /* no wall clock yet: only "most recent" */
+    } else {
+        uint16_t skip = metering_profile_skip(&rsp_end_time, end_time);
+        uint8_t max = requested > APP_PROFILE_MAX_PERIODS_PER_FRAME ? APP_PROFILE_MAX_PERIODS_PER_FRAME : requested;
+        n = metering_profile_read(&ch->meter, skip, max, periods, now);
+        if (n == 0) {
+            status = PROFILE_NO_INTERVALS;
+        } else if (requested > APP_PROFILE_MAX_PERIODS_PER_FRAME) {
+            status = PROFILE_MORE_PERIODS_REQUESTED;
+        }
+    }
+
+    uint8_t rsp[7 + 3 * APP_PROFILE_MAX_PERIODS_PER_FRAME];
+    size_t len = 0;
+    rsp[len++] = (uint8_t)rsp_end_time;
+    rsp[len++] = (uint8_t)(rsp_end_time >> 8);
+    rsp[len++] = (uint8_t)(rsp_end_time >> 16);
+    rsp[len++] = (uint8_t)(rsp_end_time >> 24);
+    rsp[len++] = status;
+    rsp[len++] = app_profile_interval_enum();
+    rsp[len++] = n;
+    for (uint8_t i = 0; i < n; i++) {
+        uint32_t v = periods[i] > 0xFFFFFF ? 0xFFFFFF : periods[i];
+        rsp[len++] = (uint8_t)v;
+        rsp[len++] = (uint8_t)(v >> 8);
+        rsp[len++] = (uint8_t)(v >> 16);
+    }
+
+    esp_zb_zcl_custom_cluster_cmd_req_t cmd = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = msg->info.src_address.u.short_addr,
+            .dst_endpoint = msg->info.src_endpoint,
+            .src_endpoint = ch->endpoint,
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_METERING,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+        .dis_default_resp = 1,
+        .custom_cmd_id = APP_METERING_CMD_GET_PROFILE_RSP,
+        .data = {
+            .type = ESP_ZB_ZCL_ATTR_TYPE_SET,   /* raw payload, no length prefix */
+            .size = (uint16_t)len,
+            .value = rsp,
+        },
+    };
+    app_tsn_mark_other(esp_zb_zcl_custom_cluster_cmd_req(&cmd));
+    APP_LOGI(GET_PROFILE, (unsigned)requested, (unsigned)n, (unsigned)status);
+}
+#endif
+
+#if CONFIG_LATENCY_PROBES
+static void app_latency_select(uint8_t stage)
+{
+    static const char *const names[LATENCY_STAGE_COUNT] = {"counted", "pickup", "attr", "tx", "total"};
+    if (stage == APP_LATENCY_STAGE_CLEAR) {
+        latency_reset();
+        stage = LATENCY_STAGE_TOTAL;
+    }
+    for (unsigned i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        const latency_hist_t *h = latency_hist((latency_stage_t)i);
+        APP_LOGI(LATENCY_STAGE, names[i], (unsigned)h->count, (unsigned)latency_percentile_ms(h, 50),
+                 (unsigned)latency_percentile_ms(h, 90), (unsigned)latency_percentile_ms(h, 99),
+                 (unsigned)(h->max_us / 1000), (unsigned)(h->count ? h->sum_us / h->count / 1000 : 0));
+    }
+    config_cluster_select_latency_stage(stage);
 }
+#endif
 
 static esp_err_t app_core_action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message)
 {
@@ -978,9 +1682,15 @@ static esp_err_t app_core_action_handler(esp_zb_core_action_callback_id_t callba
             const esp_zb_zcl_set_attr_value_message_t *m = (const esp_zb_zcl_set_attr_value_message_t *)message;
             uint16_t cluster = m->info.cluster;
             uint16_t attr = m->attribute.id;
-            if (cluster == APP_MFG_CLUSTER_ID && attr == 0x0008) {
-                ESP_LOGI(TAG, "Reset requested via core action callback");
+            if (cluster == APP_MFG_CLUSTER_ID && attr == APP_MFG_ATTR_RESET_COUNTER) {
+                APP_LOGI(CORE_RESET_REQUEST);
                 app_config_reset_counter_request();
+            } else if (cluster == APP_MFG_CLUSTER_ID && attr == APP_MFG_ATTR_TRACE_PAGE && m->attribute.data.value) {
+                config_cluster_select_trace_page(*(const uint8_t *)m->attribute.data.value);
+#if CONFIG_LATENCY_PROBES
+            } else if (cluster == APP_MFG_CLUSTER_ID && attr == APP_MFG_ATTR_LATENCY_STAGE && m->attribute.data.value) {
+                app_latency_select(*(const uint8_t *)m->attribute.data.value);
+#endif
             }
         }
         break;
@@ -989,6 +1699,25 @@ static esp_err_t app_core_action_handler(esp_zb_core_action_callback_id_t callba
             return app_ota_upgrade_status_handler(*(const esp_zb_zcl_ota_upgrade_value_message_t *)message);
         }
         break;
+#if CONFIG_METERING_HISTORY
+    case ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID:
+        if (message) {
+            const esp_zb_zcl_cmd_read_attr_resp_message_t *m = (const esp_zb_zcl_cmd_read_attr_resp_message_t *)message;
+            if (m->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_TIME) {
+                app_handle_time_read_resp(m);
+            }
+        }
+        break;
+    case ESP_ZB_CORE_CMD_PRIVILEGE_COMMAND_REQ_CB_ID:
+        if (message) {
+            const esp_zb_zcl_privilege_command_message_t *m = (const esp_zb_zcl_privilege_command_message_t *)message;
+            if (m->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_METERING &&
+                m->info.command.id == APP_METERING_CMD_GET_PROFILE) {
+                app_handle_get_profile(m);
+            }
+        }
+        break;
+#endif
     case ESP_ZB_CORE_OTA_UPGRADE_QUERY_IMAGE_RESP_CB_ID:
         if (message) {
             return app_ota_query_image_resp_handler(*(const esp_zb_zcl_ota_upgrade_query_image_resp_message_t *)message);
@@ -1024,7 +1753,7 @@ static void app_configure_attr_reporting(const esp_zb_zcl_reporting_info_t *info
 
     if ((start_err == ESP_OK || start_err == ESP_ERR_NOT_FOUND) &&
         (update_err == ESP_OK || update_err == ESP_ERR_NOT_FOUND)) {
-        ESP_LOGI(TAG, "Reporting configured: %s cluster 0x%04x attr 0x%04x",
+        APP_LOGI(REPORTING_CONFIGURED,
                  label, info->cluster_id, info->attr_id);
     }
 }
@@ -1033,16 +1762,23 @@ typedef struct {
     esp_zb_zdo_bind_req_param_t req;
     uint16_t cluster_id;
     const char *label;
+    bool busy;
 } app_bind_ctx_t;
 
+/* One slot per bind made on join: each channel's metering, plus power config and the mfg cluster
+ * in the builds that report them.
+ */
+#define APP_BIND_SLOTS (CONFIG_PULSE_CHANNELS + CONFIG_BATTERY_ADC_ENABLE + CONFIG_BATTERY_SOC_LIFEPO4_COULOMB)
+static app_bind_ctx_t s_bind_ctx[APP_BIND_SLOTS];
+
 static void app_bind_cb(esp_zb_zdp_status_t zdo_status, void *user_ctx)
 {
     app_bind_ctx_t *ctx = (app_bind_ctx_t *)user_ctx;
-    ESP_LOGI(TAG, "Bind %s (cluster 0x%04x) status %d", ctx->label, ctx->cluster_id, (int)zdo_status);
-    free(ctx);
+    APP_LOGI(BIND_STATUS, ctx->label, (unsigned)ctx->req.src_endp, ctx->cluster_id, (int)zdo_status);
+    ctx->busy = false;
 }
 
-static void app_bind_cluster(uint16_t cluster_id, const char *label)
+static void app_bind_cluster(uint8_t endpoint, uint16_t cluster_id, const char *label)
 {
     const uint16_t dst_short = APP_ZB_REPORT_DST_SHORT_ADDR;
     if (dst_short == 0xFFFF) {
@@ -1050,16 +1786,26 @@ static void app_bind_cluster(uint16_t cluster_id, const char *label)
         return;
     }
 
-    app_bind_ctx_t *ctx = (app_bind_ctx_t *)calloc(1, sizeof(*ctx));
+    /* A slot stays busy until the stack answers (success or timeout), e.g. across a quick rejoin. */
+    app_bind_ctx_t *ctx = NULL;
+    for (size_t i = 0; i < APP_BIND_SLOTS; i++) {
+        if (!s_bind_ctx[i].busy) {
+            ctx = &s_bind_ctx[i];
+            break;
+        }
+    }
     if (!ctx) {
-        ESP_LOGE(TAG, "No mem for bind ctx (%s)", label);
+        ESP_LOGW(TAG, "Bind skipped for %s: all %u bind requests still pending", label, (unsigned)APP_BIND_SLOTS);
         return;
     }
-    ctx->cluster_id = cluster_id;
-    ctx->label = label;
+    *ctx = (app_bind_ctx_t){
+        .cluster_id = cluster_id,
+        .label = label,
+        .busy = true,
+    };
 
     ctx->req.req_dst_addr = esp_zb_get_short_address();
-    ctx->req.src_endp = APP_ZB_ENDPOINT;
+    ctx->req.src_endp = endpoint;
     ctx->req.dst_endp = APP_ZB_REPORT_DST_ENDPOINT;
     ctx->req.cluster_id = cluster_id;
     ctx->req.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED;
@@ -1076,24 +1822,42 @@ static void app_zigbee_configure_reporting(void)
     uint16_t max_interval = CONFIG_ZB_REPORT_MAX_S;
     uint32_t change = CONFIG_ZB_REPORTABLE_CHANGE;
 
-    ESP_LOGI(TAG, "Configure reporting: metering min %u max %u change %u",
+    APP_LOGI(REPORTING_SETUP,
              min_interval, max_interval, change);
     if (change == 0) {
         ESP_LOGW(TAG, "CONFIG_ZB_REPORTABLE_CHANGE=0 may cause frequent reports (min interval=%u s)",
                  (unsigned)min_interval);
     }
 
-    esp_zb_zcl_reporting_info_t metering_info = {0};
-    metering_info.direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND;
-    metering_info.ep = APP_ZB_ENDPOINT;
-    metering_info.cluster_id = ESP_ZB_ZCL_CLUSTER_ID_METERING;
-    metering_info.cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
-    metering_info.attr_id = ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID;
-    metering_info.u.send_info.min_interval = min_interval;
-    metering_info.u.send_info.max_interval = max_interval;
-    metering_info.u.send_info.delta.u48 = app_to_uint48(change);
-    metering_info.u.send_info.def_min_interval = min_interval;
-    metering_info.u.send_info.def_max_interval = max_interval;
+    /* Same schedule on every endpoint, so the channels' reports tend to share a radio wake. */
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        esp_zb_zcl_reporting_info_t metering_info = {0};
+        metering_info.direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND;
+        metering_info.ep = s_channels[i].endpoint;
+        metering_info.cluster_id = ESP_ZB_ZCL_CLUSTER_ID_METERING;
+        metering_info.cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
+        metering_info.attr_id = ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID;
+        metering_info.u.send_info.min_interval = min_interval;
+        metering_info.u.send_info.max_interval = max_interval;
+        metering_info.u.send_info.delta.u48 = app_to_uint48(change);
+        metering_info.u.send_info.def_min_interval = min_interval;
+        metering_info.u.send_info.def_max_interval = max_interval;
+
+        esp_zb_zcl_reporting_info_t demand_info = {0};
+        demand_info.direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND;
+        demand_info.ep = s_channels[i].endpoint;
+        demand_info.cluster_id = ESP_ZB_ZCL_CLUSTER_ID_METERING;
+        demand_info.cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
+        demand_info.attr_id = ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID;
+        demand_info.u.send_info.min_interval = min_interval;
+        demand_info.u.send_info.max_interval = max_interval;
+        demand_info.u.send_info.delta.s24 = app_to_int24((int32_t)change);
+        demand_info.u.send_info.def_min_interval = min_interval;
+        demand_info.u.send_info.def_max_interval = max_interval;
+
+        app_configure_attr_reporting(&metering_info, "metering");
+        app_configure_attr_reporting(&demand_info, "demand");
+    }
 
 #if CONFIG_BATTERY_ADC_ENABLE
     esp_zb_zcl_reporting_info_t battery_info = {0};
@@ -1121,29 +1885,517 @@ static void app_zigbee_configure_reporting(void)
     battery_voltage_info.u.send_info.def_max_interval = CONFIG_ZB_BAT_REPORT_MAX_S;
 #endif
 
-    esp_zb_zcl_reporting_info_t demand_info = {0};
-    demand_info.direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND;
-    demand_info.ep = APP_ZB_ENDPOINT;
-    demand_info.cluster_id = ESP_ZB_ZCL_CLUSTER_ID_METERING;
-    demand_info.cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
-    demand_info.attr_id = ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID;
-    demand_info.u.send_info.min_interval = min_interval;
-    demand_info.u.send_info.max_interval = max_interval;
-    demand_info.u.send_info.delta.s24 = app_to_int24((int32_t)change);
-    demand_info.u.send_info.def_min_interval = min_interval;
-    demand_info.u.send_info.def_max_interval = max_interval;
-
-    app_configure_attr_reporting(&metering_info, "metering");
 #if CONFIG_BATTERY_ADC_ENABLE
     app_configure_attr_reporting(&battery_info, "battery");
     app_configure_attr_reporting(&battery_voltage_info, "battery_voltage");
 #endif
-    app_configure_attr_reporting(&demand_info, "demand");
+
+#if CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+    esp_zb_zcl_reporting_info_t days_info = {0};
+    days_info.direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND;
+    days_info.ep = APP_ZB_ENDPOINT;
+    days_info.cluster_id = APP_MFG_CLUSTER_ID;
+    days_info.cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
+    days_info.manuf_code = APP_MFG_CODE;
+    days_info.attr_id = APP_MFG_ATTR_BATTERY_DAYS;
+    days_info.u.send_info.min_interval = CONFIG_ZB_BAT_REPORT_MIN_S;
+    days_info.u.send_info.max_interval = CONFIG_ZB_BAT_REPORT_MAX_S;
+    days_info.u.send_info.delta.u16 = 1;
+    days_info.u.send_info.def_min_interval = CONFIG_ZB_BAT_REPORT_MIN_S;
+    days_info.u.send_info.def_max_interval = CONFIG_ZB_BAT_REPORT_MAX_S;
+    app_configure_attr_reporting(&days_info, "battery_days");
+#endif
+}
+
+static void app_set_metering_reporting(bool on)
+{
+    static const uint16_t attrs[] = {
+        ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID,
+        ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID,
+    };
+    for (size_t c = 0; c < CONFIG_PULSE_CHANNELS; c++) {
+        for (size_t i = 0; i < sizeof(attrs) / sizeof(attrs[0]); i++) {
+            esp_zb_zcl_attr_location_info_t attr_info = {
+                .endpoint_id = s_channels[c].endpoint,
+                .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                .cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+                .attr_id = attrs[i],
+            };
+            esp_err_t err = on ? esp_zb_zcl_start_attr_reporting(attr_info) : esp_zb_zcl_stop_attr_reporting(attr_info);
+            if (err != ESP_OK && err != ESP_ERR_NOT_FOUND) {
+                ESP_LOGW(TAG, "Reporting %s failed: ep %u attr 0x%04x err %s",
+                         on ? "start" : "stop", (unsigned)attr_info.endpoint_id, attrs[i], esp_err_to_name(err));
+            }
+        }
+    }
+}
+
+/* Returns the TSN the send status callback reports for this send. */
+static uint8_t app_report_attr(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, bool manuf)
+{
+    /* The report carries the stack's copy. */
+    app_attr_flush();
+    esp_zb_zcl_report_attr_cmd_t cmd = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = APP_ZB_REPORT_DST_SHORT_ADDR,
+            .dst_endpoint = APP_ZB_REPORT_DST_ENDPOINT,
+            .src_endpoint = endpoint,
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .clusterID = cluster_id,
+        .attributeID = attr_id,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+        .manuf_specific = manuf ? 1 : 0,
+        .manuf_code = manuf ? APP_MFG_CODE : 0,
+    };
+    return esp_zb_zcl_report_attr_cmd_req(&cmd);
+}
+
+static void app_report_queue_update_diag(void)
+{
+    const report_queue_stats_t *st = report_queue_stats();
+    config_cluster_set_diag(APP_MFG_ATTR_QUEUE_QUEUED, st->queued);
+    config_cluster_set_diag(APP_MFG_ATTR_QUEUE_DROPPED, st->dropped);
+    config_cluster_set_diag(APP_MFG_ATTR_QUEUE_FLUSHED, st->flushed);
+    config_cluster_set_diag(APP_MFG_ATTR_QUEUE_OUTAGES, st->outages);
+}
+
+static void app_update_attr_shadow_diag(void)
+{
+    const attr_shadow_stats_t *st = attr_shadow_stats();
+    config_cluster_set_diag(APP_MFG_ATTR_ZCL_WRITES, st->writes);
+    config_cluster_set_diag(APP_MFG_ATTR_ZCL_WRITES_AVOIDED, st->sets - st->writes);
+}
+
+static void app_report_queue_send_batch(uint32_t now_s)
+{
+    report_queue_entry_t entries[APP_BACKLOG_BATCH_ENTRIES];
+    uint8_t buf[APP_BACKLOG_BATCH_ENTRIES * APP_BACKLOG_ENTRY_SIZE];
+    size_t n = report_queue_peek(entries, APP_BACKLOG_BATCH_ENTRIES);
+    uint8_t *p = buf;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t age_s = now_s - entries[i].t_s;
+        uint32_t demand = (uint32_t)entries[i].demand;
+        *p++ = entries[i].channel;
+        for (int b = 0; b < 4; b++) {
+            *p++ = (uint8_t)(age_s >> (8 * b));
+        }
+        for (int b = 0; b < 6; b++) {
+            *p++ = (uint8_t)(entries[i].summation >> (8 * b));
+        }
+        for (int b = 0; b < 3; b++) {
+            *p++ = (uint8_t)(demand >> (8 * b));
+        }
+    }
+    config_cluster_set_backlog(buf, (uint8_t)(p - buf));
+    s_rq_tsn = app_report_attr(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_BACKLOG, true);
+    s_rq_flush_n = n;
+}
+
+/* Pause reporting while sends fail, snapshot the meter instead, probe with back-off and flush
+ * the backlog back-to-back once the link returns.
+ */
+static void app_report_queue_service(int64_t now)
+{
+    uint32_t now_s = (uint32_t)(now / 1000000LL);
+
+    if (s_rq_link_changed) {
+        s_rq_link_changed = false;
+        bool down = report_queue_link_down();
+        if (down) {
+            APP_LOGI(REPORT_LINK_DOWN, (unsigned)CONFIG_REPORT_QUEUE_FAIL_LIMIT, (unsigned)report_queue_count());
+        } else {
+            APP_LOGI(REPORT_LINK_UP, (unsigned)report_queue_count());
+        }
+        evtrace_record(EVT_REPORT_LINK, down ? 0 : 1, (uint16_t)report_queue_count());
+        app_set_metering_reporting(!down);
+        app_report_queue_update_diag();
+    }
+
+    if (s_rq_send != APP_RQ_IDLE) {
+        if (now - s_rq_send_us < APP_REPORT_QUEUE_SEND_TIMEOUT_US) {
+            return;
+        }
+        s_rq_send = APP_RQ_IDLE;
+    }
+    if (!s_joined) {
+        return;
+    }
+
+    if (report_queue_link_down()) {
+        for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+            const metering_t *m = &s_channels[i].meter;
+            report_queue_sample(now_s, (uint8_t)i, metering_get_summation(m), metering_get_instantaneous_demand(m));
+        }
+        if (report_queue_probe_due(now_s)) {
+            s_rq_tsn = app_report_attr(APP_ZB_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                                       ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID, false);
+            s_rq_send = APP_RQ_PROBE;
+            s_rq_send_us = now;
+        }
+        return;
+    }
+
+    if (report_queue_count() > 0) {
+        app_report_queue_send_batch(now_s);
+        s_rq_send = APP_RQ_FLUSH;
+        s_rq_send_us = now;
+    }
+}
+
+#if CONFIG_METERING_HISTORY
+static void app_time_sync_request(int64_t now)
+{
+    static uint16_t attrs[] = {
+        ESP_ZB_ZCL_ATTR_TIME_TIME_ID,
+        ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID,
+        ESP_ZB_ZCL_ATTR_TIME_LOCAL_TIME_ID,
+    };
+    esp_zb_zcl_read_attr_cmd_t cmd = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = APP_ZB_REPORT_DST_SHORT_ADDR,
+            .dst_endpoint = APP_ZB_REPORT_DST_ENDPOINT,
+            .src_endpoint = APP_ZB_ENDPOINT,
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .clusterID = ESP_ZB_ZCL_CLUSTER_ID_TIME,
+        .attr_number = sizeof(attrs) / sizeof(attrs[0]),
+        .attr_field = attrs,
+    };
+    app_tsn_mark_other(esp_zb_zcl_read_attr_cmd_req(&cmd));
+    /* Re-armed to the full interval when the response arrives. */
+    s_next_time_sync_us = now + APP_TIME_SYNC_RETRY_US;
+}
+
+static void app_handle_time_read_resp(const esp_zb_zcl_cmd_read_attr_resp_message_t *msg)
+{
+    bool have_utc = false;
+    bool have_local = false;
+    uint32_t utc = 0;
+    uint32_t local = 0;
+    int32_t zone = 0;
+    for (esp_zb_zcl_read_attr_resp_variable_t *v = msg->variables; v; v = v->next) {
+        if (v->status != ESP_ZB_ZCL_STATUS_SUCCESS || !v->attribute.data.value) {
+            continue;
+        }
+        switch (v->attribute.id) {
+        case ESP_ZB_ZCL_ATTR_TIME_TIME_ID:
+            utc = *(const uint32_t *)v->attribute.data.value;
+            have_utc = true;
+            break;
+        case ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID:
+            zone = *(const int32_t *)v->attribute.data.value;
+            break;
+        case ESP_ZB_ZCL_ATTR_TIME_LOCAL_TIME_ID:
+            local = *(const uint32_t *)v->attribute.data.value;
+            have_local = true;
+            break;
+        default:
+            break;
+        }
+    }
+    /* 0xFFFFFFFF is the ZCL invalid UTCTime. */
+    if (!have_utc || utc == 0 || utc == UINT32_MAX) {
+        return;
+    }
+    /* LocalTime includes DST; fall back to the standard time zone without it. */
+    int32_t offset = (have_local && local != 0 && local != UINT32_MAX) ? (int32_t)(local - utc) : zone;
+    int64_t now = esp_timer_get_time();
+    timesync_update(now, utc, offset);
+    s_next_time_sync_us = now + APP_TIME_SYNC_INTERVAL_US;
+    APP_LOGI(TIME_SYNCED, (unsigned)utc, (int)offset, (int)timesync_last_error_ms(), (int)timesync_drift_ppm());
+}
+#endif
+
+#if CONFIG_LEAK_DETECT
+/* Report the leak alarm bitmap (one nibble per channel) on every change; nothing is sent while
+ * it stays put.
+ */
+static void app_leak_service(void)
+{
+    bool changed = false;
+    uint32_t bitmap = 0;
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_channel_t *ch = &s_channels[i];
+        uint8_t alarms = metering_leak_alarms(&ch->meter);
+        if (alarms != ch->leak_alarms) {
+            APP_LOGI(LEAK_ALARM, (unsigned)ch->index, (unsigned)ch->leak_alarms, (unsigned)alarms);
+            evtrace_record(EVT_LEAK, alarms, ch->index);
+            ch->leak_alarms = alarms;
+            changed = true;
+        }
+        bitmap |= (uint32_t)(alarms & 0x0F) << (4 * i);
+    }
+    if (!changed) {
+        return;
+    }
+    config_cluster_set_leak_alarm(bitmap);
+    if (s_joined) {
+        app_tsn_mark_other(app_report_attr(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, APP_MFG_ATTR_LEAK_ALARM, true));
+    }
 }
 
+/* Worst channel: the shortest daily pause and the longest running flow. */
+static void app_update_leak_diag(int64_t now)
+{
+    uint32_t idle_s = UINT32_MAX;
+    uint32_t run_s = 0;
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        const metering_t *m = &s_channels[i].meter;
+        uint32_t ch_idle_s = metering_leak_longest_idle_s(m, now);
+        uint32_t ch_run_s = metering_leak_flow_run_s(m, now);
+        idle_s = ch_idle_s < idle_s ? ch_idle_s : idle_s;
+        run_s = ch_run_s > run_s ? ch_run_s : run_s;
+    }
+    config_cluster_set_diag(APP_MFG_ATTR_LEAK_LONGEST_IDLE_S, idle_s);
+    config_cluster_set_diag(APP_MFG_ATTR_LEAK_FLOW_RUN_S, run_s);
+}
+#endif
+
+#if CONFIG_METERING_HISTORY
+/* Day/week rollover from the synced clock; one report per boundary replaces polling. */
+static void app_calendar_service(int64_t now)
+{
+    if (!timesync_valid()) {
+        return;
+    }
+    uint32_t local_s = timesync_local(now);
+    bool any_rolled = false;
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_channel_t *ch = &s_channels[i];
+        bool first = !metering_calendar_valid(&ch->meter);
+        uint8_t rolled = metering_calendar_update(&ch->meter, local_s);
+        if (!rolled && !first) {
+            continue;
+        }
+        app_zigbee_update_calendar_attrs(ch);
+        if (!rolled) {
+            continue;
+        }
+        any_rolled = true;
+        APP_LOGI(DAY_ROLLOVER, (unsigned)ch->index, (unsigned)metering_get_previous_day_consumption(&ch->meter),
+                 (unsigned)((rolled & METERING_ROLL_WEEK) ? metering_get_previous_week_consumption(&ch->meter) : 0));
+        if (s_joined && !report_queue_link_down()) {
+            app_tsn_mark_other(app_report_attr(ch->endpoint, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                                               APP_METERING_ATTR_PREVIOUS_DAY_DELIVERED, false));
+            if (rolled & METERING_ROLL_WEEK) {
+                app_tsn_mark_other(app_report_attr(ch->endpoint, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                                                   APP_METERING_ATTR_PREVIOUS_WEEK_DELIVERED, false));
+            }
+        }
+    }
+    if (any_rolled) {
+        app_profile_save_now(now);
+    }
+}
+#endif
+
+#if CONFIG_DEEP_SLEEP_MODE
+static bool app_pulse_pins_low(void)
+{
+#if CONFIG_PULSE_LP_CORE
+    /* The LP core counts the release; the HP core never waits for it. */
+    return false;
+#endif
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        if (pulse_strobing(&s_channels[i].pulse) || app_gpio_active_low((gpio_num_t)s_channels[i].cfg.gpio_num)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void app_deep_sleep_sync_totals(void)
+{
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+#if CONFIG_PULSE_LP_CORE
+        /* Whatever the LP core counts after this is taken on the next boot. */
+        pulse_lp_poll(i, &s_channels[i].pulse);
+#endif
+        deep_sleep_set_total(i, pulse_counter_total(&s_channels[i].counter));
+    }
+}
+
+static void app_deep_sleep_update_diag(void)
+{
+    const deep_sleep_rtc_t *rec = deep_sleep_get();
+    config_cluster_set_diag(APP_MFG_ATTR_DEEP_WAKES, rec->wakes);
+    config_cluster_set_diag(APP_MFG_ATTR_DEEP_RADIO_WAKES, rec->radio_wakes);
+}
+
+/* Anything that must not be cut off by deep sleep: a probe or backlog batch, a bind, an OTA
+ * download that delivered a block recently.
+ */
+static bool app_deep_sleep_busy(int64_t now)
+{
+    if (s_rq_send != APP_RQ_IDLE) {
+        return true;
+    }
+    for (size_t i = 0; i < APP_BIND_SLOTS; i++) {
+        if (s_bind_ctx[i].busy) {
+            return true;
+        }
+    }
+    return s_ota_last_block_us != 0 && now - s_ota_last_block_us < APP_DEEP_SLEEP_OTA_IDLE_US;
+}
+
+/* Does not return; the next wake boots through app_main with a deep-sleep reset. radio: the
+ * stack ran in this boot, so NVS, the channel and the sleep statistics are brought up to date.
+ */
+static void app_deep_sleep_enter(bool radio)
+{
+    app_deep_sleep_sync_totals();
+    const deep_sleep_rtc_t *rec = deep_sleep_get();
+    if (radio) {
+        /* Count-only wakes leave NVS behind; catch it up once per radio wake. */
+        for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+            uint64_t saved = 0;
+            app_pulse_load_total((uint8_t)i, &saved);
+            if (saved != rec->total[i]) {
+                app_pulse_save_total((uint8_t)i, rec->total[i]);
+            }
+        }
+        deep_sleep_set_channel(esp_zb_get_current_channel());
+        sleep_stats_snapshot(&s_sleep_stats_rtc);
+    }
+    deep_sleep_snapshot(&s_deep_sleep_rtc);
+
+    uint64_t unreported = deep_sleep_unreported(0);
+    evtrace_record(EVT_DEEP_SLEEP, radio ? 1 : 0, unreported > UINT16_MAX ? UINT16_MAX : (uint16_t)unreported);
+    APP_LOGI(DEEP_SLEEP_ENTER, (unsigned)CONFIG_DEEP_SLEEP_TIMER_S, (unsigned)rec->total[0], (unsigned)unreported,
+             (unsigned)rec->channel);
+    tlog_drain();
+
+    /* EXT1 is already armed; keep the contacts' pull-ups powered while the rest powers down.
+     * With PULSE_PULL_EXTERNAL the board pulls the contacts up.
+     */
+    uint64_t pull_mask = CONFIG_PULSE_PULL_EXTERNAL ? 0 : app_pulse_gpio_mask();
+#if CONFIG_FACTORY_RESET_BUTTON_GPIO >= 0
+    pull_mask |= 1ULL << CONFIG_FACTORY_RESET_BUTTON_GPIO;
+#endif
+    for (int gpio = 0; gpio < GPIO_NUM_MAX; gpio++) {
+        if (!(pull_mask & (1ULL << gpio))) {
+            continue;
+        }
+#if SOC_RTCIO_INPUT_OUTPUT_SUPPORTED
+        rtc_gpio_pullup_en((gpio_num_t)gpio);
+        rtc_gpio_pulldown_dis((gpio_num_t)gpio);
+#else
+        gpio_pullup_en((gpio_num_t)gpio);
+        gpio_pulldown_dis((gpio_num_t)gpio);
+#endif
+    }
+#if SOC_PM_SUPPORT_RTC_PERIPH_PD
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+#endif
+    esp_sleep_enable_timer_wakeup((uint64_t)CONFIG_DEEP_SLEEP_TIMER_S * 1000000ULL);
+    esp_deep_sleep_start();
+}
+
+static deep_sleep_wake_t app_deep_sleep_wake(uint64_t *ext1_status)
+{
+    *ext1_status = 0;
+    if (!s_deep_resumed) {
+        return DEEP_SLEEP_WAKE_COLD;
+    }
+    switch (esp_sleep_get_wakeup_cause()) {
+    case ESP_SLEEP_WAKEUP_EXT1:
+        *ext1_status = esp_sleep_get_ext1_wakeup_status();
+        return (*ext1_status & app_pulse_gpio_mask()) ? DEEP_SLEEP_WAKE_PULSE : DEEP_SLEEP_WAKE_OTHER;
+    case ESP_SLEEP_WAKEUP_ULP:
+        return DEEP_SLEEP_WAKE_PULSE;
+    case ESP_SLEEP_WAKEUP_TIMER:
+        return DEEP_SLEEP_WAKE_TIMER;
+    default:
+        return DEEP_SLEEP_WAKE_OTHER;
+    }
+}
+
+/* Count the pulse that woke us and decide whether this boot needs the radio. A count-only wake
+ * waits for the contact to open (so its release is not counted again on the next boot) and
+ * goes straight back to sleep; returns only if the boot goes on to start the stack.
+ */
+static void app_deep_sleep_boot(void)
+{
+    uint64_t ext1_status = 0;
+    deep_sleep_wake_t wake = app_deep_sleep_wake(&ext1_status);
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        if (ext1_status & (1ULL << s_channels[i].cfg.gpio_num)) {
+            (void)pulse_record_wakeup(&s_channels[i].pulse, now);
+        }
+    }
+    app_deep_sleep_sync_totals();
+    bool radio = deep_sleep_on_wake(wake);
+    const deep_sleep_rtc_t *rec = deep_sleep_get();
+    APP_LOGI(DEEP_SLEEP_WAKE, (int)wake, (unsigned)rec->wakes, (unsigned)rec->radio_wakes,
+             (unsigned)deep_sleep_unreported(0), radio ? "radio" : "count only");
+    if (radio) {
+        return;
+    }
+
+    while (app_pulse_pins_low() && esp_timer_get_time() - now < APP_DEEP_SLEEP_RELEASE_WAIT_US) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    app_deep_sleep_sync_totals();
+    bool held = app_pulse_pins_low();
+    if (!held && !deep_sleep_radio_due()) {
+        app_deep_sleep_enter(false);
+    }
+    if (held) {
+        /* A stuck contact would wake us again at once; report it instead. */
+        APP_LOGI(DEEP_SLEEP_PIN_HELD);
+    } else {
+        /* Pulses counted while waiting for the release reached the report threshold. */
+        APP_LOGI(DEEP_SLEEP_RADIO_DUE, (unsigned)deep_sleep_unreported(0));
+    }
+    deep_sleep_radio_started();
+}
+
+/* Explicit summation reports of a radio wake; the send status settles them. */
+static void app_deep_sleep_service(void)
+{
+    app_deep_sleep_sync_totals();
+    if (!s_joined || report_queue_link_down()) {
+        return;
+    }
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_channel_t *ch = &s_channels[i];
+        if (!deep_sleep_report_due(i)) {
+            continue;
+        }
+        app_zigbee_update_metering_attrs_dynamic(ch);
+        app_report_attr(ch->endpoint, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                        ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID, false);
+        deep_sleep_report_sent(i);
+    }
+}
+
+/* A resumed device rejoins the network it slept in: scanning only the channel it was on saves
+ * a full-mask scan on every radio wake. Undone if that rejoin fails.
+ */
+static void app_deep_sleep_limit_channels(void)
+{
+    uint32_t channel = deep_sleep_get()->channel;
+    if (s_deep_resumed && channel >= 11 && channel <= 26) {
+        esp_zb_set_primary_network_channel_set(1UL << channel);
+    }
+}
+
+static void app_deep_sleep_rejoin_failed(void)
+{
+    if (s_deep_resumed) {
+        s_deep_resumed = false;
+        esp_zb_set_primary_network_channel_set(CONFIG_ZB_CHANNEL_MASK);
+    }
+}
+#endif
+
 static void app_on_joined(const char *reason)
 {
-    ESP_LOGI(TAG, "Joined network (%s)", reason ? reason : "n/a");
+    APP_LOGI(JOINED, reason ? reason : "n/a");
+    evtrace_record(EVT_JOINED, 0, esp_zb_get_short_address());
     s_joined = true;
     s_steer_started = false;
     s_steer_retry_count = 0;
@@ -1154,16 +2406,39 @@ static void app_on_joined(const char *reason)
 
     power_status_t joined_power = {0};
     power_read_status(&joined_power);
+    app_apply_battery_model(&joined_power);
 
     s_no_sleep_until_us = esp_timer_get_time() + APP_SLEEP_JOIN_BLOCK_US;
     app_update_sleep_policy();
-    app_zigbee_update_metering_attrs_static();
-    app_zigbee_update_metering_attrs_dynamic();
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_zigbee_update_metering_attrs_static(&s_channels[i]);
+        app_zigbee_update_metering_attrs_dynamic(&s_channels[i]);
+    }
     app_zigbee_update_power_attrs(&joined_power);
     app_zigbee_configure_reporting();
-    app_bind_cluster(ESP_ZB_ZCL_CLUSTER_ID_METERING, "seMetering");
+    /* Rejoined: reporting was just restarted, flush anything buffered while away. */
+    report_queue_on_success();
+#if CONFIG_DEEP_SLEEP_MODE
+    s_deep_joined_us = esp_timer_get_time();
+    app_deep_sleep_update_diag();
+    if (s_deep_resumed) {
+        /* Same network and binds as before the deep sleep: no interview window. */
+        s_no_sleep_until_us = 0;
+        app_log_network_info("Resumed info");
+        return;
+    }
+#endif
+#if CONFIG_METERING_HISTORY
+    app_time_sync_request(esp_timer_get_time());
+#endif
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_bind_cluster(s_channels[i].endpoint, ESP_ZB_ZCL_CLUSTER_ID_METERING, "seMetering");
+    }
 #if CONFIG_BATTERY_ADC_ENABLE
-    app_bind_cluster(ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, "genPowerCfg");
+    app_bind_cluster(APP_ZB_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, "genPowerCfg");
+#endif
+#if CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+    app_bind_cluster(APP_ZB_ENDPOINT, APP_MFG_CLUSTER_ID, "manuSpecific");
 #endif
 
     app_log_network_info("Joined info");
@@ -1175,7 +2450,7 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
     esp_err_t status = signal_struct->esp_err_status;
 
     if (sig_type != ESP_ZB_COMMON_SIGNAL_CAN_SLEEP) {
-        ESP_LOGI(TAG, "Zigbee signal %d (%s) status %s (0x%x)", sig_type, app_signal_to_str(sig_type),
+        APP_LOGI(ZB_SIGNAL, sig_type, app_signal_to_str(sig_type),
                  esp_err_to_name(status), status);
     }
 
@@ -1184,19 +2459,22 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
         app_log_commissioning_state("ZDO error");
         break;
     case ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP:
-        ESP_LOGI(TAG, "Zigbee stack initialized (autostart)");
+        APP_LOGI(ZB_STACK_INIT);
         break;
     case ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START:
         if (status == ESP_OK) {
             bool factory_new = esp_zb_bdb_is_factory_new();
             bool joined = esp_zb_bdb_dev_joined();
-            ESP_LOGI(TAG, "First start: factory_new=%d joined=%d", factory_new, joined);
+            APP_LOGI(ZB_FIRST_START, factory_new, joined);
             if (joined) {
                 /* The stack may report joined=true on DEVICE_FIRST_START after reboot.
                  * Without this, s_joined stays false and sleep never enables.
                  */
                 app_on_joined("DEVICE_FIRST_START (already joined)");
             } else {
+#if CONFIG_DEEP_SLEEP_MODE
+                app_deep_sleep_rejoin_failed();
+#endif
                 app_start_network_steering(factory_new ? "Device first start (factory-new)"
                                                        : "Device first start (not joined)");
             }
@@ -1212,6 +2490,9 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
         } else {
             ESP_LOGW(TAG, "Zigbee join failed: %s (0x%x)", esp_err_to_name(status), status);
             app_log_commissioning_state("Join failed");
+#if CONFIG_DEEP_SLEEP_MODE
+            app_deep_sleep_rejoin_failed();
+#endif
             app_schedule_steer_retry("join failed");
         }
         break;
@@ -1226,7 +2507,7 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
         }
         break;
     case ESP_ZB_ZDO_SIGNAL_PRODUCTION_CONFIG_READY:
-        ESP_LOGI(TAG, "Production config status: %s (0x%x)", esp_err_to_name(status), status);
+        APP_LOGI(ZB_PRODUCTION_CONFIG, esp_err_to_name(status), status);
         break;
     case ESP_ZB_COMMON_SIGNAL_CAN_SLEEP:
         /* Zigbee light sleep: enter only on battery when wakeup pins are idle. */
@@ -1236,36 +2517,59 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
             bool wake_low = app_any_wakeup_pin_asserted(&wake_reason);
             int64_t now_us = esp_timer_get_time();
 
-            if (!s_joined || wake_low) {
-                if (now_us - s_last_can_sleep_skip_log_us > 5000000LL) {
-                    ESP_LOGI(TAG, "CAN_SLEEP skipped: joined=%d wake_low=%d reason=%s",
-                             s_joined, wake_low, wake_reason ? wake_reason : "none");
-                    s_last_can_sleep_skip_log_us = now_us;
-                }
+            if (!s_joined) {
+                app_sleep_skip(SLEEP_SKIP_NOT_JOINED, "not joined", now_us);
+                break;
+            }
+            if (wake_low) {
+                app_sleep_skip(SLEEP_SKIP_PIN_ASSERTED, wake_reason, now_us);
                 break;
             }
-
             if (now_us < s_no_sleep_until_us) {
-                if (now_us - s_last_can_sleep_skip_log_us > 5000000LL) {
-                    ESP_LOGI(TAG, "CAN_SLEEP skipped: post-join block active (%lld ms left)",
-                             (long long)((s_no_sleep_until_us - now_us) / 1000LL));
-                    s_last_can_sleep_skip_log_us = now_us;
-                }
+                app_sleep_skip(SLEEP_SKIP_POST_JOIN, "post-join block", now_us);
                 break;
             }
+#if CONFIG_DEEP_SLEEP_MODE
+            /* A strobed contact needs the strobe timer, which deep sleep stops. */
+            bool held = wake_low || app_pulse_strobing_mask() != 0;
+            if (deep_sleep_allowed(s_joined, held, app_deep_sleep_busy(now_us), now_us - s_deep_joined_us)) {
+                app_deep_sleep_enter(true);
+            }
+#endif
+#if CONFIG_PULSE_PULL_STROBED
+            app_update_ext1_wakeup();
+#endif
 
             int64_t t0 = now_us;
             esp_zb_sleep_now();
-            int64_t slept_ms = (esp_timer_get_time() - t0) / 1000;
-            app_log_wakeup_info(slept_ms);
+            int64_t slept_us = esp_timer_get_time() - t0;
+            energy_add(ENERGY_STATE_SLEEP, (uint32_t)slept_us);
+            energy_count(ENERGY_COUNT_WAKES);
+            sleep_wake_t wake = app_classify_wakeup();
+            sleep_stats_wake(wake, (uint32_t)(slept_us / 1000));
+            evtrace_record_coalesced(EVT_SLEEP, (uint8_t)wake);
+            if (wake == SLEEP_WAKE_TIMER) {
+                /* Timer wakes are parent polls: the receiver stays on for the data request. */
+                energy_add(ENERGY_STATE_RX, CONFIG_ENERGY_RX_POLL_US);
+            }
+#if CONFIG_SLEEP_WAKE_LOG
+            app_log_wakeup_info(slept_us / 1000);
+#endif
 
-            if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT1) {
+            if (wake == SLEEP_WAKE_PULSE) {
                 uint64_t ext1_status = esp_sleep_get_ext1_wakeup_status();
-                if (ext1_status & (1ULL << CONFIG_PULSE_GPIO)) {
-                    int64_t now2 = esp_timer_get_time();
-                    bool counted = pulse_record_wakeup(now2);
-                    ESP_LOGI(TAG, "EXT1 wake on pulse GPIO%d (status=0x%" PRIx64 "): %s",
-                             CONFIG_PULSE_GPIO, (uint64_t)ext1_status, counted ? "counted" : "ignored");
+                int64_t wake_us = esp_timer_get_time();
+                for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+                    app_channel_t *ch = &s_channels[i];
+                    if (!(ext1_status & (1ULL << ch->cfg.gpio_num))) {
+                        continue;
+                    }
+                    bool counted = pulse_record_wakeup(&ch->pulse, wake_us);
+#if CONFIG_SLEEP_WAKE_LOG
+                    APP_LOGI(EXT1_PULSE_WAKE, ch->cfg.gpio_num, counted ? "counted" : "ignored");
+#else
+                    (void)counted;
+#endif
                 }
             }
         }
@@ -1276,6 +2580,77 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
     }
 }
 
+/* Simple Metering server of one channel, backed by the channel's attribute storage. */
+static esp_zb_attribute_list_t *app_zigbee_create_metering_cluster(app_channel_t *ch)
+{
+    esp_zb_attribute_list_t *metering_attr_list = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_METERING);
+    ch->attr_summation = app_to_uint48(metering_get_summation(&ch->meter));
+    ch->attr_unit = ch->cfg.unit_of_measure;
+    ch->attr_summation_formatting = metering_get_summation_formatting(&ch->meter);
+    ch->attr_demand_formatting = metering_get_demand_formatting(&ch->meter);
+    ch->attr_device_type = ch->cfg.metering_device_type;
+    ch->attr_multiplier = app_to_uint24(metering_get_multiplier(&ch->meter));
+    ch->attr_divisor = app_to_uint24(metering_get_divisor(&ch->meter));
+    ch->attr_demand = app_to_int24(0);
+
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_U48,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                            &ch->attr_summation);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            ESP_ZB_ZCL_ATTR_METERING_UNIT_OF_MEASURE_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                            &ch->attr_unit);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            ESP_ZB_ZCL_ATTR_METERING_SUMMATION_FORMATTING_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_8BITMAP,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                            &ch->attr_summation_formatting);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            ESP_ZB_ZCL_ATTR_METERING_DEMAND_FORMATTING_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_8BITMAP,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                            &ch->attr_demand_formatting);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            ESP_ZB_ZCL_ATTR_METERING_METERING_DEVICE_TYPE_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+                            &ch->attr_device_type);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            ESP_ZB_ZCL_ATTR_METERING_MULTIPLIER_ID, ESP_ZB_ZCL_ATTR_TYPE_U24,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &ch->attr_multiplier);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            ESP_ZB_ZCL_ATTR_METERING_DIVISOR_ID, ESP_ZB_ZCL_ATTR_TYPE_U24,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &ch->attr_divisor);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID,
+                            ESP_ZB_ZCL_ATTR_TYPE_S24,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                            &ch->attr_demand);
+#if CONFIG_METERING_HISTORY
+    /* Historical consumption, in summation units; set once the Time cluster was synced. */
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            APP_METERING_ATTR_CURRENT_DAY_DELIVERED, ESP_ZB_ZCL_ATTR_TYPE_U24,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                            &ch->attr_day_current);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            APP_METERING_ATTR_PREVIOUS_DAY_DELIVERED, ESP_ZB_ZCL_ATTR_TYPE_U24,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                            &ch->attr_day_previous);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            APP_METERING_ATTR_CURRENT_WEEK_DELIVERED, ESP_ZB_ZCL_ATTR_TYPE_U24,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                            &ch->attr_week_current);
+    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                            APP_METERING_ATTR_PREVIOUS_WEEK_DELIVERED, ESP_ZB_ZCL_ATTR_TYPE_U24,
+                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
+                            &ch->attr_week_previous);
+#endif
+    return metering_attr_list;
+}
+
 static void app_zigbee_init(void)
 {
     esp_zb_platform_config_t platform_config = {0};
@@ -1283,6 +2658,14 @@ static void app_zigbee_init(void)
     platform_config.host_config.host_connection_mode = ZB_HOST_CONNECTION_MODE_NONE;
     esp_zb_platform_config(&platform_config);
 
+#if CONFIG_ZB_SED_TABLE_SIZES
+    /* Must precede esp_zb_init(); the stack allocates its tables there. */
+    esp_zb_overall_network_size_set(CONFIG_ZB_NWK_TABLE_SIZE);
+    esp_zb_io_buffer_size_set(CONFIG_ZB_IO_BUFFER_SIZE);
+    esp_zb_scheduler_queue_size_set(CONFIG_ZB_SCHED_QUEUE_SIZE);
+    esp_zb_aps_src_binding_table_size_set(CONFIG_ZB_BINDING_TABLE_SIZE);
+    esp_zb_aps_dst_binding_table_size_set(CONFIG_ZB_BINDING_TABLE_SIZE);
+#endif
     esp_zb_cfg_t zb_nwk_cfg = {
         .esp_zb_role = ESP_ZB_DEVICE_TYPE_ED,
         .nwk_cfg = {
@@ -1356,53 +2739,6 @@ static void app_zigbee_init(void)
                             ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
                             &s_attr_battery_percent);
 
-    esp_zb_attribute_list_t *metering_attr_list = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_METERING);
-    s_attr_summation = app_to_uint48(metering_get_summation());
-    s_attr_unit = s_cfg.unit_of_measure;
-    s_attr_summation_formatting = metering_get_summation_formatting();
-    s_attr_demand_formatting = metering_get_demand_formatting();
-    s_attr_device_type = s_cfg.metering_device_type;
-    s_attr_multiplier = app_to_uint24(metering_get_multiplier());
-    s_attr_divisor = app_to_uint24(metering_get_divisor());
-    s_attr_demand = app_to_int24(0);
-
-    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                            ESP_ZB_ZCL_ATTR_METERING_CURRENT_SUMMATION_DELIVERED_ID,
-                            ESP_ZB_ZCL_ATTR_TYPE_U48,
-                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
-                            &s_attr_summation);
-    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                            ESP_ZB_ZCL_ATTR_METERING_UNIT_OF_MEASURE_ID,
-                            ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM,
-                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
-                            &s_attr_unit);
-    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                            ESP_ZB_ZCL_ATTR_METERING_SUMMATION_FORMATTING_ID,
-                            ESP_ZB_ZCL_ATTR_TYPE_8BITMAP,
-                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
-                            &s_attr_summation_formatting);
-    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                            ESP_ZB_ZCL_ATTR_METERING_DEMAND_FORMATTING_ID,
-                            ESP_ZB_ZCL_ATTR_TYPE_8BITMAP,
-                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
-                            &s_attr_demand_formatting);
-    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                            ESP_ZB_ZCL_ATTR_METERING_METERING_DEVICE_TYPE_ID,
-                            ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM,
-                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY,
-                            &s_attr_device_type);
-    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                            ESP_ZB_ZCL_ATTR_METERING_MULTIPLIER_ID, ESP_ZB_ZCL_ATTR_TYPE_U24,
-                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &s_attr_multiplier);
-    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                            ESP_ZB_ZCL_ATTR_METERING_DIVISOR_ID, ESP_ZB_ZCL_ATTR_TYPE_U24,
-                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &s_attr_divisor);
-    esp_zb_cluster_add_attr(metering_attr_list, ESP_ZB_ZCL_CLUSTER_ID_METERING,
-                            ESP_ZB_ZCL_ATTR_METERING_INSTANTANEOUS_DEMAND_ID,
-                            ESP_ZB_ZCL_ATTR_TYPE_S24,
-                            ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING,
-                            &s_attr_demand);
-
     esp_zb_ieee_addr_t ota_server_id = ESP_ZB_ZCL_OTA_UPGRADE_SERVER_DEF_VALUE;
     esp_zb_ota_cluster_cfg_t ota_cfg = {
         .ota_upgrade_file_version = CONFIG_ZB_OTA_FILE_VERSION,
@@ -1437,9 +2773,13 @@ static void app_zigbee_init(void)
 
     esp_zb_cluster_list_add_basic_cluster(cluster_list, basic_attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
     esp_zb_cluster_list_add_power_config_cluster(cluster_list, power_attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
-    esp_zb_cluster_list_add_metering_cluster(cluster_list, metering_attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+    esp_zb_cluster_list_add_metering_cluster(cluster_list, app_zigbee_create_metering_cluster(&s_channels[0]),
+                                             ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
     esp_zb_cluster_list_add_ota_cluster(cluster_list, ota_attr_list, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE);
-    config_cluster_add(cluster_list, &s_cfg);
+#if CONFIG_METERING_HISTORY
+    esp_zb_cluster_list_add_time_cluster(cluster_list, esp_zb_time_cluster_create(NULL), ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE);
+#endif
+    config_cluster_add(cluster_list, &s_channels[0].cfg);
 
     esp_zb_ep_list_t *ep_list = esp_zb_ep_list_create();
     esp_zb_endpoint_config_t endpoint_cfg = {
@@ -1449,8 +2789,23 @@ static void app_zigbee_init(void)
         .app_device_version = 0,
     };
     esp_zb_ep_list_add_ep(ep_list, cluster_list, endpoint_cfg);
+    /* Further channels: a bare Simple Metering endpoint each; device-wide clusters stay on the first. */
+    for (size_t i = 1; i < CONFIG_PULSE_CHANNELS; i++) {
+        esp_zb_cluster_list_t *ch_clusters = esp_zb_zcl_cluster_list_create();
+        esp_zb_cluster_list_add_metering_cluster(ch_clusters, app_zigbee_create_metering_cluster(&s_channels[i]),
+                                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+        endpoint_cfg.endpoint = s_channels[i].endpoint;
+        esp_zb_ep_list_add_ep(ep_list, ch_clusters, endpoint_cfg);
+    }
 
     esp_zb_device_register(ep_list);
+#if CONFIG_METERING_HISTORY
+    /* Deliver Get Profile to the app; the stack has no handler for it. */
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        esp_zb_zcl_add_privilege_command(s_channels[i].endpoint, ESP_ZB_ZCL_CLUSTER_ID_METERING,
+                                         APP_METERING_CMD_GET_PROFILE);
+    }
+#endif
 
     ota_init();
     config_cluster_register_callbacks();
@@ -1460,7 +2815,11 @@ static void app_zigbee_init(void)
 
 static void zigbee_task(void *arg)
 {
+    (void)arg;
     app_zigbee_init();
+#if CONFIG_DEEP_SLEEP_MODE
+    app_deep_sleep_limit_channels();
+#endif
 
     /* Startup factory reset: hold the button during boot. */
 #if CONFIG_FACTORY_RESET_BUTTON_GPIO >= 0
@@ -1485,16 +2844,19 @@ static void zigbee_task(void *arg)
 
     esp_zb_core_action_handler_register(app_core_action_handler);
     esp_zb_zcl_command_send_status_handler_register(app_zcl_send_status_cb);
-    ESP_LOGI(TAG, "Starting Zigbee stack (autostart=true)");
+    APP_LOGI(ZB_STACK_START);
     esp_zb_start(true);
 
     power_status_t initial_power = {0};
     power_read_status(&initial_power);
+    app_apply_battery_model(&initial_power);
     app_log_power_status(&initial_power, "Startup");
     app_update_sleep_policy();
     app_zigbee_update_power_attrs(&initial_power);
-    app_zigbee_update_metering_attrs_static();
-    app_zigbee_update_metering_attrs_dynamic();
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_zigbee_update_metering_attrs_static(&s_channels[i]);
+        app_zigbee_update_metering_attrs_dynamic(&s_channels[i]);
+    }
 
     while (true) {
         app_factory_reset_button_service();
@@ -1503,54 +2865,96 @@ static void zigbee_task(void *arg)
             app_handle_factory_reset_request("button long press");
         }
 
+        app_attr_flush();
         esp_zb_stack_main_loop_iteration();
 
         ulTaskNotifyTake(pdTRUE, 0);
+#if CONFIG_METERING_HISTORY
+        /* Before the pulses so a batch that woke us after midnight lands in the new day. */
+        app_calendar_service(esp_timer_get_time());
+#endif
         app_handle_pending_pulses();
+#if CONFIG_DEEP_SLEEP_MODE
+        app_deep_sleep_service();
+#endif
+        tlog_drain();
 
         app_event_t evt;
         while (xQueueReceive(s_app_event_queue, &evt, 0) == pdTRUE) {
             if (evt.type == APP_EVENT_BATTERY) {
+                app_apply_battery_model(&evt.power);
                 app_zigbee_update_power_attrs(&evt.power);
             }
         }
 
         int64_t now = esp_timer_get_time();
-        if (s_total_dirty &&
-            ((now - s_last_save_us) >= (int64_t)APP_SAVE_INTERVAL_US ||
-             (metering_get_last_pulse_us() > 0 &&
-              (now - metering_get_last_pulse_us()) >= (int64_t)APP_SAVE_DEBOUNCE_US))) {
-            app_pulse_save_total(metering_get_total_pulses());
-            s_last_save_us = now;
-            s_total_dirty = false;
+        app_energy_tick(now);
+        if (now - s_last_energy_diag_us >= APP_ENERGY_DIAG_INTERVAL_US) {
+            app_update_energy_diag(now);
+            app_update_sleep_diag();
+            app_update_mem_diag();
+            app_report_queue_update_diag();
+            app_update_attr_shadow_diag();
+#if CONFIG_LEAK_DETECT
+            app_update_leak_diag(now);
+#endif
+            s_last_energy_diag_us = now;
+        }
+        for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+            app_channel_t *ch = &s_channels[i];
+            if (save_sched_due(&ch->save, now, metering_get_last_pulse_us(&ch->meter))) {
+                app_pulse_save_total(ch->index, metering_get_total_pulses(&ch->meter));
+                save_sched_done(&ch->save, now);
+            }
         }
 
+        app_report_queue_service(now);
+#if CONFIG_METERING_HISTORY
+        if (s_joined && now >= s_next_time_sync_us) {
+            app_time_sync_request(now);
+        }
+
+        if (now - s_last_profile_save_us >= APP_PROFILE_SAVE_INTERVAL_US) {
+            app_profile_save_now(now);
+        }
+#endif
+
         if (now - s_last_demand_check_us >= APP_DEMAND_IDLE_CHECK_US) {
             s_last_demand_check_us = now;
-            if (metering_tick(now)) {
-                app_zigbee_update_metering_attrs_dynamic();
+            for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+                if (metering_tick(&s_channels[i].meter, now)) {
+                    app_zigbee_update_metering_attrs_dynamic(&s_channels[i]);
+                }
             }
         }
+#if CONFIG_LEAK_DETECT
+        app_leak_service();
+#endif
 
         if (s_request_steer) {
             s_request_steer = false;
             app_log_commissioning_state("Retry steering");
-            ESP_LOGI(TAG, "Retrying network steering (attempt %u)", s_steer_retry_count);
+            APP_LOGI(STEERING_RETRY, s_steer_retry_count);
             app_start_network_steering("Retry steering");
         }
 
-        config_cluster_apply_pending(&s_cfg);
+        config_cluster_apply_pending(&s_channels[0].cfg);
         if (app_config_consume_reset_request()) {
-            ESP_LOGI(TAG, "Resetting metering and pulse counters");
-            metering_reset();
-            metering_set_instantaneous_demand(0);
-            pulse_set_total(0);
-            app_pulse_save_total(0);
-            s_total_dirty = false;
-            s_last_save_us = esp_timer_get_time();
-            app_zigbee_update_metering_attrs_dynamic();
+            APP_LOGI(COUNTERS_RESET);
+            for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+                app_channel_t *ch = &s_channels[i];
+                metering_reset(&ch->meter);
+                metering_set_instantaneous_demand(&ch->meter, 0);
+                app_pulse_save_total(ch->index, 0);
+                save_sched_done(&ch->save, esp_timer_get_time());
+                app_zigbee_update_metering_attrs_dynamic(ch);
+            }
+#if CONFIG_METERING_HISTORY
+            app_profile_save_now(esp_timer_get_time());
+#endif
             power_status_t current_power = {0};
             power_read_status(&current_power);
+            app_apply_battery_model(&current_power);
             app_zigbee_update_power_attrs(&current_power);
         }
 
@@ -1561,6 +2965,8 @@ static void zigbee_task(void *arg)
 
 void app_main(void)
 {
+    tlog_init();
+    evtrace_init();
     esp_err_t nvs_err = nvs_flash_init();
     if (nvs_err == ESP_ERR_NVS_NO_FREE_PAGES || nvs_err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW(TAG, "NVS init requires erase (%s), erasing...", esp_err_to_name(nvs_err));
@@ -1576,8 +2982,8 @@ void app_main(void)
      */
     esp_pm_config_t pm_cfg = {
         .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
-        /* Keep min same as max to avoid invalid values on this target; adjust via menuconfig if tested. */
-        .min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        /* Equal to max unless LOW_POWER_PROFILE lowers it to the XTAL frequency. */
+        .min_freq_mhz = CONFIG_PM_MIN_FREQ_MHZ,
         .light_sleep_enable = true,
     };
     esp_err_t pm_err = esp_pm_configure(&pm_cfg);
@@ -1586,31 +2992,128 @@ void app_main(void)
     }
 #endif
 
-    app_config_load(&s_cfg);
-    uint64_t total_pulses = 0;
-    app_pulse_load_total(&total_pulses);
+    energy_model_t energy_model = {
+        .current_ua = {
+            [ENERGY_STATE_SLEEP] = CONFIG_ENERGY_SLEEP_UA,
+            [ENERGY_STATE_AWAKE_IDLE] = CONFIG_ENERGY_AWAKE_IDLE_UA,
+            [ENERGY_STATE_CPU_BUSY] = CONFIG_ENERGY_CPU_BUSY_UA,
+            [ENERGY_STATE_RX] = CONFIG_ENERGY_RX_UA,
+            [ENERGY_STATE_TX] = CONFIG_ENERGY_TX_UA,
+            [ENERGY_STATE_ADC] = CONFIG_ENERGY_ADC_UA,
+            [ENERGY_STATE_FLASH] = CONFIG_ENERGY_FLASH_UA,
+        },
+    };
+    energy_init(&energy_model, esp_timer_get_time());
+    if (sleep_stats_restore(&s_sleep_stats_rtc)) {
+        APP_LOGI(SLEEP_STATS_RESTORED);
+    } else {
+        sleep_stats_reset();
+    }
+#if CONFIG_DEEP_SLEEP_MODE
+    deep_sleep_cfg_t deep_cfg = {
+        .report_pulses = CONFIG_DEEP_SLEEP_REPORT_PULSES,
+        .awake_max_us = (int64_t)CONFIG_DEEP_SLEEP_AWAKE_MAX_S * 1000000LL,
+    };
+    deep_sleep_init(&deep_cfg);
+    s_deep_resumed = esp_reset_reason() == ESP_RST_DEEPSLEEP && deep_sleep_restore(&s_deep_sleep_rtc);
+#endif
+#if CONFIG_ENERGY_CPU_STATS
+    s_last_idle_counter = ulTaskGetIdleRunTimeCounter();
+#endif
 
-    metering_init(&s_cfg, total_pulses);
-    ESP_LOGI(TAG, "Meter scaling: pulses_per_unit=%" PRIu32 " divisor=%" PRIu32 " multiplier=%" PRIu32,
-             s_cfg.pulse_per_unit_numerator, metering_get_divisor(), metering_get_multiplier());
-    s_app_event_queue = xQueueCreate(APP_EVENT_QUEUE_LEN, sizeof(app_event_t));
+#if CONFIG_BATTERY_SOC_LIFEPO4_COULOMB
+    battery_soc_cfg_t soc_cfg = {
+        .capacity_mah = CONFIG_BATTERY_CAPACITY_MAH,
+        .cells = CONFIG_BATTERY_CELLS_SERIES,
+        .curve = battery_soc_lifepo4_curve,
+        .curve_len = battery_soc_lifepo4_curve_len,
+        .plateau_lo_pct = 20,
+        .plateau_hi_pct = 90,
+    };
+    int64_t soc_uah = -1;
+    if (!app_soc_load(&soc_uah)) {
+        soc_uah = -1;
+    }
+    battery_soc_init(&soc_cfg, soc_uah);
+    s_last_soc_save_us = esp_timer_get_time();
+#endif
 
-    pulse_config_t pulse_cfg = {
-        .gpio_num = CONFIG_PULSE_GPIO,
-        .debounce_ms = s_cfg.debounce_ms,
-        .min_width_ms = CONFIG_PULSE_MIN_WIDTH_MS,
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_channel_t *ch = &s_channels[i];
+        uint64_t total_pulses = 0;
+        ch->index = (uint8_t)i;
+        ch->endpoint = (uint8_t)(APP_ZB_ENDPOINT + i);
+        app_attr_shadow_register_channel(ch);
+        app_config_load(ch->index, &ch->cfg);
+        app_pulse_load_total(ch->index, &total_pulses);
+#if CONFIG_DEEP_SLEEP_MODE
+        if (s_deep_resumed) {
+            /* NVS is written on radio wakes only; RTC memory has the newer total. */
+            total_pulses = deep_sleep_get()->total[i];
+        }
+#endif
+        pulse_counter_init(&ch->counter, total_pulses);
+        metering_init(&ch->meter, &ch->cfg, &ch->counter);
+#if CONFIG_METERING_HISTORY
+        if (app_profile_load(ch->index, &s_profile_blob, sizeof(s_profile_blob))) {
+            metering_profile_import(&ch->meter, &s_profile_blob, esp_timer_get_time());
+        }
+#endif
+        APP_LOGI(METER_SCALING, (unsigned)ch->index, ch->cfg.gpio_num, ch->cfg.pulse_per_unit_numerator,
+                 metering_get_divisor(&ch->meter), metering_get_multiplier(&ch->meter));
+    }
+    app_check_pulse_gpios();
+    app_attr_shadow_register_device();
+    report_queue_config_t rq_cfg = {
+        .fail_limit = CONFIG_REPORT_QUEUE_FAIL_LIMIT,
+        .probe_s = CONFIG_REPORT_QUEUE_PROBE_S,
+        .probe_max_s = CONFIG_REPORT_QUEUE_PROBE_MAX_S,
+        .sample_min_s = CONFIG_ZB_REPORT_MIN_S,
+        .sample_max_s = CONFIG_ZB_REPORT_MAX_S,
     };
-    ESP_ERROR_CHECK(pulse_init(&pulse_cfg, NULL, NULL, total_pulses));
+    report_queue_init(&rq_cfg);
+#if CONFIG_METERING_HISTORY
+    s_last_profile_save_us = esp_timer_get_time();
+#endif
+    s_app_event_queue = xQueueCreateStatic(APP_EVENT_QUEUE_LEN, sizeof(app_event_t), s_app_event_queue_storage,
+                                           &s_app_event_queue_buf);
+
+#if CONFIG_PULSE_LP_CORE
+    pulse_config_t lp_cfgs[CONFIG_PULSE_CHANNELS];
+#endif
+    for (size_t i = 0; i < CONFIG_PULSE_CHANNELS; i++) {
+        app_channel_t *ch = &s_channels[i];
+        pulse_config_t pulse_cfg = {
+            .gpio_num = ch->cfg.gpio_num,
+            .debounce_ms = ch->cfg.debounce_ms,
+            .min_width_ms = CONFIG_PULSE_MIN_WIDTH_MS,
+        };
+        ESP_ERROR_CHECK(pulse_init(&ch->pulse, &pulse_cfg, NULL, NULL, &ch->counter));
+        save_sched_init(&ch->save, APP_SAVE_INTERVAL_US, APP_SAVE_QUIET_US, esp_timer_get_time());
+#if CONFIG_PULSE_LP_CORE
+        lp_cfgs[i] = pulse_cfg;
+#endif
+    }
+#if CONFIG_PULSE_LP_CORE
+    /* Light sleep reports every pulse; deep sleep lets the LP core batch them. */
+    uint32_t lp_wake_pulses = CONFIG_DEEP_SLEEP_MODE ? CONFIG_DEEP_SLEEP_REPORT_PULSES : 1;
+    ESP_ERROR_CHECK(pulse_lp_start(lp_cfgs, CONFIG_PULSE_CHANNELS, lp_wake_pulses,
+                                   esp_reset_reason() == ESP_RST_DEEPSLEEP));
+#endif
 
     power_init();
+#if CONFIG_PULSE_SOURCE_OPTICAL
+    app_optical_start();
+#endif
     app_factory_reset_button_init();
 
     app_configure_light_sleep_wakeup_sources();
+#if CONFIG_DEEP_SLEEP_MODE
+    app_deep_sleep_boot();
+#endif
 
     s_last_battery_percent = 0xFF;
-    s_last_battery_voltage = 0xFF;
     s_last_demand_check_us = 0;
-    s_last_save_us = esp_timer_get_time();
 
     esp_timer_create_args_t retry_timer_args = {
         .callback = app_steer_retry_timer_cb,
@@ -1624,9 +3127,10 @@ void app_main(void)
         ESP_LOGW(TAG, "power_start_monitor failed: %s", esp_err_to_name(mon_err));
     }
 #else
-    ESP_LOGI(TAG, "Battery monitoring disabled (CONFIG_BATTERY_ADC_ENABLE=n)");
+    APP_LOGI(BATTERY_DISABLED);
 #endif
 
-    xTaskCreate(zigbee_task, "zigbee_task", 6144, NULL, 5, &s_zigbee_task_handle);
+    s_zigbee_task_handle = xTaskCreateStatic(zigbee_task, "zigbee_task", CONFIG_ZIGBEE_TASK_STACK_SIZE, NULL, 5,
+                                             s_zigbee_task_stack, &s_zigbee_task_tcb);
     pulse_set_consumer_task(s_zigbee_task_handle);
 }
@@ -6,17 +6,29 @@
 #ifndef CONFIG_DEMAND_IDLE_TIMEOUT_S
 #define CONFIG_DEMAND_IDLE_TIMEOUT_S 0
 #endif
+#ifndef CONFIG_DEMAND_WINDOW_S
+#define CONFIG_DEMAND_WINDOW_S 300
+#endif
+#ifndef CONFIG_LEAK_IDLE_GAP_MIN
+#define CONFIG_LEAK_IDLE_GAP_MIN 60
+#endif
+#ifndef CONFIG_LEAK_CONTINUOUS_H
+#define CONFIG_LEAK_CONTINUOUS_H 6
+#endif
+#ifndef CONFIG_LEAK_BURST_PULSES
+#define CONFIG_LEAK_BURST_PULSES 0
+#endif
+
+#define METERING_PROFILE_VERSION 2
+#define METERING_PROFILE_INTERVAL_US ((int64_t)CONFIG_METERING_PROFILE_INTERVAL_MIN * 60LL * 1000000LL)
+
+#define METERING_DAY_S 86400u
+/* 2000-01-01 was a Saturday; shift so weeks start on Monday. */
+#define METERING_WEEK_DAY_SHIFT 5u
 
-static app_metering_cfg_t s_cfg;
-static uint64_t s_total_pulses;
-static uint8_t s_summation_formatting;
-static uint8_t s_demand_formatting;
-static uint32_t s_multiplier = 1;
-static uint32_t s_divisor = 1;
-static int32_t s_instantaneous_demand;
-static int64_t s_last_pulse_us;
-static double s_rate_est_ph;
-static int64_t s_rate_last_update_us;
+#define LEAK_HOUR_US (3600LL * 1000000LL)
+#define LEAK_IDLE_GAP_US ((int64_t)CONFIG_LEAK_IDLE_GAP_MIN * 60LL * 1000000LL)
+#define LEAK_CONTINUOUS_US ((int64_t)CONFIG_LEAK_CONTINUOUS_H * LEAK_HOUR_US)
 
 static int32_t clamp_demand_int24(int32_t value)
 {
@@ -40,6 +52,7 @@ static uint32_t clamp_divisor(uint32_t v)
     return v;
 }
 
+#if !CONFIG_DEMAND_ESTIMATOR_WINDOW
 static double decay_mul(double dt_s, double tau_s)
 {
     if (tau_s <= 0.0 || dt_s <= 0.0) {
@@ -47,6 +60,7 @@ static double decay_mul(double dt_s, double tau_s)
     }
     return exp(-dt_s / tau_s);
 }
+#endif
 
 static uint8_t calc_digits_right(uint32_t divisor)
 {
@@ -77,57 +91,333 @@ static uint64_t calc_summation(uint64_t total_pulses)
     return total_pulses;
 }
 
-static void update_scaling(const app_metering_cfg_t *cfg)
+static void update_scaling(metering_t *m, const app_metering_cfg_t *cfg)
+{
+    m->multiplier = 1;
+    m->divisor = clamp_divisor(cfg->pulse_per_unit_numerator);
+}
+
+#if CONFIG_METERING_HISTORY
+static void profile_push(metering_t *m, uint32_t value)
+{
+    m->profile[m->profile_head] = value;
+    m->profile_head = (uint16_t)((m->profile_head + 1) % CONFIG_METERING_PROFILE_PERIODS);
+    if (m->profile_count < CONFIG_METERING_PROFILE_PERIODS) {
+        m->profile_count++;
+    }
+}
+
+/* Close every interval that ended at or before now_us; idle intervals are stored as 0. */
+static void profile_roll(metering_t *m, int64_t now_us)
+{
+    if (m->profile_open_start_us < 0) {
+        m->profile_open_start_us = now_us;
+        return;
+    }
+    int64_t elapsed = now_us - m->profile_open_start_us;
+    if (elapsed < METERING_PROFILE_INTERVAL_US) {
+        return;
+    }
+    int64_t closed = elapsed / METERING_PROFILE_INTERVAL_US;
+    profile_push(m, m->profile_open);
+    m->profile_open = 0;
+    for (int64_t i = 1; i < closed && i <= CONFIG_METERING_PROFILE_PERIODS; i++) {
+        profile_push(m, 0);
+    }
+    m->profile_open_start_us += closed * METERING_PROFILE_INTERVAL_US;
+}
+
+static void profile_add(metering_t *m, uint32_t count)
+{
+    m->profile_open = (UINT32_MAX - m->profile_open < count) ? UINT32_MAX : m->profile_open + count;
+}
+
+static void profile_clear(metering_t *m)
+{
+    memset(m->profile, 0, sizeof(m->profile));
+    m->profile_head = 0;
+    m->profile_count = 0;
+    m->profile_open = 0;
+    m->profile_open_start_us = -1;
+}
+#else
+static void profile_roll(metering_t *m, int64_t now_us)
+{
+    (void)m;
+    (void)now_us;
+}
+
+static void profile_add(metering_t *m, uint32_t count)
+{
+    (void)m;
+    (void)count;
+}
+
+static void profile_clear(metering_t *m)
+{
+    (void)m;
+}
+#endif
+
+static void leak_clear(metering_t *m)
+{
+#if CONFIG_LEAK_DETECT
+    memset(m->leak_gap_s, 0, sizeof(m->leak_gap_s));
+    for (int i = 0; i < METERING_LEAK_WINDOW_HOURS; i++) {
+        m->leak_gap_hour[i] = -1;
+    }
+    m->leak_since_us = -1;
+    m->leak_last_us = -1;
+    m->leak_run_start_us = -1;
+    m->leak_run_pulses = 0;
+    m->leak_alarms = 0;
+#else
+    (void)m;
+#endif
+}
+
+#if CONFIG_LEAK_DETECT
+static void leak_note_gap(metering_t *m, int64_t end_us, int64_t gap_us)
+{
+    int64_t hour = end_us / LEAK_HOUR_US;
+    int slot = (int)(hour % METERING_LEAK_WINDOW_HOURS);
+    uint32_t gap_s = gap_us / 1000000LL > UINT32_MAX ? UINT32_MAX : (uint32_t)(gap_us / 1000000LL);
+    if (m->leak_gap_hour[slot] != hour) {
+        m->leak_gap_hour[slot] = hour;
+        m->leak_gap_s[slot] = 0;
+    }
+    if (gap_s > m->leak_gap_s[slot]) {
+        m->leak_gap_s[slot] = gap_s;
+    }
+}
+
+static uint32_t leak_longest_idle_s(const metering_t *m, int64_t now_us)
+{
+    int64_t hour = now_us / LEAK_HOUR_US;
+    uint32_t longest = 0;
+    for (int i = 0; i < METERING_LEAK_WINDOW_HOURS; i++) {
+        if (m->leak_gap_hour[i] > hour - METERING_LEAK_WINDOW_HOURS && m->leak_gap_s[i] > longest) {
+            longest = m->leak_gap_s[i];
+        }
+    }
+    /* The gap still running counts too. */
+    int64_t from = m->leak_last_us >= 0 ? m->leak_last_us : m->leak_since_us;
+    if (from >= 0 && (uint64_t)(now_us - from) / 1000000ULL > longest) {
+        longest = (uint32_t)((now_us - from) / 1000000LL);
+    }
+    return longest;
+}
+#endif
+
+static void leak_evaluate(metering_t *m, int64_t now_us)
 {
-    s_multiplier = 1;
-    s_divisor = clamp_divisor(cfg->pulse_per_unit_numerator);
+#if CONFIG_LEAK_DETECT
+    if (m->leak_since_us < 0) {
+        m->leak_since_us = now_us;
+    }
+    uint8_t alarms = 0;
+    bool flowing = m->leak_last_us >= 0 && (now_us - m->leak_last_us) < LEAK_IDLE_GAP_US;
+    if (now_us - m->leak_since_us >= METERING_LEAK_WINDOW_HOURS * LEAK_HOUR_US &&
+        (int64_t)leak_longest_idle_s(m, now_us) * 1000000LL < LEAK_IDLE_GAP_US) {
+        alarms |= METERING_LEAK_NO_IDLE;
+    }
+    if (flowing && m->leak_run_start_us >= 0) {
+        if (CONFIG_LEAK_CONTINUOUS_H > 0 && m->leak_last_us - m->leak_run_start_us >= LEAK_CONTINUOUS_US) {
+            alarms |= METERING_LEAK_CONTINUOUS;
+        }
+        if (CONFIG_LEAK_BURST_PULSES > 0 && m->leak_run_pulses >= CONFIG_LEAK_BURST_PULSES) {
+            alarms |= METERING_LEAK_BURST;
+        }
+    }
+    m->leak_alarms = alarms;
+#else
+    (void)m;
+    (void)now_us;
+#endif
 }
 
-void metering_init(const app_metering_cfg_t *cfg, uint64_t total_pulses)
+/* A batch of pulses ending at last_us; prev_us (if known) bounds the gap before the batch. */
+static void leak_on_pulses(metering_t *m, uint32_t count, int64_t last_us, int64_t prev_us)
 {
-    memcpy(&s_cfg, cfg, sizeof(s_cfg));
-    s_total_pulses = total_pulses;
-    s_summation_formatting = calc_summation_formatting(cfg);
-    s_demand_formatting = calc_demand_formatting(cfg);
-    update_scaling(cfg);
-    s_instantaneous_demand = 0;
-    s_last_pulse_us = 0;
-    s_rate_est_ph = 0.0;
-    s_rate_last_update_us = 0;
+#if CONFIG_LEAK_DETECT
+    if (m->leak_since_us < 0) {
+        m->leak_since_us = last_us;
+    }
+    int64_t first_us = (count > 1 && prev_us > 0) ? prev_us : last_us;
+    if (m->leak_last_us >= 0 && first_us > m->leak_last_us) {
+        int64_t gap_us = first_us - m->leak_last_us;
+        leak_note_gap(m, first_us, gap_us);
+        if (gap_us >= LEAK_IDLE_GAP_US) {
+            m->leak_run_start_us = -1;   /* a real pause: the flow run starts over */
+        }
+    }
+    if (m->leak_run_start_us < 0) {
+        m->leak_run_start_us = first_us;
+        m->leak_run_pulses = 0;
+    }
+    m->leak_run_pulses = (UINT32_MAX - m->leak_run_pulses < count) ? UINT32_MAX : m->leak_run_pulses + count;
+    m->leak_last_us = last_us;
+    leak_evaluate(m, last_us);
+#else
+    (void)m;
+    (void)count;
+    (void)last_us;
+    (void)prev_us;
+#endif
 }
 
-bool metering_tick(int64_t now_us)
+#if CONFIG_DEMAND_ESTIMATOR_WINDOW
+static void demand_window_clear(metering_t *m)
 {
-    if (s_rate_last_update_us == 0) {
-        s_rate_last_update_us = now_us;
+    m->demand_pulses = 0;
+    m->demand_head = 0;
+    m->demand_count = 0;
+    m->demand_fit_pulse_us = 0;
+}
+
+static void demand_window_push(metering_t *m, int64_t t_us, uint32_t n)
+{
+    m->demand_t_us[m->demand_head] = t_us;
+    m->demand_n[m->demand_head] = n;
+    m->demand_head = (uint8_t)((m->demand_head + 1) % CONFIG_DEMAND_WINDOW_PULSES);
+    if (m->demand_count < CONFIG_DEMAND_WINDOW_PULSES) {
+        m->demand_count++;
+    }
+}
+
+static int64_t demand_window_newest_us(const metering_t *m)
+{
+    if (m->demand_count == 0) {
+        return 0;
+    }
+    return m->demand_t_us[(m->demand_head + CONFIG_DEMAND_WINDOW_PULSES - 1) % CONFIG_DEMAND_WINDOW_PULSES];
+}
+
+static void demand_window_on_pulses(metering_t *m, uint32_t count, int64_t last_us, int64_t prev_us)
+{
+    /* A batch only carries its last two times; the earlier pulses of it are not placed. */
+    if (count >= 2 && prev_us > demand_window_newest_us(m)) {
+        demand_window_push(m, prev_us, m->demand_pulses + count - 1u);
+    }
+    m->demand_pulses += count;
+    demand_window_push(m, last_us, m->demand_pulses);
+}
+
+/* Pulses per hour at now_us: least-squares slope of pulse number over time for the pulses
+ * within the window (at least the newest two), capped at one pulse per time since the last.
+ */
+static double demand_window_rate_ph(const metering_t *m, int64_t now_us)
+{
+    if (m->demand_count < 2) {
+        return 0.0;
+    }
+
+    size_t newest = (m->demand_head + CONFIG_DEMAND_WINDOW_PULSES - 1) % CONFIG_DEMAND_WINDOW_PULSES;
+    int64_t t0 = m->demand_t_us[newest];
+    uint32_t n0 = m->demand_n[newest];
+    int64_t window_start = now_us - (int64_t)CONFIG_DEMAND_WINDOW_S * 1000000LL;
+
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < m->demand_count; i++) {
+        size_t idx = (newest + CONFIG_DEMAND_WINDOW_PULSES - i) % CONFIG_DEMAND_WINDOW_PULSES;
+        if (used >= 2 && m->demand_t_us[idx] < window_start) {
+            break;
+        }
+        /* Relative to the newest point to keep the sums well conditioned. */
+        double x = (double)(m->demand_t_us[idx] - t0) / 1000000.0;
+        double y = -(double)(uint32_t)(n0 - m->demand_n[idx]);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        used++;
+    }
+
+    double denom = (double)used * sxx - sx * sx;
+    if (denom <= 0.0) {
+        return 0.0;
+    }
+    double rate_ph = ((double)used * sxy - sx * sy) / denom * 3600.0;
+    if (rate_ph < 0.0) {
+        rate_ph = 0.0;
+    }
+
+    double since_s = (double)(now_us - t0) / 1000000.0;
+    if (since_s > 0.0 && rate_ph > 3600.0 / since_s) {
+        rate_ph = 3600.0 / since_s;
+    }
+    return rate_ph;
+}
+#else
+static void demand_window_clear(metering_t *m)
+{
+    (void)m;
+}
+#endif
+
+void metering_init(metering_t *m, const app_metering_cfg_t *cfg, pulse_counter_t *counter)
+{
+    memcpy(&m->cfg, cfg, sizeof(m->cfg));
+    m->counter = counter;
+    m->summation_formatting = calc_summation_formatting(cfg);
+    m->demand_formatting = calc_demand_formatting(cfg);
+    update_scaling(m, cfg);
+    m->instantaneous_demand = 0;
+    m->last_pulse_us = 0;
+    m->rate_est_ph = 0.0;
+    m->rate_last_update_us = 0;
+    demand_window_clear(m);
+    profile_clear(m);
+    memset(&m->calendar, 0, sizeof(m->calendar));
+    leak_clear(m);
+}
+
+bool metering_tick(metering_t *m, int64_t now_us)
+{
+    profile_roll(m, now_us);
+    leak_evaluate(m, now_us);
+    if (m->rate_last_update_us == 0) {
+        m->rate_last_update_us = now_us;
         return false;
     }
 
-#if CONFIG_DEMAND_IDLE_TIMEOUT_S > 0
-    if (s_last_pulse_us > 0 &&
-        (now_us - s_last_pulse_us) >= ((int64_t)CONFIG_DEMAND_IDLE_TIMEOUT_S * 1000000LL)) {
-        bool changed = (s_instantaneous_demand != 0);
-        s_rate_est_ph = 0.0;
-        s_instantaneous_demand = 0;
-        s_rate_last_update_us = now_us;
+#if CONFIG_DEMAND_IDLE_TIMEOUT_S > 0 && !CONFIG_DEMAND_ESTIMATOR_WINDOW
+    if (m->last_pulse_us > 0 &&
+        (now_us - m->last_pulse_us) >= ((int64_t)CONFIG_DEMAND_IDLE_TIMEOUT_S * 1000000LL)) {
+        bool changed = (m->instantaneous_demand != 0);
+        m->rate_est_ph = 0.0;
+        m->instantaneous_demand = 0;
+        m->rate_last_update_us = now_us;
         return changed;
     }
 #endif
 
-    double dt_s = (double)(now_us - s_rate_last_update_us) / 1000000.0;
+#if CONFIG_DEMAND_ESTIMATOR_WINDOW
+    /* Pulses leaving the window can steepen the fit; without a new pulse demand only falls. */
+    double rate_ph = demand_window_rate_ph(m, now_us);
+    if (m->last_pulse_us == m->demand_fit_pulse_us && rate_ph > m->rate_est_ph) {
+        rate_ph = m->rate_est_ph;
+    }
+    m->rate_est_ph = rate_ph;
+    m->demand_fit_pulse_us = m->last_pulse_us;
+#else
+    double dt_s = (double)(now_us - m->rate_last_update_us) / 1000000.0;
     if (dt_s <= 0.0) {
         return false;
     }
 
-    s_rate_est_ph *= decay_mul(dt_s, CONFIG_DEMAND_DECAY_TAU_S);
-    int32_t new_demand = clamp_demand_int24((int32_t)llround(s_rate_est_ph));
-    bool changed = (new_demand != s_instantaneous_demand);
-    s_instantaneous_demand = new_demand;
-    s_rate_last_update_us = now_us;
+    m->rate_est_ph *= decay_mul(dt_s, CONFIG_DEMAND_DECAY_TAU_S);
+#endif
+    int32_t new_demand = clamp_demand_int24((int32_t)llround(m->rate_est_ph));
+    bool changed = (new_demand != m->instantaneous_demand);
+    m->instantaneous_demand = new_demand;
+    m->rate_last_update_us = now_us;
     return changed;
 }
 
-static void update_instantaneous_demand(int64_t last_us, int64_t prev_us)
+#if !CONFIG_DEMAND_ESTIMATOR_WINDOW
+static void update_instantaneous_demand(metering_t *m, int64_t last_us, int64_t prev_us)
 {
     if (prev_us > 0 && last_us > prev_us) {
         int64_t dt_us = last_us - prev_us;
@@ -136,111 +426,292 @@ static void update_instantaneous_demand(int64_t last_us, int64_t prev_us)
             double demand_pulses_per_hour = (1.0 / dt_s) * 3600.0;
             double alpha = 1.0 - decay_mul(dt_s, CONFIG_DEMAND_RISE_TAU_S);
             double inst_ph = demand_pulses_per_hour;
-            s_rate_est_ph = s_rate_est_ph + alpha * (inst_ph - s_rate_est_ph);
-            if (s_rate_est_ph < 0.0) {
-                s_rate_est_ph = 0.0;
+            m->rate_est_ph = m->rate_est_ph + alpha * (inst_ph - m->rate_est_ph);
+            if (m->rate_est_ph < 0.0) {
+                m->rate_est_ph = 0.0;
             }
-            s_instantaneous_demand = clamp_demand_int24((int32_t)llround(s_rate_est_ph));
+            m->instantaneous_demand = clamp_demand_int24((int32_t)llround(m->rate_est_ph));
         }
     }
 }
+#endif
 
-void metering_on_pulses(uint32_t count, int64_t last_us, int64_t prev_us)
+void metering_on_pulses(metering_t *m, uint32_t count, int64_t last_us, int64_t prev_us)
 {
     if (count == 0) {
         return;
     }
 
-    if (UINT64_MAX - s_total_pulses < count) {
-        s_total_pulses = UINT64_MAX;
-    } else {
-        s_total_pulses += count;
+    if (last_us > 0) {
+        profile_roll(m, last_us);
+    }
+    profile_add(m, count);
+    if (last_us > 0) {
+        leak_on_pulses(m, count, last_us, prev_us);
     }
 
     if (last_us > 0) {
+#if CONFIG_DEMAND_ESTIMATOR_WINDOW
+        m->last_pulse_us = last_us;
+        demand_window_on_pulses(m, count, last_us, prev_us);
+        metering_tick(m, last_us);
+#else
         /* Apply decay up to the timestamp of this pulse. */
-        metering_tick(last_us);
+        metering_tick(m, last_us);
         /* Demand needs real timing data; skip updates when we do not have two timestamps. */
         if (prev_us > 0) {
-            update_instantaneous_demand(last_us, prev_us);
+            update_instantaneous_demand(m, last_us, prev_us);
         }
-        s_last_pulse_us = last_us;
+        m->last_pulse_us = last_us;
+#endif
     }
 }
 
-void metering_on_pulse(int64_t now_us)
+void metering_set_config(metering_t *m, const app_metering_cfg_t *cfg)
 {
-    metering_on_pulses(1, now_us, s_last_pulse_us);
+    memcpy(&m->cfg, cfg, sizeof(m->cfg));
+    m->summation_formatting = calc_summation_formatting(cfg);
+    m->demand_formatting = calc_demand_formatting(cfg);
+    update_scaling(m, cfg);
 }
 
-void metering_set_config(const app_metering_cfg_t *cfg)
+uint64_t metering_get_total_pulses(const metering_t *m)
 {
-    memcpy(&s_cfg, cfg, sizeof(s_cfg));
-    s_summation_formatting = calc_summation_formatting(cfg);
-    s_demand_formatting = calc_demand_formatting(cfg);
-    update_scaling(cfg);
+    return pulse_counter_total(m->counter);
 }
 
-uint64_t metering_get_total_pulses(void)
+uint64_t metering_get_summation(const metering_t *m)
 {
-    return s_total_pulses;
+    return calc_summation(metering_get_total_pulses(m));
 }
 
-uint64_t metering_get_summation(void)
+void metering_reset(metering_t *m)
 {
-    return calc_summation(s_total_pulses);
+    pulse_counter_set_total(m->counter, 0);
+    m->calendar.day_start = 0;
+    m->calendar.week_start = 0;
+    m->calendar.prev_day = 0;
+    m->calendar.prev_week = 0;
+    m->instantaneous_demand = 0;
+    m->last_pulse_us = 0;
+    m->rate_est_ph = 0.0;
+    m->rate_last_update_us = 0;
+    demand_window_clear(m);
+    profile_clear(m);
+    leak_clear(m);
 }
 
-void metering_reset(void)
+uint8_t metering_get_unit_of_measure(const metering_t *m)
 {
-    s_total_pulses = 0;
-    s_instantaneous_demand = 0;
-    s_last_pulse_us = 0;
-    s_rate_est_ph = 0.0;
-    s_rate_last_update_us = 0;
+    return m->cfg.unit_of_measure;
 }
 
-uint8_t metering_get_unit_of_measure(void)
+uint8_t metering_get_device_type(const metering_t *m)
 {
-    return s_cfg.unit_of_measure;
+    return m->cfg.metering_device_type;
 }
 
-uint8_t metering_get_device_type(void)
+uint8_t metering_get_summation_formatting(const metering_t *m)
 {
-    return s_cfg.metering_device_type;
+    return m->summation_formatting;
 }
 
-uint8_t metering_get_summation_formatting(void)
+uint8_t metering_get_demand_formatting(const metering_t *m)
 {
-    return s_summation_formatting;
+    return m->demand_formatting;
 }
 
-uint8_t metering_get_demand_formatting(void)
+uint32_t metering_get_multiplier(const metering_t *m)
 {
-    return s_demand_formatting;
+    return m->multiplier;
 }
 
-uint32_t metering_get_multiplier(void)
+uint32_t metering_get_divisor(const metering_t *m)
 {
-    return s_multiplier;
+    return m->divisor;
 }
 
-uint32_t metering_get_divisor(void)
+int32_t metering_get_instantaneous_demand(const metering_t *m)
 {
-    return s_divisor;
+    return m->instantaneous_demand;
 }
 
-int32_t metering_get_instantaneous_demand(void)
+void metering_set_instantaneous_demand(metering_t *m, int32_t demand)
 {
-    return s_instantaneous_demand;
+    m->instantaneous_demand = demand;
 }
 
-void metering_set_instantaneous_demand(int32_t demand)
+int64_t metering_get_last_pulse_us(const metering_t *m)
 {
-    s_instantaneous_demand = demand;
+    return m->last_pulse_us;
 }
 
-int64_t metering_get_last_pulse_us(void)
+uint32_t metering_profile_interval_s(void)
 {
-    return s_last_pulse_us;
+    return (uint32_t)CONFIG_METERING_PROFILE_INTERVAL_MIN * 60u;
+}
+
+uint16_t metering_profile_skip(uint32_t *newest_end_s, uint32_t end_s)
+{
+    if (end_s == 0 || end_s >= *newest_end_s) {
+        return 0;
+    }
+    uint32_t interval_s = metering_profile_interval_s();
+    uint64_t skip_s = (uint64_t)(*newest_end_s - end_s) + interval_s - 1;
+    uint16_t skip = skip_s / interval_s > UINT16_MAX ? UINT16_MAX : (uint16_t)(skip_s / interval_s);
+    *newest_end_s -= (uint32_t)skip * interval_s;
+    return skip;
+}
+
+#if CONFIG_METERING_HISTORY
+uint16_t metering_profile_count(const metering_t *m)
+{
+    return m->profile_count;
+}
+
+uint32_t metering_profile_age_s(metering_t *m, int64_t now_us)
+{
+    profile_roll(m, now_us);
+    return (uint32_t)((now_us - m->profile_open_start_us) / 1000000LL);
+}
+
+uint8_t metering_profile_read(metering_t *m, uint16_t skip, uint8_t max, uint32_t *out, int64_t now_us)
+{
+    profile_roll(m, now_us);
+    uint8_t n = 0;
+    for (uint16_t i = skip; i < m->profile_count && n < max; i++) {
+        uint16_t slot = (uint16_t)((m->profile_head + CONFIG_METERING_PROFILE_PERIODS - 1 - i) %
+                                   CONFIG_METERING_PROFILE_PERIODS);
+        out[n++] = m->profile[slot];
+    }
+    return n;
+}
+
+void metering_profile_export(const metering_t *m, metering_profile_blob_t *blob)
+{
+    blob->version = METERING_PROFILE_VERSION;
+    blob->interval_s = metering_profile_interval_s();
+    blob->count = m->profile_count;
+    blob->head = m->profile_head;
+    memcpy(blob->periods, m->profile, sizeof(blob->periods));
+    blob->calendar = m->calendar;
+}
+
+bool metering_profile_import(metering_t *m, const metering_profile_blob_t *blob, int64_t now_us)
+{
+    if (blob->version != METERING_PROFILE_VERSION || blob->interval_s != metering_profile_interval_s() ||
+        blob->count > CONFIG_METERING_PROFILE_PERIODS || blob->head >= CONFIG_METERING_PROFILE_PERIODS) {
+        return false;
+    }
+    memcpy(m->profile, blob->periods, sizeof(m->profile));
+    m->calendar = blob->calendar;
+    m->profile_count = blob->count;
+    m->profile_head = blob->head;
+    /* Time spent in reset is unknown; the restored history continues from here. */
+    m->profile_open = 0;
+    m->profile_open_start_us = now_us;
+    return true;
+}
+#endif
+
+static uint32_t calendar_since(const metering_t *m, uint64_t start)
+{
+    uint64_t summation = metering_get_summation(m);
+    uint64_t used = summation > start ? summation - start : 0;
+    return used > UINT32_MAX ? UINT32_MAX : (uint32_t)used;
+}
+
+uint8_t metering_calendar_update(metering_t *m, uint32_t local_s)
+{
+    uint32_t day = local_s / METERING_DAY_S;
+    uint32_t week = (day + METERING_WEEK_DAY_SHIFT) / 7u;
+    uint64_t summation = metering_get_summation(m);
+
+    if (!m->calendar.valid) {
+        memset(&m->calendar, 0, sizeof(m->calendar));
+        m->calendar.valid = 1;
+        m->calendar.day = day;
+        m->calendar.week = week;
+        m->calendar.day_start = summation;
+        m->calendar.week_start = summation;
+        return 0;
+    }
+    if (day <= m->calendar.day) {
+        /* Same day, or the clock was stepped back: keep accumulating into the later day, so
+         * catching up with it again does not roll a second time.
+         */
+        return 0;
+    }
+
+    uint8_t rolled = METERING_ROLL_DAY;
+    m->calendar.prev_day = (day == m->calendar.day + 1) ? calendar_since(m, m->calendar.day_start) : 0;
+    m->calendar.day = day;
+    m->calendar.day_start = summation;
+    if (week != m->calendar.week) {
+        m->calendar.prev_week = (week == m->calendar.week + 1) ? calendar_since(m, m->calendar.week_start) : 0;
+        m->calendar.week = week;
+        m->calendar.week_start = summation;
+        rolled |= METERING_ROLL_WEEK;
+    }
+    return rolled;
+}
+
+bool metering_calendar_valid(const metering_t *m)
+{
+    return m->calendar.valid != 0;
+}
+
+uint32_t metering_get_current_day_consumption(const metering_t *m)
+{
+    return m->calendar.valid ? calendar_since(m, m->calendar.day_start) : 0;
+}
+
+uint32_t metering_get_previous_day_consumption(const metering_t *m)
+{
+    return m->calendar.prev_day;
+}
+
+uint32_t metering_get_current_week_consumption(const metering_t *m)
+{
+    return m->calendar.valid ? calendar_since(m, m->calendar.week_start) : 0;
+}
+
+uint32_t metering_get_previous_week_consumption(const metering_t *m)
+{
+    return m->calendar.prev_week;
+}
+
+uint8_t metering_leak_alarms(const metering_t *m)
+{
+#if CONFIG_LEAK_DETECT
+    return m->leak_alarms;
+#else
+    (void)m;
+    return 0;
+#endif
+}
+
+uint32_t metering_leak_longest_idle_s(const metering_t *m, int64_t now_us)
+{
+#if CONFIG_LEAK_DETECT
+    return leak_longest_idle_s(m, now_us);
+#else
+    (void)m;
+    (void)now_us;
+    return 0;
+#endif
+}
+
+uint32_t metering_leak_flow_run_s(const metering_t *m, int64_t now_us)
+{
+#if !CONFIG_LEAK_DETECT
+    (void)m;
+    (void)now_us;
+    return 0;
+#else
+    if (m->leak_run_start_us < 0 || m->leak_last_us < 0 || now_us - m->leak_last_us >= LEAK_IDLE_GAP_US) {
+        return 0;
+    }
+    return (uint32_t)((m->leak_last_us - m->leak_run_start_us) / 1000000LL);
+#endif
 }
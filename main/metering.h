@@ -2,23 +2,156 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "sdkconfig.h"
 #include "app_config.h"
+#include "pulse_counter.h"
 
-void metering_init(const app_metering_cfg_t *cfg, uint64_t total_pulses);
-void metering_on_pulse(int64_t now_us);
-void metering_on_pulses(uint32_t count, int64_t last_us, int64_t prev_us);
-bool metering_tick(int64_t now_us);
-void metering_set_config(const app_metering_cfg_t *cfg);
-uint64_t metering_get_total_pulses(void);
-uint64_t metering_get_summation(void);
-void metering_reset(void);
-
-uint8_t metering_get_unit_of_measure(void);
-uint8_t metering_get_device_type(void);
-uint8_t metering_get_summation_formatting(void);
-uint8_t metering_get_demand_formatting(void);
-uint32_t metering_get_multiplier(void);
-uint32_t metering_get_divisor(void);
-int32_t metering_get_instantaneous_demand(void);
-void metering_set_instantaneous_demand(int32_t demand);
-int64_t metering_get_last_pulse_us(void);
+#ifndef CONFIG_METERING_PROFILE_PERIODS
+#define CONFIG_METERING_PROFILE_PERIODS 168
+#endif
+#ifndef CONFIG_METERING_PROFILE_INTERVAL_MIN
+#define CONFIG_METERING_PROFILE_INTERVAL_MIN 60
+#endif
+
+#ifndef CONFIG_DEMAND_ESTIMATOR_WINDOW
+#define CONFIG_DEMAND_ESTIMATOR_WINDOW 0
+#endif
+#ifndef CONFIG_DEMAND_WINDOW_PULSES
+#define CONFIG_DEMAND_WINDOW_PULSES 8
+#endif
+#ifndef CONFIG_LEAK_DETECT
+#define CONFIG_LEAK_DETECT 0
+#endif
+
+#define METERING_LEAK_WINDOW_HOURS 24
+
+/* Day/week consumption in summation units, from local wall-clock time (ZCL epoch, weeks start Monday). */
+typedef struct {
+    uint32_t day;           /* local days since 2000-01-01 */
+    uint32_t week;
+    uint64_t day_start;     /* summation when the current day began */
+    uint64_t week_start;
+    uint32_t prev_day;      /* previous day's consumption, 0 if that day was not observed */
+    uint32_t prev_week;
+    uint32_t valid;
+} metering_calendar_t;
+
+/* One meter: summation, demand, load profile, calendar and leak state of a pulse channel.
+ * Callers own the storage; every function takes the instance first. The total lives in the
+ * channel's pulse_counter_t, shared with the pulse input; the meter only reads it, except
+ * for metering_reset().
+ */
+typedef struct {
+    app_metering_cfg_t cfg;
+    pulse_counter_t *counter;
+    uint8_t summation_formatting;
+    uint8_t demand_formatting;
+    uint32_t multiplier;
+    uint32_t divisor;
+    int32_t instantaneous_demand;
+    int64_t last_pulse_us;
+    double rate_est_ph;
+    int64_t rate_last_update_us;
+#if CONFIG_DEMAND_ESTIMATOR_WINDOW
+    /* Recent pulse times and their running pulse number, oldest overwritten first. */
+    int64_t demand_t_us[CONFIG_DEMAND_WINDOW_PULSES];
+    uint32_t demand_n[CONFIG_DEMAND_WINDOW_PULSES];
+    uint32_t demand_pulses;
+    int64_t demand_fit_pulse_us;    /* last_pulse_us when rate_est_ph was fitted */
+    uint8_t demand_head;
+    uint8_t demand_count;
+#endif
+
+#if CONFIG_METERING_HISTORY
+    uint32_t profile[CONFIG_METERING_PROFILE_PERIODS];
+    uint16_t profile_head;
+    uint16_t profile_count;
+    uint32_t profile_open;
+    int64_t profile_open_start_us;
+#endif
+
+    metering_calendar_t calendar;
+
+#if CONFIG_LEAK_DETECT
+    /* Longest pulse gap that ended in each of the last 24 hours (by uptime hour). */
+    uint32_t leak_gap_s[METERING_LEAK_WINDOW_HOURS];
+    int64_t leak_gap_hour[METERING_LEAK_WINDOW_HOURS];
+    int64_t leak_since_us;      /* detector start; no-idle needs a full window */
+    int64_t leak_last_us;       /* last pulse seen by the detector */
+    int64_t leak_run_start_us;
+    uint32_t leak_run_pulses;
+    uint8_t leak_alarms;
+#endif
+} metering_t;
+
+void metering_init(metering_t *m, const app_metering_cfg_t *cfg, pulse_counter_t *counter);
+/* Feed a batch taken from the pulse input (demand, profile, leak); the total is already counted. */
+void metering_on_pulses(metering_t *m, uint32_t count, int64_t last_us, int64_t prev_us);
+bool metering_tick(metering_t *m, int64_t now_us);
+void metering_set_config(metering_t *m, const app_metering_cfg_t *cfg);
+uint64_t metering_get_total_pulses(const metering_t *m);
+uint64_t metering_get_summation(const metering_t *m);
+/* Zero the total in the shared counter and clear demand, profile, calendar and leak state. */
+void metering_reset(metering_t *m);
+
+uint8_t metering_get_unit_of_measure(const metering_t *m);
+uint8_t metering_get_device_type(const metering_t *m);
+uint8_t metering_get_summation_formatting(const metering_t *m);
+uint8_t metering_get_demand_formatting(const metering_t *m);
+uint32_t metering_get_multiplier(const metering_t *m);
+uint32_t metering_get_divisor(const metering_t *m);
+int32_t metering_get_instantaneous_demand(const metering_t *m);
+void metering_set_instantaneous_demand(metering_t *m, int32_t demand);
+int64_t metering_get_last_pulse_us(const metering_t *m);
+
+#define METERING_ROLL_DAY 0x01
+#define METERING_ROLL_WEEK 0x02
+
+/* Advance the calendar to local time local_s. Returns METERING_ROLL_* for boundaries crossed. */
+uint8_t metering_calendar_update(metering_t *m, uint32_t local_s);
+bool metering_calendar_valid(const metering_t *m);
+uint32_t metering_get_current_day_consumption(const metering_t *m);
+uint32_t metering_get_previous_day_consumption(const metering_t *m);
+uint32_t metering_get_current_week_consumption(const metering_t *m);
+uint32_t metering_get_previous_week_consumption(const metering_t *m);
+
+/* Leak / continuous-flow detection from pulse timestamps (water meters, CONFIG_LEAK_DETECT). */
+#define METERING_LEAK_NO_IDLE 0x01      /* no pause of LEAK_IDLE_GAP_MIN in the last 24 h */
+#define METERING_LEAK_CONTINUOUS 0x02   /* flow without such a pause for LEAK_CONTINUOUS_H */
+#define METERING_LEAK_BURST 0x04        /* LEAK_BURST_PULSES within one flow run */
+
+/* All three read 0 without CONFIG_LEAK_DETECT. */
+uint8_t metering_leak_alarms(const metering_t *m);
+/* Longest pulse gap in the last 24 h, including the current one. */
+uint32_t metering_leak_longest_idle_s(const metering_t *m, int64_t now_us);
+/* Duration of the current flow run, 0 when idle. */
+uint32_t metering_leak_flow_run_s(const metering_t *m, int64_t now_us);
+
+/* Load profile: pulses per fixed interval in a circular store (newest first on read). The store
+ * and the functions that use it exist only with CONFIG_METERING_HISTORY.
+ */
+typedef struct {
+    uint32_t version;
+    uint32_t interval_s;
+    uint16_t count;         /* completed intervals stored */
+    uint16_t head;          /* slot the next completed interval goes to */
+    uint32_t periods[CONFIG_METERING_PROFILE_PERIODS];
+    metering_calendar_t calendar;
+} metering_profile_blob_t;
+
+uint32_t metering_profile_interval_s(void);
+/* Get Profile EndTime: intervals to skip so the first one returned ends at or before end_s
+ * (0: the newest). *newest_end_s, the UTC end of the newest stored interval, becomes the end of
+ * the first one returned.
+ */
+uint16_t metering_profile_skip(uint32_t *newest_end_s, uint32_t end_s);
+#if CONFIG_METERING_HISTORY
+uint16_t metering_profile_count(const metering_t *m);
+/* Seconds from the end of the newest completed interval to now_us. */
+uint32_t metering_profile_age_s(metering_t *m, int64_t now_us);
+/* Copy up to max completed intervals, newest first, after skipping `skip` of them. */
+uint8_t metering_profile_read(metering_t *m, uint16_t skip, uint8_t max, uint32_t *out, int64_t now_us);
+void metering_profile_export(const metering_t *m, metering_profile_blob_t *blob);
+/* Restore a saved store and calendar; the open interval restarts at now_us. False if the blob does not fit. */
+bool metering_profile_import(metering_t *m, const metering_profile_blob_t *blob, int64_t now_us);
+#endif
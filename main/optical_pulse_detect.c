@@ -0,0 +1,73 @@
+#include "optical_pulse_detect.h"
+
+#include <string.h>
+
+/* Q16 keeps the relax step above zero down to a fraction of a count at the slowest shift. */
+#define OPTICAL_PULSE_Q 16
+#define OPTICAL_PULSE_SHIFT_MAX 24
+
+uint8_t optical_pulse_track_shift(uint32_t track_s, uint32_t sample_hz)
+{
+    uint64_t samples = (uint64_t)track_s * sample_hz;
+    uint8_t shift = 0;
+    while (shift < OPTICAL_PULSE_SHIFT_MAX && (1ULL << shift) < samples) {
+        shift++;
+    }
+    return shift;
+}
+
+void optical_pulse_init(optical_pulse_t *o, const optical_pulse_cfg_t *cfg)
+{
+    memset(o, 0, sizeof(*o));
+    o->cfg = *cfg;
+    if (o->cfg.hyst_pct > 49) {
+        o->cfg.hyst_pct = 49;
+    }
+    if (o->cfg.track_shift > OPTICAL_PULSE_SHIFT_MAX) {
+        o->cfg.track_shift = OPTICAL_PULSE_SHIFT_MAX;
+    }
+}
+
+optical_pulse_edge_t optical_pulse_sample(optical_pulse_t *o, int reading)
+{
+    int32_t x = (int32_t)(o->cfg.active_low ? -reading : reading) * (1 << OPTICAL_PULSE_Q);
+    if (!o->primed) {
+        o->hi_q16 = x;
+        o->lo_q16 = x;
+        o->primed = true;
+        return OPTICAL_PULSE_NONE;
+    }
+
+    /* Attack at once, relax slowly: a pulse resets its level, a pause lets both drift. */
+    if (x > o->hi_q16) {
+        o->hi_q16 = x;
+    } else {
+        o->hi_q16 -= (o->hi_q16 - x) >> o->cfg.track_shift;
+    }
+    if (x < o->lo_q16) {
+        o->lo_q16 = x;
+    } else {
+        o->lo_q16 += (x - o->lo_q16) >> o->cfg.track_shift;
+    }
+
+    int32_t span = o->hi_q16 - o->lo_q16;
+    if (span < ((int32_t)o->cfg.min_span << OPTICAL_PULSE_Q)) {
+        return OPTICAL_PULSE_NONE;
+    }
+    int32_t mid = o->lo_q16 + span / 2;
+    int32_t band = span / 100 * o->cfg.hyst_pct;
+    if (!o->active && x >= mid + band) {
+        o->active = true;
+        return OPTICAL_PULSE_ON;
+    }
+    if (o->active && x <= mid - band) {
+        o->active = false;
+        return OPTICAL_PULSE_OFF;
+    }
+    return OPTICAL_PULSE_NONE;
+}
+
+int optical_pulse_span(const optical_pulse_t *o)
+{
+    return (int)((o->hi_q16 - o->lo_q16) >> OPTICAL_PULSE_Q);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Pulse detector of the optical input (CONFIG_PULSE_SOURCE_OPTICAL): one ADC reading of a
+ * phototransistor per sample, from a meter's LED or a reflective disc. It tracks the bright and
+ * dark levels of the signal (an instant attack, then a slow relax toward the reading) and
+ * switches at the midpoint between them, plus or minus a hysteresis band. Nothing is detected
+ * until the levels are at least min_span apart, so noise on a steady signal never counts.
+ * Ambient drift slower than min_span per relax time constant is absorbed. A quick ambient step
+ * reads as the start of the next pulse; one larger than about the contrast stalls detection for
+ * about a time constant, which is why a reflective sensor subtracts a dark reading.
+ *
+ * Edges only: debounce and minimum width are pulse.c's, on the sample times. host/bench.c drives
+ * it with synthetic light (drift, noise, contrast steps).
+ */
+
+typedef enum {
+    OPTICAL_PULSE_NONE,
+    OPTICAL_PULSE_ON,           /* the signal crossed into the pulse */
+    OPTICAL_PULSE_OFF,          /* and back */
+} optical_pulse_edge_t;
+
+typedef struct {
+    uint16_t min_span;          /* ADC counts between the levels before anything is detected */
+    uint8_t hyst_pct;           /* thresholds at the midpoint +/- this % of the span */
+    uint8_t track_shift;        /* levels relax toward the reading by 1/2^shift per sample */
+    bool active_low;            /* a pulse lowers the reading */
+} optical_pulse_cfg_t;
+
+typedef struct {
+    optical_pulse_cfg_t cfg;
+    int32_t hi_q16;             /* bright level, ADC counts in Q16 (negated if active_low) */
+    int32_t lo_q16;             /* dark level */
+    bool primed;                /* levels seeded by the first reading */
+    bool active;
+} optical_pulse_t;
+
+/* Shift whose relax time constant (2^shift samples) first covers track_s at sample_hz. */
+uint8_t optical_pulse_track_shift(uint32_t track_s, uint32_t sample_hz);
+
+void optical_pulse_init(optical_pulse_t *o, const optical_pulse_cfg_t *cfg);
+/* One reading (ADC counts); returns the edge it completes, if any. */
+optical_pulse_edge_t optical_pulse_sample(optical_pulse_t *o, int reading);
+/* Current distance between the tracked levels, in ADC counts. */
+int optical_pulse_span(const optical_pulse_t *o);
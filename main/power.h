@@ -8,6 +8,8 @@ typedef struct {
     uint16_t battery_mv;
     uint8_t battery_voltage_attr;
     uint8_t battery_percent_attr;
+    uint16_t adc_samples;   /* samples used by the last burst (0 if no ADC read happened) */
+    uint32_t adc_awake_us;  /* time spent in the last ADC burst */
 } power_status_t;
 
 void power_init(void);
@@ -17,3 +19,5 @@ typedef void (*power_status_cb_t)(const power_status_t *status, void *ctx);
 
 /* Start a background task that periodically reads battery status and notifies via callback. */
 esp_err_t power_start_monitor(uint32_t period_ms, power_status_cb_t cb, void *ctx);
+/* Bytes of the monitor task's stack never used so far; 0 if the task is not running. */
+uint32_t power_monitor_stack_free(void);
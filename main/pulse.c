@@ -6,26 +6,14 @@
 
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
 #include "esp_timer.h"
-#include "iot_button.h"
 #include "button_gpio.h"
 
 static const char *TAG = "pulse";
 
-static pulse_config_t s_cfg;
-static button_handle_t s_button;
-static volatile uint64_t s_total_pulses;
-static int64_t s_last_valid_us;
-static int64_t s_prev_valid_us;
-static volatile uint32_t s_pending_pulses;
-static volatile uint32_t s_dropped_pulses;
 static TaskHandle_t s_consumer_task;
-static pulse_cb_t s_cb;
-static void *s_cb_arg;
-static portMUX_TYPE s_pulse_mux = portMUX_INITIALIZER_UNLOCKED;
-static volatile bool s_blocked;
 static volatile bool s_enabled = true;
-static int64_t s_last_down_us;
 
 static void pulse_notify_consumer(void)
 {
@@ -34,88 +22,180 @@ static void pulse_notify_consumer(void)
     }
 }
 
-static void pulse_record_valid(int64_t now_us)
+static bool pulse_record_valid(pulse_t *p, int64_t edge_us, int64_t now_us)
 {
-    portENTER_CRITICAL(&s_pulse_mux);
-    s_prev_valid_us = s_last_valid_us;
-    s_last_valid_us = now_us;
-    if (s_total_pulses != UINT64_MAX) {
-        s_total_pulses++;
-    }
-    if (s_pending_pulses == UINT32_MAX) {
-        s_dropped_pulses++;
-    } else {
-        s_pending_pulses++;
+    if (!pulse_counter_add(p->counter, now_us, (int64_t)p->cfg.debounce_ms * 1000LL)) {
+        return false;
     }
-    portEXIT_CRITICAL(&s_pulse_mux);
+    LATENCY_PROBE_COUNTED(&p->latency, edge_us, now_us);
+    (void)edge_us;
 
-    if (s_cb) {
-        s_cb(s_cb_arg);
+    if (p->cb) {
+        p->cb(p->cb_arg);
     }
     pulse_notify_consumer();
+    return true;
 }
 
 static void pulse_on_press_down(void *arg, void *data)
 {
     (void)arg;
-    (void)data;
-    s_last_down_us = esp_timer_get_time();
+    pulse_t *p = (pulse_t *)data;
+    p->last_down_us = esp_timer_get_time();
 }
 
-static void pulse_on_press_up(void *arg, void *data)
+/* The contact opened at release_us; a valid pulse is counted at ts_us (release_us from an edge,
+ * the last strobe that found the contact closed when strobed).
+ */
+static void pulse_release(pulse_t *p, int64_t release_us, int64_t ts_us)
 {
-    (void)arg;
-    (void)data;
-
-    if (!s_enabled || s_blocked) {
+    if (!s_enabled || p->blocked) {
         return;
     }
 
-    int64_t now = esp_timer_get_time();
-    int64_t down = s_last_down_us;
+    int64_t now = release_us;
+    int64_t down = p->last_down_us;
     if (down == 0 || down > now) {
         down = now;
     }
 
+    /* The closure that woke us was counted at wake; its press edge, if it was delivered at
+     * all, lands within the debounce of that. A later press is a new pulse; no press edge since
+     * the wake (e.g. after a deep-sleep boot) means this release is the waking closure's.
+     */
+    int64_t wake_us = p->wake_us;
+    if (wake_us != 0) {
+        p->wake_us = 0;
+        if (p->last_down_us == 0 || p->last_down_us < wake_us + (int64_t)p->cfg.debounce_ms * 1000LL) {
+            return;
+        }
+    }
+
     int64_t width_us = now - down;
-    if (s_cfg.min_width_ms > 0 && width_us < ((int64_t)s_cfg.min_width_ms * 1000LL)) {
+    if (p->cfg.min_width_ms > 0 && width_us < ((int64_t)p->cfg.min_width_ms * 1000LL)) {
         return;
     }
 
-    int64_t last_valid_us = 0;
-    uint16_t debounce_ms = 0;
-    portENTER_CRITICAL(&s_pulse_mux);
-    last_valid_us = s_last_valid_us;
-    debounce_ms = s_cfg.debounce_ms;
-    portEXIT_CRITICAL(&s_pulse_mux);
+    (void)pulse_record_valid(p, down, ts_us < down ? down : ts_us);
+}
+
+static void pulse_on_press_up(void *arg, void *data)
+{
+    (void)arg;
+    pulse_t *p = (pulse_t *)data;
+    int64_t now = esp_timer_get_time();
+    pulse_release(p, now, now);
+}
 
-    if (debounce_ms > 0 && (now - last_valid_us) < ((int64_t)debounce_ms * 1000LL)) {
+#if CONFIG_PULSE_PULL_STROBED
+/* A closed reed conducts through the pull-up. Once a closure is seen the pin is pulled down
+ * instead (no current with the contact open or closed) and the pull-up goes on only for a
+ * strobe every PULSE_STROBE_MS until one reads the contact open. Width is measured to that
+ * strobe, so no valid pulse is rejected; the pulse is timestamped at the last strobe that read
+ * it closed, so the next closure is never within the debounce of it.
+ */
+static void pulse_strobe_begin(pulse_t *p, int64_t down_us)
+{
+    gpio_intr_disable((gpio_num_t)p->cfg.gpio_num);
+    if (p->strobing) {
         return;
     }
+    p->strobing = true;
+    p->last_down_us = down_us;
+    p->strobe_closed_us = down_us;
+    /* The first strobe a period later also rides out the closing bounce. */
+    (void)esp_timer_start_once(p->strobe_timer, CONFIG_PULSE_STROBE_MS * 1000ULL);
+}
 
-    pulse_record_valid(now);
+static void pulse_strobe_isr(void *arg)
+{
+    pulse_strobe_begin((pulse_t *)arg, esp_timer_get_time());
+}
+
+static void pulse_strobe_cb(void *arg)
+{
+    pulse_t *p = (pulse_t *)arg;
+    gpio_num_t gpio = (gpio_num_t)p->cfg.gpio_num;
+
+    gpio_set_pull_mode(gpio, GPIO_PULLUP_ONLY);
+    esp_rom_delay_us(CONFIG_PULSE_STROBE_SETTLE_US);
+    int64_t now = esp_timer_get_time();
+    if (gpio_get_level(gpio) == 0) {
+        gpio_set_pull_mode(gpio, GPIO_PULLDOWN_ONLY);
+        p->strobe_closed_us = now;
+        (void)esp_timer_start_once(p->strobe_timer, CONFIG_PULSE_STROBE_MS * 1000ULL);
+        return;
+    }
+
+    /* Open: the pull-up stays on and the closure interrupt is armed again. */
+    p->strobing = false;
+    pulse_release(p, now, p->strobe_closed_us);
+    gpio_intr_enable(gpio);
+}
+
+static esp_err_t pulse_strobe_init(pulse_t *p)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = pulse_strobe_cb,
+        .arg = p,
+        .name = "pulse_strobe",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &p->strobe_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    /* Level interrupt: a contact already closed when it is armed fires at once. */
+    gpio_config_t io_cfg = {
+        .pin_bit_mask = 1ULL << p->cfg.gpio_num,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_LOW_LEVEL,
+    };
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+    gpio_intr_disable((gpio_num_t)p->cfg.gpio_num);
+    err = gpio_isr_handler_add((gpio_num_t)p->cfg.gpio_num, pulse_strobe_isr, p);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = gpio_config(&io_cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init strobed input on GPIO%d: %s", p->cfg.gpio_num, esp_err_to_name(err));
+    }
+    return err;
 }
+#endif
 
-esp_err_t pulse_init(const pulse_config_t *cfg, pulse_cb_t cb, void *cb_arg, uint64_t initial_total)
+esp_err_t pulse_init(pulse_t *p, const pulse_config_t *cfg, pulse_cb_t cb, void *cb_arg, pulse_counter_t *counter)
 {
-    if (!cfg || cfg->gpio_num < 0 || cfg->gpio_num >= GPIO_NUM_MAX) {
+    if (!p || !counter || !cfg || cfg->gpio_num < 0 || cfg->gpio_num >= GPIO_NUM_MAX) {
         ESP_LOGE(TAG, "Invalid pulse GPIO %d", cfg ? cfg->gpio_num : -1);
         return ESP_ERR_INVALID_ARG;
     }
 
-    s_cfg = *cfg;
-    s_cb = cb;
-    s_cb_arg = cb_arg;
-    s_total_pulses = initial_total;
-    s_last_valid_us = 0;
-    s_prev_valid_us = 0;
-    s_pending_pulses = 0;
-    s_dropped_pulses = 0;
-    s_blocked = false;
-    s_enabled = true;
-    s_last_down_us = 0;
-    s_button = NULL;
-    s_consumer_task = NULL;
+    *p = (pulse_t){
+        .cfg = *cfg,
+        .cb = cb,
+        .cb_arg = cb_arg,
+        .counter = counter,
+    };
+    pulse_counter_snapshot_t snap;
+    pulse_counter_read(counter, &snap);
+    p->consumed = snap.counted;
+
+#if CONFIG_PULSE_LP_CORE
+    /* The LP core owns the pin and counts; pulse_import() brings its pulses in. */
+    return ESP_OK;
+#elif CONFIG_PULSE_SOURCE_OPTICAL
+    /* pulse_optical.c samples the sensor and brings its edges in with pulse_feed_edge(). */
+    return ESP_OK;
+#elif CONFIG_PULSE_PULL_STROBED
+    return pulse_strobe_init(p);
+#endif
 
     button_config_t btn_cfg = {
         .long_press_time = 0,
@@ -126,20 +206,21 @@ esp_err_t pulse_init(const pulse_config_t *cfg, pulse_cb_t cb, void *cb_arg, uin
         .active_level = 0, /* pulses are active-low */
         /* Power-save lets the driver stop its timer when idle; wake via GPIO interrupt. */
         .enable_power_save = true,
-        .disable_pull = false,
+        /* PULSE_PULL_EXTERNAL: a high-value resistor on the board pulls the contact up. */
+        .disable_pull = CONFIG_PULSE_PULL_EXTERNAL,
     };
 
-    esp_err_t err = iot_button_new_gpio_device(&btn_cfg, &gpio_cfg, &s_button);
+    esp_err_t err = iot_button_new_gpio_device(&btn_cfg, &gpio_cfg, &p->button);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to init button on GPIO%d: %s", cfg->gpio_num, esp_err_to_name(err));
         return err;
     }
 
-    err = iot_button_register_cb(s_button, BUTTON_PRESS_DOWN, NULL, pulse_on_press_down, NULL);
+    err = iot_button_register_cb(p->button, BUTTON_PRESS_DOWN, NULL, pulse_on_press_down, p);
     if (err != ESP_OK) {
         return err;
     }
-    err = iot_button_register_cb(s_button, BUTTON_PRESS_UP, NULL, pulse_on_press_up, NULL);
+    err = iot_button_register_cb(p->button, BUTTON_PRESS_UP, NULL, pulse_on_press_up, p);
     if (err != ESP_OK) {
         return err;
     }
@@ -147,68 +228,47 @@ esp_err_t pulse_init(const pulse_config_t *cfg, pulse_cb_t cb, void *cb_arg, uin
     return ESP_OK;
 }
 
-void pulse_update_debounce(uint16_t debounce_ms)
-{
-    portENTER_CRITICAL(&s_pulse_mux);
-    s_cfg.debounce_ms = debounce_ms;
-    portEXIT_CRITICAL(&s_pulse_mux);
-}
-
-void pulse_set_total(uint64_t total)
-{
-    portENTER_CRITICAL(&s_pulse_mux);
-    s_total_pulses = total;
-    s_pending_pulses = 0;
-    s_dropped_pulses = 0;
-    portEXIT_CRITICAL(&s_pulse_mux);
-}
-
-uint64_t pulse_get_total(void)
+void pulse_update_debounce(pulse_t *p, uint16_t debounce_ms)
 {
-    uint64_t total = 0;
-    portENTER_CRITICAL(&s_pulse_mux);
-    total = s_total_pulses;
-    portEXIT_CRITICAL(&s_pulse_mux);
-    return total;
+    /* A single 16-bit store; the pulse path picks it up on its next edge. */
+    p->cfg.debounce_ms = debounce_ms;
 }
 
 void pulse_set_consumer_task(TaskHandle_t task)
 {
+    /* Pulses counted before the task existed are picked up on its first loop pass. */
     s_consumer_task = task;
-    if (s_pending_pulses > 0) {
-        pulse_notify_consumer();
-    }
+    pulse_notify_consumer();
 }
 
-bool pulse_take_pending(pulse_pending_info_t *info)
+bool pulse_take_pending(pulse_t *p, pulse_pending_info_t *info)
 {
     if (!info) {
         return false;
     }
 
-    bool has = false;
-    portENTER_CRITICAL(&s_pulse_mux);
-    if (s_pending_pulses > 0 || s_dropped_pulses > 0) {
-        info->count = s_pending_pulses;
-        info->lost = s_dropped_pulses;
-        info->last_ts_us = s_last_valid_us;
-        info->prev_ts_us = s_prev_valid_us;
-        s_pending_pulses = 0;
-        s_dropped_pulses = 0;
-        has = true;
-    } else {
-        info->count = 0;
-        info->lost = 0;
-        info->last_ts_us = s_last_valid_us;
-        info->prev_ts_us = s_prev_valid_us;
-    }
-    portEXIT_CRITICAL(&s_pulse_mux);
-    return has;
+    pulse_counter_snapshot_t snap;
+    pulse_counter_read(p->counter, &snap);
+    uint64_t pending = snap.counted - p->consumed;
+    p->consumed = snap.counted;
+
+    info->count = pending > UINT32_MAX ? UINT32_MAX : (uint32_t)pending;
+    info->lost = pending > UINT32_MAX ? (uint32_t)(pending - UINT32_MAX) : 0;
+    info->last_ts_us = snap.last_us;
+    info->prev_ts_us = snap.prev_us;
+    return pending > 0;
 }
 
-void pulse_block(bool block)
+bool pulse_pending(const pulse_t *p)
 {
-    s_blocked = block;
+    pulse_counter_snapshot_t snap;
+    pulse_counter_read(p->counter, &snap);
+    return snap.counted != p->consumed;
+}
+
+void pulse_block(pulse_t *p, bool block)
+{
+    p->blocked = block;
 }
 
 void pulse_enable(bool enable)
@@ -221,34 +281,52 @@ void pulse_enable(bool enable)
     }
 }
 
-bool pulse_record_wakeup(int64_t now_us)
+bool pulse_record_wakeup(pulse_t *p, int64_t now_us)
 {
-    if (!s_enabled || s_blocked) {
+    if (!s_enabled || p->blocked) {
+        return false;
+    }
+    /* The edge is what woke us; its exact time is lost in sleep. */
+#if CONFIG_PULSE_PULL_STROBED
+    /* The closure interrupt may not have run yet; strobe for the release either way. */
+    pulse_strobe_begin(p, now_us);
+#endif
+    if (!pulse_record_valid(p, now_us, now_us)) {
         return false;
     }
+    p->wake_us = now_us;
+    return true;
+}
 
-    bool counted = false;
-    portENTER_CRITICAL(&s_pulse_mux);
-    if ((now_us - s_last_valid_us) >= ((int64_t)s_cfg.debounce_ms * 1000)) {
-        s_prev_valid_us = s_last_valid_us;
-        s_last_valid_us = now_us;
-        if (s_total_pulses != UINT64_MAX) {
-            s_total_pulses++;
-        }
-        if (s_pending_pulses == UINT32_MAX) {
-            s_dropped_pulses++;
-        } else {
-            s_pending_pulses++;
-        }
-        counted = true;
+bool pulse_strobing(const pulse_t *p)
+{
+#if CONFIG_PULSE_PULL_STROBED
+    return p->strobing;
+#else
+    (void)p;
+    return false;
+#endif
+}
+
+void pulse_feed_edge(pulse_t *p, bool active, int64_t t_us)
+{
+    if (active) {
+        p->last_down_us = t_us;
+    } else {
+        pulse_release(p, t_us, t_us);
     }
-    portEXIT_CRITICAL(&s_pulse_mux);
+}
 
-    if (counted) {
-        if (s_cb) {
-            s_cb(s_cb_arg);
-        }
-        pulse_notify_consumer();
+void pulse_import(pulse_t *p, uint32_t n, int64_t last_us, int64_t prev_us)
+{
+    if (n == 0 || !s_enabled || p->blocked) {
+        return;
     }
-    return counted;
+    pulse_counter_add_batch(p->counter, n, last_us, prev_us);
+    /* One sample per batch: only the last pulse's time is known (see latency.h). */
+    LATENCY_PROBE_COUNTED(&p->latency, last_us, esp_timer_get_time());
+    if (p->cb) {
+        p->cb(p->cb_arg);
+    }
+    pulse_notify_consumer();
 }
@@ -4,8 +4,31 @@
 #include <stdbool.h>
 
 #include "esp_err.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "iot_button.h"
+#include "pulse_counter.h"
+#include "latency.h"
+
+#ifndef CONFIG_PULSE_LP_CORE
+#define CONFIG_PULSE_LP_CORE 0
+#endif
+#ifndef CONFIG_PULSE_SOURCE_OPTICAL
+#define CONFIG_PULSE_SOURCE_OPTICAL 0
+#endif
+#ifndef CONFIG_PULSE_PULL_STROBED
+#define CONFIG_PULSE_PULL_STROBED 0
+#endif
+#ifndef CONFIG_PULSE_PULL_EXTERNAL
+#define CONFIG_PULSE_PULL_EXTERNAL 0
+#endif
+#ifndef CONFIG_PULSE_STROBE_MS
+#define CONFIG_PULSE_STROBE_MS 100
+#endif
+#ifndef CONFIG_PULSE_STROBE_SETTLE_US
+#define CONFIG_PULSE_STROBE_SETTLE_US 20
+#endif
 
 typedef void (*pulse_cb_t)(void *arg);
 
@@ -22,18 +45,61 @@ typedef struct {
     int64_t prev_ts_us;
 } pulse_pending_info_t;
 
-esp_err_t pulse_init(const pulse_config_t *cfg, pulse_cb_t cb, void *cb_arg, uint64_t initial_total);
-void pulse_update_debounce(uint16_t debounce_ms);
-void pulse_set_total(uint64_t total);
-uint64_t pulse_get_total(void);
+/* One pulse input. Callers own the storage (one per channel); every function takes the
+ * instance first. Pulses are counted into the caller's pulse_counter_t, which the meter
+ * reads too. All inputs notify the same consumer task, so one wake drains them all.
+ */
+typedef struct {
+    pulse_config_t cfg;
+    button_handle_t button;
+    pulse_counter_t *counter;
+    uint64_t consumed;          /* counter->counted already handed out by pulse_take_pending() */
+    pulse_cb_t cb;
+    void *cb_arg;
+    volatile bool blocked;
+    int64_t last_down_us;
+    int64_t wake_us;            /* pulse counted by pulse_record_wakeup(), its release still due; 0 if none */
+#if CONFIG_PULSE_PULL_STROBED
+    esp_timer_handle_t strobe_timer;
+    volatile bool strobing;     /* contact seen closed: pulled down, strobed for its release */
+    int64_t strobe_closed_us;   /* last strobe that still read it closed */
+#endif
+#if CONFIG_LATENCY_PROBES
+    latency_chan_t latency;
+#endif
+} pulse_t;
+
+esp_err_t pulse_init(pulse_t *p, const pulse_config_t *cfg, pulse_cb_t cb, void *cb_arg, pulse_counter_t *counter);
+void pulse_update_debounce(pulse_t *p, uint16_t debounce_ms);
+/* Task notified on every counted pulse of any input. */
 void pulse_set_consumer_task(TaskHandle_t task);
-bool pulse_take_pending(pulse_pending_info_t *info);
+/* Pulses counted since the last call; call from the consumer task only. */
+bool pulse_take_pending(pulse_t *p, pulse_pending_info_t *info);
+/* True if pulse_take_pending() would return pulses; consumer task only. */
+bool pulse_pending(const pulse_t *p);
 /* Temporarily drop incoming pulses (e.g., while a shared button is held). */
-void pulse_block(bool block);
-/* Enable/disable pulse interrupt processing. */
+void pulse_block(pulse_t *p, bool block);
+/* Enable/disable pulse interrupt processing on all inputs. */
 void pulse_enable(bool enable);
+/* CONFIG_PULSE_PULL_STROBED: the contact is closed and the pin pulled down between strobes, so
+ * it reads low and must not be an EXT1 wake source; the strobe timer wakes the device instead.
+ * Always false in the other modes.
+ */
+bool pulse_strobing(const pulse_t *p);
 
 /* Record a pulse after a level-based wakeup (EXT1 ANY_LOW / GPIO low wake),
- * where the NEGEDGE IRQ might not have been delivered while CPU slept.
+ * where the NEGEDGE IRQ might not have been delivered while CPU slept. The release of
+ * that contact closure is then not counted again.
+ */
+bool pulse_record_wakeup(pulse_t *p, int64_t now_us);
+
+/* Hand over n pulses another counter already debounced (the LP core with CONFIG_PULSE_LP_CORE,
+ * where pulse_init() leaves the pin to it), the latest at last_us and the one before at prev_us.
+ * Dropped like edges while the input is blocked or disabled. Consumer task only.
+ */
+void pulse_import(pulse_t *p, uint32_t n, int64_t last_us, int64_t prev_us);
+/* An edge from a sampled source (the optical input with CONFIG_PULSE_SOURCE_OPTICAL, where
+ * pulse_init() creates no button): active is the contact-closed side, at t_us. Same debounce and
+ * minimum width as contact edges.
  */
-bool pulse_record_wakeup(int64_t now_us);
+void pulse_feed_edge(pulse_t *p, bool active, int64_t t_us);
@@ -0,0 +1,126 @@
+#include "pulse_counter.h"
+
+/* Claim the record: seq even -> odd. Fails if another writer holds it. */
+static bool counter_claim(pulse_counter_t *c)
+{
+    uint32_t seq = __atomic_load_n(&c->seq, __ATOMIC_RELAXED);
+    if (seq & 1u) {
+        return false;
+    }
+    if (!__atomic_compare_exchange_n(&c->seq, &seq, seq + 1u, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    /* Field stores must not become visible before the odd seq. */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return true;
+}
+
+/* Count one pulse; the record is claimed. */
+static bool counter_count(pulse_counter_t *c, int64_t now_us, int64_t debounce_us)
+{
+    if (debounce_us > 0 && c->last_us != 0 && (now_us - c->last_us) < debounce_us) {
+        return false;
+    }
+    c->prev_us = c->last_us;
+    c->last_us = now_us;
+    if (c->total != UINT64_MAX) {
+        c->total++;
+    }
+    c->counted++;
+    return true;
+}
+
+/* Apply the pulses deferred to us and let go. A pulse deferred after the last check finds the
+ * record free on its own retry, or is picked up here on another pass.
+ */
+static void counter_release(pulse_counter_t *c)
+{
+    for (;;) {
+        uint32_t n = __atomic_exchange_n(&c->deferred, 0, __ATOMIC_ACQUIRE);
+        if (n) {
+            int64_t at_us = c->deferred_us;
+            int64_t debounce_us = c->deferred_debounce_us;
+            /* Only the latest has a timestamp; the earlier ones (if any) share it. */
+            for (uint32_t i = 0; i < n; i++) {
+                (void)counter_count(c, at_us, i == 0 ? debounce_us : 0);
+            }
+        }
+        __atomic_store_n(&c->seq, c->seq + 1u, __ATOMIC_RELEASE);
+        if (__atomic_load_n(&c->deferred, __ATOMIC_ACQUIRE) == 0 || !counter_claim(c)) {
+            return;
+        }
+    }
+}
+
+void pulse_counter_init(pulse_counter_t *c, uint64_t total)
+{
+    c->seq = 0;
+    c->total = total;
+    c->counted = 0;
+    c->last_us = 0;
+    c->prev_us = 0;
+    c->deferred = 0;
+    c->deferred_us = 0;
+    c->deferred_debounce_us = 0;
+}
+
+bool pulse_counter_add(pulse_counter_t *c, int64_t now_us, int64_t debounce_us)
+{
+    if (!counter_claim(c)) {
+        /* Timestamp first: the holder reads it once it sees the count. */
+        c->deferred_us = now_us;
+        c->deferred_debounce_us = debounce_us;
+        __atomic_fetch_add(&c->deferred, 1u, __ATOMIC_RELEASE);
+        /* The holder may have let go before the count landed; then apply it ourselves. */
+        if (counter_claim(c)) {
+            counter_release(c);
+        }
+        return true;
+    }
+
+    bool counted = counter_count(c, now_us, debounce_us);
+    counter_release(c);
+    return counted;
+}
+
+void pulse_counter_add_batch(pulse_counter_t *c, uint32_t n, int64_t last_us, int64_t prev_us)
+{
+    if (n == 0) {
+        return;
+    }
+    while (!counter_claim(c)) {
+    }
+    c->prev_us = n > 1 ? prev_us : c->last_us;
+    c->last_us = last_us;
+    c->total = c->total > UINT64_MAX - n ? UINT64_MAX : c->total + n;
+    c->counted += n;
+    counter_release(c);
+}
+
+void pulse_counter_set_total(pulse_counter_t *c, uint64_t total)
+{
+    while (!counter_claim(c)) {
+    }
+    c->total = total;
+    counter_release(c);
+}
+
+void pulse_counter_read(const pulse_counter_t *c, pulse_counter_snapshot_t *out)
+{
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+        out->total = c->total;
+        out->counted = c->counted;
+        out->last_us = c->last_us;
+        out->prev_us = c->prev_us;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1u) || seq != __atomic_load_n(&c->seq, __ATOMIC_RELAXED));
+}
+
+uint64_t pulse_counter_total(const pulse_counter_t *c)
+{
+    pulse_counter_snapshot_t snap;
+    pulse_counter_read(c, &snap);
+    return snap.total;
+}
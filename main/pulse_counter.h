@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Authoritative counter record of one pulse input, shared by pulse.c (writer) and metering.c
+ * and the Zigbee task (readers). Published with a sequence lock: a writer makes seq odd,
+ * updates the fields and makes it even again; readers copy the fields and retry if seq was
+ * odd or moved under them. Readers never block the writer and nobody masks interrupts.
+ *
+ * Writers claim seq with a compare-and-swap instead of spinning. The pulse path cannot wait: it
+ * may have preempted the holder (a reset from the Zigbee task, an LP core import), so it leaves
+ * its pulse in an atomic deferred count that the holder applies before it lets go. Other
+ * writers wait for the claim.
+ * A reader must not preempt a writer on the same core, i.e. do not read from a task that
+ * outranks the pulse callbacks (esp_timer task) or from an ISR.
+ */
+typedef struct {
+    volatile uint32_t seq;
+    uint64_t total;         /* persisted total, what the meter reports */
+    uint64_t counted;       /* pulses counted since boot; never reset, consumers diff it */
+    int64_t last_us;        /* timestamp of the last counted pulse, 0 if none */
+    int64_t prev_us;        /* timestamp of the one before, 0 if none */
+    volatile uint32_t deferred;             /* pulses added while another writer held seq */
+    volatile int64_t deferred_us;           /* timestamp of the latest of them */
+    volatile int64_t deferred_debounce_us;
+} pulse_counter_t;
+
+typedef struct {
+    uint64_t total;
+    uint64_t counted;
+    int64_t last_us;
+    int64_t prev_us;
+} pulse_counter_snapshot_t;
+
+void pulse_counter_init(pulse_counter_t *c, uint64_t total);
+/* Count one pulse at now_us unless it falls within debounce_us of the last one. If another
+ * writer holds the record the pulse is deferred to it and applied, debounce included, before it
+ * releases; that also returns true.
+ */
+bool pulse_counter_add(pulse_counter_t *c, int64_t now_us, int64_t debounce_us);
+/* Count n pulses counted elsewhere (the LP core), the latest at last_us and, if n > 1, the one
+ * before at prev_us. Waits for a concurrent writer; no debounce, the source applied it.
+ */
+void pulse_counter_add_batch(pulse_counter_t *c, uint32_t n, int64_t last_us, int64_t prev_us);
+/* Overwrite the total (counter reset); waits for a concurrent writer. */
+void pulse_counter_set_total(pulse_counter_t *c, uint64_t total);
+void pulse_counter_read(const pulse_counter_t *c, pulse_counter_snapshot_t *out);
+uint64_t pulse_counter_total(const pulse_counter_t *c);
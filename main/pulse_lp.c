@@ -0,0 +1,124 @@
+#include "pulse_lp.h"
+
+#include "sdkconfig.h"
+
+#if CONFIG_PULSE_LP_CORE
+
+#include "driver/rtc_io.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ulp_lp_core.h"
+#include "ulp_pulse.h"
+#include "lp_pulse_sm.h"
+#include "tlog.h"
+
+static const char *TAG = "pulse_lp";
+
+extern const uint8_t ulp_pulse_bin_start[] asm("_binary_ulp_pulse_bin_start");
+extern const uint8_t ulp_pulse_bin_end[] asm("_binary_ulp_pulse_bin_end");
+
+/* The LP program's lp_pulse, exported by the ULP build as ulp_lp_pulse. */
+#define PULSE_LP_SHARED ((lp_pulse_t *)&ulp_lp_pulse)
+
+static bool s_running;
+
+esp_err_t pulse_lp_start(const pulse_config_t *cfgs, size_t channels, uint32_t wake_pulses, bool resume)
+{
+    if (!cfgs || channels == 0 || channels > LP_PULSE_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    lp_pulse_cfg_t cfg = {
+        .channels = (uint32_t)channels,
+        .sample_us = CONFIG_PULSE_LP_SAMPLE_MS * 1000u,
+        .wake_pulses = wake_pulses,
+        .strobe_settle_us = CONFIG_PULSE_PULL_STROBED ? CONFIG_PULSE_STROBE_SETTLE_US : 0,
+    };
+    for (size_t i = 0; i < channels; i++) {
+        if (!rtc_gpio_is_valid_gpio((gpio_num_t)cfgs[i].gpio_num)) {
+            ESP_LOGE(TAG, "Pulse channel %u: GPIO%d is not an LP IO", (unsigned)i, cfgs[i].gpio_num);
+            return ESP_ERR_INVALID_ARG;
+        }
+        cfg.chan[i] = (lp_pulse_chan_cfg_t){
+            .gpio = (uint32_t)cfgs[i].gpio_num,
+            .debounce_ticks = lp_pulse_ticks(cfgs[i].debounce_ms, cfg.sample_us),
+            .min_width_ticks = lp_pulse_ticks(cfgs[i].min_width_ms, cfg.sample_us),
+        };
+    }
+
+    lp_pulse_t *lp = PULSE_LP_SHARED;
+    if (resume && lp_pulse_valid(lp, &cfg)) {
+        /* Counted on through deep sleep; the untaken pulses are picked up by the first poll. */
+        s_running = true;
+        APP_LOGI(LP_PULSE_RESUMED, (unsigned)lp->wakes, (unsigned)lp->tick);
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i < channels; i++) {
+        gpio_num_t gpio = (gpio_num_t)cfgs[i].gpio_num;
+        rtc_gpio_init(gpio);
+        rtc_gpio_set_direction(gpio, RTC_GPIO_MODE_INPUT_ONLY);
+        /* Strobed: the program pulls up only to sample. External: the board's resistor does. */
+        if (CONFIG_PULSE_PULL_STROBED) {
+            rtc_gpio_pullup_dis(gpio);
+            rtc_gpio_pulldown_en(gpio);
+        } else if (CONFIG_PULSE_PULL_EXTERNAL) {
+            rtc_gpio_pullup_dis(gpio);
+            rtc_gpio_pulldown_dis(gpio);
+        } else {
+            rtc_gpio_pullup_en(gpio);
+            rtc_gpio_pulldown_dis(gpio);
+        }
+    }
+
+    esp_err_t err = ulp_lp_core_load_binary(ulp_pulse_bin_start, ulp_pulse_bin_end - ulp_pulse_bin_start);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "LP core load failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    /* After the load, which clears the program's data. */
+    lp_pulse_init(lp, &cfg);
+
+    ulp_lp_core_cfg_t run = {
+        .wakeup_source = ULP_LP_CORE_WAKEUP_SOURCE_LP_TIMER,
+        .lp_timer_sleep_duration_us = cfg.sample_us,
+    };
+    err = ulp_lp_core_run(&run);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "LP core start failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_running = true;
+    APP_LOGI(LP_PULSE_STARTED, (unsigned)channels, (unsigned)CONFIG_PULSE_LP_SAMPLE_MS, (unsigned)lp->cfg.wake_pulses);
+    return ESP_OK;
+}
+
+/* esp_timer time of an LP tick; ticks from before this boot clamp to its start. */
+static int64_t pulse_lp_tick_us(const lp_pulse_snapshot_t *snap, uint64_t tick, int64_t now_us)
+{
+    if (tick == 0) {
+        return 0;
+    }
+    int64_t ts = now_us - (int64_t)(snap->tick - tick) * (int64_t)PULSE_LP_SHARED->cfg.sample_us;
+    return ts > 0 ? ts : 1;
+}
+
+void pulse_lp_poll(size_t channel, pulse_t *p)
+{
+    if (!s_running) {
+        return;
+    }
+    lp_pulse_snapshot_t snap;
+    uint32_t n = lp_pulse_take(PULSE_LP_SHARED, channel, &snap);
+    if (n == 0) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    pulse_import(p, n, pulse_lp_tick_us(&snap, snap.last_tick, now), pulse_lp_tick_us(&snap, snap.prev_tick, now));
+}
+
+bool pulse_lp_due(size_t channel)
+{
+    return s_running && lp_pulse_due(PULSE_LP_SHARED, channel);
+}
+
+#endif /* CONFIG_PULSE_LP_CORE */
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "pulse.h"
+
+#ifndef CONFIG_PULSE_LP_SAMPLE_MS
+#define CONFIG_PULSE_LP_SAMPLE_MS 5
+#endif
+
+/* HP side of the LP core pulse backend (CONFIG_PULSE_LP_CORE, ESP32-C6): loads and starts the
+ * LP program that runs lp_pulse_sm.c on the pulse pins and moves its counts into the pulse_t inputs.
+ * The LP core keeps counting through light and deep sleep and wakes the HP core (ULP wake) once
+ * an input has wake_pulses untaken pulses.
+ */
+
+/* cfgs[i] is input i. resume: a deep-sleep boot, keep a program that is already running with the
+ * same settings (and its untaken pulses) instead of restarting it.
+ */
+esp_err_t pulse_lp_start(const pulse_config_t *cfgs, size_t channels, uint32_t wake_pulses, bool resume);
+/* Move the pulses the LP core counted on input channel into p. */
+void pulse_lp_poll(size_t channel, pulse_t *p);
+/* Input channel has enough untaken pulses to wake the HP core. */
+bool pulse_lp_due(size_t channel);
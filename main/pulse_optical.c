@@ -0,0 +1,117 @@
+#include "pulse_optical.h"
+
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+static const char *TAG = "pulse_optical";
+
+static pulse_optical_cfg_t s_cfg;
+static pulse_t *s_pulse;
+static optical_pulse_t s_detect;
+static pulse_optical_stats_t s_stats;
+static esp_timer_handle_t s_timer;
+
+static bool pulse_optical_read(int *raw)
+{
+    if (adc_oneshot_read(s_cfg.adc, s_cfg.channel, raw) != ESP_OK) {
+        s_stats.read_errors++;
+        return false;
+    }
+    return true;
+}
+
+static void pulse_optical_sample_cb(void *arg)
+{
+    (void)arg;
+    int64_t t0 = esp_timer_get_time();
+    int reading = 0;
+    bool ok;
+
+    if (s_cfg.emitter_gpio >= 0) {
+        int dark = 0;
+        ok = pulse_optical_read(&dark);
+        gpio_set_level((gpio_num_t)s_cfg.emitter_gpio, 1);
+        esp_rom_delay_us(s_cfg.emitter_settle_us);
+        ok = pulse_optical_read(&reading) && ok;
+        gpio_set_level((gpio_num_t)s_cfg.emitter_gpio, 0);
+        reading -= dark;
+    } else {
+        ok = pulse_optical_read(&reading);
+    }
+
+    if (ok) {
+        /* Stamped at the start of the sample, so edges are on the sample grid. */
+        optical_pulse_edge_t edge = optical_pulse_sample(&s_detect, reading);
+        if (edge != OPTICAL_PULSE_NONE) {
+            s_stats.edges++;
+            pulse_feed_edge(s_pulse, edge == OPTICAL_PULSE_ON, t0);
+        }
+        s_stats.samples++;
+        s_stats.last_reading = reading;
+        s_stats.span = optical_pulse_span(&s_detect);
+    }
+    s_stats.awake_us += (uint64_t)(esp_timer_get_time() - t0);
+}
+
+esp_err_t pulse_optical_start(pulse_t *p, const pulse_optical_cfg_t *cfg)
+{
+    if (!p || !cfg || !cfg->adc || cfg->sample_hz == 0 || cfg->sample_hz > 1000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pulse_optical_stop();
+
+    adc_oneshot_chan_cfg_t chan_cfg = {
+        .atten = cfg->atten,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    esp_err_t err = adc_oneshot_config_channel(cfg->adc, cfg->channel, &chan_cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "adc_oneshot_config_channel failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    if (cfg->emitter_gpio >= 0) {
+        gpio_config_t io_cfg = {
+            .pin_bit_mask = 1ULL << cfg->emitter_gpio,
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+        err = gpio_config(&io_cfg);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Emitter GPIO%d: %s", cfg->emitter_gpio, esp_err_to_name(err));
+            return err;
+        }
+        gpio_set_level((gpio_num_t)cfg->emitter_gpio, 0);
+    }
+    if (!s_timer) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = pulse_optical_sample_cb,
+            .name = "pulse_optical",
+        };
+        err = esp_timer_create(&timer_args, &s_timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    s_cfg = *cfg;
+    s_pulse = p;
+    s_stats = (pulse_optical_stats_t){0};
+    optical_pulse_init(&s_detect, &cfg->detect);
+    return esp_timer_start_periodic(s_timer, 1000000ULL / cfg->sample_hz);
+}
+
+void pulse_optical_stop(void)
+{
+    if (s_timer) {
+        (void)esp_timer_stop(s_timer);
+    }
+}
+
+const pulse_optical_stats_t *pulse_optical_stats(void)
+{
+    return &s_stats;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_adc/adc_oneshot.h"
+#include "optical_pulse_detect.h"
+#include "pulse.h"
+
+#ifndef CONFIG_OPTICAL_SAMPLE_HZ
+#define CONFIG_OPTICAL_SAMPLE_HZ 50
+#endif
+#ifndef CONFIG_OPTICAL_ADC_ATTEN
+#define CONFIG_OPTICAL_ADC_ATTEN 3
+#endif
+#ifndef CONFIG_OPTICAL_ACTIVE_LOW
+#define CONFIG_OPTICAL_ACTIVE_LOW 0
+#endif
+#ifndef CONFIG_OPTICAL_EMITTER_GPIO
+#define CONFIG_OPTICAL_EMITTER_GPIO -1
+#endif
+#ifndef CONFIG_OPTICAL_EMITTER_SETTLE_US
+#define CONFIG_OPTICAL_EMITTER_SETTLE_US 50
+#endif
+#ifndef CONFIG_OPTICAL_MIN_SPAN
+#define CONFIG_OPTICAL_MIN_SPAN 100
+#endif
+#ifndef CONFIG_OPTICAL_HYSTERESIS_PCT
+#define CONFIG_OPTICAL_HYSTERESIS_PCT 15
+#endif
+#ifndef CONFIG_OPTICAL_TRACK_S
+#define CONFIG_OPTICAL_TRACK_S 10
+#endif
+
+/* Sampling engine of the optical input (CONFIG_PULSE_SOURCE_OPTICAL): a periodic esp_timer
+ * wakes the CPU sample_hz times a second for one oneshot ADC reading of the sensor, runs
+ * optical_pulse_detect.c on it and feeds the edges to pulse.c. The CPU sleeps between samples
+ * (light sleep ends at the next esp_timer alarm).
+ *
+ * With an emitter (the IR LED of a reflective sensor) the LED is lit only for the reading, and
+ * a dark reading is subtracted from the lit one so ambient light cancels out.
+ */
+
+typedef struct {
+    adc_oneshot_unit_handle_t adc;  /* shared unit handle (adc_sampler_oneshot_unit()) */
+    adc_channel_t channel;
+    adc_atten_t atten;
+    int emitter_gpio;               /* -1: a self-lit source such as a meter LED */
+    uint32_t emitter_settle_us;     /* emitter on before the lit reading */
+    uint32_t sample_hz;
+    optical_pulse_cfg_t detect;
+} pulse_optical_cfg_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t edges;
+    uint32_t read_errors;
+    uint64_t awake_us;              /* time spent in the sample callback */
+    int last_reading;
+    int span;
+} pulse_optical_stats_t;
+
+/* Start sampling for input p. Calling it again restarts with cfg. */
+esp_err_t pulse_optical_start(pulse_t *p, const pulse_optical_cfg_t *cfg);
+void pulse_optical_stop(void);
+const pulse_optical_stats_t *pulse_optical_stats(void);
@@ -0,0 +1,156 @@
+#include "report_queue.h"
+
+#include <string.h>
+
+static report_queue_config_t s_cfg;
+static report_queue_entry_t s_ring[CONFIG_REPORT_QUEUE_DEPTH];
+static size_t s_head;       /* oldest entry */
+static size_t s_count;
+static report_queue_stats_t s_stats;
+static uint8_t s_failures;
+static bool s_down;
+static uint32_t s_probe_at_s;
+static uint32_t s_probe_delay_s;
+
+static void report_queue_inc(uint32_t *v)
+{
+    if (*v != UINT32_MAX) {
+        (*v)++;
+    }
+}
+
+static const report_queue_entry_t *report_queue_newest(uint8_t channel)
+{
+    for (size_t i = s_count; i > 0; i--) {
+        const report_queue_entry_t *e = &s_ring[(s_head + i - 1) % CONFIG_REPORT_QUEUE_DEPTH];
+        if (e->channel == channel) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+void report_queue_push(uint32_t now_s, uint8_t channel, uint64_t summation, int32_t demand)
+{
+    const report_queue_entry_t *last = report_queue_newest(channel);
+    if (last && last->summation == summation && last->demand == demand) {
+        return;     /* nothing new to deliver */
+    }
+    if (s_count == CONFIG_REPORT_QUEUE_DEPTH) {
+        s_head = (s_head + 1) % CONFIG_REPORT_QUEUE_DEPTH;
+        s_count--;
+        report_queue_inc(&s_stats.dropped);
+    }
+    report_queue_entry_t *e = &s_ring[(s_head + s_count) % CONFIG_REPORT_QUEUE_DEPTH];
+    e->t_s = now_s;
+    e->demand = demand;
+    e->summation = summation;
+    e->channel = channel;
+    s_count++;
+    report_queue_inc(&s_stats.queued);
+}
+
+void report_queue_init(const report_queue_config_t *cfg)
+{
+    s_cfg = *cfg;
+    if (s_cfg.fail_limit == 0) {
+        s_cfg.fail_limit = 1;
+    }
+    if (s_cfg.probe_max_s < s_cfg.probe_s) {
+        s_cfg.probe_max_s = s_cfg.probe_s;
+    }
+    s_head = 0;
+    s_count = 0;
+    s_failures = 0;
+    s_down = false;
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+bool report_queue_on_failure(uint32_t now_s)
+{
+    if (s_down) {
+        /* A probe failed: back off. */
+        s_probe_delay_s = s_probe_delay_s > s_cfg.probe_max_s / 2 ? s_cfg.probe_max_s : s_probe_delay_s * 2;
+        s_probe_at_s = now_s + s_probe_delay_s;
+        return false;
+    }
+    if (s_failures < UINT8_MAX) {
+        s_failures++;
+    }
+    if (s_failures < s_cfg.fail_limit) {
+        return false;
+    }
+    s_down = true;
+    s_probe_delay_s = s_cfg.probe_s;
+    s_probe_at_s = now_s + s_probe_delay_s;
+    report_queue_inc(&s_stats.outages);
+    return true;
+}
+
+bool report_queue_on_success(void)
+{
+    s_failures = 0;
+    if (!s_down) {
+        return false;
+    }
+    s_down = false;
+    return true;
+}
+
+bool report_queue_link_down(void)
+{
+    return s_down;
+}
+
+void report_queue_sample(uint32_t now_s, uint8_t channel, uint64_t summation, int32_t demand)
+{
+    if (!s_down) {
+        return;
+    }
+    const report_queue_entry_t *last = report_queue_newest(channel);
+    uint32_t age_s = last ? now_s - last->t_s : UINT32_MAX;
+    bool changed = !last || last->summation != summation;
+    if ((changed && age_s >= s_cfg.sample_min_s) || age_s >= s_cfg.sample_max_s) {
+        report_queue_push(now_s, channel, summation, demand);
+    }
+}
+
+bool report_queue_probe_due(uint32_t now_s)
+{
+    if (!s_down || (int32_t)(now_s - s_probe_at_s) < 0) {
+        return false;
+    }
+    /* Rearmed by the probe's send status; this only guards against a lost callback. */
+    s_probe_at_s = now_s + s_probe_delay_s;
+    report_queue_inc(&s_stats.probes);
+    return true;
+}
+
+size_t report_queue_count(void)
+{
+    return s_count;
+}
+
+size_t report_queue_peek(report_queue_entry_t *out, size_t max)
+{
+    size_t n = max < s_count ? max : s_count;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_ring[(s_head + i) % CONFIG_REPORT_QUEUE_DEPTH];
+    }
+    return n;
+}
+
+void report_queue_pop(size_t n)
+{
+    if (n > s_count) {
+        n = s_count;
+    }
+    s_head = (s_head + n) % CONFIG_REPORT_QUEUE_DEPTH;
+    s_count -= n;
+    s_stats.flushed += (uint32_t)n;
+}
+
+const report_queue_stats_t *report_queue_stats(void)
+{
+    return &s_stats;
+}
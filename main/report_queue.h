@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+/* Store-and-forward buffering of metering reports while the parent is unreachable.
+ * main.c feeds it the ZCL send results from the stack's callbacks and asks it when to stop and
+ * restart attribute reporting, probe the link and flush the backlog, all on the Zigbee task.
+ */
+
+#ifndef CONFIG_REPORT_QUEUE_DEPTH
+#define CONFIG_REPORT_QUEUE_DEPTH 32
+#endif
+
+typedef struct {
+    uint32_t t_s;           /* uptime when the snapshot was taken */
+    int32_t demand;
+    uint64_t summation;
+    uint8_t channel;        /* pulse channel the snapshot belongs to */
+} report_queue_entry_t;
+
+typedef struct {
+    uint32_t queued;        /* snapshots taken */
+    uint32_t dropped;       /* oldest snapshots overwritten while the queue was full */
+    uint32_t flushed;       /* snapshots delivered after the link returned */
+    uint32_t outages;       /* times the link was declared down */
+    uint32_t probes;        /* link probes sent while down */
+} report_queue_stats_t;
+
+typedef struct {
+    uint8_t fail_limit;     /* consecutive failures before the link is declared down */
+    uint32_t probe_s;       /* first probe delay; doubles per failed probe */
+    uint32_t probe_max_s;
+    uint32_t sample_min_s;  /* while down: snapshot a change no sooner than this */
+    uint32_t sample_max_s;  /* while down: snapshot at least this often */
+} report_queue_config_t;
+
+void report_queue_init(const report_queue_config_t *cfg);
+
+/* Snapshot one channel's meter; skipped when it equals that channel's newest snapshot. */
+void report_queue_push(uint32_t now_s, uint8_t channel, uint64_t summation, int32_t demand);
+/* A ZCL send failed (push the meters first). Returns true when this failure takes the link down. */
+bool report_queue_on_failure(uint32_t now_s);
+/* A ZCL send succeeded. Returns true when this brings the link back up. */
+bool report_queue_on_success(void);
+bool report_queue_link_down(void);
+
+/* While the link is down, snapshot a channel on the schedule reporting would have used. */
+void report_queue_sample(uint32_t now_s, uint8_t channel, uint64_t summation, int32_t demand);
+/* True (and the probe is accounted) when a link probe should be sent now. */
+bool report_queue_probe_due(uint32_t now_s);
+
+size_t report_queue_count(void);
+/* Copy up to max oldest entries without removing them; pop once they were delivered. */
+size_t report_queue_peek(report_queue_entry_t *out, size_t max);
+void report_queue_pop(size_t n);
+const report_queue_stats_t *report_queue_stats(void);
@@ -0,0 +1,29 @@
+#include "save_sched.h"
+
+void save_sched_init(save_sched_t *s, int64_t interval_us, int64_t quiet_us, int64_t now_us)
+{
+    s->interval_us = interval_us;
+    s->quiet_us = quiet_us;
+    s->last_save_us = now_us;
+    s->dirty = false;
+}
+
+void save_sched_mark(save_sched_t *s)
+{
+    s->dirty = true;
+}
+
+bool save_sched_due(const save_sched_t *s, int64_t now_us, int64_t last_pulse_us)
+{
+    if (!s->dirty) {
+        return false;
+    }
+    return (now_us - s->last_save_us) >= s->interval_us ||
+           (last_pulse_us > 0 && (now_us - last_pulse_us) >= s->quiet_us);
+}
+
+void save_sched_done(save_sched_t *s, int64_t now_us)
+{
+    s->dirty = false;
+    s->last_save_us = now_us;
+}
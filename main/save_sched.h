@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* When to write a channel's pulse total to NVS: once the input has been quiet for quiet_us
+ * after a pulse, and at the latest interval_us after the previous save while pulses keep
+ * coming. Pure so the host simulator replays the firmware's flash-write decisions.
+ */
+typedef struct {
+    int64_t interval_us;
+    int64_t quiet_us;
+    int64_t last_save_us;
+    bool dirty;
+} save_sched_t;
+
+void save_sched_init(save_sched_t *s, int64_t interval_us, int64_t quiet_us, int64_t now_us);
+/* The total changed since the last save. */
+void save_sched_mark(save_sched_t *s);
+bool save_sched_due(const save_sched_t *s, int64_t now_us, int64_t last_pulse_us);
+/* The total was written (or deliberately not, e.g. before a factory reset). */
+void save_sched_done(save_sched_t *s, int64_t now_us);
@@ -0,0 +1,85 @@
+#include "sleep_stats.h"
+
+#include <string.h>
+#include <stddef.h>
+
+#define SLEEP_STATS_MAGIC 0x534C5053u /* "SLPS" */
+
+const uint32_t sleep_stats_bucket_ms[SLEEP_STATS_BUCKETS - 1] = {
+    10, 50, 200, 1000, 5000, 30000, 120000,
+};
+
+static sleep_stats_t s_stats;
+
+static uint32_t sleep_stats_checksum(const sleep_stats_t *st)
+{
+    /* FNV-1a over everything before the checksum field. */
+    const uint8_t *p = (const uint8_t *)st;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < offsetof(sleep_stats_t, checksum); i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void sleep_stats_inc(uint32_t *v)
+{
+    if (*v != UINT32_MAX) {
+        (*v)++;
+    }
+}
+
+void sleep_stats_reset(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.magic = SLEEP_STATS_MAGIC;
+}
+
+void sleep_stats_wake(sleep_wake_t cause, uint32_t slept_ms)
+{
+    if ((unsigned)cause >= SLEEP_WAKE_COUNT) {
+        cause = SLEEP_WAKE_OTHER;
+    }
+    sleep_stats_inc(&s_stats.wakes[cause]);
+
+    size_t bucket = 0;
+    while (bucket < SLEEP_STATS_BUCKETS - 1 && slept_ms >= sleep_stats_bucket_ms[bucket]) {
+        bucket++;
+    }
+    sleep_stats_inc(&s_stats.hist[bucket]);
+
+    if (slept_ms > s_stats.max_sleep_ms) {
+        s_stats.max_sleep_ms = slept_ms;
+    }
+}
+
+void sleep_stats_skip(sleep_skip_t reason)
+{
+    if ((unsigned)reason < SLEEP_SKIP_COUNT) {
+        sleep_stats_inc(&s_stats.skips[reason]);
+    }
+}
+
+const sleep_stats_t *sleep_stats_get(void)
+{
+    return &s_stats;
+}
+
+void sleep_stats_snapshot(sleep_stats_t *dst)
+{
+    if (!dst) {
+        return;
+    }
+    *dst = s_stats;
+    dst->magic = SLEEP_STATS_MAGIC;
+    dst->checksum = sleep_stats_checksum(dst);
+}
+
+bool sleep_stats_restore(const sleep_stats_t *src)
+{
+    if (!src || src->magic != SLEEP_STATS_MAGIC || src->checksum != sleep_stats_checksum(src)) {
+        return false;
+    }
+    s_stats = *src;
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Wake-cause, sleep-duration and sleep-skip counters for the sleepy end device.
+ * The firmware keeps a copy in RTC memory so the counters survive a software reset. Updated
+ * around esp_zb_sleep_now(), on the Zigbee task.
+ */
+
+typedef enum {
+    SLEEP_WAKE_PULSE = 0,   /* EXT1 on the pulse input */
+    SLEEP_WAKE_BUTTON,      /* EXT1 on the factory-reset button */
+    SLEEP_WAKE_TIMER,       /* stack timer, mostly parent polls */
+    SLEEP_WAKE_RADIO,       /* modem wake */
+    SLEEP_WAKE_OTHER,
+    SLEEP_WAKE_COUNT,
+} sleep_wake_t;
+
+typedef enum {
+    SLEEP_SKIP_NOT_JOINED = 0,
+    SLEEP_SKIP_PIN_ASSERTED,
+    SLEEP_SKIP_POST_JOIN,
+    SLEEP_SKIP_COUNT,
+} sleep_skip_t;
+
+/* Sleep duration histogram upper bounds in ms; the last bucket is open-ended. */
+#define SLEEP_STATS_BUCKETS 8
+extern const uint32_t sleep_stats_bucket_ms[SLEEP_STATS_BUCKETS - 1];
+
+typedef struct {
+    uint32_t magic;
+    uint32_t wakes[SLEEP_WAKE_COUNT];
+    uint32_t skips[SLEEP_SKIP_COUNT];
+    uint32_t hist[SLEEP_STATS_BUCKETS];
+    uint32_t max_sleep_ms;
+    uint32_t checksum;
+} sleep_stats_t;
+
+void sleep_stats_reset(void);
+void sleep_stats_wake(sleep_wake_t cause, uint32_t slept_ms);
+void sleep_stats_skip(sleep_skip_t reason);
+const sleep_stats_t *sleep_stats_get(void);
+
+/* Copy the counters into (or restore them from) a retained snapshot. Restore returns false
+ * and leaves the counters untouched if the snapshot's magic or checksum do not match.
+ */
+void sleep_stats_snapshot(sleep_stats_t *dst);
+bool sleep_stats_restore(const sleep_stats_t *src);
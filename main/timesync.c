@@ -0,0 +1,96 @@
+#include "timesync.h"
+
+static bool s_valid;
+static int64_t s_anchor_local_us;
+static int64_t s_anchor_utc_us;
+static int32_t s_local_offset_s;
+static int32_t s_drift_ppm;
+static bool s_drift_known;
+static int64_t s_drift_base_local_us;
+static int64_t s_drift_base_utc_us;
+static int32_t s_last_error_ms;
+
+static int64_t timesync_predict_us(int64_t local_us)
+{
+    int64_t elapsed = local_us - s_anchor_local_us;
+    return s_anchor_utc_us + elapsed + elapsed * s_drift_ppm / 1000000LL;
+}
+
+void timesync_reset(void)
+{
+    s_valid = false;
+    s_drift_ppm = 0;
+    s_drift_known = false;
+    s_last_error_ms = 0;
+}
+
+void timesync_update(int64_t local_us, uint32_t utc_s, int32_t local_offset_s)
+{
+    /* The attribute is whole seconds; assume we are halfway through the second. */
+    int64_t utc_us = (int64_t)utc_s * 1000000LL + 500000LL;
+    s_local_offset_s = local_offset_s;
+
+    if (s_valid) {
+        int64_t err_us = utc_us - timesync_predict_us(local_us);
+        s_last_error_ms = (int32_t)(err_us / 1000LL);
+        if (err_us > (int64_t)TIMESYNC_MAX_STEP_S * 1000000LL || err_us < -(int64_t)TIMESYNC_MAX_STEP_S * 1000000LL) {
+            /* Coordinator clock stepped: restart drift estimation from here. */
+            s_drift_base_local_us = local_us;
+            s_drift_base_utc_us = utc_us;
+        } else {
+            int64_t base_local = local_us - s_drift_base_local_us;
+            if (base_local >= (int64_t)TIMESYNC_MIN_DRIFT_BASELINE_S * 1000000LL) {
+                int64_t base_utc = utc_us - s_drift_base_utc_us;
+                int64_t ppm = (base_utc - base_local) * 1000000LL / base_local;
+                if (ppm > TIMESYNC_MAX_DRIFT_PPM) {
+                    ppm = TIMESYNC_MAX_DRIFT_PPM;
+                } else if (ppm < -TIMESYNC_MAX_DRIFT_PPM) {
+                    ppm = -TIMESYNC_MAX_DRIFT_PPM;
+                }
+                /* Average with the previous window to smooth temperature swings. */
+                s_drift_ppm = s_drift_known ? (int32_t)((s_drift_ppm + ppm) / 2) : (int32_t)ppm;
+                s_drift_known = true;
+                s_drift_base_local_us = local_us;
+                s_drift_base_utc_us = utc_us;
+            }
+        }
+    } else {
+        s_drift_base_local_us = local_us;
+        s_drift_base_utc_us = utc_us;
+    }
+
+    s_anchor_local_us = local_us;
+    s_anchor_utc_us = utc_us;
+    s_valid = true;
+}
+
+bool timesync_valid(void)
+{
+    return s_valid;
+}
+
+uint32_t timesync_utc(int64_t local_us)
+{
+    if (!s_valid) {
+        return 0;
+    }
+    return (uint32_t)(timesync_predict_us(local_us) / 1000000LL);
+}
+
+uint32_t timesync_local(int64_t local_us)
+{
+    if (!s_valid) {
+        return 0;
+    }
+    return timesync_utc(local_us) + (uint32_t)s_local_offset_s;
+}
+
+int32_t timesync_drift_ppm(void)
+{
+    return s_drift_ppm;
+}
+
+int32_t timesync_last_error_ms(void)
+{
+    return s_last_error_ms;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Wall-clock time from the coordinator's Time cluster, kept as an offset on the monotonic
+ * esp_timer clock and corrected for the local oscillator's drift between syncs.
+ * Times are ZCL UTC: seconds since 2000-01-01 00:00 UTC. Zigbee task only.
+ */
+
+/* Syncs closer together than this do not update the drift estimate (1 s quantization). */
+#define TIMESYNC_MIN_DRIFT_BASELINE_S 3600
+/* Larger corrections are treated as a clock step on the coordinator, not drift. */
+#define TIMESYNC_MAX_STEP_S 600
+#define TIMESYNC_MAX_DRIFT_PPM 50000
+
+void timesync_reset(void);
+/* Anchor utc_s (and the local offset: time zone + DST, in seconds) at local time local_us. */
+void timesync_update(int64_t local_us, uint32_t utc_s, int32_t local_offset_s);
+bool timesync_valid(void);
+/* Drift-corrected UTC / local standard-or-DST time at local_us; 0 until the first sync. */
+uint32_t timesync_utc(int64_t local_us);
+uint32_t timesync_local(int64_t local_us);
+/* Estimated local clock error in ppm (positive: esp_timer runs slow). */
+int32_t timesync_drift_ppm(void);
+/* Correction applied by the latest sync (UTC minus prediction, ms). */
+int32_t timesync_last_error_ms(void);
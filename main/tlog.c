@@ -0,0 +1,220 @@
+#include "tlog.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+#include "driver/usb_serial_jtag.h"
+#endif
+
+#ifndef CONFIG_TLOG_RING_SIZE
+#define CONFIG_TLOG_RING_SIZE 1024
+#endif
+#ifndef CONFIG_TLOG_RING_RTC
+#define CONFIG_TLOG_RING_RTC 0
+#endif
+#ifndef CONFIG_TLOG_DRAIN_ALWAYS
+#define CONFIG_TLOG_DRAIN_ALWAYS 0
+#endif
+
+#if CONFIG_APP_LOG_TOKENIZED
+
+#define TLOG_MAGIC 0x544C4F47u /* "TLOG" */
+#define TLOG_HDR_LEN 8         /* len, id (2), level, timestamp ms (4) */
+#define TLOG_REC_MAX 255
+#define TLOG_STR_MAX 32
+#define TLOG_LEVEL_TRUNCATED 0x80
+#define TLOG_DRAIN_BATCH 16
+
+/* Records are byte-packed little-endian:
+ *   [len][id lo][id hi][level][ts ms x4][args...]
+ * u32 args take 4 bytes, u64 args 8, strings a length byte plus up to TLOG_STR_MAX chars.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t head;
+    uint16_t tail;
+    uint16_t used;
+    uint32_t dropped;
+    uint8_t buf[CONFIG_TLOG_RING_SIZE];
+} tlog_ring_t;
+
+#if CONFIG_TLOG_RING_RTC
+static RTC_NOINIT_ATTR tlog_ring_t s_ring;
+#else
+static tlog_ring_t s_ring;
+#endif
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_host_was_attached;
+
+void tlog_init(void)
+{
+    if (s_ring.magic != TLOG_MAGIC || s_ring.head >= sizeof(s_ring.buf) ||
+        s_ring.tail >= sizeof(s_ring.buf) || s_ring.used > sizeof(s_ring.buf)) {
+        memset(&s_ring, 0, sizeof(s_ring));
+        s_ring.magic = TLOG_MAGIC;
+    }
+}
+
+static uint8_t tlog_peek(uint16_t offset)
+{
+    return s_ring.buf[(s_ring.tail + offset) % sizeof(s_ring.buf)];
+}
+
+static void tlog_drop_oldest(void)
+{
+    uint8_t len = tlog_peek(0);
+    s_ring.tail = (uint16_t)((s_ring.tail + len) % sizeof(s_ring.buf));
+    s_ring.used -= len;
+    s_ring.dropped++;
+}
+
+static void tlog_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+void tlog_write(esp_log_level_t level, uint16_t id, const tlog_arg_t *args, size_t nargs)
+{
+    uint8_t rec[TLOG_REC_MAX];
+    size_t len = TLOG_HDR_LEN;
+
+    rec[1] = (uint8_t)id;
+    rec[2] = (uint8_t)(id >> 8);
+    rec[3] = (uint8_t)level;
+    tlog_put_u32(&rec[4], (uint32_t)(esp_timer_get_time() / 1000));
+
+    for (size_t i = 0; i < nargs; i++) {
+        const tlog_arg_t *a = &args[i];
+        size_t need;
+        if (a->kind == TLOG_ARG_STR) {
+            const char *s = a->str ? a->str : "(null)";
+            size_t n = strnlen(s, TLOG_STR_MAX);
+            need = 1 + n;
+            if (len + need > sizeof(rec)) {
+                rec[3] |= TLOG_LEVEL_TRUNCATED;
+                break;
+            }
+            rec[len] = (uint8_t)n;
+            memcpy(&rec[len + 1], s, n);
+        } else if (a->kind == TLOG_ARG_U64) {
+            need = 8;
+            if (len + need > sizeof(rec)) {
+                rec[3] |= TLOG_LEVEL_TRUNCATED;
+                break;
+            }
+            tlog_put_u32(&rec[len], (uint32_t)a->u64);
+            tlog_put_u32(&rec[len + 4], (uint32_t)(a->u64 >> 32));
+        } else {
+            need = 4;
+            if (len + need > sizeof(rec)) {
+                rec[3] |= TLOG_LEVEL_TRUNCATED;
+                break;
+            }
+            tlog_put_u32(&rec[len], a->u32);
+        }
+        len += need;
+    }
+    rec[0] = (uint8_t)len;
+    if (len > sizeof(s_ring.buf)) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    while (sizeof(s_ring.buf) - s_ring.used < len) {
+        tlog_drop_oldest();
+    }
+    for (size_t i = 0; i < len; i++) {
+        s_ring.buf[s_ring.head] = rec[i];
+        s_ring.head = (uint16_t)((s_ring.head + 1) % sizeof(s_ring.buf));
+    }
+    s_ring.used += (uint16_t)len;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static bool tlog_host_attached(void)
+{
+#if CONFIG_TLOG_DRAIN_ALWAYS
+    return true;
+#elif CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    return usb_serial_jtag_is_connected();
+#else
+    return false;
+#endif
+}
+
+/* Copy the oldest record out of the ring; returns its length or 0 when empty. */
+static size_t tlog_pop(uint8_t *out)
+{
+    size_t len = 0;
+    portENTER_CRITICAL(&s_lock);
+    if (s_ring.used > 0) {
+        len = tlog_peek(0);
+        for (size_t i = 0; i < len; i++) {
+            out[i] = tlog_peek((uint16_t)i);
+        }
+        s_ring.tail = (uint16_t)((s_ring.tail + len) % sizeof(s_ring.buf));
+        s_ring.used -= (uint16_t)len;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return len;
+}
+
+void tlog_drain(void)
+{
+    if (!tlog_host_attached()) {
+        s_host_was_attached = false;
+        return;
+    }
+    if (!s_host_was_attached) {
+        /* New session: tell the decoder which dictionary to use and what was lost. */
+        printf("#T:H%08" PRIx32 " D%" PRIu32 "\n", (uint32_t)TLOG_DICT_HASH, s_ring.dropped);
+        s_host_was_attached = true;
+    }
+
+    static const char hex[] = "0123456789abcdef";
+    uint8_t rec[TLOG_REC_MAX];
+    char line[4 + 2 * TLOG_REC_MAX + 2];
+    for (int n = 0; n < TLOG_DRAIN_BATCH; n++) {
+        size_t len = tlog_pop(rec);
+        if (len == 0) {
+            break;
+        }
+        memcpy(line, "#T:", 3);
+        size_t pos = 3;
+        for (size_t i = 0; i < len; i++) {
+            line[pos++] = hex[rec[i] >> 4];
+            line[pos++] = hex[rec[i] & 0x0F];
+        }
+        line[pos++] = '\n';
+        line[pos] = '\0';
+        fputs(line, stdout);
+    }
+}
+
+#else /* !CONFIG_APP_LOG_TOKENIZED: APP_LOGI formats directly, nothing to buffer. */
+
+void tlog_init(void)
+{
+}
+
+void tlog_write(esp_log_level_t level, uint16_t id, const tlog_arg_t *args, size_t nargs)
+{
+    (void)level;
+    (void)id;
+    (void)args;
+    (void)nargs;
+}
+
+void tlog_drain(void)
+{
+}
+
+#endif
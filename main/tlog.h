@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "tlog_dict.h"
+
+/* Tokenized logging for the app modules.
+ *
+ *   APP_LOGI(PULSE_COUNTED, count, total);
+ *
+ * The message name refers to a TLOG_MSG entry in log_msgs.def. With APP_LOG_TOKENIZED the
+ * call stores the 16-bit message ID, a millisecond timestamp and the raw arguments in a ring
+ * that is drained as "#T:<hex>" lines while a host is attached; tools/tlog_decode.py turns
+ * them back into text using build/tlog_dict.json. Without it the call is a plain ESP_LOGI
+ * with the format from the dictionary, so both builds print the same text.
+ *
+ * Warnings and errors stay on ESP_LOGW/ESP_LOGE so failures are readable without a decoder.
+ */
+
+#ifndef CONFIG_APP_LOG_TOKENIZED
+#define CONFIG_APP_LOG_TOKENIZED 0
+#endif
+
+typedef enum {
+    TLOG_ARG_U32 = 0,
+    TLOG_ARG_U64,
+    TLOG_ARG_STR,
+} tlog_arg_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    union {
+        uint32_t u32;
+        uint64_t u64;
+        const char *str;
+    };
+} tlog_arg_t;
+
+void tlog_init(void);
+/* Not ISR-safe. Records that do not fit push out the oldest ones. */
+void tlog_write(esp_log_level_t level, uint16_t id, const tlog_arg_t *args, size_t nargs);
+/* Emit buffered records on the console if a host is attached. Call from a task loop. */
+void tlog_drain(void);
+
+static inline tlog_arg_t tlog_arg_int(uint64_t v, size_t size)
+{
+    if (size > sizeof(uint32_t)) {
+        return (tlog_arg_t){ .kind = TLOG_ARG_U64, .u64 = v };
+    }
+    return (tlog_arg_t){ .kind = TLOG_ARG_U32, .u32 = (uint32_t)v };
+}
+
+static inline tlog_arg_t tlog_arg_str(const char *s, size_t size)
+{
+    (void)size;
+    return (tlog_arg_t){ .kind = TLOG_ARG_STR, .str = s };
+}
+
+/* Strings are copied; integers are stored as 4 or 8 bytes depending on their width. */
+#define TLOG_ARG(x) _Generic((x),                                   \
+        char *: tlog_arg_str,                                       \
+        const char *: tlog_arg_str,                                 \
+        default: tlog_arg_int)((x), sizeof(x))
+
+#define TLOG_CAT_(a, b) a##b
+#define TLOG_CAT(a, b) TLOG_CAT_(a, b)
+#define TLOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, n, ...) n
+#define TLOG_NARG(...) TLOG_NARG_(__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TLOG_MAP_0()
+#define TLOG_MAP_1(a) TLOG_ARG(a)
+#define TLOG_MAP_2(a, ...) TLOG_ARG(a), TLOG_MAP_1(__VA_ARGS__)
+#define TLOG_MAP_3(a, ...) TLOG_ARG(a), TLOG_MAP_2(__VA_ARGS__)
+#define TLOG_MAP_4(a, ...) TLOG_ARG(a), TLOG_MAP_3(__VA_ARGS__)
+#define TLOG_MAP_5(a, ...) TLOG_ARG(a), TLOG_MAP_4(__VA_ARGS__)
+#define TLOG_MAP_6(a, ...) TLOG_ARG(a), TLOG_MAP_5(__VA_ARGS__)
+#define TLOG_MAP_7(a, ...) TLOG_ARG(a), TLOG_MAP_6(__VA_ARGS__)
+#define TLOG_MAP_8(a, ...) TLOG_ARG(a), TLOG_MAP_7(__VA_ARGS__)
+#define TLOG_MAP_9(a, ...) TLOG_ARG(a), TLOG_MAP_8(__VA_ARGS__)
+#define TLOG_MAP_10(a, ...) TLOG_ARG(a), TLOG_MAP_9(__VA_ARGS__)
+#define TLOG_MAP_11(a, ...) TLOG_ARG(a), TLOG_MAP_10(__VA_ARGS__)
+#define TLOG_MAP_12(a, ...) TLOG_ARG(a), TLOG_MAP_11(__VA_ARGS__)
+/* The leading dummy keeps the count right for zero arguments (GNU comma swallowing). */
+#define TLOG_MAP(...) TLOG_CAT(TLOG_MAP_, TLOG_NARG(dummy, ##__VA_ARGS__))(__VA_ARGS__)
+
+#if CONFIG_APP_LOG_TOKENIZED
+#define APP_LOGI(name, ...) do {                                                            \
+        if (LOG_LOCAL_LEVEL >= ESP_LOG_INFO) {                                              \
+            const tlog_arg_t tlog_args_[] = { { 0 }, TLOG_MAP(__VA_ARGS__) };               \
+            tlog_write(ESP_LOG_INFO, TLOG_ID_##name, &tlog_args_[1],                        \
+                       sizeof(tlog_args_) / sizeof(tlog_args_[0]) - 1);                     \
+        }                                                                                   \
+    } while (0)
+#else
+#define APP_LOGI(name, ...) ESP_LOGI(TAG, TLOG_FMT_##name, ##__VA_ARGS__)
+#endif
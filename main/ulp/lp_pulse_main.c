@@ -0,0 +1,49 @@
+/* LP core program of CONFIG_PULSE_LP_CORE: woken by the LP timer every sample period, reads the
+ * pulse pins and runs the state machine in lp_pulse_sm.c. Returning halts the core until the next
+ * timer wake. With strobe_settle_us set the pull-ups are on only around the read.
+ */
+#include <stdint.h>
+
+#include "ulp_lp_core.h"
+#include "ulp_lp_core_gpio.h"
+#include "ulp_lp_core_utils.h"
+#include "lp_pulse_sm.h"
+
+/* Shared with the HP core as ulp_lp_pulse; pulse_lp_start() fills cfg before the first run. */
+lp_pulse_t lp_pulse;
+
+static void lp_pulse_pull(bool up)
+{
+    for (uint32_t i = 0; i < lp_pulse.cfg.channels; i++) {
+        lp_io_num_t gpio = (lp_io_num_t)lp_pulse.cfg.chan[i].gpio;
+        if (up) {
+            ulp_lp_core_gpio_pulldown_disable(gpio);
+            ulp_lp_core_gpio_pullup_enable(gpio);
+        } else {
+            ulp_lp_core_gpio_pullup_disable(gpio);
+            ulp_lp_core_gpio_pulldown_enable(gpio);
+        }
+    }
+}
+
+int main(void)
+{
+    uint32_t settle_us = lp_pulse.cfg.strobe_settle_us;
+    if (settle_us) {
+        lp_pulse_pull(true);
+        ulp_lp_core_delay_us(settle_us);
+    }
+    uint32_t low = 0;
+    for (uint32_t i = 0; i < lp_pulse.cfg.channels; i++) {
+        if (ulp_lp_core_gpio_get_level((lp_io_num_t)lp_pulse.cfg.chan[i].gpio) == 0) {
+            low |= 1u << i;
+        }
+    }
+    if (settle_us) {
+        lp_pulse_pull(false);
+    }
+    if (lp_pulse_sample(&lp_pulse, low)) {
+        ulp_lp_core_wakeup_main_processor();
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Decode the post-mortem event trace downloaded from cluster 0xFD10.
+
+Download: for page in 0..ceil(total/8)-1 write attribute 0x0051 = page, then read 0x0052
+(octet string, 8 entries of 8 bytes, oldest first). Pass the pages as hex strings in order,
+one per argument or one per line on stdin:
+
+    evtrace_decode.py 0a000000010c0300... 5b020000030201...
+"""
+
+import struct
+import sys
+
+EVENTS = {
+    1: 'BOOT', 2: 'PULSES', 3: 'SLEEP', 4: 'SLEEP_SKIP', 5: 'STEER',
+    6: 'JOINED', 7: 'TX_STATUS', 8: 'NVS_SAVE', 9: 'OTA', 10: 'REPORT_LINK',
+    11: 'LEAK', 12: 'DEEP_SLEEP',
+}
+RESET_REASONS = {
+    0: 'unknown', 1: 'power-on', 2: 'external', 3: 'software', 4: 'panic', 5: 'int-wdt',
+    6: 'task-wdt', 7: 'wdt', 8: 'deep-sleep', 9: 'brownout', 10: 'sdio', 11: 'usb',
+    12: 'jtag', 13: 'efuse', 14: 'power-glitch', 15: 'cpu-lockup',
+}
+WAKE_CAUSES = {0: 'pulse', 1: 'button', 2: 'timer', 3: 'radio', 4: 'other'}
+SKIP_REASONS = {0: 'not-joined', 1: 'pin-asserted', 2: 'post-join'}
+NVS_KEYS = {0: 'pulses', 1: 'soc', 2: 'profile'}
+OTA_STAGES = {0: 'start', 1: 'apply', 2: 'receive', 3: 'finish', 4: 'abort', 5: 'check', 6: 'ok',
+              7: 'error', 8: 'image-status-normal', 9: 'busy', 10: 'server-not-found'}
+
+
+def describe(kind, arg8, arg16):
+    if kind == 1:
+        return f'reset={RESET_REASONS.get(arg8, arg8)} boot#{arg16}'
+    if kind == 2:
+        return f'ch{arg8 >> 5} count={arg16} lost={arg8 & 0x1f}'
+    if kind == 3:
+        return f'wake={WAKE_CAUSES.get(arg8, arg8)} x{arg16}'
+    if kind == 4:
+        return f'reason={SKIP_REASONS.get(arg8, arg8)} x{arg16}'
+    if kind == 5:
+        return f'attempt={arg8}'
+    if kind == 6:
+        return f'short=0x{arg16:04x}'
+    if kind == 7:
+        status = arg16 - 0x10000 if arg16 & 0x8000 else arg16
+        return f'tsn={arg8} status=0x{status & 0xFFFF:x}' + (' ok' if status == 0 else '')
+    if kind == 8:
+        key = NVS_KEYS.get(arg8 & 0x0f, arg8 & 0x0f)
+        return f'key={key}{arg8 >> 4 or ""} err=0x{arg16:x}'
+    if kind == 9:
+        return f'stage={OTA_STAGES.get(arg8, arg8)} received={arg16} KiB'
+    if kind == 10:
+        return f'{"up" if arg8 else "down"} buffered={arg16}'
+    if kind == 11:
+        flags = [name for bit, name in ((1, 'no-idle'), (2, 'continuous'), (4, 'burst')) if arg8 & bit]
+        return f'ch{arg16} alarms=' + (','.join(flags) or 'clear')
+    if kind == 12:
+        return f'{"radio" if arg8 else "count-only"} unreported={arg16}'
+    return f'arg8={arg8} arg16={arg16}'
+
+
+def main():
+    pages = sys.argv[1:] or [line.strip() for line in sys.stdin if line.strip()]
+    data = b''.join(bytes.fromhex(p.replace(' ', '')) for p in pages)
+    for i in range(0, len(data) - len(data) % 8, 8):
+        ts, kind, arg8, arg16 = struct.unpack_from('<IBBH', data, i)
+        # ts is esp_timer time >> 10; timestamps restart at every BOOT entry.
+        secs = ts * 1024 / 1e6
+        print(f'{i // 8:4d} {secs:12.3f}s {EVENTS.get(kind, kind)!s:<10} {describe(kind, arg8, arg16)}')
+
+
+if __name__ == '__main__':
+    main()
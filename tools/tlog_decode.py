@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Decode tokenized log lines ("#T:...") from the pulse meter console.
+
+    tlog_decode.py build/tlog_dict.json [input]
+
+input is a capture file, '-' for stdin (default), or a serial port (needs pyserial,
+e.g. /dev/ttyACM0 --baud 115200). Lines without the "#T:" marker pass through unchanged,
+so the decoder can sit on the normal monitor output.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+MARKER = '#T:'
+LEVELS = {1: 'E', 2: 'W', 3: 'I', 4: 'D', 5: 'V'}
+LEVEL_TRUNCATED = 0x80
+CONV_RE = re.compile(r'%(?P<flags>[-+ #0]*)(?P<width>\d+)?(?:\.(?P<prec>\d+))?'
+                     r'(?P<len>hh|h|ll|l|z|j|t)?(?P<conv>[diouxXcsp%])')
+
+
+class Record:
+    def __init__(self, data):
+        self.length, self.msg_id, level, self.ts_ms = struct.unpack_from('<BHBI', data, 0)
+        self.level = LEVELS.get(level & 0x7F, '?')
+        self.truncated = bool(level & LEVEL_TRUNCATED)
+        self.payload = data[8:self.length]
+
+
+def format_record(fmt, payload):
+    pos = 0
+    out = []
+    last = 0
+    for m in CONV_RE.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        conv = m.group('conv')
+        if conv == '%':
+            out.append('%')
+            continue
+        if conv == 's':
+            if pos >= len(payload):
+                out.append('?')
+                continue
+            n = payload[pos]
+            value = payload[pos + 1:pos + 1 + n].decode('utf-8', 'replace')
+            pos += 1 + n
+        else:
+            size = 8 if m.group('len') == 'll' else 4
+            if pos + size > len(payload):
+                out.append('?')
+                continue
+            value = int.from_bytes(payload[pos:pos + size], 'little')
+            pos += size
+            if m.group('len') == 'h':
+                value &= 0xFFFF
+            elif m.group('len') == 'hh':
+                value &= 0xFF
+            if conv in 'di':
+                bits = {'h': 16, 'hh': 8}.get(m.group('len'), size * 8)
+                if value & (1 << (bits - 1)):
+                    value -= 1 << bits
+        spec = '%' + m.group('flags') + (m.group('width') or '')
+        if m.group('prec') is not None:
+            spec += '.' + m.group('prec')
+        if conv == 'u':
+            spec += 'd'
+        elif conv == 'p':
+            spec = '0x%08x'
+        else:
+            spec += conv
+        out.append(spec % value)
+    out.append(fmt[last:])
+    return ''.join(out)
+
+
+class Decoder:
+    def __init__(self, dictionary):
+        self.hash = dictionary['hash']
+        self.messages = {m['id']: m for m in dictionary['messages']}
+
+    def line(self, text):
+        idx = text.find(MARKER)
+        if idx < 0:
+            return text
+        body = text[idx + len(MARKER):].strip()
+        if body.startswith('H'):
+            fields = body[1:].split()
+            dev_hash = fields[0] if fields else '?'
+            dropped = fields[1][1:] if len(fields) > 1 else '?'
+            note = '' if dev_hash == self.hash else f' (dictionary {self.hash} does not match, decode may be wrong)'
+            return f'-- tlog session: firmware dictionary {dev_hash}, {dropped} records dropped{note}'
+        try:
+            rec = Record(bytes.fromhex(body))
+        except (ValueError, struct.error):
+            return f'-- tlog: bad record {body}'
+        msg = self.messages.get(rec.msg_id)
+        if msg is None:
+            return f'{rec.level} ({rec.ts_ms}) tlog: unknown id {rec.msg_id} payload {rec.payload.hex()}'
+        text = format_record(msg['format'], rec.payload)
+        if rec.truncated:
+            text += ' [truncated]'
+        return f'{rec.level} ({rec.ts_ms}) {msg["name"]}: {text}'
+
+
+def open_input(path, baud):
+    if path == '-':
+        return sys.stdin
+    if path.startswith(('/dev/', 'COM')):
+        import serial  # pyserial, only needed for live ports
+        port = serial.Serial(path, baud, timeout=1)
+        return (raw.decode('utf-8', 'replace') for raw in iter(port.readline, None))
+    return open(path, encoding='utf-8', errors='replace')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('dictionary', help='tlog_dict.json from the firmware build directory')
+    parser.add_argument('input', nargs='?', default='-')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    with open(args.dictionary, encoding='utf-8') as f:
+        decoder = Decoder(json.load(f))
+    for line in open_input(args.input, args.baud):
+        print(decoder.line(line.rstrip('\r\n')), flush=True)
+
+
+if __name__ == '__main__':
+    main()
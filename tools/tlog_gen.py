@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Generate the tokenized-log dictionary from main/log_msgs.def.
+
+Outputs a C header (message IDs, format strings for the text fallback, dictionary hash)
+and a JSON dictionary consumed by tools/tlog_decode.py.
+
+    tlog_gen.py <log_msgs.def> <out_header.h> <out_dict.json>
+"""
+
+import json
+import re
+import sys
+import zlib
+
+MSG_RE = re.compile(r'^\s*TLOG_MSG\(\s*(\w+)\s*,\s*(.*)\)\s*$')
+PART_RE = re.compile(r'\s*(?:"((?:[^"\\]|\\.)*)"|(\w+))')
+
+# <inttypes.h> macros as expanded by the RISC-V ESP-IDF toolchain (uint32_t is unsigned long).
+PRI_MACROS = {
+    'PRId32': 'ld', 'PRIi32': 'li', 'PRIu32': 'lu', 'PRIx32': 'lx', 'PRIX32': 'lX',
+    'PRId64': 'lld', 'PRIi64': 'lli', 'PRIu64': 'llu', 'PRIx64': 'llx', 'PRIX64': 'llX',
+}
+
+
+def parse_format(expr, lineno):
+    """Concatenate string literals and PRI macros into (c_literal, python_text)."""
+    c_parts, text = [], ''
+    pos = 0
+    while pos < len(expr):
+        m = PART_RE.match(expr, pos)
+        if not m or m.end() == pos:
+            if expr[pos:].strip():
+                raise SystemExit(f'log_msgs.def:{lineno}: cannot parse format: {expr!r}')
+            break
+        if m.group(1) is not None:
+            c_parts.append(f'"{m.group(1)}"')
+            text += m.group(1).encode().decode('unicode_escape')
+        else:
+            name = m.group(2)
+            if name not in PRI_MACROS:
+                raise SystemExit(f'log_msgs.def:{lineno}: unknown macro {name}')
+            c_parts.append(name)
+            text += PRI_MACROS[name]
+        pos = m.end()
+    return ' '.join(c_parts), text
+
+
+def load(path):
+    msgs = []
+    with open(path, encoding='utf-8') as f:
+        for lineno, line in enumerate(f, 1):
+            if not line.strip() or line.lstrip().startswith(('/*', '*', '//')):
+                continue
+            m = MSG_RE.match(line)
+            if not m:
+                raise SystemExit(f'{path}:{lineno}: expected TLOG_MSG(NAME, "format")')
+            c_fmt, text = parse_format(m.group(2), lineno)
+            msgs.append((m.group(1), c_fmt, text))
+    names = [n for n, _, _ in msgs]
+    dup = {n for n in names if names.count(n) > 1}
+    if dup:
+        raise SystemExit(f'{path}: duplicate message names: {", ".join(sorted(dup))}')
+    if len(msgs) > 0xFFFF:
+        raise SystemExit(f'{path}: too many messages')
+    return msgs
+
+
+def main():
+    if len(sys.argv) != 4:
+        raise SystemExit(__doc__)
+    def_path, hdr_path, json_path = sys.argv[1:]
+    msgs = load(def_path)
+    digest = zlib.crc32('\n'.join(f'{n}\t{t}' for n, _, t in msgs).encode()) & 0xFFFFFFFF
+
+    lines = [
+        '/* Generated by tools/tlog_gen.py from log_msgs.def. Do not edit. */',
+        '#pragma once',
+        '',
+        '#include <inttypes.h>',
+        '',
+        f'#define TLOG_DICT_HASH 0x{digest:08x}u',
+        f'#define TLOG_MSG_COUNT {len(msgs)}',
+        '',
+    ]
+    for i, (name, c_fmt, _) in enumerate(msgs):
+        lines.append(f'#define TLOG_ID_{name} {i}')
+        lines.append(f'#define TLOG_FMT_{name} {c_fmt}')
+    with open(hdr_path, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(lines) + '\n')
+
+    with open(json_path, 'w', encoding='utf-8') as f:
+        json.dump({
+            'hash': f'{digest:08x}',
+            'messages': [{'id': i, 'name': n, 'format': t} for i, (n, _, t) in enumerate(msgs)],
+        }, f, indent=1)
+        f.write('\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -23,10 +23,88 @@ const readMeteringValues = async (endpoint) => {
 const MFG_CLUSTER = 0xFD10;
 const ATTR = {
   reset_counter: 0x0008,
+  battery_days_remaining: 0x0010,
+  trace_total: 0x0050,
+  trace_page: 0x0051,
+  trace_data: 0x0052,
+  backlog: 0x0058,
+  leak_alarm: 0x0060,
+};
+
+// Leak alarm bitmap (firmware LEAK_DETECT): one nibble per pulse channel, channel 0 in the low nibble.
+const LEAK_FLAGS = {1: 'no_idle_24h', 2: 'continuous_flow', 4: 'burst'};
+
+const parseLeakAlarms = (leak) => {
+  const names = [];
+  for (let ch = 0; ch < 8; ch++) {
+    const nibble = (leak >>> (ch * 4)) & 0xF;
+    for (const [bit, name] of Object.entries(LEAK_FLAGS)) {
+      if (nibble & Number(bit)) names.push(ch === 0 ? name : `${name}_ch${ch}`);
+    }
+  }
+  return names.join(',');
+};
+
+// Read-only power-state diagnostics (uint32); published as-is, not exposed.
+const DIAG_ATTR = {
+  diag_sleep_s: 0x0020,
+  diag_awake_idle_s: 0x0021,
+  diag_cpu_busy_ms: 0x0022,
+  diag_rx_ms: 0x0023,
+  diag_tx_ms: 0x0024,
+  diag_adc_ms: 0x0025,
+  diag_flash_ms: 0x0026,
+  diag_wakes: 0x0027,
+  diag_tx_frames: 0x0028,
+  diag_adc_bursts: 0x0029,
+  diag_flash_writes: 0x002A,
+  diag_uah_per_day: 0x002B,
+  wake_pulse: 0x0030,
+  wake_button: 0x0031,
+  wake_timer: 0x0032,
+  wake_radio: 0x0033,
+  wake_other: 0x0034,
+  sleep_skip_not_joined: 0x0035,
+  sleep_skip_pin_asserted: 0x0036,
+  sleep_skip_post_join: 0x0037,
+  sleep_hist_lt_10ms: 0x0038,
+  sleep_hist_lt_50ms: 0x0039,
+  sleep_hist_lt_200ms: 0x003A,
+  sleep_hist_lt_1s: 0x003B,
+  sleep_hist_lt_5s: 0x003C,
+  sleep_hist_lt_30s: 0x003D,
+  sleep_hist_lt_120s: 0x003E,
+  sleep_hist_ge_120s: 0x003F,
+  sleep_max_ms: 0x0040,
+  report_queued: 0x0054,
+  report_dropped: 0x0055,
+  report_flushed: 0x0056,
+  report_outages: 0x0057,
+  leak_longest_idle_s: 0x0061,
+  leak_flow_run_s: 0x0062,
+  zcl_writes: 0x0064,
+  zcl_writes_avoided: 0x0065,
+};
+
+// Snapshots buffered while the parent was unreachable, sent in batches once the link returns:
+// {channel u8, age s u32, summation u48, demand s24} little-endian, oldest first.
+const parseBacklog = (raw) => {
+  const buf = Buffer.from(raw);
+  const entries = [];
+  for (let off = 0; off + 14 <= buf.length; off += 14) {
+    entries.push({
+      channel: buf.readUInt8(off),
+      age_s: buf.readUInt32LE(off + 1),
+      summation: buf.readUIntLE(off + 5, 6),
+      demand: buf.readIntLE(off + 11, 3),
+    });
+  }
+  return entries;
 };
 
 const ATTR_TYPE = {
   reset_counter: 0x10, // boolean
+  trace_page: 0x20, // uint8
 };
 
 const hasBatteryPower = (device) => {
@@ -65,6 +143,19 @@ const tzLocal = {
       return {state: {reset_counter: null}};
     },
   },
+  // Post-mortem trace download: publish {"trace_page": n} for n = 0..ceil(trace_total / 8) - 1
+  // and feed the trace_data hex strings to tools/evtrace_decode.py.
+  trace_page: {
+    key: ['trace_page'],
+    convertSet: async (entity, key, value, meta) => {
+      const page = Number(value);
+      const endpoint = meta.device?.getEndpoint ? (meta.device.getEndpoint(1) || entity) : entity;
+      await endpoint.write(MFG_CLUSTER, {[ATTR.trace_page]: {value: page, type: ATTR_TYPE.trace_page}},
+          {manufacturerCode: 0x1234});
+      await endpoint.read(MFG_CLUSTER, [ATTR.trace_total, ATTR.trace_data], {manufacturerCode: 0x1234});
+      return {state: {trace_page: page}};
+    },
+  },
 };
 
 const applyHaMeta = (expose, deviceClass, stateClass) => {
@@ -119,6 +210,32 @@ const safeRound = (value, precision, meta) => {
   }
 };
 
+const batteryDaysExpose = () => exposes.numeric('battery_days_remaining', ea.STATE)
+    .withDescription('Projected days until the battery is empty (coulomb-counting firmware model)')
+    .withUnit('d')
+    .withValueMin(0);
+
+// Simple Metering historical consumption (uint24, summation units), kept by the firmware from Time cluster sync.
+// Herdsman may decode them by name or leave the numeric id.
+const CONSUMPTION_ATTR = {
+  consumption_today: 0x0401,
+  consumption_yesterday: 0x0403,
+  consumption_this_week: 0x0430,
+  consumption_last_week: 0x0432,
+};
+const CONSUMPTION_NAME = {
+  consumption_today: 'currentDayConsumpDelivered',
+  consumption_yesterday: 'previousDayConsumpDelivered',
+  consumption_this_week: 'currentWeekConsumpDelivered',
+  consumption_last_week: 'previousWeekConsumpDelivered',
+};
+
+const consumptionExposes = (variant) => Object.keys(CONSUMPTION_ATTR).map((key) =>
+  exposes.numeric(key, ea.STATE)
+      .withDescription(`Consumption ${key.replace('consumption_', '').replace('_', ' ')} (device clock)`)
+      .withUnit(variant.energyUnit)
+      .withValueMin(0));
+
 const buildExposes = (variant, batteryCapable = true) => {
   const reset = exposes.enum('reset_counter', ea.SET, ['RESET'])
       .withDescription('Reset counter (write-only)');
@@ -143,10 +260,10 @@ const buildExposes = (variant, batteryCapable = true) => {
           .withValueMin(0)
           .withValueStep(0.1);
       applyHaMeta(battVoltage, 'voltage', 'measurement');
-      exposeList.push(e.battery(), battVoltage);
+      exposeList.push(e.battery(), battVoltage, batteryDaysExpose());
     }
 
-    exposeList.push(reset);
+    exposeList.push(...consumptionExposes(variant), reset);
     return exposeList;
   }
 
@@ -180,16 +297,78 @@ const buildExposes = (variant, batteryCapable = true) => {
         .withValueMin(0)
         .withValueStep(0.1);
     applyHaMeta(battVoltage, 'voltage', 'measurement');
-    exposeList.push(e.battery(), battVoltage);
+    exposeList.push(e.battery(), battVoltage, batteryDaysExpose());
   }
 
-  exposeList.push(reset);
+  if (variant.type === 'water') {
+    exposeList.push(
+        e.water_leak(),
+        exposes.text('leak_alarms', ea.STATE).withDescription('Active leak conditions reported by the device'));
+  }
+
+  exposeList.push(...consumptionExposes(variant), reset);
   return exposeList;
 };
 
+const mfgAttr = (data, id) => {
+  if (!data) return undefined;
+  if (data[id] !== undefined) return data[id];
+  return data[String(id)];
+};
+
+const readMfgAttrs = async (endpoint, ids) => {
+  try {
+    await endpoint.read(MFG_CLUSTER, ids, {manufacturerCode: 0x1234});
+  } catch (error) {
+    // Attributes are optional (depend on firmware Kconfig); ignore unsupported ones.
+  }
+};
+
 const FLOW_MODELS = new Set(['ESP32-PulseMeter-Gas', 'ESP32-PulseMeter-Water']);
 
 const fzLocal = {
+  manufacturer: {
+    cluster: String(MFG_CLUSTER),
+    type: ['attributeReport', 'readResponse'],
+    convert: (model, msg, publish, options, meta) => {
+      const result = {};
+      const days = mfgAttr(msg.data, ATTR.battery_days_remaining);
+      if (days !== undefined) {
+        result.battery_days_remaining = days === 0xFFFF ? null : days;
+      }
+      const traceTotal = mfgAttr(msg.data, ATTR.trace_total);
+      if (traceTotal !== undefined) result.trace_total = traceTotal;
+      const traceData = mfgAttr(msg.data, ATTR.trace_data);
+      if (traceData !== undefined) result.trace_data = Buffer.from(traceData).toString('hex');
+      const leak = mfgAttr(msg.data, ATTR.leak_alarm);
+      if (leak !== undefined) {
+        result.water_leak = leak !== 0;
+        result.leak_alarms = parseLeakAlarms(leak);
+      }
+      const backlog = mfgAttr(msg.data, ATTR.backlog);
+      if (backlog !== undefined) result.backlog = parseBacklog(backlog);
+      for (const [key, id] of Object.entries(DIAG_ATTR)) {
+        const value = mfgAttr(msg.data, id);
+        if (value !== undefined) result[key] = value;
+      }
+      return result;
+    },
+  },
+  consumption: {
+    cluster: 'seMetering',
+    type: ['attributeReport', 'readResponse'],
+    convert: (model, msg, publish, options, meta) => {
+      const result = {};
+      const divisor = msg.endpoint?.getClusterAttributeValue?.('seMetering', 'divisor') || 1;
+      for (const [key, id] of Object.entries(CONSUMPTION_ATTR)) {
+        const raw = msg.data?.[CONSUMPTION_NAME[key]] ?? mfgAttr(msg.data, id);
+        if (raw === undefined) continue;
+        const value = safeRound(raw / divisor, 3, meta);
+        if (value !== undefined) result[key] = value;
+      }
+      return result;
+    },
+  },
   metering_round: {
     ...fz.metering,
     convert: (model, msg, publish, options, meta) => {
@@ -232,11 +411,11 @@ module.exports = DEVICE_VARIANTS.map((variant) => ({
   vendor: 'Custom',
   description: variant.desc,
 
-  fromZigbee: [fzLocal.metering_round, fz.battery],
-  toZigbee: [tzLocal.reset_action],
+  fromZigbee: [fzLocal.metering_round, fzLocal.consumption, fz.battery, fzLocal.manufacturer],
+  toZigbee: [tzLocal.reset_action, tzLocal.trace_page],
 
   meta: {
-    configureKey: 15,
+    configureKey: 16,
     manufacturerCode: 0x1234,
   },
 
@@ -250,6 +429,15 @@ module.exports = DEVICE_VARIANTS.map((variant) => ({
 
     await reporting.instantaneousDemand(endpoint, {min: 10, max: 300, change: 0});
     await reporting.currentSummDelivered(endpoint, {min: 10, max: 300, change: 0});
+    // Extra pulse channels (firmware PULSE_CHANNELS > 1) each serve seMetering on the next endpoint.
+    // They are bound and reported here; the exposes below describe channel 0 only.
+    for (const extra of device.endpoints.filter((ep) => ep.ID > 1 && ep.supportsInputCluster('seMetering'))) {
+      await reporting.bind(extra, coordinatorEndpoint, ['seMetering']);
+      await reporting.instantaneousDemand(extra, {min: 10, max: 300, change: 0});
+      await reporting.currentSummDelivered(extra, {min: 10, max: 300, change: 0});
+      await readMeteringScale(extra);
+      await readMeteringValues(extra);
+    }
     if (batteryCapable) {
       await reporting.batteryPercentageRemaining(endpoint, {min: 10, max: 21600, change: 0});
       await reporting.batteryVoltage(endpoint, {min: 10, max: 21600, change: 0});
@@ -259,6 +447,17 @@ module.exports = DEVICE_VARIANTS.map((variant) => ({
 
     await readMeteringScale(endpoint);
     await readMeteringValues(endpoint);
+    try {
+      await endpoint.read('seMetering', Object.values(CONSUMPTION_ATTR));
+    } catch (error) {
+      // Empty until the device has synced its clock.
+    }
+    if (batteryCapable) {
+      await readMfgAttrs(endpoint, [ATTR.battery_days_remaining]);
+    }
+    if (variant.type === 'water') {
+      await readMfgAttrs(endpoint, [ATTR.leak_alarm]);
+    }
   },
 
   exposes: (device) => buildExposes(variant, hasBatteryPower(device)),